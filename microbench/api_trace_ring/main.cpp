@@ -0,0 +1,261 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of recording parsed APIs under resource trace mode
+ *  \note   we compare the previous path, which retains the context of each API until the client exits
+ *          (stood for by a heap copy of its handle views), with the trace ring (POSApiTraceRing) drained by
+ *          the writer thread (POSApiTraceWriter); the trace file is then read back by POSApiTraceReader,
+ *          all records must match the recorded calls
+ *  \note   we also record into a small ring faster than the writer drains it, the dropped records must be
+ *          counted, and the rest must still be readable
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <filesystem>
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pos/include/common.h"
+#include "pos/include/api_trace.h"
+#include "pos/include/utils/timer.h"
+
+constexpr uint64_t kNbCalls = 200000;
+constexpr uint64_t kNbApis = 64;
+constexpr uint64_t kMaxNbHandles = 8;
+constexpr uint64_t kSmallRingCapacity = 64ull << 10;
+
+// stands for POSHandleView_t
+struct bench_view_t {
+    uint32_t resource_type_id;
+    uint64_t handle_id;
+    uint64_t param_index;
+    uint64_t offset;
+};
+
+// stands for a parsed API context
+struct bench_call_t {
+    uint32_t api_id;
+    uint64_t create_tick;
+    std::vector<bench_view_t> views[kPOS_Edge_Direction_Delete + 1];
+};
+
+
+static void generate_calls(std::vector<bench_call_t>& calls){
+    std::mt19937_64 rng(42);
+    uint64_t i, j, nb_handles;
+    uint8_t direction;
+
+    calls.resize(kNbCalls);
+    for(i=0; i<kNbCalls; i++){
+        calls[i].api_id = rng() % kNbApis;
+        calls[i].create_tick = i * 1000;
+        nb_handles = rng() % (kMaxNbHandles + 1);
+        for(j=0; j<nb_handles; j++){
+            direction = rng() % (kPOS_Edge_Direction_Delete + 1);
+            calls[i].views[direction].push_back({
+                /* resource_type_id */ (uint32_t)(rng() % 16),
+                /* handle_id */ rng() % 1024,
+                /* param_index */ j,
+                /* offset */ (rng() % 4096) * 256
+            });
+        }
+    }
+}
+
+
+static double record_by_retaining(const std::vector<bench_call_t>& calls){
+    std::vector<bench_call_t*> retained;
+    std::chrono::time_point<std::chrono::high_resolution_clock> s_time, e_time;
+    double ns;
+
+    s_time = std::chrono::high_resolution_clock::now();
+    for(const bench_call_t& call : calls){
+        retained.push_back(new bench_call_t(call));
+    }
+    e_time = std::chrono::high_resolution_clock::now();
+    ns = std::chrono::duration<double, std::nano>(e_time - s_time).count();
+
+    for(bench_call_t *call : retained){ delete call; }
+    return ns / calls.size();
+}
+
+
+static void record_by_ring(POSApiTraceRing& ring, const bench_call_t& call, uint64_t id){
+    pos_api_trace_record_t *record;
+    pos_api_trace_handle_t *handle;
+    uint64_t nb_handles = 0;
+    uint8_t direction;
+
+    for(direction=0; direction<=kPOS_Edge_Direction_Delete; direction++){
+        nb_handles += call.views[direction].size();
+    }
+    if(unlikely(nullptr == (record = ring.reserve(nb_handles)))){ return; }
+
+    record->api_id = call.api_id;
+    record->apicxt_id = id;
+    record->create_tick = call.create_tick;
+    record->parser_s_tick = call.create_tick + 10;
+    record->parser_e_tick = call.create_tick + 20;
+    record->is_sync = call.api_id % 2;
+    record->status = 0;
+    record->reserved = 0;
+
+    handle = POSApiTraceRing::handles_of(record);
+    for(direction=0; direction<=kPOS_Edge_Direction_Delete; direction++){
+        for(const bench_view_t& view : call.views[direction]){
+            handle->direction = direction;
+            handle->reserved = 0;
+            handle->param_index = view.param_index;
+            handle->resource_type_id = view.resource_type_id;
+            handle->handle_id = view.handle_id;
+            handle->offset = view.offset;
+            handle++;
+        }
+    }
+
+    ring.commit();
+}
+
+
+static double run_ring(
+    const std::vector<bench_call_t>& calls, const std::string& file_path, uint64_t capacity, double tsc_freq
+){
+    POSApiTraceWriter writer;
+    POSApiTraceRing ring(/* client_id */ 1, /* pid */ getpid(), capacity);
+    std::chrono::time_point<std::chrono::high_resolution_clock> s_time, e_time;
+    uint64_t i;
+    double ns;
+
+    if(POS_SUCCESS != writer.init(file_path, tsc_freq)){
+        printf("failed to create trace file %s\n", file_path.c_str());
+        exit(1);
+    }
+    writer.add(&ring);
+
+    s_time = std::chrono::high_resolution_clock::now();
+    for(i=0; i<calls.size(); i++){ record_by_ring(ring, calls[i], i); }
+    e_time = std::chrono::high_resolution_clock::now();
+    ns = std::chrono::duration<double, std::nano>(e_time - s_time).count();
+
+    writer.remove(&ring);
+    writer.deinit();
+
+    return ns / calls.size();
+}
+
+
+static uint64_t verify(
+    const std::vector<bench_call_t>& calls, const std::string& file_path, uint64_t& nb_records, uint64_t& nb_dropped
+){
+    POSApiTraceReader reader;
+    uint64_t nb_mismatched = 0, expected_id = 0;
+
+    nb_records = 0;
+    if(POS_SUCCESS != reader.open(file_path)){
+        printf("failed to open trace file %s\n", file_path.c_str());
+        return 1;
+    }
+
+    nb_mismatched += POS_SUCCESS != reader.for_each([&](
+        const pos_api_trace_chunk_header_t& chunk,
+        const pos_api_trace_record_t& record,
+        const pos_api_trace_handle_t* handles
+    ){
+        uint64_t i = 0;
+        uint8_t direction;
+
+        nb_records += 1;
+
+        // records could be dropped, but those kept must be in order
+        if(record.apicxt_id < expected_id || record.apicxt_id >= calls.size()){
+            nb_mismatched += 1;
+            return;
+        }
+        expected_id = record.apicxt_id + 1;
+
+        const bench_call_t& call = calls[record.apicxt_id];
+        nb_mismatched += record.api_id != call.api_id || record.create_tick != call.create_tick;
+        for(direction=0; direction<=kPOS_Edge_Direction_Delete; direction++){
+            for(const bench_view_t& view : call.views[direction]){
+                if(i >= record.nb_handles){ nb_mismatched += 1; return; }
+                nb_mismatched += handles[i].direction != direction
+                                || handles[i].handle_id != view.handle_id
+                                || handles[i].resource_type_id != view.resource_type_id
+                                || handles[i].param_index != view.param_index
+                                || handles[i].offset != view.offset;
+                i++;
+            }
+        }
+        nb_mismatched += i != record.nb_handles;
+    }, nb_dropped);
+
+    nb_mismatched += nb_records + nb_dropped != calls.size();
+    return nb_mismatched;
+}
+
+
+int main(){
+    std::vector<bench_call_t> calls;
+    POSUtilTscTimer tsc_timer;
+    POSApiTraceReader reader;
+    pos_api_trace_summary_t summary;
+    std::string dir, file_path;
+    uint64_t nb_mismatched = 0, nb_records, nb_dropped, nb_small_records, nb_small_dropped;
+    double retain_ns, ring_ns, small_ring_ns;
+
+    generate_calls(calls);
+
+    dir = std::filesystem::temp_directory_path().string() + std::string("/pos_api_trace_ring");
+    std::filesystem::create_directories(dir);
+
+    retain_ns = record_by_retaining(calls);
+
+    // the ring is large enough to hold the whole trace, nothing should be dropped
+    file_path = dir + std::string("/large.bin");
+    ring_ns = run_ring(calls, file_path, /* capacity */ 64ull << 20, tsc_timer.get_tsc_freq());
+    nb_mismatched += verify(calls, file_path, nb_records, nb_dropped);
+    nb_mismatched += nb_dropped != 0;
+
+    POS_ASSERT(POS_SUCCESS == reader.open(file_path));
+    POS_ASSERT(POS_SUCCESS == reader.summarize(summary));
+    nb_mismatched += summary.nb_records != calls.size() || summary.apis.size() != kNbApis;
+
+    // the ring is filled faster than the writer drains it
+    file_path = dir + std::string("/small.bin");
+    small_ring_ns = run_ring(calls, file_path, kSmallRingCapacity, tsc_timer.get_tsc_freq());
+    nb_mismatched += verify(calls, file_path, nb_small_records, nb_small_dropped);
+
+    std::filesystem::remove_all(dir);
+
+    printf(
+        "%lu calls of %lu APIs (%lu records read back, %lu distinct handles), %lu mismatched\n",
+        calls.size(), kNbApis, nb_records, summary.handles.size(), nb_mismatched
+    );
+    printf("retained context: %.2f ns/call\n", retain_ns);
+    printf("trace ring: %.2f ns/call, speedup %.2fx\n", ring_ns, retain_ns / ring_ns);
+    printf(
+        "trace ring (%lu KB): %.2f ns/call, %lu kept, %lu dropped\n",
+        kSmallRingCapacity >> 10, small_ring_ns, nb_small_records, nb_small_dropped
+    );
+
+    return nb_mismatched > 0 ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of the allocation path of pos_process
+ *  \note   the RPC thread creates a WQE for each call and pushes it to the work queue, a
+ *          pipeline thread (stands for parser and worker) reads all parameters and pushes the WQE
+ *          back to the completion queue, and the RPC thread polls the completion queue once every
+ *          kSyncInterval calls (i.e., a sync call after a batch of async kernel launches);
+ *          we compare WQEs allocated from the heap for each call with WQEs from POSAPIContextPool
+ */
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pos/include/common.h"
+#include "pos/include/api_context.h"
+#include "pos/include/utils/lockfree_queue.h"
+
+constexpr uint64_t kNbCalls = 2000000;
+constexpr uint64_t kSyncInterval = 16;
+
+enum alloc_mode_t { kAlloc_Heap = 0, kAlloc_Pool };
+
+struct bench_cxt_t {
+    POSLockFreeQueue<POSAPIContext_QE_t*> wq;
+    POSLockFreeQueue<POSAPIContext_QE_t*> cq;
+    std::atomic<bool> stop_flag;
+    bench_cxt_t() : stop_flag(false) {}
+};
+
+
+static void pipeline_thread(bench_cxt_t *cxt){
+    POSAPIContext_QE_t *wqe;
+    POSAPIContextPool *pool;
+    uint64_t i, checksum = 0;
+
+    while(!cxt->stop_flag.load(std::memory_order_relaxed)){
+        if(cxt->wq.dequeue(wqe) != POS_SUCCESS){ std::this_thread::yield(); continue; }
+        for(i=0; i<wqe->api_cxt->params.size(); i++){
+            checksum += *((uint8_t*)pos_api_param_addr(wqe, i));
+        }
+        wqe->api_cxt->return_code = (int)(checksum & 0x1);
+
+        // heap-allocated WQE might be deleted by the RPC thread right after it's pushed
+        pool = wqe->pool;
+        cxt->cq.push(wqe);
+        if(pool != nullptr){ wqe->release(); }
+    }
+}
+
+
+static double run(alloc_mode_t mode){
+    bench_cxt_t cxt;
+    POSAPIContextPool pool;
+    POSAPIContext_QE_t *wqe, *cqe;
+    uint64_t i, nb_inflight = 0;
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    std::thread *pipeline;
+    int dummy_client;
+
+    // parameters of a typical cudaLaunchKernel call: function, grid, block, arguments, shared memory, stream
+    uint64_t func = 0x7f0000001000, stream = 0;
+    uint32_t grid[3] = {128, 1, 1}, block[3] = {256, 1, 1}, shm = 0;
+    uint8_t args[64] = {0};
+    std::vector<POSAPIParamDesp_t> param_desps = {
+        { &func, sizeof(func) }, { grid, sizeof(grid) }, { block, sizeof(block) },
+        { args, sizeof(args) }, { &shm, sizeof(shm) }, { &stream, sizeof(stream) }
+    };
+
+    pipeline = new std::thread(pipeline_thread, &cxt);
+
+    s_time = std::chrono::steady_clock::now();
+    for(i=0; i<kNbCalls; i++){
+        if(mode == kAlloc_Heap){
+            wqe = new POSAPIContext_QE_t(
+                /* api_id */ 0, /* uuid */ 0, /* param_desps */ param_desps, /* inst_id */ i,
+                /* retval_data */ nullptr, /* retval_size */ 0, /* pos_client */ (POSClient*)(&dummy_client)
+            );
+        } else {
+            wqe = pool.acquire(
+                /* api_id */ 0, /* uuid */ 0, /* param_desps */ param_desps, /* inst_id */ i,
+                /* retval_data */ nullptr, /* retval_size */ 0, /* pos_client */ (POSClient*)(&dummy_client)
+            );
+            wqe->retain();
+        }
+        cxt.wq.push(wqe);
+        nb_inflight += 1;
+
+        if((i+1) % kSyncInterval == 0 || i+1 == kNbCalls){
+            while(nb_inflight > 0){
+                if(cxt.cq.dequeue(cqe) != POS_SUCCESS){ std::this_thread::yield(); continue; }
+                nb_inflight -= 1;
+                if(mode == kAlloc_Heap){ delete cqe; } else { cqe->release(); }
+            }
+        }
+    }
+    e_time = std::chrono::steady_clock::now();
+
+    cxt.stop_flag = true;
+    pipeline->join();
+    delete pipeline;
+
+    if(mode == kAlloc_Pool){
+        printf("  pool: allocated %lu WQEs for %lu calls\n", pool.get_nb_allocated(), kNbCalls);
+    }
+
+    return (double)(kNbCalls) / std::chrono::duration<double>(e_time - s_time).count();
+}
+
+
+int main(){
+    double heap_tput, pool_tput;
+
+    heap_tput = run(kAlloc_Heap);
+    pool_tput = run(kAlloc_Pool);
+
+    printf("heap: %.2f Mcalls/s (%.1f ns/call)\n", heap_tput / 1e6, 1e9 / heap_tput);
+    printf("pool: %.2f Mcalls/s (%.1f ns/call)\n", pool_tput / 1e6, 1e9 / pool_tput);
+    printf("speedup: %.2fx\n", pool_tput / heap_tput);
+
+    return 0;
+}
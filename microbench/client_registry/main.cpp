@@ -0,0 +1,208 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of the client lookup on the RPC path of pos_process with many clients
+ *  \note   each RPC thread stands for a client process issuing calls: for each call it looks up its
+ *          client by the piggybacked uuid (and by pid once every kPidLookupInterval calls, as the OOB
+ *          routines do) and checks its status, while a churn thread keeps registering / removing
+ *          short-lived clients; we compare POSClientRegistry with a mutex-protected vector and map
+ */
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pos/include/common.h"
+#include "pos/include/client_registry.h"
+
+constexpr uint64_t kNbCallsPerThread = 1000000;
+constexpr uint64_t kPidLookupInterval = 16;
+constexpr uint64_t kNbLongLivedClients = 64;
+constexpr __pid_t kBasePid = 1000;
+
+enum registry_mode_t { kRegistry_Mutex = 0, kRegistry_RCU };
+
+// stands for POSClient, only the status is checked
+struct bench_client_t {
+    volatile uint64_t status;
+    uint64_t uuid;
+};
+
+
+// the previous structure of the workspace, made safe by a mutex
+struct mutex_registry_t {
+    std::mutex mutex;
+    std::vector<bench_client_t*> clients;
+    std::map<__pid_t, bench_client_t*> pid_map;
+};
+
+
+struct bench_cxt_t {
+    registry_mode_t mode;
+    POSClientRegistry rcu_registry;
+    mutex_registry_t mutex_registry;
+    std::atomic<bool> stop_flag;
+    std::atomic<uint64_t> nb_churns;
+    bench_cxt_t() : stop_flag(false), nb_churns(0) {}
+};
+
+
+static inline bench_client_t* lookup(bench_cxt_t *cxt, uint64_t uuid, __pid_t pid, bool by_pid){
+    bench_client_t *client = nullptr;
+
+    if(cxt->mode == kRegistry_RCU){
+        client = by_pid ? (bench_client_t*)(cxt->rcu_registry.get_by_pid(pid))
+                        : (bench_client_t*)(cxt->rcu_registry.get_by_uuid(uuid));
+    } else {
+        std::lock_guard<std::mutex> lock(cxt->mutex_registry.mutex);
+        if(by_pid){
+            if(cxt->mutex_registry.pid_map.count(pid) > 0){ client = cxt->mutex_registry.pid_map[pid]; }
+        } else if(uuid < cxt->mutex_registry.clients.size()){
+            client = cxt->mutex_registry.clients[uuid];
+        }
+    }
+
+    return client;
+}
+
+
+static void rpc_thread(bench_cxt_t *cxt, uint64_t uuid, uint64_t *checksum){
+    bench_client_t *client;
+    uint64_t i, sum = 0;
+
+    for(i=0; i<kNbCallsPerThread; i++){
+        if(cxt->mode == kRegistry_RCU){ POSClientRegistry::read_lock(); }
+        client = lookup(cxt, uuid, kBasePid + uuid, /* by_pid */ i % kPidLookupInterval == 0);
+        if(likely(client != nullptr)){ sum += client->status + client->uuid; }
+        if(cxt->mode == kRegistry_RCU){ POSClientRegistry::read_unlock(); }
+    }
+
+    *checksum = sum;
+}
+
+
+static void churn_thread(bench_cxt_t *cxt){
+    bench_client_t *client;
+    uint64_t uuid;
+
+    while(!cxt->stop_flag.load(std::memory_order_relaxed)){
+        POS_CHECK_POINTER(client = new bench_client_t());
+
+        if(cxt->mode == kRegistry_RCU){
+            uuid = client->uuid = cxt->rcu_registry.alloc_uuid();
+            if(unlikely(uuid >= POSClientRegistry::kMaxNbClients)){ delete client; break; }
+            cxt->rcu_registry.insert(uuid, kBasePid + uuid, (POSClient*)(client));
+            std::this_thread::yield();
+            POS_ASSERT(cxt->rcu_registry.erase(uuid) == (POSClient*)(client));
+        } else {
+            {
+                std::lock_guard<std::mutex> lock(cxt->mutex_registry.mutex);
+                uuid = client->uuid = cxt->mutex_registry.clients.size();
+                cxt->mutex_registry.clients.push_back(client);
+                cxt->mutex_registry.pid_map[kBasePid + uuid] = client;
+            }
+            std::this_thread::yield();
+            {
+                std::lock_guard<std::mutex> lock(cxt->mutex_registry.mutex);
+                cxt->mutex_registry.clients[uuid] = nullptr;
+                cxt->mutex_registry.pid_map.erase(kBasePid + uuid);
+            }
+        }
+
+        delete client;
+        cxt->nb_churns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+static double run(registry_mode_t mode, uint64_t nb_threads){
+    bench_cxt_t cxt;
+    std::vector<bench_client_t*> clients;
+    std::vector<std::thread*> threads;
+    std::vector<uint64_t> checksums(nb_threads, 0);
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    std::thread *churn;
+    uint64_t i;
+
+    cxt.mode = mode;
+
+    // long-lived clients, the callers
+    for(i=0; i<kNbLongLivedClients; i++){
+        clients.push_back(new bench_client_t());
+        clients[i]->status = 1;
+        if(mode == kRegistry_RCU){
+            clients[i]->uuid = cxt.rcu_registry.alloc_uuid();
+            cxt.rcu_registry.insert(clients[i]->uuid, kBasePid + clients[i]->uuid, (POSClient*)(clients[i]));
+        } else {
+            clients[i]->uuid = cxt.mutex_registry.clients.size();
+            cxt.mutex_registry.clients.push_back(clients[i]);
+            cxt.mutex_registry.pid_map[kBasePid + clients[i]->uuid] = clients[i];
+        }
+    }
+
+    churn = new std::thread(churn_thread, &cxt);
+
+    s_time = std::chrono::steady_clock::now();
+    for(i=0; i<nb_threads; i++){
+        threads.push_back(new std::thread(rpc_thread, &cxt, i % kNbLongLivedClients, &checksums[i]));
+    }
+    for(i=0; i<nb_threads; i++){
+        threads[i]->join();
+        delete threads[i];
+    }
+    e_time = std::chrono::steady_clock::now();
+
+    cxt.stop_flag = true;
+    churn->join();
+    delete churn;
+
+    for(i=0; i<kNbLongLivedClients; i++){
+        if(mode == kRegistry_RCU){ cxt.rcu_registry.erase(clients[i]->uuid); }
+        delete clients[i];
+    }
+
+    printf(
+        "  %s, %lu threads: %lu clients registered / removed during the run\n",
+        mode == kRegistry_RCU ? "rcu" : "mutex", nb_threads, cxt.nb_churns.load()
+    );
+
+    return (double)(kNbCallsPerThread * nb_threads) / std::chrono::duration<double>(e_time - s_time).count();
+}
+
+
+int main(){
+    double mutex_tput, rcu_tput;
+    uint64_t nb_threads;
+
+    for(nb_threads=1; nb_threads<=16; nb_threads*=2){
+        mutex_tput = run(kRegistry_Mutex, nb_threads);
+        rcu_tput = run(kRegistry_RCU, nb_threads);
+        printf(
+            "%2lu threads: mutex %.2f Mcalls/s, rcu %.2f Mcalls/s, speedup %.2fx\n",
+            nb_threads, mutex_tput / 1e6, rcu_tput / 1e6, rcu_tput / mutex_tput
+        );
+    }
+
+    return 0;
+}
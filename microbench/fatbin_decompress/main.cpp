@@ -0,0 +1,449 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of decompressing fatbin text sections
+ *  \note   the cubin is taken from the ".nv_fatbin" section of the host object compiled by nvcc
+ *          (../crc/output.fatbin by default); we compress many renamed copies of it, together with random
+ *          streams full of short-period runs (i.e., overlapped matches), then compare the decompressor of
+ *          POSUtil_CUDA_Fatbin with the previous bytewise one, the outputs must be identical; we also
+ *          compare decompressing the sections with looking them up from the section cache
+ *          (POSUtil_CUDA_Fatbin_Cache), in memory and spilled to files
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <filesystem>
+
+#include <stdint.h>
+#include <string.h>
+#include <elf.h>
+
+#include "pos/include/common.h"
+#include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
+
+// number of renamed cubins, each of them is compressed as a section
+constexpr uint64_t kNbCubins = 1024;
+
+// number of random streams
+constexpr uint64_t kNbRandomStreams = 256;
+
+// number of rounds to decompress
+constexpr uint64_t kNbRounds = 10;
+
+// the kernel name to be renamed within the cubin, i.e., "crc32" within "_Z12crc32_kernelPKhmPjPKj"
+static const std::string kKernelTag = "crc32";
+
+
+typedef struct __attribute__((__packed__)) bench_fat_elf_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint64_t size;
+} bench_fat_elf_header_t;
+
+typedef struct __attribute__((__packed__)) bench_fat_text_header {
+    uint16_t kind;
+    uint16_t unknown1;
+    uint32_t header_size;
+    uint64_t size;
+    uint32_t compressed_size;
+    uint32_t unknown2;
+    uint16_t minor;
+    uint16_t major;
+    uint32_t arch;
+    uint32_t obj_name_offset;
+    uint32_t obj_name_len;
+    uint64_t flags;
+    uint64_t zero;
+    uint64_t decompressed_size;
+} bench_fat_text_header_t;
+
+typedef struct bench_stream {
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> compressed;
+} bench_stream_t;
+
+
+/*!
+ *  \brief  obtain the content of the ".nv_fatbin" section within a host object
+ */
+static bool load_nv_fatbin(const std::string& path, std::vector<uint8_t>& fatbin){
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> obj;
+    Elf64_Ehdr *ehdr;
+    Elf64_Shdr *shdrs;
+    const char *shstrtab;
+    uint16_t i;
+
+    if(!file.is_open()){ return false; }
+    obj.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if(obj.size() < sizeof(Elf64_Ehdr) || memcmp(obj.data(), ELFMAG, SELFMAG) != 0){ return false; }
+
+    ehdr = (Elf64_Ehdr*)obj.data();
+    shdrs = (Elf64_Shdr*)(obj.data() + ehdr->e_shoff);
+    shstrtab = (const char*)(obj.data() + shdrs[ehdr->e_shstrndx].sh_offset);
+    for(i=0; i<ehdr->e_shnum; i++){
+        if(strcmp(shstrtab + shdrs[i].sh_name, ".nv_fatbin") == 0){
+            fatbin.assign(obj.data() + shdrs[i].sh_offset, obj.data() + shdrs[i].sh_offset + shdrs[i].sh_size);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*!
+ *  \brief  compress the data in the format accepted by POSUtil_CUDA_Fatbin (i.e., LZ4 block)
+ */
+static void compress(const std::vector<uint8_t>& input, std::vector<uint8_t>& output){
+    std::vector<int64_t> table(1 << 16, -1);
+    uint64_t ipos = 0, anchor = 0, match_len, token;
+    int64_t candidate;
+    uint32_t seq;
+
+    auto __put_len = [&](uint64_t len){
+        for(; len >= 0xff; len -= 0xff){ output.push_back(0xff); }
+        output.push_back(len);
+    };
+
+    // a sequence is a token, literals, and a match (offset + length) which is absent for the last sequence
+    auto __put_sequence = [&](uint64_t offset, uint64_t match_len){
+        token = output.size();
+        output.push_back(std::min<uint64_t>(ipos - anchor, 0xf) << 4);
+        if(ipos - anchor >= 0xf){ __put_len(ipos - anchor - 0xf); }
+        output.insert(output.end(), input.begin() + anchor, input.begin() + ipos);
+        if(match_len == 0){ return; }
+        output.push_back(offset & 0xff);
+        output.push_back(offset >> 8);
+        output[token] |= std::min<uint64_t>(match_len - 4, 0xf);
+        if(match_len - 4 >= 0xf){ __put_len(match_len - 4 - 0xf); }
+    };
+
+    output.clear();
+    while(ipos + 4 <= input.size()){
+        memcpy(&seq, &input[ipos], 4);
+        seq = (seq * 2654435761u) >> 16;
+        candidate = table[seq];
+        table[seq] = ipos;
+        if(candidate >= 0 && ipos - candidate <= 0xffff && memcmp(&input[candidate], &input[ipos], 4) == 0){
+            match_len = 4;
+            while(ipos + match_len < input.size() && input[candidate + match_len] == input[ipos + match_len]){
+                match_len++;
+            }
+            __put_sequence(ipos - candidate, match_len);
+            ipos += match_len;
+            anchor = ipos;
+        } else {
+            ipos++;
+        }
+    }
+    ipos = input.size();
+    __put_sequence(0, 0);
+}
+
+
+/*!
+ *  \brief  the previous decompressor, which copies overlapped matches byte by byte
+ */
+static size_t decompress_bytewise(const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size){
+    size_t ipos = 0, opos = 0;
+    uint64_t next_nclen, next_clen, back_offset;
+
+    while (ipos < input_size) {
+        next_nclen = (input[ipos] & 0xf0) >> 4;
+        next_clen = 4 + (input[ipos] & 0xf);
+        if (next_nclen == 0xf) {
+            do {
+                next_nclen += input[++ipos];
+            } while (input[ipos] == 0xff);
+        }
+
+        memcpy(output + opos, input + (++ipos), next_nclen);
+
+        ipos += next_nclen;
+        opos += next_nclen;
+        if (ipos >= input_size || opos >= output_size) {
+            break;
+        }
+        back_offset = input[ipos] + (input[ipos + 1] << 8);
+        ipos += 2;
+        if (next_clen == 0xf+4) {
+            do {
+                next_clen += input[ipos++];
+            } while (input[ipos - 1] == 0xff);
+        }
+
+        if (next_clen <= back_offset) {
+            memcpy(output + opos, output + opos - back_offset, next_clen);
+        } else {
+            memcpy(output + opos, output + opos - back_offset, back_offset);
+            for (size_t i = back_offset; i < next_clen; i++) {
+                output[opos + i] = output[opos + i - back_offset];
+            }
+        }
+
+        opos += next_clen;
+    }
+
+    return opos;
+}
+
+
+/*!
+ *  \brief  synthesize the streams to be decompressed
+ *  \param  cubin       the template cubin, renamed copies of which are the sections
+ *  \param  sections    the sections
+ *  \param  randoms     random streams of literals and short-period runs
+ */
+static void synthesize_streams(
+    const std::vector<uint8_t>& cubin, std::vector<bench_stream_t>& sections, std::vector<bench_stream_t>& randoms
+){
+    std::mt19937_64 rng(0x706f73);
+    std::vector<size_t> tag_positions;
+    uint64_t i, j, period, run_len;
+    char tag[8];
+    size_t pos;
+
+    for(pos=0; pos+kKernelTag.size()<=cubin.size(); pos++){
+        if(memcmp(&cubin[pos], kKernelTag.data(), kKernelTag.size()) == 0){ tag_positions.push_back(pos); }
+    }
+
+    for(i=0; i<kNbCubins; i++){
+        sections.emplace_back();
+        sections.back().raw = cubin;
+        snprintf(tag, sizeof(tag), "k%04lx", i);
+        for(size_t p : tag_positions){ memcpy(&sections.back().raw[p], tag, kKernelTag.size()); }
+        compress(sections.back().raw, sections.back().compressed);
+    }
+
+    for(i=0; i<kNbRandomStreams; i++){
+        randoms.emplace_back();
+        std::vector<uint8_t>& raw = randoms.back().raw;
+        while(raw.size() < 64 * 1024){
+            // a few literals, then a run repeating the last bytes
+            for(j=rng()%24; j>0; j--){ raw.push_back(rng() % 4 == 0 ? 0 : rng()); }
+            period = 1 + rng() % 8;
+            run_len = rng() % 2 ? 4 + rng() % 32 : 4 + rng() % 1024;
+            if(raw.size() < period){ continue; }
+            for(j=0; j<run_len; j++){ raw.push_back(raw[raw.size() - period]); }
+        }
+        compress(raw, randoms.back().compressed);
+    }
+}
+
+
+/*!
+ *  \brief  decompress all streams for rounds, and verify the output against the raw content
+ *  \return throughput in MB/s (of the decompressed data)
+ */
+template<typename F>
+static double run(const std::vector<bench_stream_t>& streams, F&& decompress_func, uint64_t& nb_mismatched){
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    std::vector<std::vector<uint8_t>> outputs(streams.size());
+    uint64_t i, r, total_size = 0;
+    size_t ret;
+    double us = 0;
+
+    for(i=0; i<streams.size(); i++){ outputs[i].resize(streams[i].raw.size()); }
+
+    for(r=0; r<kNbRounds; r++){
+        s_time = std::chrono::steady_clock::now();
+        for(i=0; i<streams.size(); i++){
+            ret = decompress_func(
+                streams[i].compressed.data(), streams[i].compressed.size(), outputs[i].data(), outputs[i].size()
+            );
+            nb_mismatched += ret != streams[i].raw.size();
+        }
+        e_time = std::chrono::steady_clock::now();
+        us += std::chrono::duration<double, std::micro>(e_time - s_time).count();
+
+        for(i=0; i<streams.size(); i++){
+            nb_mismatched += outputs[i] != streams[i].raw;
+            if(r == 0){ total_size += outputs[i].size(); }
+            memset(outputs[i].data(), 0xcc, outputs[i].size());
+        }
+    }
+
+    return (double)(total_size * kNbRounds) / us;
+}
+
+
+/*!
+ *  \brief  feed truncated and corrupted streams, which must be rejected without touching out of the buffers
+ *  \return number of streams that are wrongly accepted
+ */
+static uint64_t run_malformed(const std::vector<bench_stream_t>& streams){
+    std::mt19937_64 rng(0x636f7272);
+    std::vector<uint8_t> input, output;
+    uint64_t i, nb_accepted = 0;
+
+    for(i=0; i<streams.size(); i++){
+        // truncated stream, allocated precisely so that out-of-bounds reads are caught by sanitizers
+        input.assign(
+            streams[i].compressed.begin(), streams[i].compressed.begin() + rng() % (streams[i].compressed.size() - 1)
+        );
+        output.resize(streams[i].raw.size());
+        nb_accepted += POSUtil_CUDA_Fatbin::decompress(
+            input.data(), input.size(), output.data(), output.size()
+        ) == streams[i].raw.size();
+
+        // output buffer too small, the decompression stops at the end of the buffer at most
+        output.resize(streams[i].raw.size() / 2);
+        nb_accepted += POSUtil_CUDA_Fatbin::decompress(
+            streams[i].compressed.data(), streams[i].compressed.size(), output.data(), output.size()
+        ) > output.size();
+
+        // match referring to the data before the output
+        input.assign({ 0x10, 0xaa, 0x08, 0x00, 0x00 });
+        output.resize(64);
+        nb_accepted += POSUtil_CUDA_Fatbin::decompress(input.data(), input.size(), output.data(), output.size()) != 0;
+    }
+
+    return nb_accepted;
+}
+
+
+/*!
+ *  \brief  look up all sections from the section cache, the missed ones are decompressed and stored
+ *  \return time in us
+ */
+static double run_with_section_cache(
+    const std::vector<bench_stream_t>& sections, POSUtil_CUDA_Fatbin_Cache& section_cache, uint64_t& nb_mismatched
+){
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    std::shared_ptr<const std::vector<uint8_t>> text;
+    std::shared_ptr<std::vector<uint8_t>> decompressed_text;
+    std::string key;
+    uint64_t i;
+
+    s_time = std::chrono::steady_clock::now();
+    for(i=0; i<sections.size(); i++){
+        key = POSUtil_CUDA_Fatbin_Cache::key_of(
+            sections[i].compressed.data(), sections[i].compressed.size(), /* is_compressed */ true
+        );
+        if(POS_SUCCESS != section_cache.lookup_text(key, sections[i].raw.size(), text)){
+            decompressed_text = std::make_shared<std::vector<uint8_t>>(sections[i].raw.size());
+            POSUtil_CUDA_Fatbin::decompress(
+                sections[i].compressed.data(), sections[i].compressed.size(),
+                decompressed_text->data(), decompressed_text->size()
+            );
+            text = decompressed_text;
+            section_cache.store_text(key, text);
+        }
+        nb_mismatched += text->size() != sections[i].raw.size();
+    }
+    e_time = std::chrono::steady_clock::now();
+
+    for(i=0; i<sections.size(); i++){
+        key = POSUtil_CUDA_Fatbin_Cache::key_of(
+            sections[i].compressed.data(), sections[i].compressed.size(), /* is_compressed */ true
+        );
+        nb_mismatched += POS_SUCCESS != section_cache.lookup_text(key, sections[i].raw.size(), text)
+                        || *text != sections[i].raw;
+    }
+
+    return std::chrono::duration<double, std::micro>(e_time - s_time).count();
+}
+
+
+int main(int argc, char *argv[]){
+    std::string obj_path, cache_dir;
+    std::vector<uint8_t> nv_fatbin, cubin;
+    std::vector<bench_stream_t> sections, randoms;
+    bench_fat_elf_header_t *elf_hdr;
+    bench_fat_text_header_t *text_hdr;
+    uint64_t nb_mismatched = 0, nb_accepted;
+    uint64_t raw_size = 0, compressed_size = 0;
+    double old_section_mbps, new_section_mbps, old_random_mbps, new_random_mbps;
+    double cold_us, memory_us, spill_us;
+
+    obj_path = argc > 1 ? argv[1] : "../../crc/output.fatbin";
+    cache_dir = argc > 2 ? argv[2] : "/tmp/pos_fatbin_decompress_cache";
+
+    if(!load_nv_fatbin(obj_path, nv_fatbin)){
+        printf("failed to load .nv_fatbin section from %s\n", obj_path.c_str());
+        return 1;
+    }
+
+    // take the first cubin within the fatbin as template
+    elf_hdr = (bench_fat_elf_header_t*)nv_fatbin.data();
+    text_hdr = (bench_fat_text_header_t*)(nv_fatbin.data() + elf_hdr->header_size);
+    if(elf_hdr->magic != FATBIN_TEXT_MAGIC || text_hdr->kind != 2 || (text_hdr->flags & FATBIN_FLAG_COMPRESS)){
+        printf("no uncompressed cubin found within the fatbin of %s\n", obj_path.c_str());
+        return 1;
+    }
+    cubin.assign(
+        (uint8_t*)text_hdr + text_hdr->header_size, (uint8_t*)text_hdr + text_hdr->header_size + text_hdr->size
+    );
+
+    synthesize_streams(cubin, sections, randoms);
+    for(const bench_stream_t& section : sections){
+        raw_size += section.raw.size();
+        compressed_size += section.compressed.size();
+    }
+
+    old_section_mbps = run(sections, decompress_bytewise, nb_mismatched);
+    new_section_mbps = run(sections, POSUtil_CUDA_Fatbin::decompress, nb_mismatched);
+    old_random_mbps = run(randoms, decompress_bytewise, nb_mismatched);
+    new_random_mbps = run(randoms, POSUtil_CUDA_Fatbin::decompress, nb_mismatched);
+    nb_accepted = run_malformed(sections) + run_malformed(randoms);
+
+    // sections decompressed by a daemon are kept in memory, and spilled to files for the next daemon
+    std::filesystem::remove_all(cache_dir);
+    {
+        POSUtil_CUDA_Fatbin_Cache section_cache;
+        section_cache.set_dir(cache_dir);
+        section_cache.set_text_spill(true);
+        cold_us = run_with_section_cache(sections, section_cache, nb_mismatched);
+        memory_us = run_with_section_cache(sections, section_cache, nb_mismatched);
+        section_cache.flush();
+    }
+    {
+        POSUtil_CUDA_Fatbin_Cache section_cache;
+        section_cache.set_dir(cache_dir);
+        section_cache.set_text_spill(true);
+        spill_us = run_with_section_cache(sections, section_cache, nb_mismatched);
+        section_cache.print_metrics();
+    }
+    std::filesystem::remove_all(cache_dir);
+
+    printf(
+        "%lu sections (%lu bytes, compressed to %lu bytes), %lu random streams, %lu mismatched, %lu malformed accepted\n",
+        sections.size(), raw_size, compressed_size, randoms.size(), nb_mismatched, nb_accepted
+    );
+    printf(
+        "sections: bytewise %.0f MB/s, bulk %.0f MB/s, speedup %.2fx\n",
+        old_section_mbps, new_section_mbps, new_section_mbps / old_section_mbps
+    );
+    printf(
+        "random streams: bytewise %.0f MB/s, bulk %.0f MB/s, speedup %.2fx\n",
+        old_random_mbps, new_random_mbps, new_random_mbps / old_random_mbps
+    );
+    printf(
+        "section cache: decompress (cold) %.2f ms, memory hit %.2f ms, spill hit %.2f ms\n",
+        cold_us / 1000, memory_us / 1000, spill_us / 1000
+    );
+
+    return nb_mismatched > 0 || nb_accepted > 0 ? 1 : 0;
+}
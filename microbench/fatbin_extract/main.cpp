@@ -0,0 +1,455 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of extracting kernel metadata from a fatbin while loading a module
+ *  \note   the fatbin is taken from the ".nv_fatbin" section of the host object compiled by nvcc
+ *          (../crc/output.fatbin by default); to mimic the fatbin of a large framework, we replicate its
+ *          cubin into many text sections, rename the kernel within each cubin, compress half of them,
+ *          and duplicate all of them as sections of another architecture; we compare extracting with
+ *          a single thread and with multiple threads, and with the node-wide fatbin cache
+ *          (POSUtil_CUDA_Fatbin_Cache), the results must be identical; we also extract in lazy mode,
+ *          where only the launched kernels are resolved afterwards
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <filesystem>
+
+#include <stdint.h>
+#include <string.h>
+#include <elf.h>
+
+#include "pos/include/common.h"
+#include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
+
+// number of distinct cubins within the synthesized fatbin
+constexpr uint64_t kNbCubins = 2048;
+
+// number of architectures that each cubin is compiled for
+constexpr uint64_t kNbArchs = 2;
+
+// number of rounds to extract
+constexpr uint64_t kNbRounds = 5;
+
+// one out of every kLaunchedKernelStride kernels is launched in lazy mode
+constexpr uint64_t kLaunchedKernelStride = 16;
+
+// the kernel name to be renamed within the cubin, i.e., "crc32" within "_Z12crc32_kernelPKhmPjPKj"
+static const std::string kKernelTag = "crc32";
+
+
+typedef struct __attribute__((__packed__)) bench_fat_elf_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint64_t size;
+} bench_fat_elf_header_t;
+
+typedef struct __attribute__((__packed__)) bench_fat_text_header {
+    uint16_t kind;
+    uint16_t unknown1;
+    uint32_t header_size;
+    uint64_t size;
+    uint32_t compressed_size;
+    uint32_t unknown2;
+    uint16_t minor;
+    uint16_t major;
+    uint32_t arch;
+    uint32_t obj_name_offset;
+    uint32_t obj_name_len;
+    uint64_t flags;
+    uint64_t zero;
+    uint64_t decompressed_size;
+} bench_fat_text_header_t;
+
+
+/*!
+ *  \brief  obtain the content of the ".nv_fatbin" section within a host object
+ */
+static bool load_nv_fatbin(const std::string& path, std::vector<uint8_t>& fatbin){
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> obj;
+    Elf64_Ehdr *ehdr;
+    Elf64_Shdr *shdrs;
+    const char *shstrtab;
+    uint16_t i;
+
+    if(!file.is_open()){ return false; }
+    obj.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if(obj.size() < sizeof(Elf64_Ehdr) || memcmp(obj.data(), ELFMAG, SELFMAG) != 0){ return false; }
+
+    ehdr = (Elf64_Ehdr*)obj.data();
+    shdrs = (Elf64_Shdr*)(obj.data() + ehdr->e_shoff);
+    shstrtab = (const char*)(obj.data() + shdrs[ehdr->e_shstrndx].sh_offset);
+    for(i=0; i<ehdr->e_shnum; i++){
+        if(strcmp(shstrtab + shdrs[i].sh_name, ".nv_fatbin") == 0){
+            fatbin.assign(obj.data() + shdrs[i].sh_offset, obj.data() + shdrs[i].sh_offset + shdrs[i].sh_size);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*!
+ *  \brief  compress the data in the format accepted by POSUtil_CUDA_Fatbin (i.e., LZ4 block)
+ */
+static void compress(const std::vector<uint8_t>& input, std::vector<uint8_t>& output){
+    std::vector<int64_t> table(1 << 16, -1);
+    uint64_t ipos = 0, anchor = 0, match_len, token;
+    int64_t candidate;
+    uint32_t seq;
+
+    auto __put_len = [&](uint64_t len){
+        for(; len >= 0xff; len -= 0xff){ output.push_back(0xff); }
+        output.push_back(len);
+    };
+
+    // a sequence is a token, literals, and a match (offset + length) which is absent for the last sequence
+    auto __put_sequence = [&](uint64_t offset, uint64_t match_len){
+        token = output.size();
+        output.push_back(std::min<uint64_t>(ipos - anchor, 0xf) << 4);
+        if(ipos - anchor >= 0xf){ __put_len(ipos - anchor - 0xf); }
+        output.insert(output.end(), input.begin() + anchor, input.begin() + ipos);
+        if(match_len == 0){ return; }
+        output.push_back(offset & 0xff);
+        output.push_back(offset >> 8);
+        output[token] |= std::min<uint64_t>(match_len - 4, 0xf);
+        if(match_len - 4 >= 0xf){ __put_len(match_len - 4 - 0xf); }
+    };
+
+    output.clear();
+    while(ipos + 4 <= input.size()){
+        memcpy(&seq, &input[ipos], 4);
+        seq = (seq * 2654435761u) >> 16;
+        candidate = table[seq];
+        table[seq] = ipos;
+        if(candidate >= 0 && ipos - candidate <= 0xffff && memcmp(&input[candidate], &input[ipos], 4) == 0){
+            match_len = 4;
+            while(ipos + match_len < input.size() && input[candidate + match_len] == input[ipos + match_len]){
+                match_len++;
+            }
+            __put_sequence(ipos - candidate, match_len);
+            ipos += match_len;
+            anchor = ipos;
+        } else {
+            ipos++;
+        }
+    }
+    ipos = input.size();
+    __put_sequence(0, 0);
+}
+
+
+/*!
+ *  \brief  synthesize a fatbin with many text sections out of a single cubin
+ */
+static void synthesize_fatbin(
+    const bench_fat_text_header_t& template_hdr, const std::vector<uint8_t>& cubin, std::vector<uint64_t>& fatbin
+){
+    std::vector<uint8_t> buffer, renamed, compressed;
+    bench_fat_elf_header_t elf_hdr;
+    bench_fat_text_header_t text_hdr;
+    std::vector<size_t> tag_positions;
+    char tag[8];
+    uint64_t arch, i;
+    size_t pos;
+
+    for(pos=0; pos+kKernelTag.size()<=cubin.size(); pos++){
+        if(memcmp(&cubin[pos], kKernelTag.data(), kKernelTag.size()) == 0){ tag_positions.push_back(pos); }
+    }
+
+    buffer.resize(sizeof(bench_fat_elf_header_t));
+    for(arch=0; arch<kNbArchs; arch++){
+        for(i=0; i<kNbCubins; i++){
+            // rename the kernel (and its sections), while keeping the length of the name
+            renamed = cubin;
+            snprintf(tag, sizeof(tag), "k%04lx", i);
+            for(size_t p : tag_positions){ memcpy(&renamed[p], tag, kKernelTag.size()); }
+
+            text_hdr = template_hdr;
+            text_hdr.arch = template_hdr.arch + arch;
+            if(i % 2 == 1){
+                compress(renamed, compressed);
+                text_hdr.flags |= FATBIN_FLAG_COMPRESS;
+                text_hdr.compressed_size = compressed.size();
+                text_hdr.decompressed_size = renamed.size();
+                compressed.resize((compressed.size() + 7) / 8 * 8, 0);
+                text_hdr.size = compressed.size();
+                renamed = compressed;
+            } else {
+                text_hdr.size = renamed.size();
+            }
+
+            buffer.insert(buffer.end(), (uint8_t*)&text_hdr, (uint8_t*)&text_hdr + sizeof(text_hdr));
+            buffer.insert(buffer.end(), renamed.begin(), renamed.end());
+        }
+    }
+
+    elf_hdr.magic = FATBIN_TEXT_MAGIC;
+    elf_hdr.version = 1;
+    elf_hdr.header_size = sizeof(bench_fat_elf_header_t);
+    elf_hdr.size = buffer.size() - sizeof(bench_fat_elf_header_t);
+    memcpy(buffer.data(), &elf_hdr, sizeof(elf_hdr));
+
+    // keep the fatbin 8-byte aligned, as the padding of compressed sections is aligned by address
+    fatbin.resize((buffer.size() + 7) / 8);
+    memcpy(fatbin.data(), buffer.data(), buffer.size());
+}
+
+
+static double run(
+    std::vector<uint64_t>& fatbin, uint32_t nb_threads, std::vector<POSCudaFunctionDesp*>& desps,
+    bool is_lazy = false
+){
+    POSUtil_CUDA_Kernel_Meta_Cache cached_desp_map;
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    pos_retval_t retval;
+    double duration_us = 0;
+    uint64_t r;
+
+    for(r=0; r<kNbRounds; r++){
+        for(POSCudaFunctionDesp *desp : desps){ delete desp; }
+        desps.clear();
+
+        s_time = std::chrono::steady_clock::now();
+        retval = POSUtil_CUDA_Fatbin::obtain_functions_from_cuda_binary(
+            /* binary_ptr */ (uint8_t*)(fatbin.data()),
+            /* binary_size */ fatbin.size() * sizeof(uint64_t),
+            /* desps */ &desps,
+            /* cached_desp_map */ cached_desp_map,
+            /* fatbin_cache */ nullptr,
+            /* is_lazy */ is_lazy,
+            /* nb_threads */ nb_threads
+        );
+        e_time = std::chrono::steady_clock::now();
+        if(retval != POS_SUCCESS){
+            printf("failed to extract kernels from the fatbin: retval(%d)\n", retval);
+            exit(1);
+        }
+        duration_us += std::chrono::duration<double, std::micro>(e_time - s_time).count();
+    }
+
+    return duration_us / kNbRounds;
+}
+
+
+/*!
+ *  \brief  extract with the node-wide fatbin cache
+ *  \note   the cache is created for each extraction to mimic a newly launched daemon, unless reused
+ *  \param  fatbin_cache    the fatbin cache
+ *  \param  desps           the extracted kernels, which are owned by the cache if hit
+ */
+static double run_with_fatbin_cache(
+    std::vector<uint64_t>& fatbin, uint32_t nb_threads, POSUtil_CUDA_Fatbin_Cache& fatbin_cache,
+    std::vector<POSCudaFunctionDesp*>& desps
+){
+    POSUtil_CUDA_Kernel_Meta_Cache cached_desp_map;
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    pos_retval_t retval;
+
+    s_time = std::chrono::steady_clock::now();
+    retval = POSUtil_CUDA_Fatbin::obtain_functions_from_cuda_binary(
+        /* binary_ptr */ (uint8_t*)(fatbin.data()),
+        /* binary_size */ fatbin.size() * sizeof(uint64_t),
+        /* desps */ &desps,
+        /* cached_desp_map */ cached_desp_map,
+        /* fatbin_cache */ &fatbin_cache,
+        /* is_lazy */ false,
+        /* nb_threads */ nb_threads
+    );
+    e_time = std::chrono::steady_clock::now();
+    if(retval != POS_SUCCESS){
+        printf("failed to extract kernels from the fatbin: retval(%d)\n", retval);
+        exit(1);
+    }
+
+    return std::chrono::duration<double, std::micro>(e_time - s_time).count();
+}
+
+
+static bool is_same(const POSCudaFunctionDesp *a, const POSCudaFunctionDesp *b){
+    return  a->name == b->name && a->signature == b->signature && a->nb_params == b->nb_params
+            && a->param_offsets == b->param_offsets && a->param_sizes == b->param_sizes
+            && a->input_pointer_params == b->input_pointer_params
+            && a->inout_pointer_params == b->inout_pointer_params
+            && a->output_pointer_params == b->output_pointer_params
+            && a->suspicious_params == b->suspicious_params
+            && a->cbank_param_size == b->cbank_param_size && a->is_resolved == b->is_resolved;
+}
+
+
+int main(int argc, char *argv[]){
+    std::string obj_path, cache_dir;
+    std::vector<uint8_t> nv_fatbin, cubin;
+    std::vector<uint64_t> fatbin;
+    std::vector<POSCudaFunctionDesp*> serial_desps, parallel_desps, cold_desps, warm_desps, memory_desps, lazy_desps;
+    std::vector<POSCudaFunctionDesp*> sweep_desps;
+    std::vector<uint32_t> sweep_threads;
+    std::vector<double> sweep_us;
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    bench_fat_elf_header_t *elf_hdr;
+    bench_fat_text_header_t *text_hdr;
+    uint32_t nb_threads, t;
+    uint64_t i, nb_mismatched = 0, nb_launched = 0;
+    double serial_us, parallel_us, cold_us, warm_us, memory_us, lazy_us, resolve_us;
+
+    obj_path = argc > 1 ? argv[1] : "../../crc/output.fatbin";
+    nb_threads = argc > 2 ? std::stoul(argv[2]) : std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    cache_dir = argc > 3 ? argv[3] : "/tmp/pos_fatbin_extract_cache";
+
+    if(!load_nv_fatbin(obj_path, nv_fatbin)){
+        printf("failed to load .nv_fatbin section from %s\n", obj_path.c_str());
+        return 1;
+    }
+
+    // take the first cubin within the fatbin as template
+    elf_hdr = (bench_fat_elf_header_t*)nv_fatbin.data();
+    text_hdr = (bench_fat_text_header_t*)(nv_fatbin.data() + elf_hdr->header_size);
+    if(elf_hdr->magic != FATBIN_TEXT_MAGIC || text_hdr->kind != 2 || (text_hdr->flags & FATBIN_FLAG_COMPRESS)){
+        printf("no uncompressed cubin found within the fatbin of %s\n", obj_path.c_str());
+        return 1;
+    }
+    cubin.assign(
+        (uint8_t*)text_hdr + text_hdr->header_size, (uint8_t*)text_hdr + text_hdr->header_size + text_hdr->size
+    );
+
+    synthesize_fatbin(*text_hdr, cubin, fatbin);
+
+    serial_us = run(fatbin, /* nb_threads */ 1, serial_desps);
+    parallel_us = run(fatbin, nb_threads, parallel_desps);
+
+    // sweep the number of threads below the given one, to show how extraction scales with cores
+    for(t=2; t<nb_threads; t*=2){
+        sweep_threads.push_back(t);
+        sweep_us.push_back(run(fatbin, t, sweep_desps));
+        if(sweep_desps.size() != serial_desps.size()){ nb_mismatched += 1; continue; }
+        for(i=0; i<serial_desps.size(); i++){
+            if(!is_same(serial_desps[i], sweep_desps[i])){ nb_mismatched += 1; }
+        }
+    }
+    for(POSCudaFunctionDesp *desp : sweep_desps){ delete desp; }
+
+    // only the parameter offsets and sizes are indexed in lazy mode, and the launched kernels are resolved
+    lazy_us = run(fatbin, nb_threads, lazy_desps, /* is_lazy */ true);
+    s_time = std::chrono::steady_clock::now();
+    for(i=0; i<lazy_desps.size(); i+=kLaunchedKernelStride){
+        if(lazy_desps[i]->is_resolved){ nb_mismatched += 1; }
+        if(POS_SUCCESS != POSUtil_CUDA_Kernel_Parser::parse_by_prototype(lazy_desps[i]->name.c_str(), lazy_desps[i])){
+            nb_mismatched += 1;
+        }
+        nb_launched += 1;
+    }
+    e_time = std::chrono::steady_clock::now();
+    resolve_us = std::chrono::duration<double, std::micro>(e_time - s_time).count();
+
+    // the first daemon misses the fatbin and stores it, the next daemon loads it from the directory,
+    // and the next module loaded by the same daemon hits it in memory
+    std::filesystem::remove_all(cache_dir);
+    {
+        POSUtil_CUDA_Fatbin_Cache cold_cache, warm_cache;
+        cold_cache.set_dir(cache_dir);
+        cold_us = run_with_fatbin_cache(fatbin, nb_threads, cold_cache, cold_desps);
+        cold_cache.flush();
+        warm_cache.set_dir(cache_dir);
+        warm_us = run_with_fatbin_cache(fatbin, nb_threads, warm_cache, warm_desps);
+        memory_us = run_with_fatbin_cache(fatbin, nb_threads, warm_cache, memory_desps);
+
+        if(cold_desps.size() != serial_desps.size() || warm_desps.size() != serial_desps.size()
+            || memory_desps.size() != serial_desps.size()
+        ){
+            printf(
+                "mismatched number of kernels with fatbin cache: cold(%lu), warm(%lu), memory(%lu)\n",
+                cold_desps.size(), warm_desps.size(), memory_desps.size()
+            );
+            return 1;
+        }
+        for(i=0; i<serial_desps.size(); i++){
+            if(!is_same(serial_desps[i], cold_desps[i])){ nb_mismatched += 1; }
+            if(!is_same(serial_desps[i], warm_desps[i])){ nb_mismatched += 1; }
+            if(!is_same(serial_desps[i], memory_desps[i])){ nb_mismatched += 1; }
+        }
+        warm_cache.print_metrics();
+
+        // kernels hit the cache are owned by the cache
+        for(POSCudaFunctionDesp *desp : cold_desps){ delete desp; }
+    }
+    std::filesystem::remove_all(cache_dir);
+
+    if(serial_desps.size() != kNbCubins || serial_desps.size() != parallel_desps.size()){
+        printf(
+            "mismatched number of kernels: expected(%lu), serial(%lu), parallel(%lu)\n",
+            kNbCubins, serial_desps.size(), parallel_desps.size()
+        );
+        return 1;
+    }
+    for(i=0; i<serial_desps.size(); i++){
+        if(!is_same(serial_desps[i], parallel_desps[i])){ nb_mismatched += 1; }
+    }
+    if(lazy_desps.size() != serial_desps.size()){
+        printf("mismatched number of kernels in lazy mode: expected(%lu), lazy(%lu)\n", kNbCubins, lazy_desps.size());
+        return 1;
+    }
+    for(i=0; i<serial_desps.size(); i++){
+        // the resolved kernels must be identical, and the others must carry the same parameter layout
+        if(i % kLaunchedKernelStride == 0){
+            if(!is_same(serial_desps[i], lazy_desps[i])){ nb_mismatched += 1; }
+        } else if(
+            lazy_desps[i]->is_resolved || lazy_desps[i]->signature.size() > 0
+            || lazy_desps[i]->param_offsets != serial_desps[i]->param_offsets
+            || lazy_desps[i]->param_sizes != serial_desps[i]->param_sizes
+        ){
+            nb_mismatched += 1;
+        }
+    }
+
+    printf(
+        "%lu text sections (%lu bytes), %lu kernels, %lu mismatched: %s\n",
+        kNbCubins * kNbArchs, fatbin.size() * sizeof(uint64_t), serial_desps.size(), nb_mismatched,
+        serial_desps[0]->signature.c_str()
+    );
+    for(i=0; i<sweep_threads.size(); i++){
+        printf(
+            "serial: %.2f ms, %u threads: %.2f ms, speedup %.2fx\n",
+            serial_us / 1000, sweep_threads[i], sweep_us[i] / 1000, serial_us / sweep_us[i]
+        );
+    }
+    printf(
+        "serial: %.2f ms, %u threads: %.2f ms, speedup %.2fx\n",
+        serial_us / 1000, nb_threads, parallel_us / 1000, serial_us / parallel_us
+    );
+    printf(
+        "fatbin cache: cold %.2f ms, warm (new daemon) %.2f ms, warm (in memory) %.2f ms, speedup %.2fx / %.2fx / %.2fx\n",
+        cold_us / 1000, warm_us / 1000, memory_us / 1000,
+        parallel_us / cold_us, parallel_us / warm_us, parallel_us / memory_us
+    );
+    printf(
+        "lazy: %.2f ms, resolving %lu launched kernels: %.2f ms, speedup %.2fx\n",
+        lazy_us / 1000, nb_launched, resolve_us / 1000, parallel_us / (lazy_us + resolve_us)
+    );
+
+    for(POSCudaFunctionDesp *desp : serial_desps){ delete desp; }
+    for(POSCudaFunctionDesp *desp : parallel_desps){ delete desp; }
+    for(POSCudaFunctionDesp *desp : lazy_desps){ delete desp; }
+
+    return nb_mismatched > 0 ? 1 : 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of looking up handles by client-side address, as the parser does
+ *          for each pointer argument of each API
+ *  \note   the trace mimics a training process: a set of long-lived buffers (weights / optimizer states)
+ *          and a pool of short-lived activations that are freed and reallocated every iteration; each
+ *          kernel launch passes kNbPtrArgs pointers, mostly into the buffers of the current layer (so
+ *          consecutive launches reuse the same buffers), with interior offsets as the caching allocator
+ *          of frameworks hands out sub-ranges of large segments; we compare POSUtilAddressIndex with
+ *          the previous std::map lookup (count + operator[] + lower_bound)
+ *  \note   we also replay a random trace within a small address space, where ranges of handles overlap
+ *          (e.g., a lower handle covers the base of another one), both indices must resolve every
+ *          address to the same handle
+ */
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pos/include/common.h"
+#include "pos/include/utils/address_index.h"
+
+constexpr uint64_t kNbIterations = 200;
+constexpr uint64_t kNbLayers = 64;
+constexpr uint64_t kNbLaunchesPerLayer = 32;
+constexpr uint64_t kNbPtrArgs = 6;
+constexpr uint64_t kBaseAddr = 0x7f0000000000ull;
+constexpr uint64_t kNbOverlapOps = 1000000;
+constexpr uint64_t kOverlapSpace = 4096;
+
+// stands for POSHandle, only the range is accessed
+struct bench_handle_t {
+    uint64_t client_addr;
+    uint64_t size;
+};
+
+enum trace_op_type_t { kTraceOp_Alloc = 0, kTraceOp_Free, kTraceOp_Lookup };
+
+struct trace_op_t {
+    trace_op_type_t type;
+    uint64_t addr;
+    bench_handle_t *handle;
+};
+
+
+// the previous lookup within POSHandleManager
+struct map_index_t {
+    std::map<uint64_t, bench_handle_t*> map;
+
+    inline bench_handle_t* lookup(uint64_t addr){
+        std::map<uint64_t, bench_handle_t*>::iterator iter;
+        bench_handle_t *handle;
+
+        if(this->map.count(addr) > 0){ return this->map[addr]; }
+        iter = this->map.lower_bound(addr);
+        if(iter != this->map.begin()){
+            iter--;
+            handle = iter->second;
+            if(handle->client_addr <= addr && addr < handle->client_addr + handle->size){ return handle; }
+        }
+        return nullptr;
+    }
+    inline void insert(bench_handle_t *handle){ this->map[handle->client_addr] = handle; }
+    inline void erase(bench_handle_t *handle){ this->map.erase(handle->client_addr); }
+};
+
+
+// the lookup within POSHandleManager after this change
+struct btree_index_t {
+    POSUtilAddressIndex<bench_handle_t> index;
+
+    inline bench_handle_t* lookup(uint64_t addr){
+        bench_handle_t *handle;
+        uint64_t base, next_base;
+
+        if(likely(nullptr != (handle = this->index.lookup_cache(addr, base)))){ return handle; }
+        handle = this->index.floor(addr, base, next_base);
+        if(handle != nullptr && (base == addr || addr < base + handle->size)){
+            this->index.fill_cache(base, base + handle->size, next_base, handle);
+            return handle;
+        }
+        return nullptr;
+    }
+    inline void insert(bench_handle_t *handle){ this->index.insert(handle->client_addr, handle); }
+    inline void erase(bench_handle_t *handle){ this->index.erase(handle->client_addr); }
+};
+
+
+static void generate_trace(std::vector<trace_op_t>& trace, std::vector<bench_handle_t*>& handles){
+    std::mt19937_64 rng(42);
+    std::vector<bench_handle_t*> weights, activations;
+    bench_handle_t *handle;
+    uint64_t next_addr = kBaseAddr, it, layer, launch, arg, i;
+
+    auto __alloc = [&](uint64_t size) -> bench_handle_t* {
+        bench_handle_t *h = new bench_handle_t();
+        h->client_addr = next_addr;
+        h->size = size;
+        next_addr += (size + 511) & ~511ull;
+        handles.push_back(h);
+        trace.push_back({ kTraceOp_Alloc, h->client_addr, h });
+        return h;
+    };
+
+    // small handles of other resource types share the manager in some cases (e.g., events, streams)
+    for(i=0; i<256; i++){ __alloc(512); }
+
+    // weights, grads and optimizer states of each layer
+    for(layer=0; layer<kNbLayers; layer++){
+        for(i=0; i<4; i++){ weights.push_back(__alloc((1 + rng() % 64) << 20)); }
+    }
+
+    for(it=0; it<kNbIterations; it++){
+        // activations are reallocated every iteration
+        for(layer=0; layer<kNbLayers; layer++){
+            for(i=0; i<3; i++){ activations.push_back(__alloc((1 + rng() % 16) << 20)); }
+        }
+
+        for(layer=0; layer<kNbLayers; layer++){
+            for(launch=0; launch<kNbLaunchesPerLayer; launch++){
+                for(arg=0; arg<kNbPtrArgs; arg++){
+                    // mostly buffers of the current layer, sometimes buffers of any layer
+                    if(rng() % 8 != 0){
+                        handle = arg % 2 == 0   ? weights[layer * 4 + rng() % 4]
+                                                : activations[layer * 3 + rng() % 3];
+                    } else {
+                        handle = rng() % 2 == 0 ? weights[rng() % weights.size()]
+                                                : activations[rng() % activations.size()];
+                    }
+                    trace.push_back({ kTraceOp_Lookup, handle->client_addr + (rng() % handle->size) / 256 * 256, nullptr });
+                }
+            }
+        }
+
+        for(bench_handle_t *h : activations){ trace.push_back({ kTraceOp_Free, h->client_addr, h }); }
+        activations.clear();
+    }
+}
+
+
+static void generate_overlap_trace(std::vector<trace_op_t>& trace, std::vector<bench_handle_t*>& handles){
+    std::mt19937_64 rng(42);
+    std::vector<bench_handle_t*> alive;
+    bench_handle_t *handle;
+    uint64_t i, j;
+
+    for(i=0; i<kNbOverlapOps; i++){
+        switch(rng() % 4){
+        case 0:
+            handle = new bench_handle_t();
+            handle->client_addr = kBaseAddr + rng() % kOverlapSpace;
+            handle->size = 1 + rng() % 64;
+            handles.push_back(handle);
+            alive.push_back(handle);
+            trace.push_back({ kTraceOp_Alloc, handle->client_addr, handle });
+            break;
+        case 1:
+            if(alive.empty()){ break; }
+            j = rng() % alive.size();
+            trace.push_back({ kTraceOp_Free, alive[j]->client_addr, alive[j] });
+            alive[j] = alive.back();
+            alive.pop_back();
+            break;
+        default:
+            trace.push_back({ kTraceOp_Lookup, kBaseAddr + rng() % kOverlapSpace, nullptr });
+            break;
+        }
+    }
+}
+
+
+template<typename T_Index>
+static double run(const std::vector<trace_op_t>& trace, uint64_t& nb_lookups, uint64_t& checksum){
+    T_Index index;
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    bench_handle_t *handle;
+
+    nb_lookups = 0;
+    checksum = 0;
+
+    s_time = std::chrono::steady_clock::now();
+    for(const trace_op_t& op : trace){
+        switch(op.type){
+        case kTraceOp_Alloc:
+            index.insert(op.handle);
+            break;
+        case kTraceOp_Free:
+            index.erase(op.handle);
+            break;
+        case kTraceOp_Lookup:
+            handle = index.lookup(op.addr);
+            checksum = checksum * 1000003 + (handle != nullptr ? op.addr - handle->client_addr + 1 : 0);
+            nb_lookups += 1;
+            break;
+        }
+    }
+    e_time = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(e_time - s_time).count();
+}
+
+
+int main(){
+    std::vector<trace_op_t> trace;
+    std::vector<bench_handle_t*> handles;
+    uint64_t nb_lookups, map_checksum, btree_checksum;
+    double map_ns, btree_ns;
+
+    generate_trace(trace, handles);
+
+    map_ns = run<map_index_t>(trace, nb_lookups, map_checksum);
+    btree_ns = run<btree_index_t>(trace, nb_lookups, btree_checksum);
+    if(map_checksum != btree_checksum){
+        printf("mismatched lookup results: map(%lu), btree(%lu)\n", map_checksum, btree_checksum);
+        return 1;
+    }
+
+    printf(
+        "%lu ops (%lu lookups, %lu handles): map %.2f ns/op, btree %.2f ns/op, speedup %.2fx\n",
+        trace.size(), nb_lookups, handles.size(),
+        map_ns / trace.size(), btree_ns / trace.size(), map_ns / btree_ns
+    );
+
+    trace.clear();
+    generate_overlap_trace(trace, handles);
+
+    map_ns = run<map_index_t>(trace, nb_lookups, map_checksum);
+    btree_ns = run<btree_index_t>(trace, nb_lookups, btree_checksum);
+    if(map_checksum != btree_checksum){
+        printf("mismatched lookup results of overlapped handles: map(%lu), btree(%lu)\n", map_checksum, btree_checksum);
+        return 1;
+    }
+
+    printf(
+        "%lu ops (%lu lookups) over overlapped handles: map %.2f ns/op, btree %.2f ns/op\n",
+        trace.size(), nb_lookups, map_ns / trace.size(), btree_ns / trace.size()
+    );
+
+    for(bench_handle_t *h : handles){ delete h; }
+
+    return 0;
+}
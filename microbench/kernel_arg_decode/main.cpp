@@ -0,0 +1,470 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of decoding the pointer arguments of kernel launches, as the parser of
+ *          cudaLaunchKernel does for every launch
+ *  \note   the trace mimics the launches of a training process with small kernels: elementwise kernels
+ *          taking a few tensors, and kernels taking structs that carry pointers inside (e.g., the
+ *          at::detail::Array<char*, N> of TensorIterator), whose arguments point into the buffers of the
+ *          current layer at interior offsets, with some nullptr and unknown pointers; we compare the
+ *          previous path (walking the parameter lists of each direction and looking up each pointer)
+ *          with the argument cache (POSUtil_CUDA_Kernel_Arg_Cache), both must record the same handle views
+ *  \note   the trace is replayed for rounds like the steps of an inference loop, so launches repeat their
+ *          pointers across rounds; we also replay it with malloc / free in every layer, which invalidates
+ *          the cached entries, so the argument cache should be bypassed
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pos/include/common.h"
+#include "pos/include/utils/address_index.h"
+#include "pos/cuda_impl/utils/kernel_arg_cache.h"
+
+constexpr uint64_t kNbKernels = 256;
+constexpr uint64_t kNbLayers = 64;
+constexpr uint64_t kNbLaunchesPerLayer = 64;
+constexpr uint64_t kNbRounds = 20;
+
+// number of times to repeat each replay, interleaved with the others, and the fastest one is taken
+constexpr uint64_t kNbRepeats = 5;
+constexpr uint64_t kBaseAddr = 0x7f0000000000ull;
+
+// stands for POSHandle_CUDA_Memory, only the range is accessed
+struct bench_handle_t {
+    uint64_t client_addr;
+    uint64_t size;
+};
+
+// stands for POSHandle_CUDA_Function, only the parameter directions are accessed
+struct bench_kernel_t {
+    std::vector<uint32_t> param_offsets;
+    std::vector<uint32_t> param_sizes;
+    std::vector<uint32_t> input_pointer_params;
+    std::vector<uint32_t> inout_pointer_params;
+    std::vector<uint32_t> output_pointer_params;
+    std::vector<std::pair<uint32_t,uint64_t>> confirmed_suspicious_params;
+    POSUtil_CUDA_Kernel_Arg_Cache<bench_handle_t> arg_cache;
+};
+
+// a recorded launch: the kernel and its packed arguments
+struct bench_launch_t {
+    bench_kernel_t *kernel;
+    std::vector<uint8_t> args;
+};
+
+// stands for the handle views recorded to the WQE
+struct bench_view_t {
+    bench_handle_t *handle;
+    uint64_t param_index;
+    uint64_t offset;
+    bool operator==(const bench_view_t& other) const {
+        return handle == other.handle && param_index == other.param_index && offset == other.offset;
+    }
+};
+
+struct bench_wqe_t {
+    std::vector<bench_view_t> input_views;
+    std::vector<bench_view_t> inout_views;
+    std::vector<bench_view_t> output_views;
+    std::vector<bench_handle_t*> modified_handles;
+
+    inline void clear(){
+        this->input_views.clear();
+        this->inout_views.clear();
+        this->output_views.clear();
+        this->modified_handles.clear();
+    }
+};
+
+
+// stands for POSHandleManager_CUDA_Memory
+struct bench_hm_t {
+    POSUtilAddressIndex<bench_handle_t> index;
+
+    // same as POSHandleManager::get_address_generation, bumped by the trace to mimic malloc / free
+    uint64_t generation = 0;
+
+    // same as POSHandleManager::get_handle_by_client_addr
+    inline pos_retval_t get_handle_by_client_addr(void* client_addr, bench_handle_t** handle, uint64_t* offset){
+        uint64_t base, addr = (uint64_t)(client_addr);
+        bench_handle_t *handle_ptr;
+
+        if(likely(nullptr != (handle_ptr = this->index.lookup_cache(addr, base)))){
+            *handle = handle_ptr;
+            *offset = addr - base;
+            return POS_SUCCESS;
+        }
+        handle_ptr = this->index.floor(addr, base);
+        if(handle_ptr != nullptr && (base == addr || addr < base + handle_ptr->size)){
+            this->index.fill_cache(base, base + handle_ptr->size, handle_ptr);
+            *handle = handle_ptr;
+            *offset = addr - base;
+            return POS_SUCCESS;
+        }
+        *handle = nullptr;
+        return POS_FAILED_NOT_EXIST;
+    }
+};
+
+
+/*!
+ *  \brief  synthesize kernels, buffers and the launches
+ */
+static void generate_trace(
+    std::vector<bench_kernel_t*>& kernels, std::vector<bench_handle_t*>& handles, std::vector<bench_launch_t>& trace,
+    bench_hm_t& hm
+){
+    std::mt19937_64 rng(0x6b617267);
+    std::vector<std::vector<uint64_t>> pointer_slots(kNbKernels);
+    bench_kernel_t *kernel;
+    bench_handle_t *handle;
+    uint64_t next_addr = kBaseAddr, i, j, k, nb_params, offset, align, layer, launch, value;
+
+    for(i=0; i<kNbLayers * 6; i++){
+        handle = new bench_handle_t();
+        handle->client_addr = next_addr;
+        handle->size = (1 + rng() % 16) << 20;
+        next_addr += (handle->size + 511) & ~511ull;
+        hm.index.insert(handle->client_addr, handle);
+        handles.push_back(handle);
+    }
+
+    for(i=0; i<kNbKernels; i++){
+        kernel = new bench_kernel_t();
+        nb_params = 2 + rng() % 8;
+        for(j=0, offset=0; j<nb_params; j++){
+            switch(rng() % 6){
+            case 0: case 1:
+                kernel->input_pointer_params.push_back(j);
+                kernel->param_sizes.push_back(8);
+                break;
+            case 2:
+                kernel->output_pointer_params.push_back(j);
+                kernel->param_sizes.push_back(8);
+                break;
+            case 3:
+                kernel->inout_pointer_params.push_back(j);
+                kernel->param_sizes.push_back(8);
+                break;
+            case 4:
+                // struct carrying 2~4 pointers, e.g., at::detail::Array<char*, N>
+                kernel->param_sizes.push_back(8 * (2 + rng() % 3));
+                for(k=0; k<kernel->param_sizes.back(); k+=8){ kernel->confirmed_suspicious_params.push_back({ j, k }); }
+                break;
+            default:
+                kernel->param_sizes.push_back(rng() % 2 ? 4 : 8);
+                break;
+            }
+            // parameters are aligned to their sizes (8 at most)
+            align = std::min<uint64_t>(kernel->param_sizes.back(), 8);
+            offset = (offset + align - 1) / align * align;
+            kernel->param_offsets.push_back(offset);
+            offset += kernel->param_sizes.back();
+        }
+        for(uint32_t p : kernel->input_pointer_params){ pointer_slots[i].push_back(kernel->param_offsets[p]); }
+        for(uint32_t p : kernel->inout_pointer_params){ pointer_slots[i].push_back(kernel->param_offsets[p]); }
+        for(uint32_t p : kernel->output_pointer_params){ pointer_slots[i].push_back(kernel->param_offsets[p]); }
+        for(auto& p : kernel->confirmed_suspicious_params){
+            pointer_slots[i].push_back(kernel->param_offsets[p.first] + p.second);
+        }
+        kernels.push_back(kernel);
+    }
+
+    for(layer=0; layer<kNbLayers; layer++){
+        for(launch=0; launch<kNbLaunchesPerLayer; launch++){
+            trace.emplace_back();
+            i = rng() % kNbKernels;
+            trace.back().kernel = kernels[i];
+            trace.back().args.resize(kernels[i]->param_offsets.back() + kernels[i]->param_sizes.back());
+            for(j=0; j<trace.back().args.size(); j++){ trace.back().args[j] = rng(); }
+            for(uint64_t slot : pointer_slots[i]){
+                // mostly buffers of the current layer, sometimes nullptr or memory not managed by us
+                switch(rng() % 16){
+                case 0:
+                    value = 0;
+                    break;
+                case 1:
+                    value = 0x10000 + rng() % 0x10000;
+                    break;
+                default:
+                    handle = handles[layer * 6 + rng() % 6];
+                    value = handle->client_addr + (rng() % handle->size) / 256 * 256;
+                    break;
+                }
+                memcpy(&trace.back().args[slot], &value, sizeof(value));
+            }
+        }
+    }
+}
+
+
+/*!
+ *  \brief  the previous path within the parser of cudaLaunchKernel
+ */
+static inline void decode_by_param_lists(const bench_launch_t& launch, bench_hm_t& hm, bench_wqe_t& wqe){
+    const bench_kernel_t *kernel = launch.kernel;
+    const uint8_t *args = launch.args.data();
+    bench_handle_t *handle;
+    uint64_t i, param_index, struct_offset, offset;
+    void *arg_value;
+
+    auto __record = [&](std::vector<bench_view_t>& views, bool is_modified){
+        if(unlikely(arg_value == nullptr)){ return; }
+        if(unlikely(POS_SUCCESS != hm.get_handle_by_client_addr(arg_value, &handle, &offset))){ return; }
+        views.push_back({ handle, param_index, (uint64_t)(arg_value) - handle->client_addr });
+        if(is_modified){ wqe.modified_handles.push_back(handle); }
+    };
+
+    for(i=0; i<kernel->input_pointer_params.size(); i++){
+        param_index = kernel->input_pointer_params[i];
+        arg_value = *((void**)(args + kernel->param_offsets[param_index]));
+        __record(wqe.input_views, false);
+    }
+    for(i=0; i<kernel->inout_pointer_params.size(); i++){
+        param_index = kernel->inout_pointer_params[i];
+        arg_value = *((void**)(args + kernel->param_offsets[param_index]));
+        __record(wqe.inout_views, true);
+    }
+    for(i=0; i<kernel->output_pointer_params.size(); i++){
+        param_index = kernel->output_pointer_params[i];
+        arg_value = *((void**)(args + kernel->param_offsets[param_index]));
+        __record(wqe.output_views, true);
+    }
+    for(i=0; i<kernel->confirmed_suspicious_params.size(); i++){
+        param_index = kernel->confirmed_suspicious_params[i].first;
+        struct_offset = kernel->confirmed_suspicious_params[i].second;
+        arg_value = *((void**)(args + kernel->param_offsets[param_index] + struct_offset));
+        __record(wqe.inout_views, true);
+    }
+}
+
+
+/*!
+ *  \brief  the path with the argument cache, same as the parser of cudaLaunchKernel
+ */
+static inline void decode_by_arg_cache(const bench_launch_t& launch, bench_hm_t& hm, bench_wqe_t& wqe){
+    using cache_t = POSUtil_CUDA_Kernel_Arg_Cache<bench_handle_t>;
+    bench_kernel_t *kernel = launch.kernel;
+    const uint8_t *args = launch.args.data();
+    const cache_t::pos_kernel_arg_cache_entry_t *entry = nullptr;
+    cache_t::pos_kernel_arg_cache_entry_t *new_entry;
+    bench_handle_t *handle;
+    void **values, *value;
+    uint64_t i, k, nb_values, offset;
+
+    // either read from the entry, or look up directly if the cache is bypassed
+    auto __resolve = [&](uint64_t k, uint64_t arg_offset) -> bool {
+        if(likely(entry != nullptr)){
+            handle = entry->handles()[k];
+            offset = entry->offsets()[k];
+            return handle != nullptr;
+        }
+        value = *((void**)(args + arg_offset));
+        if(unlikely(value == nullptr)){ return false; }
+        return POS_SUCCESS == hm.get_handle_by_client_addr(value, &handle, &offset);
+    };
+
+    if(likely(kernel->arg_cache.arm(hm.generation))){
+        nb_values = kernel->input_pointer_params.size() + kernel->inout_pointer_params.size()
+                    + kernel->output_pointer_params.size() + kernel->confirmed_suspicious_params.size();
+        values = kernel->arg_cache.prepare_key(nb_values);
+        k = 0;
+        for(uint32_t p : kernel->input_pointer_params){ values[k++] = *((void**)(args + kernel->param_offsets[p])); }
+        for(uint32_t p : kernel->inout_pointer_params){ values[k++] = *((void**)(args + kernel->param_offsets[p])); }
+        for(auto& p : kernel->confirmed_suspicious_params){
+            values[k++] = *((void**)(args + kernel->param_offsets[p.first] + p.second));
+        }
+        for(uint32_t p : kernel->output_pointer_params){ values[k++] = *((void**)(args + kernel->param_offsets[p])); }
+
+        entry = kernel->arg_cache.lookup(hm.generation);
+        if(unlikely(entry == nullptr)){
+            new_entry = kernel->arg_cache.insert(hm.generation);
+            for(k=0; k<nb_values; k++){
+                if(unlikely(values[k] == nullptr)){ new_entry->handles()[k] = nullptr; continue; }
+                hm.get_handle_by_client_addr(values[k], &new_entry->handles()[k], &new_entry->offsets()[k]);
+            }
+            entry = new_entry;
+        }
+    }
+
+    k = 0;
+    for(i=0; i<kernel->input_pointer_params.size(); i++, k++){
+        if(unlikely(!__resolve(k, kernel->param_offsets[kernel->input_pointer_params[i]]))){ continue; }
+        wqe.input_views.push_back({ handle, kernel->input_pointer_params[i], offset });
+    }
+    for(i=0; i<kernel->inout_pointer_params.size(); i++, k++){
+        if(unlikely(!__resolve(k, kernel->param_offsets[kernel->inout_pointer_params[i]]))){ continue; }
+        wqe.inout_views.push_back({ handle, kernel->inout_pointer_params[i], offset });
+        wqe.modified_handles.push_back(handle);
+    }
+    for(i=0; i<kernel->confirmed_suspicious_params.size(); i++, k++){
+        if(unlikely(!__resolve(
+            k, kernel->param_offsets[kernel->confirmed_suspicious_params[i].first] + kernel->confirmed_suspicious_params[i].second
+        ))){
+            continue;
+        }
+        wqe.inout_views.push_back({ handle, kernel->confirmed_suspicious_params[i].first, offset });
+        wqe.modified_handles.push_back(handle);
+    }
+    for(i=0; i<kernel->output_pointer_params.size(); i++, k++){
+        if(unlikely(!__resolve(k, kernel->param_offsets[kernel->output_pointer_params[i]]))){ continue; }
+        wqe.output_views.push_back({ handle, kernel->output_pointer_params[i], offset });
+        wqe.modified_handles.push_back(handle);
+    }
+}
+
+
+using cache_metrics_t = POSUtil_CUDA_Kernel_Arg_Cache<bench_handle_t>::pos_kernel_arg_cache_metrics_t;
+
+static cache_metrics_t sum_cache_metrics(const std::vector<bench_kernel_t*>& kernels){
+    cache_metrics_t metrics = { 0, 0, 0, 0 };
+
+    for(const bench_kernel_t *kernel : kernels){
+        metrics.nb_hits += kernel->arg_cache.get_metrics().nb_hits;
+        metrics.nb_misses += kernel->arg_cache.get_metrics().nb_misses;
+        metrics.nb_bypasses += kernel->arg_cache.get_metrics().nb_bypasses;
+        metrics.nb_invalidations += kernel->arg_cache.get_metrics().nb_invalidations;
+    }
+
+    return metrics;
+}
+
+
+/*!
+ *  \brief  replay the trace for rounds, after an untimed round to warm up the caches
+ *  \param  kernels         the kernels, whose argument cache counters are collected
+ *  \param  metrics         the argument cache counters of the timed rounds
+ *  \param  malloc_interval bump the generation of the address map every this number of launches, to mimic
+ *                          malloc / free in between (0 for never)
+ */
+template<typename F>
+static double run(
+    const std::vector<bench_launch_t>& trace, bench_hm_t& hm, F&& decode_func, std::vector<bench_wqe_t>& wqes,
+    const std::vector<bench_kernel_t*>& kernels, cache_metrics_t& metrics, uint64_t malloc_interval = 0
+){
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    cache_metrics_t warm_metrics;
+    uint64_t r, i;
+    double ns = 0;
+
+    wqes.resize(trace.size());
+    for(i=0; i<trace.size(); i++){
+        if(malloc_interval > 0 && i % malloc_interval == 0){ hm.generation += 1; }
+        decode_func(trace[i], hm, wqes[i]);
+    }
+    warm_metrics = sum_cache_metrics(kernels);
+
+    for(r=0; r<kNbRounds; r++){
+        for(bench_wqe_t& wqe : wqes){ wqe.clear(); }
+        s_time = std::chrono::steady_clock::now();
+        for(i=0; i<trace.size(); i++){
+            if(malloc_interval > 0 && i % malloc_interval == 0){ hm.generation += 1; }
+            decode_func(trace[i], hm, wqes[i]);
+        }
+        e_time = std::chrono::steady_clock::now();
+        ns += std::chrono::duration<double, std::nano>(e_time - s_time).count();
+    }
+
+    metrics = sum_cache_metrics(kernels);
+    metrics.nb_hits -= warm_metrics.nb_hits;
+    metrics.nb_misses -= warm_metrics.nb_misses;
+    metrics.nb_bypasses -= warm_metrics.nb_bypasses;
+    metrics.nb_invalidations -= warm_metrics.nb_invalidations;
+
+    return ns / kNbRounds / trace.size();
+}
+
+
+static uint64_t compare(std::vector<bench_wqe_t>& expected_wqes, std::vector<bench_wqe_t>& wqes){
+    uint64_t i, nb_mismatched = 0;
+
+    for(i=0; i<expected_wqes.size(); i++){
+        // modified handles are recorded into a set by the handle manager, so the order doesn't matter
+        std::sort(expected_wqes[i].modified_handles.begin(), expected_wqes[i].modified_handles.end());
+        std::sort(wqes[i].modified_handles.begin(), wqes[i].modified_handles.end());
+        nb_mismatched += expected_wqes[i].input_views != wqes[i].input_views
+                        || expected_wqes[i].inout_views != wqes[i].inout_views
+                        || expected_wqes[i].output_views != wqes[i].output_views
+                        || expected_wqes[i].modified_handles != wqes[i].modified_handles;
+    }
+
+    return nb_mismatched;
+}
+
+
+static void print_cache_metrics(const char* name, double ns, double list_ns, const cache_metrics_t& metrics){
+    printf(
+        "%s: %.2f ns/launch, speedup %.2fx, hit rate %.2f%% (%lu hits, %lu misses, %lu bypasses, %lu invalidations)\n",
+        name, ns, list_ns / ns,
+        100.0 * metrics.nb_hits / std::max<uint64_t>(metrics.nb_hits + metrics.nb_misses + metrics.nb_bypasses, 1),
+        metrics.nb_hits, metrics.nb_misses, metrics.nb_bypasses, metrics.nb_invalidations
+    );
+}
+
+
+int main(){
+    std::vector<bench_kernel_t*> kernels;
+    std::vector<bench_handle_t*> handles;
+    std::vector<bench_launch_t> trace;
+    std::vector<bench_wqe_t> list_wqes, steady_wqes, malloc_list_wqes, malloc_wqes;
+    bench_hm_t hm;
+    uint64_t r, nb_mismatched = 0, nb_views = 0;
+    double list_ns = 1e18, steady_ns = 1e18, malloc_list_ns = 1e18, malloc_ns = 1e18;
+    cache_metrics_t list_metrics, steady_metrics, malloc_metrics;
+
+    generate_trace(kernels, handles, trace, hm);
+
+    // the previous path is replayed with malloc per layer as well, so that both are compared under the same trace
+    for(r=0; r<kNbRepeats; r++){
+        list_ns = std::min(list_ns, run(trace, hm, decode_by_param_lists, list_wqes, kernels, list_metrics));
+        steady_ns = std::min(steady_ns, run(trace, hm, decode_by_arg_cache, steady_wqes, kernels, steady_metrics));
+        malloc_list_ns = std::min(malloc_list_ns, run(
+            trace, hm, decode_by_param_lists, malloc_list_wqes, kernels, list_metrics, kNbLaunchesPerLayer
+        ));
+        malloc_ns = std::min(malloc_ns, run(
+            trace, hm, decode_by_arg_cache, malloc_wqes, kernels, malloc_metrics, kNbLaunchesPerLayer
+        ));
+    }
+
+    for(bench_wqe_t& wqe : list_wqes){
+        nb_views += wqe.input_views.size() + wqe.inout_views.size() + wqe.output_views.size();
+    }
+    nb_mismatched += compare(list_wqes, steady_wqes);
+    nb_mismatched += compare(list_wqes, malloc_list_wqes);
+    nb_mismatched += compare(list_wqes, malloc_wqes);
+
+    printf(
+        "%lu launches of %lu kernels (%lu handle views), %lu mismatched\n",
+        trace.size(), kernels.size(), nb_views, nb_mismatched
+    );
+    printf("param lists (steady): %.2f ns/launch\n", list_ns);
+    print_cache_metrics("argument cache (steady)", steady_ns, list_ns, steady_metrics);
+    printf("param lists (malloc per layer): %.2f ns/launch\n", malloc_list_ns);
+    print_cache_metrics("argument cache (malloc per layer)", malloc_ns, malloc_list_ns, malloc_metrics);
+
+    for(bench_kernel_t *kernel : kernels){ delete kernel; }
+    for(bench_handle_t *handle : handles){ delete handle; }
+
+    return nb_mismatched > 0 ? 1 : 0;
+}
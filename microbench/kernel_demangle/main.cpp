@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of obtaining the prototype of kernels while loading a module
+ *  \note   for each mangled name within the corpus, we compare forking the demangler binary
+ *          (cu++filt by default, as POSUtil_CUDA_Kernel_Parser did for each kernel) with demangling
+ *          and classifying the parameters in-process (POSUtil_Demangle); the in-process prototype
+ *          must be identical to the output of the binary when the binary is c++filt
+ */
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/utils/command_caller.h"
+#include "pos/include/utils/demangle.h"
+
+// number of kernels of a module to be loaded, e.g., libtorch_cuda contains tens of thousands of kernels
+constexpr uint64_t kNbKernels = 20000;
+
+
+int main(int argc, char *argv[]){
+    std::string corpus_path, demangler, name, cmd, prototype, forked_prototype;
+    std::vector<std::string> names, params;
+    std::ifstream corpus;
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    pos_demangle_param_kind_t kind;
+    uint64_t i, j, nb_pointers = 0, nb_const_pointers = 0, nb_unclassified = 0, nb_mismatched = 0;
+    double fork_us, inproc_us;
+
+    corpus_path = argc > 1 ? argv[1] : "../corpus.txt";
+    demangler = argc > 2 ? argv[2] : "cu++filt";
+
+    corpus.open(corpus_path);
+    if(!corpus.is_open()){
+        printf("failed to open corpus: %s\n", corpus_path.c_str());
+        return 1;
+    }
+    while(std::getline(corpus, name)){
+        if(name.size() > 0){ names.push_back(name); }
+    }
+
+    // fork the demangler for each name within the corpus once, it's too slow to run for all kernels
+    s_time = std::chrono::steady_clock::now();
+    for(i=0; i<names.size(); i++){
+        cmd = demangler + " " + names[i];
+        if(unlikely(POS_SUCCESS != POSUtil_Command_Caller::exec_sync(
+            cmd, forked_prototype,
+            /* ignore_error */ false, /* print_stdout */ false, /* print_stderr */ false
+        ))){
+            printf("failed to execute %s\n", demangler.c_str());
+            return 1;
+        }
+        if(POS_SUCCESS != POSUtil_Demangle::demangle(names[i], prototype)){ prototype = names[i]; }
+        while(forked_prototype.size() > 0 && forked_prototype.back() == '\n'){ forked_prototype.pop_back(); }
+        if(demangler == "c++filt" && forked_prototype != prototype){
+            printf("mismatched prototype:\n  %s\n  %s\n", forked_prototype.c_str(), prototype.c_str());
+            nb_mismatched += 1;
+        }
+    }
+    e_time = std::chrono::steady_clock::now();
+    fork_us = std::chrono::duration<double, std::micro>(e_time - s_time).count() / names.size();
+
+    // in-process demangling and classification for all kernels
+    s_time = std::chrono::steady_clock::now();
+    for(i=0; i<kNbKernels; i++){
+        if(POS_SUCCESS != POSUtil_Demangle::demangle(names[i % names.size()], prototype)){ continue; }
+        if(POS_SUCCESS != POSUtil_Demangle::split_params(prototype, params)){
+            nb_unclassified += 1;
+            continue;
+        }
+        for(j=0; j<params.size(); j++){
+            if(POS_SUCCESS != POSUtil_Demangle::classify_param(params[j], kind)){
+                nb_unclassified += 1;
+                break;
+            }
+            nb_pointers += kind != kPOS_DemangleParam_Value;
+            nb_const_pointers += kind == kPOS_DemangleParam_ConstPointer;
+        }
+    }
+    e_time = std::chrono::steady_clock::now();
+    inproc_us = std::chrono::duration<double, std::micro>(e_time - s_time).count() / kNbKernels;
+
+    printf(
+        "%lu names in corpus, %lu mismatched prototypes, %lu kernels: "
+        "pointer params %lu (const %lu), unclassified kernels %lu\n",
+        names.size(), nb_mismatched, kNbKernels, nb_pointers, nb_const_pointers, nb_unclassified
+    );
+    printf(
+        "fork %s: %.2f us/kernel (%.2f s for %lu kernels), in-process: %.2f us/kernel (%.4f s), speedup %.0fx\n",
+        demangler.c_str(), fork_us, fork_us * kNbKernels / 1e6, kNbKernels,
+        inproc_us, inproc_us * kNbKernels / 1e6, fork_us / inproc_us
+    );
+
+    return nb_mismatched > 0 ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*!
+ *  \brief  CPU-only microbenchmark of loading the kernel metadata dumped by previous runs
+ *  \note   we synthesize the metadata of many kernels, dump them as text ('|'-delimited) and as binary,
+ *          then compare parsing the text file with mmap-ing the binary file; the kernels looked up from
+ *          the binary file must be identical to the synthesized ones
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include "pos/include/common.h"
+#include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/kernel_meta_cache.h"
+
+// number of kernels, e.g., libtorch_cuda contains tens of thousands of kernels
+constexpr uint64_t kNbKernels = 50000;
+
+// number of kernels that a typical run launches
+constexpr uint64_t kNbHitKernels = 2000;
+
+
+static void synthesize(std::vector<POSCudaFunctionDesp*>& desps){
+    std::mt19937_64 rng(0x706f73);
+    POSCudaFunctionDesp *desp;
+    uint64_t i, j, offset;
+    char name[128];
+
+    for(i=0; i<kNbKernels; i++){
+        POS_CHECK_POINTER(desp = new POSCudaFunctionDesp_t());
+
+        snprintf(
+            name, sizeof(name),
+            "_ZN2at6native29vectorized_elementwise_kernelILi4EN%lu_GLOBAL__N_18functorEJNS_6detail5ArrayIPcLi%luEEEEEvi",
+            i, i % 7 + 2
+        );
+        desp->name = name;
+        desp->signature = std::string("void at::native::vectorized_elementwise_kernel<4, functor") + std::to_string(i)
+                        + std::string(">(int, at::detail::Array<char*, ") + std::to_string(i % 7 + 2) + std::string(">)");
+
+        desp->nb_params = rng() % 12;
+        for(j=0, offset=0; j<desp->nb_params; j++){
+            desp->param_offsets.push_back(offset);
+            desp->param_sizes.push_back(rng() % 2 ? 8 : 4);
+            offset += desp->param_sizes.back();
+            switch(rng() % 4){
+                case 0: desp->input_pointer_params.push_back(j); break;
+                case 1: desp->output_pointer_params.push_back(j); break;
+                case 2: desp->inout_pointer_params.push_back(j); break;
+                default: desp->suspicious_params.push_back(j); break;
+            }
+        }
+
+        desp->has_verified_params = rng() % 2;
+        if(desp->has_verified_params){
+            for(j=0; j<desp->suspicious_params.size(); j++){
+                desp->confirmed_suspicious_params.push_back({ desp->suspicious_params[j], (rng() % 8) * 8 });
+            }
+        }
+        desp->cbank_param_size = 0x160 + offset;
+
+        desps.push_back(desp);
+    }
+}
+
+
+static bool is_same(const POSCudaFunctionDesp *a, const POSCudaFunctionDesp *b){
+    return a->name == b->name && a->signature == b->signature && a->nb_params == b->nb_params
+        && a->param_offsets == b->param_offsets && a->param_sizes == b->param_sizes
+        && a->input_pointer_params == b->input_pointer_params
+        && a->output_pointer_params == b->output_pointer_params
+        && a->inout_pointer_params == b->inout_pointer_params
+        && a->suspicious_params == b->suspicious_params
+        && a->has_verified_params == b->has_verified_params
+        && a->confirmed_suspicious_params == b->confirmed_suspicious_params
+        && a->cbank_param_size == b->cbank_param_size;
+}
+
+
+static std::string read_file(const std::string& file_path){
+    std::ifstream file(file_path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+
+int main(int argc, char *argv[]){
+    std::vector<POSCudaFunctionDesp*> desps, collected_desps;
+    std::string dir, text_path, binary_path, export_path;
+    std::chrono::time_point<std::chrono::steady_clock> s_time, e_time;
+    POSCudaFunctionDesp *desp;
+    uint64_t i, nb_mismatched = 0;
+    double text_ms, binary_ms, binary_hit_ms;
+
+    dir = argc > 1 ? argv[1] : "/tmp";
+    text_path = dir + std::string("/pos_kernel_metas_bench.txt");
+    binary_path = dir + std::string("/pos_kernel_metas_bench.bin");
+    export_path = dir + std::string("/pos_kernel_metas_bench_export.txt");
+
+    synthesize(desps);
+    unlink(text_path.c_str());
+    if(
+        POS_SUCCESS != POSUtil_CUDA_Kernel_Meta_Cache::dump_text(text_path, desps, /* append */ false)
+        || POS_SUCCESS != POSUtil_CUDA_Kernel_Meta_Cache::dump_binary(binary_path, desps)
+    ){
+        printf("failed to dump kernel metas to %s\n", dir.c_str());
+        return 1;
+    }
+
+    // parse the text file
+    {
+        POSUtil_CUDA_Kernel_Meta_Cache cache;
+        s_time = std::chrono::steady_clock::now();
+        cache.load(text_path);
+        for(i=0; i<kNbHitKernels; i++){ nb_mismatched += cache.find(desps[i * 13 % kNbKernels]->name.c_str()) == nullptr; }
+        e_time = std::chrono::steady_clock::now();
+        text_ms = std::chrono::duration<double, std::milli>(e_time - s_time).count();
+    }
+
+    // mmap the binary file, only the launched kernels are materialized
+    {
+        POSUtil_CUDA_Kernel_Meta_Cache cache;
+        s_time = std::chrono::steady_clock::now();
+        cache.load(binary_path);
+        for(i=0; i<kNbHitKernels; i++){ nb_mismatched += cache.find(desps[i * 13 % kNbKernels]->name.c_str()) == nullptr; }
+        e_time = std::chrono::steady_clock::now();
+        binary_hit_ms = std::chrono::duration<double, std::milli>(e_time - s_time).count();
+    }
+
+    // mmap the binary file and look up all kernels, then check them
+    {
+        POSUtil_CUDA_Kernel_Meta_Cache cache;
+        s_time = std::chrono::steady_clock::now();
+        cache.load(binary_path);
+        for(i=0; i<kNbKernels; i++){
+            desp = cache.find(desps[i]->name.c_str());
+            if(desp == nullptr || !is_same(desp, desps[i])){ nb_mismatched += 1; }
+        }
+        e_time = std::chrono::steady_clock::now();
+        binary_ms = std::chrono::duration<double, std::milli>(e_time - s_time).count();
+
+        nb_mismatched += cache.find("_Z15missing_kernelv") != nullptr;
+        nb_mismatched += cache.size() != kNbKernels;
+
+        // export back to text, which must be identical to the dumped one
+        cache.collect(collected_desps);
+        POSUtil_CUDA_Kernel_Meta_Cache::dump_text(export_path, collected_desps, /* append */ false);
+        nb_mismatched += read_file(export_path) != read_file(text_path);
+    }
+
+    printf(
+        "%lu kernels, %lu mismatched, text file %lu bytes, binary file %lu bytes\n",
+        kNbKernels, nb_mismatched, read_file(text_path).size(), read_file(binary_path).size()
+    );
+    printf(
+        "text: %.2f ms, binary (%lu hits): %.2f ms, binary (all hits): %.2f ms, speedup %.0fx\n",
+        text_ms, kNbHitKernels, binary_hit_ms, binary_ms, text_ms / binary_hit_ms
+    );
+
+    unlink(text_path.c_str());
+    unlink(binary_path.c_str());
+    unlink(export_path.c_str());
+    for(POSCudaFunctionDesp *desp : desps){ delete desp; }
+
+    return nb_mismatched > 0 ? 1 : 0;
+}
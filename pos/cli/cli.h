@@ -28,6 +28,7 @@
 #include "pos/include/oob/ckpt_predump.h"
 #include "pos/include/oob/ckpt_dump.h"
 #include "pos/include/oob/trace.h"
+#include "pos/include/oob/config.h"
 
 
 /*!
@@ -45,6 +46,8 @@ enum pos_cli_arg : int {
     kPOS_CliAction_Clean,
     kPOS_CliAction_TraceResource,
     kPOS_CliAction_Migrate,
+    kPOS_CliAction_Config,
+    kPOS_CliAction_KernelMeta,
     kPOS_CliAction_PLACEHOLDER,
 
     /* ==== metadatas (with params) === */
@@ -96,6 +99,12 @@ static std::string pos_cli_action_name(pos_cli_arg action_type){
     case kPOS_CliAction_Migrate:
         return "migrate";
 
+    case kPOS_CliAction_Config:
+        return "config";
+
+    case kPOS_CliAction_KernelMeta:
+        return "kernel-meta";
+
     default:
         return "unknown";
     }
@@ -124,6 +133,18 @@ typedef struct pos_cli_trace_resource_metas {
 } pos_cli_trace_resource_metas_t;
 
 
+typedef struct pos_cli_config_metas {
+    oob_functions::cli_config::config_action action;
+    char name[oob_functions::cli_config::kConfigNameMaxLen];
+    char value[oob_functions::cli_config::kConfigValueMaxLen];
+} pos_cli_config_metas_t;
+
+
+typedef struct pos_cli_kernel_meta_metas {
+    char output_dir[1024];
+} pos_cli_kernel_meta_metas_t;
+
+
 typedef struct pos_cli_migrate_metas {
     uint64_t pid;
     in_addr_t dip;
@@ -152,7 +173,9 @@ typedef struct pos_cli_options {
         pos_cli_ckpt_metas_t ckpt;
         pos_cli_migrate_metas_t migrate;
         pos_cli_trace_resource_metas_t trace_resource;
+        pos_cli_config_metas_t config;
         pos_cli_start_metas_t start;
+        pos_cli_kernel_meta_metas_t kernel_meta;
     } metas;
 
     pos_cli_options() : local_oob_client(nullptr), remote_oob_client(nullptr), action_type(kPOS_CliAction_Unknown) {
@@ -216,5 +239,7 @@ pos_retval_t handle_predump(pos_cli_options_t &clio);
 pos_retval_t handle_dump(pos_cli_options_t &clio);
 pos_retval_t handle_migrate(pos_cli_options_t &clio);
 pos_retval_t handle_trace(pos_cli_options_t &clio);
+pos_retval_t handle_config(pos_cli_options_t &clio);
 pos_retval_t handle_restore(pos_cli_options_t &clio);
 pos_retval_t handle_start(pos_cli_options_t &clio);
+pos_retval_t handle_kernel_meta(pos_cli_options_t &clio);
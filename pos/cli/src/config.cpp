@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <string>
+
+#include <stdio.h>
+#include <getopt.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "pos/include/common.h"
+#include "pos/include/oob.h"
+#include "pos/include/oob/config.h"
+
+#include "pos/cli/cli.h"
+
+pos_retval_t handle_config(pos_cli_options_t &clio){
+    pos_retval_t retval = POS_SUCCESS;
+    oob_functions::cli_config::oob_call_data_t call_data;
+
+    validate_and_cast_args(
+        /* clio */ clio, 
+        /* rules */ {
+            {
+                /* meta_type */ kPOS_CliMeta_Option,
+                /* meta_name */ "option",
+                /* meta_desp */ "config to be set (in form of name=value) or get (in form of name)",
+                /* cast_func */ [](pos_cli_options_t &clio, std::string& meta_val) -> pos_retval_t {
+                    pos_retval_t retval = POS_SUCCESS;
+                    std::string name, value;
+                    std::string::size_type pos;
+
+                    if((pos = meta_val.find('=')) != std::string::npos){
+                        clio.metas.config.action = oob_functions::cli_config::kConfig_Set;
+                        name = meta_val.substr(0, pos);
+                        value = meta_val.substr(pos+1);
+                    } else {
+                        clio.metas.config.action = oob_functions::cli_config::kConfig_Get;
+                        name = meta_val;
+                    }
+
+                    if(unlikely(name.size() == 0 || name.size() >= oob_functions::cli_config::kConfigNameMaxLen)){
+                        POS_WARN(
+                            "invalid config name: given(%s), expected_max_len(%u)",
+                            name.c_str(), oob_functions::cli_config::kConfigNameMaxLen
+                        );
+                        retval = POS_FAILED_INVALID_INPUT;
+                        goto exit;
+                    }
+                    if(unlikely(value.size() >= oob_functions::cli_config::kConfigValueMaxLen)){
+                        POS_WARN(
+                            "config value too long: given(%lu), expected_max(%u)",
+                            value.size(), oob_functions::cli_config::kConfigValueMaxLen
+                        );
+                        retval = POS_FAILED_INVALID_INPUT;
+                        goto exit;
+                    }
+
+                    memset(clio.metas.config.name, 0, oob_functions::cli_config::kConfigNameMaxLen);
+                    memcpy(clio.metas.config.name, name.c_str(), name.size());
+                    memset(clio.metas.config.value, 0, oob_functions::cli_config::kConfigValueMaxLen);
+                    memcpy(clio.metas.config.value, value.c_str(), value.size());
+
+                exit:
+                    return retval;
+                },
+                /* is_required */ true
+            }
+        },
+        /* collapse_rule */ [](pos_cli_options_t& clio) -> pos_retval_t {
+            pos_retval_t retval = POS_SUCCESS;
+            return retval;
+        }
+    );
+
+    // send config request
+    call_data.action = clio.metas.config.action;
+    memcpy(call_data.name, clio.metas.config.name, oob_functions::cli_config::kConfigNameMaxLen);
+    memcpy(call_data.value, clio.metas.config.value, oob_functions::cli_config::kConfigValueMaxLen);
+
+    retval = clio.local_oob_client->call(kPOS_OOB_Msg_CLI_Config, &call_data);
+    if(POS_SUCCESS != call_data.retval){
+        POS_WARN("%s config failed, %s", call_data.action == oob_functions::cli_config::kConfig_Set ? "set" : "get", call_data.retmsg);
+        retval = call_data.retval;
+    } else {
+        POS_LOG("config: %s=%s", call_data.name, call_data.value);
+    }
+
+    return retval;
+}
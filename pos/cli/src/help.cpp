@@ -12,6 +12,8 @@ pos_retval_t handle_help(pos_cli_options_t &clio){
     std::stringstream helper_message_pre_dump, helper_message_dump, helper_message_restore, helper_message_pre_restore, helper_message_clean;
     std::stringstream helper_message_migration;
     std::stringstream helper_message_trace;
+    std::stringstream helper_message_config;
+    std::stringstream helper_message_kernel_meta;
 
     helper_message_help 
         << "--help:                  print help message (like you just did)\n"
@@ -104,6 +106,34 @@ pos_retval_t handle_help(pos_cli_options_t &clio){
         << "\n"
         << "     e.g., for starting trace, 'pos_cli --trace-resource --subaction=start --pid=23491'\n";
 
+    helper_message_config
+        << "--config:               get / set runtime config of the daemon\n"
+        << "    --option <opt>      'name=value' to set the config, or 'name' to get the config, available names:\n"
+        << "                        ckpt_interval_ms, ckpt_commit_lanes, ckpt_commit_bw, ckpt_commit_burst,\n"
+        << "                        ckpt_persist_bw, ckpt_persist_burst, ckpt_max_slowdown_pct, daemon_batch_size,\n"
+        << "                        wait_spin_us, wait_yield_us, wait_park_timeout_us, daemon_pool_threads,\n"
+        << "                        placement_policy, placement_numa_node, placement_critical_cores,\n"
+        << "                        kernel_meta_cache_dir ('none' for disabling the node-wide kernel metadata cache),\n"
+        << "                        lazy_kernel_meta ('true' for parsing kernel prototypes on their first launch),\n"
+        << "                        fatbin_text_spill ('true' for spilling decompressed fatbin sections to the cache directory),\n"
+        << "                        placement (read-only, actual cores of the daemon threads), ...\n"
+        << "                        ckpt_max_slowdown_pct bounds the slowdown of application copies by adapting the\n"
+        << "                        commit rate to the observed copy traffic, it caps ckpt_commit_bw if set, otherwise\n"
+        << "                        the commit rate is derived from the observed copy traffic only\n"
+        << "\n"
+        << "     e.g., for limiting the checkpoint commit traffic to 1GB/s, 'pos_cli --config --option=ckpt_commit_bw=1073741824'\n"
+        << "     e.g., for bounding the slowdown of application copies to 5%, 'pos_cli --config --option=ckpt_max_slowdown_pct=5'\n";
+
+    helper_message_kernel_meta
+        << "--kernel-meta:          precompute kernel metadata of shared libraries offline (without the daemon)\n"
+        << "    --target <str>      paths of the shared libraries to be analysed, splited using ','\n"
+        << "    --dir <dir>         directory to store the kernel metadata, which contains\n"
+        << "                          - kernels of each fatbin text section, use it as the kernel_meta_cache_dir\n"
+        << "                            of the daemon to skip parsing the kernels while loading modules\n"
+        << "                          - kernel_metas.bin, kernels of all libraries in a single file\n"
+        << "\n"
+        << "     e.g., 'pos_cli --kernel-meta --target=libtorch_cuda.so,libcublasLt.so --dir=/opt/phos/kernel_meta_cache'\n";
+
     helper_message_shell    << "FORMAT: pos_cli --ACTION [--METADATA --VALUE]\n"
                             << "\n"
                             << "[A. Miscellaneous]\n"
@@ -136,6 +166,16 @@ pos_retval_t handle_help(pos_cli_options_t &clio){
                                 << helper_message_trace.str()
                             << "------------------------------------------------------------------------------------\n"
                             << "\n\n"
+                            << "[D. Config]\n"
+                            << "------------------------------------------------------------------------------------\n"
+                                << helper_message_config.str()
+                            << "------------------------------------------------------------------------------------\n"
+                            << "\n\n"
+                            << "[E. Kernel Metadata]\n"
+                            << "------------------------------------------------------------------------------------\n"
+                                << helper_message_kernel_meta.str()
+                            << "------------------------------------------------------------------------------------\n"
+                            << "\n\n"
                             ;
 
     POS_LOG(
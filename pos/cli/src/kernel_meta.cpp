@@ -0,0 +1,371 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <unordered_set>
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <libelf.h>
+#include <gelf.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/string.h"
+#include "pos/include/utils/timer.h"
+#include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
+#include "pos/cuda_impl/utils/kernel_meta_cache.h"
+
+#include "pos/cli/cli.h"
+
+
+/*!
+ *  \brief  header of each fatbin within the ".nv_fatbin" section,
+ *          the same as POSUtil_CUDA_Fatbin::fat_elf_header_t
+ */
+typedef struct __attribute__((__packed__)) pos_cli_fatbin_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint64_t size;
+} pos_cli_fatbin_header_t;
+
+
+/*!
+ *  \brief  kernel metadata extracted from a shared library
+ */
+typedef struct pos_cli_library_kernel_metas {
+    std::string path;
+    // kernels of all fatbins, might be duplicated across fatbins
+    std::vector<POSCudaFunctionDesp*> desps;
+    uint64_t nb_fatbins;
+    pos_retval_t retval;
+
+    pos_cli_library_kernel_metas() : nb_fatbins(0), retval(POS_SUCCESS) {}
+} pos_cli_library_kernel_metas_t;
+
+
+/*!
+ *  \brief  extract the kernel metadata of all fatbins within the ".nv_fatbin" section of a shared library
+ *  \note   the fatbins within the section are concatenated, each starts with its header and is padded
+ *  \param  library         the library to be analysed, whose desps are filled
+ *  \param  fatbin_cache    the fatbin cache that stores the kernels of each fatbin
+ *  \param  nb_threads      number of threads for extracting each fatbin
+ */
+static void __extract_library(
+    pos_cli_library_kernel_metas_t& library, POSUtil_CUDA_Fatbin_Cache& fatbin_cache, uint32_t nb_threads
+){
+    pos_retval_t retval;
+    POSUtil_CUDA_Kernel_Meta_Cache cached_desp_map;
+    int fd = -1;
+    struct stat file_stat;
+    uint8_t *file_ptr = (uint8_t*)(MAP_FAILED);
+    Elf *elf = nullptr;
+    Elf_Scn *scn = nullptr;
+    GElf_Shdr shdr;
+    size_t shstrndx;
+    const char *section_name;
+    uint8_t *fatbin_ptr = nullptr;
+    uint64_t fatbin_size = 0, offset;
+    pos_cli_fatbin_header_t *fatbin_hdr;
+    std::vector<POSCudaFunctionDesp*> fatbin_desps;
+
+    if(unlikely((fd = open(library.path.c_str(), O_RDONLY)) < 0)){
+        POS_WARN("failed to open library: path(%s), error(%s)", library.path.c_str(), strerror(errno));
+        library.retval = POS_FAILED_NOT_EXIST;
+        goto exit;
+    }
+    if(unlikely(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)){
+        POS_WARN("failed to stat library: path(%s)", library.path.c_str());
+        library.retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+
+    file_ptr = (uint8_t*)(mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    if(unlikely(file_ptr == (uint8_t*)(MAP_FAILED))){
+        POS_WARN("failed to map library: path(%s), error(%s)", library.path.c_str(), strerror(errno));
+        library.retval = POS_FAILED;
+        goto exit;
+    }
+
+    // locate the ".nv_fatbin" section
+    if(unlikely((elf = elf_memory((char*)(file_ptr), file_stat.st_size)) == nullptr || elf_kind(elf) != ELF_K_ELF)){
+        POS_WARN("not an ELF file: path(%s)", library.path.c_str());
+        library.retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+    if(unlikely(elf_getshdrstrndx(elf, &shstrndx) != 0)){
+        POS_WARN("failed to obtain section names of the library: path(%s), error(%s)", library.path.c_str(), elf_errmsg(-1));
+        library.retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+    while((scn = elf_nextscn(elf, scn)) != nullptr){
+        if(unlikely(gelf_getshdr(scn, &shdr) == nullptr)){ continue; }
+        if((section_name = elf_strptr(elf, shstrndx, shdr.sh_name)) == nullptr){ continue; }
+        if(strcmp(section_name, ".nv_fatbin") != 0 || shdr.sh_type == SHT_NOBITS){ continue; }
+        if(unlikely(shdr.sh_offset + shdr.sh_size > (uint64_t)(file_stat.st_size))){
+            POS_WARN("truncated .nv_fatbin section: path(%s)", library.path.c_str());
+            library.retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        fatbin_ptr = file_ptr + shdr.sh_offset;
+        fatbin_size = shdr.sh_size;
+        break;
+    }
+    if(fatbin_ptr == nullptr){
+        POS_WARN("no .nv_fatbin section within the library, skipped: path(%s)", library.path.c_str());
+        goto exit;
+    }
+
+    // walk the concatenated fatbins
+    offset = 0;
+    while(offset + sizeof(pos_cli_fatbin_header_t) <= fatbin_size){
+        fatbin_hdr = (pos_cli_fatbin_header_t*)(fatbin_ptr + offset);
+
+        // skip the padding between fatbins
+        if(fatbin_hdr->magic != FATBIN_TEXT_MAGIC){
+            offset += 8;
+            continue;
+        }
+
+        if(unlikely(
+            fatbin_hdr->header_size < sizeof(pos_cli_fatbin_header_t)
+            || offset + fatbin_hdr->header_size + fatbin_hdr->size > fatbin_size
+        )){
+            POS_WARN(
+                "corrupted fatbin within the library: path(%s), offset(%lu), size(%lu)",
+                library.path.c_str(), offset, fatbin_hdr->size
+            );
+            library.retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+
+        /*!
+         *  \note  each fatbin is extracted on its own (as it's loaded as a module by the daemon), so that
+         *          it's stored to the fatbin cache under the same key as the daemon looks it up
+         */
+        fatbin_desps.clear();
+        retval = POSUtil_CUDA_Fatbin::obtain_functions_from_cuda_binary(
+            /* binary_ptr */ fatbin_ptr + offset,
+            /* binary_size */ fatbin_hdr->header_size + fatbin_hdr->size,
+            /* desps */ &fatbin_desps,
+            /* cached_desp_map */ cached_desp_map,
+            /* fatbin_cache */ &fatbin_cache,
+            /* is_lazy */ false,
+            /* nb_threads */ nb_threads
+        );
+        if(unlikely(retval != POS_SUCCESS)){
+            POS_WARN(
+                "failed to extract kernels from fatbin: path(%s), offset(%lu), retval(%d)",
+                library.path.c_str(), offset, retval
+            );
+            library.retval = retval;
+        }
+        library.desps.insert(library.desps.end(), fatbin_desps.begin(), fatbin_desps.end());
+        library.nb_fatbins += 1;
+
+        offset += fatbin_hdr->header_size + fatbin_hdr->size;
+        offset = (offset + 7) & ~(uint64_t)(7);
+    }
+
+exit:
+    if(elf != nullptr){ elf_end(elf); }
+    if(file_ptr != (uint8_t*)(MAP_FAILED)){ munmap(file_ptr, file_stat.st_size); }
+    if(fd >= 0){ close(fd); }
+}
+
+
+pos_retval_t handle_kernel_meta(pos_cli_options_t &clio){
+    pos_retval_t retval = POS_SUCCESS;
+    std::vector<std::string> library_paths;
+    std::vector<pos_cli_library_kernel_metas_t> libraries;
+    std::vector<POSCudaFunctionDesp*> desps;
+    std::unordered_set<std::string> desp_names;
+    std::vector<std::thread*> threads;
+    std::atomic<uint64_t> next_library(0);
+    POSUtil_CUDA_Fatbin_Cache fatbin_cache;
+    POSUtilHpetTimer timer;
+    std::string output_dir, output_path;
+    uint32_t nb_cores, nb_library_threads, nb_section_threads;
+    uint64_t i, nb_fatbins = 0;
+
+    // analyse the libraries one by one, until all of them are taken
+    auto __drain = [&](){
+        uint64_t id;
+        while((id = next_library.fetch_add(1, std::memory_order_relaxed)) < libraries.size()){
+            __extract_library(libraries[id], fatbin_cache, nb_section_threads);
+            POS_LOG(
+                "  %s: %lu fatbins, %lu kernels%s",
+                libraries[id].path.c_str(), libraries[id].nb_fatbins, libraries[id].desps.size(),
+                libraries[id].retval == POS_SUCCESS ? "" : " (failed)"
+            );
+        }
+    };
+
+    validate_and_cast_args(
+        /* clio */ clio,
+        /* rules */ {
+            {
+                /* meta_type */ kPOS_CliMeta_Target,
+                /* meta_name */ "target",
+                /* meta_desp */ "shared libraries to be analysed, splited using ','",
+                /* cast_func */ [](pos_cli_options_t &clio, std::string& meta_val) -> pos_retval_t {
+                    pos_retval_t retval = POS_SUCCESS;
+                    std::vector<std::string> substrings;
+
+                    substrings = POSUtil_String::split_string(meta_val, ',');
+                    if(unlikely(substrings.size() == 0)){
+                        POS_WARN("no library is given");
+                        retval = POS_FAILED_INVALID_INPUT;
+                        goto exit;
+                    }
+                    for(auto& substring : substrings){
+                        if(unlikely(!std::filesystem::is_regular_file(substring))){
+                            POS_WARN("library not exist: %s", substring.c_str());
+                            retval = POS_FAILED_INVALID_INPUT;
+                            goto exit;
+                        }
+                    }
+
+                exit:
+                    return retval;
+                },
+                /* is_required */ true
+            },
+            {
+                /* meta_type */ kPOS_CliMeta_Dir,
+                /* meta_name */ "dir",
+                /* meta_desp */ "directory to store the kernel metadata",
+                /* cast_func */ [](pos_cli_options_t &clio, std::string& meta_val) -> pos_retval_t {
+                    pos_retval_t retval = POS_SUCCESS;
+                    std::string abs_dir;
+
+                    abs_dir = std::filesystem::absolute(meta_val).string();
+                    if(abs_dir.size() >= sizeof(clio.metas.kernel_meta.output_dir)){
+                        POS_WARN(
+                            "kernel meta dir path too long: given(%lu), expected_max(%lu)",
+                            abs_dir.size(),
+                            sizeof(clio.metas.kernel_meta.output_dir)
+                        );
+                        retval = POS_FAILED_INVALID_INPUT;
+                        goto exit;
+                    }
+                    memset(clio.metas.kernel_meta.output_dir, 0, sizeof(clio.metas.kernel_meta.output_dir));
+                    memcpy(clio.metas.kernel_meta.output_dir, abs_dir.c_str(), abs_dir.size());
+
+                exit:
+                    return retval;
+                },
+                /* is_required */ true
+            }
+        },
+        /* collapse_rule */ [](pos_cli_options_t& clio) -> pos_retval_t {
+            pos_retval_t retval = POS_SUCCESS;
+            return retval;
+        }
+    );
+
+    library_paths = POSUtil_String::split_string(clio._raw_metas[kPOS_CliMeta_Target], ',');
+    output_dir = std::string(clio.metas.kernel_meta.output_dir);
+    output_path = output_dir + std::string("/kernel_metas.bin");
+
+    /*!
+     *  \note   the kernels of each fatbin are stored to the directory by the fatbin cache, which could be
+     *          used by the daemon directly (i.e., as its kernel_meta_cache_dir), fatbins already within
+     *          the directory are reused instead of being parsed again
+     */
+    retval = fatbin_cache.set_dir(output_dir);
+    if(unlikely(retval != POS_SUCCESS)){
+        POS_WARN("failed to create kernel meta dir: %s", output_dir.c_str());
+        goto exit;
+    }
+    // the sections are only visited once, so we needn't keep the decompressed ones
+    fatbin_cache.set_text_capacity(0);
+
+    if(unlikely(elf_version(EV_CURRENT) == EV_NONE)){
+        POS_WARN("failed to initialize libelf: %s", elf_errmsg(-1));
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    libraries.resize(library_paths.size());
+    for(i=0; i<library_paths.size(); i++){ libraries[i].path = library_paths[i]; }
+
+    // libraries are analysed concurrently, and the cores are shared by the sections of each library
+    nb_cores = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    nb_library_threads = std::min<uint64_t>(nb_cores, libraries.size());
+    nb_section_threads = std::min<uint32_t>(
+        std::max<uint32_t>(nb_cores / nb_library_threads, 1), POSUtil_CUDA_Fatbin::kMaxNbThreads
+    );
+
+    POS_LOG(
+        "precomputing kernel metadata: nb_libraries(%lu), library_threads(%u), section_threads(%u), dir(%s)",
+        libraries.size(), nb_library_threads, nb_section_threads, output_dir.c_str()
+    );
+
+    timer.start();
+    for(i=1; i<nb_library_threads; i++){
+        threads.push_back(new std::thread(__drain));
+        POS_CHECK_POINTER(threads.back());
+    }
+    __drain();
+    for(i=0; i<threads.size(); i++){
+        if(threads[i]->joinable()){ threads[i]->join(); }
+        delete threads[i];
+    }
+
+    // wait for the fatbins to be written to the directory
+    fatbin_cache.flush();
+
+    // aggregated kernel metadata of all libraries, which could be used as the kernel meta file of the jobs
+    for(auto& library : libraries){
+        for(POSCudaFunctionDesp *desp : library.desps){
+            if(desp_names.insert(desp->name).second){ desps.push_back(desp); }
+        }
+        nb_fatbins += library.nb_fatbins;
+        if(unlikely(library.retval != POS_SUCCESS && retval == POS_SUCCESS)){
+            retval = library.retval;
+        }
+    }
+    if(unlikely(POS_SUCCESS != POSUtil_CUDA_Kernel_Meta_Cache::dump_binary(output_path, desps))){
+        POS_WARN("failed to dump kernel metadata to %s", output_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    POS_LOG(
+        "precomputed kernel metadata of %lu kernels from %lu fatbins within %.2f ms: %s",
+        desps.size(), nb_fatbins, timer.stop_get_ms(), output_path.c_str()
+    );
+    fatbin_cache.print_metrics();
+
+    // the descriptors are partially owned by the fatbin cache, so we leave them to be released on exit
+
+exit:
+    return retval;
+}
@@ -58,7 +58,7 @@ inline void __readin_raw_cli(int argc, char *argv[], pos_cli_options_t &clio){
 
     sprintf(
         short_opt,
-        /* action */    "%d%d%d%d%d%d%d%d%d"
+        /* action */    "%d%d%d%d%d%d%d%d%d%d%d"
         /* meta */      "%d:%d:%d:%d:%d:%d:%d:",
         kPOS_CliAction_Help,
         kPOS_CliAction_Start,
@@ -69,6 +69,8 @@ inline void __readin_raw_cli(int argc, char *argv[], pos_cli_options_t &clio){
         kPOS_CliAction_Clean,
         kPOS_CliAction_Migrate,
         kPOS_CliAction_TraceResource,
+        kPOS_CliAction_Config,
+        kPOS_CliAction_KernelMeta,
         kPOS_CliMeta_Target,
         kPOS_CliMeta_SkipTarget,
         kPOS_CliMeta_SubAction,
@@ -89,6 +91,8 @@ inline void __readin_raw_cli(int argc, char *argv[], pos_cli_options_t &clio){
         {"clean",           no_argument,        NULL,   kPOS_CliAction_Clean},
         {"migrate",         no_argument,        NULL,   kPOS_CliAction_Migrate},
         {"trace-resource",  no_argument,        NULL,   kPOS_CliAction_TraceResource},
+        {"config",          no_argument,        NULL,   kPOS_CliAction_Config},
+        {"kernel-meta",     no_argument,        NULL,   kPOS_CliAction_KernelMeta},
 
         // metadatas (with param)
         {"target",      required_argument,  NULL,   kPOS_CliMeta_Target},
@@ -139,9 +143,15 @@ inline pos_retval_t __dispatch(pos_cli_options_t &clio){
     case kPOS_CliAction_TraceResource:
         return handle_trace(clio);
 
+    case kPOS_CliAction_Config:
+        return handle_config(clio);
+
     case kPOS_CliAction_Start:
         return handle_start(clio);
 
+    case kPOS_CliAction_KernelMeta:
+        return handle_kernel_meta(clio);
+
     default:
         return POS_FAILED_NOT_IMPLEMENTED;
     }
@@ -156,6 +166,7 @@ namespace oob_functions {
     POS_OOB_DECLARE_CLNT_FUNCTIONS(cli_ckpt_dump);
     POS_OOB_DECLARE_CLNT_FUNCTIONS(cli_restore);
     POS_OOB_DECLARE_CLNT_FUNCTIONS(cli_trace_resource);
+    POS_OOB_DECLARE_CLNT_FUNCTIONS(cli_config);
 }; // namespace oob_functions
 
 
@@ -165,17 +176,21 @@ int main(int argc, char *argv[]){
 
     __readin_raw_cli(argc, argv, clio);
 
-    clio.local_oob_client = new POSOobClient(
-        /* req_functions */ {
-            {   kPOS_OOB_Msg_CLI_Ckpt_PreDump,      oob_functions::cli_ckpt_predump::clnt       },
-            {   kPOS_OOB_Msg_CLI_Ckpt_Dump,         oob_functions::cli_ckpt_dump::clnt          },
-            {   kPOS_OOB_Msg_CLI_Restore,           oob_functions::cli_restore::clnt            },
-            {   kPOS_OOB_Msg_CLI_Trace_Resource,    oob_functions::cli_trace_resource::clnt     },
-        },
-        /* local_port */ 10086,
-        /* local_ip */ CLIENT_IP
-    );
-    POS_CHECK_POINTER(clio.local_oob_client);
+    // kernel metadata is precomputed offline, which needn't the daemon
+    if(clio.action_type != kPOS_CliAction_KernelMeta){
+        clio.local_oob_client = new POSOobClient(
+            /* req_functions */ {
+                {   kPOS_OOB_Msg_CLI_Ckpt_PreDump,      oob_functions::cli_ckpt_predump::clnt       },
+                {   kPOS_OOB_Msg_CLI_Ckpt_Dump,         oob_functions::cli_ckpt_dump::clnt          },
+                {   kPOS_OOB_Msg_CLI_Restore,           oob_functions::cli_restore::clnt            },
+                {   kPOS_OOB_Msg_CLI_Trace_Resource,    oob_functions::cli_trace_resource::clnt     },
+                {   kPOS_OOB_Msg_CLI_Config,            oob_functions::cli_config::clnt             },
+            },
+            /* local_port */ 10086,
+            /* local_ip */ CLIENT_IP
+        );
+        POS_CHECK_POINTER(clio.local_oob_client);
+    }
 
     retval = __dispatch(clio);
     switch (retval)
@@ -29,6 +29,7 @@
 #include "pos/cuda_impl/api_index.h"
 #include "pos/cuda_impl/parser.h"
 #include "pos/cuda_impl/worker.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
 
 
 /*!
@@ -36,6 +37,12 @@
  */
 typedef struct pos_client_cxt_CUDA {
     POS_CLIENT_CXT_HEAD;
+
+    // node-wide cache of the kernel metadata, owned by the workspace
+    POSUtil_CUDA_Fatbin_Cache *fatbin_cache;
+
+    // whether to extract kernels in lazy mode, i.e., their prototypes are parsed on the first launch
+    bool is_lazy_kernel_meta;
 } pos_client_cxt_CUDA_t;
 
 
@@ -146,5 +153,17 @@ class POSClient_CUDA : public POSClient {
      *  \note   this function is called in deinit_handle_managers
      */
     void __dump_hm_cuda_functions();
+
+    /*!
+     *  \brief  count and print the kernels extracted in lazy mode, and those never resolved
+     *  \note   this function is called in deinit_handle_managers
+     */
+    void __print_lazy_kernel_metrics();
+
+    /*!
+     *  \brief  sum up and print the counters of the argument caches of all kernels
+     *  \note   this function is called in deinit_handle_managers
+     */
+    void __print_arg_cache_metrics();
     /* =============== resource management =============== */
 };
@@ -29,10 +29,12 @@
 #include "pos/include/handle.h"
 #include "pos/cuda_impl/handle.h"
 #include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/kernel_arg_cache.h"
 
 
 // forward declaration
 class POSHandleManager_CUDA_Function;
+class POSHandle_CUDA_Memory;
 
 
 /*!
@@ -81,6 +83,16 @@ class POSHandle_CUDA_Function final : public POSHandle_CUDA {
     pos_retval_t tear_down() override;
 
 
+    /*!
+     *  \brief  resolve the signature and the parameter directions of the kernel from its prototype,
+     *          kernels extracted in lazy mode are resolved on their first launch
+     *  \note   the result is memoized within the handle
+     *  \return POS_SUCCESS for successfully resolved (or already resolved);
+     *          POS_FAILED for failed to parse the prototype
+     */
+    pos_retval_t resolve_params();
+
+
     /* ======================== handle specific fields ======================= */
  public:
     // name of the kernel
@@ -120,6 +132,12 @@ class POSHandle_CUDA_Function final : public POSHandle_CUDA {
 
     // cbank parameter size (p.s., what is this?)
     uint64_t cbank_param_size;
+
+    // whether the signature and the parameter directions are resolved (see POSCudaFunctionDesp::is_resolved)
+    bool is_resolved;
+
+    // memory handles resolved from the pointer arguments of recent launches, dropped once the directions are changed
+    POSUtil_CUDA_Kernel_Arg_Cache<POSHandle_CUDA_Memory> arg_cache;
     /* ======================== handle specific fields ======================= */
 
 
@@ -219,6 +237,41 @@ class POSHandleManager_CUDA_Function : public POSHandleManager<POSHandle_CUDA_Fu
     pos_retval_t try_restore_from_pool(POSHandle_CUDA_Function* handle) override;
 
 
+    /* =================== lazy kernel metadata metrics ====================== */
+ public:
+    enum lazy_metrics_counter_type_t : uint8_t {
+        __LAZY_COUNTER_BASE__ = 0,
+        LAZY_indexed_kernels,
+        LAZY_resolved_kernels,
+        LAZY_never_resolved_kernels
+    };
+    POSMetrics_CounterList<lazy_metrics_counter_type_t> lazy_metric_counters;
+
+    /*!
+     *  \brief  print the metrics of the kernels extracted in lazy mode
+     */
+    void print_lazy_metrics();
+    /* =================== lazy kernel metadata metrics ====================== */
+
+
+    /* =================== kernel argument cache metrics ===================== */
+ public:
+    enum arg_cache_metrics_counter_type_t : uint8_t {
+        __ARG_CACHE_COUNTER_BASE__ = 0,
+        ARG_CACHE_hits,
+        ARG_CACHE_misses,
+        ARG_CACHE_bypasses,
+        ARG_CACHE_invalidations
+    };
+    POSMetrics_CounterList<arg_cache_metrics_counter_type_t> arg_cache_metric_counters;
+
+    /*!
+     *  \brief  print the metrics of the argument caches of the kernels
+     */
+    void print_arg_cache_metrics();
+    /* =================== kernel argument cache metrics ===================== */
+
+
  private:
     /*!
      *  \brief  restore the extra fields of handle with specific type
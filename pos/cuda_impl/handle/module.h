@@ -31,6 +31,8 @@
 #include "pos/include/api_context.h"
 #include "pos/cuda_impl/handle.h"
 #include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/kernel_meta_cache.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
 
 
 // forward declaration
@@ -181,7 +183,13 @@ class POSHandle_CUDA_Module final : public POSHandle_CUDA {
  */
 class POSHandleManager_CUDA_Module : public POSHandleManager<POSHandle_CUDA_Module> {
  public:
-    std::map<std::string, POSCudaFunctionDesp_t*> cached_function_desps;
+    POSUtil_CUDA_Kernel_Meta_Cache cached_function_desps;
+
+    // node-wide cache of the kernels within each fatbin, owned by the workspace
+    POSUtil_CUDA_Fatbin_Cache *fatbin_cache;
+
+    // whether to extract kernels in lazy mode, i.e., their prototypes are parsed on the first launch
+    bool is_lazy_kernel_meta;
 
     /*!
      *  \brief  initialize of the handle manager
@@ -197,8 +205,8 @@ class POSHandleManager_CUDA_Module : public POSHandleManager<POSHandle_CUDA_Modu
 
     /*!
      *  \brief  load kernel metadata which dumps by previous run
-     *  \todo   change to use protobuf to store
-     *  \param  file_path   path to the file that stores the metadata of kernels
+     *  \note   the binary file is mmap-ed and looked up in place, while the text file is parsed
+     *  \param  file_path   path to the file that stores the metadata of kernels (binary or text)
      *  \return POS_SUCCESS for successfully loaded
      */
     pos_retval_t load_cached_function_metas(std::string &file_path);
@@ -69,3 +69,32 @@ static int pos_destory_workspace_cuda(POSWorkspace_CUDA* pos_cuda_ws){
 exit:
     return retval;
 }
+
+
+/*!
+ *  \brief  obtain the uuid of the client by the pid of its process, for remoting frameworks
+ *          that identify the caller by its process instead of piggybacking the uuid
+ *  \param  pos_cuda_ws pointer to the CUDA workspace
+ *  \param  pid         pid of the client process
+ *  \param  uuid        the obtained uuid
+ *  \return 0 for successfully obtained
+ *          1 for no client registered with the pid
+ */
+static int pos_get_client_uuid_by_pid_cuda(POSWorkspace_CUDA* pos_cuda_ws, __pid_t pid, pos_client_uuid_t* uuid){
+    int retval = 0;
+    POSClient *client;
+
+    POS_CHECK_POINTER(pos_cuda_ws);
+    POS_CHECK_POINTER(uuid);
+
+    POSClientRegistry::read_lock();
+    if(unlikely(nullptr == (client = pos_cuda_ws->get_client_by_pid(pid)))){
+        retval = 1;
+        goto exit;
+    }
+    *uuid = client->id;
+
+exit:
+    POSClientRegistry::read_unlock();
+    return retval;
+}
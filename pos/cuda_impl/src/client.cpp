@@ -16,6 +16,7 @@
 
 #include <iostream>
 #include <set>
+#include <unordered_set>
 #include <filesystem>
 
 #include "pos/include/common.h"
@@ -46,7 +47,10 @@ POSClient_CUDA::POSClient_CUDA(pos_client_uuid_t id, pid_t pid, pos_client_cxt_C
 }
 
 
-POSClient_CUDA::POSClient_CUDA(){}
+POSClient_CUDA::POSClient_CUDA(){
+    this->_cxt_CUDA.fatbin_cache = nullptr;
+    this->_cxt_CUDA.is_lazy_kernel_meta = false;
+}
 
 
 POSClient_CUDA::~POSClient_CUDA(){}
@@ -68,6 +72,7 @@ pos_retval_t POSClient_CUDA::init_handle_managers(bool is_restoring){
     POSHandleManager_CUDA_Memory *memory_mgr;
 
     std::map<uint64_t, std::vector<POSHandle*>> related_handles;
+    std::string kernel_meta_path;
 
     auto __cast_to_base_handle_list = [](auto handle_list) -> std::vector<POSHandle*> {
         std::vector<POSHandle*> ret_list;
@@ -160,15 +165,24 @@ pos_retval_t POSClient_CUDA::init_handle_managers(bool is_restoring){
         goto exit;
     }
     this->handle_managers[kPOS_ResourceTypeId_CUDA_Module] = (POSHandleManager<POSHandle>*)(module_mgr);
-    if(std::filesystem::exists(this->_cxt.kernel_meta_path) && !is_restoring){
-        POS_DEBUG_C("loading kernel meta from cache %s...", this->_cxt.kernel_meta_path.c_str());
-        retval = module_mgr->load_cached_function_metas(this->_cxt.kernel_meta_path);
-        if(likely(retval == POS_SUCCESS)){
-            this->_cxt.is_load_kernel_from_cache = true;
-            POS_BACK_LINE
-            POS_DEBUG_C("loading kernel meta from cache %s [done]", this->_cxt.kernel_meta_path.c_str());
-        } else {
-            POS_WARN_C("loading kernel meta from cache %s [failed]", this->_cxt.kernel_meta_path.c_str());
+    module_mgr->fatbin_cache = this->_cxt_CUDA.fatbin_cache;
+    module_mgr->is_lazy_kernel_meta = this->_cxt_CUDA.is_lazy_kernel_meta;
+    if(!is_restoring){
+        // fall back to the text file dumped by previous version if the binary one isn't there
+        kernel_meta_path = this->_cxt.kernel_meta_path;
+        if(!std::filesystem::exists(kernel_meta_path)){
+            kernel_meta_path = std::filesystem::path(kernel_meta_path).replace_extension(".txt").string();
+        }
+        if(std::filesystem::exists(kernel_meta_path)){
+            POS_DEBUG_C("loading kernel meta from cache %s...", kernel_meta_path.c_str());
+            retval = module_mgr->load_cached_function_metas(kernel_meta_path);
+            if(likely(retval == POS_SUCCESS)){
+                this->_cxt.is_load_kernel_from_cache = true;
+                POS_BACK_LINE
+                POS_DEBUG_C("loading kernel meta from cache %s [done]", kernel_meta_path.c_str());
+            } else {
+                POS_WARN_C("loading kernel meta from cache %s [failed]", kernel_meta_path.c_str());
+            }
         }
     }
 
@@ -240,18 +254,24 @@ void POSClient_CUDA::deinit_handle_managers(){
         hm_module->print_metrics();
     #endif
 
+    if(this->_cxt_CUDA.fatbin_cache != nullptr){
+        this->_cxt_CUDA.fatbin_cache->print_metrics();
+    }
+    if(this->_cxt_CUDA.is_lazy_kernel_meta){
+        this->__print_lazy_kernel_metrics();
+    }
+    this->__print_arg_cache_metrics();
+
     this->__dump_hm_cuda_functions();
 }
 
 
 pos_retval_t POSClient_CUDA::persist_handles(bool with_state){
     pos_retval_t retval = POS_SUCCESS;
-    std::string trace_dir, apicxt_dir, resource_dir;
+    std::string trace_dir, resource_dir;
     uint64_t i;
     POSHandleManager<POSHandle>* hm;
     POSHandle *handle;
-    POSAPIContext_QE *wqe;
-    std::vector<POSAPIContext_QE*> wqes;
 
     POS_LOG_C("dumping trace resource result...");
 
@@ -265,11 +285,9 @@ pos_retval_t POSClient_CUDA::persist_handles(bool with_state){
                 + std::to_string(this->_cxt.pid)
                 + std::string("-")
                 + std::to_string(this->_ws->tsc_timer.get_tsc());
-    apicxt_dir = trace_dir + std::string("/apicxt/");
     resource_dir = trace_dir + std::string("/resource/");
     if (std::filesystem::exists(trace_dir)) { std::filesystem::remove_all(trace_dir); }
     try {
-        std::filesystem::create_directories(apicxt_dir);
         std::filesystem::create_directories(resource_dir);
     } catch (const std::filesystem::filesystem_error& e) {
         POS_WARN_C("failed to create directory to store trace result, failed to dump");
@@ -278,15 +296,7 @@ pos_retval_t POSClient_CUDA::persist_handles(bool with_state){
     POS_BACK_LINE;
     POS_LOG_C("dumping trace resource result to %s...", trace_dir.c_str());
 
-    // dumping API context
-    wqes.clear();
-    this->template poll_q<kPOS_QueueDirection_ParserLocal, kPOS_QueueType_ApiCxt_Trace_WQ>(&wqes);
-    for(i=0; i<wqes.size(); i++){
-        POS_CHECK_POINTER(wqe = wqes[i]);
-        wqe->persist</* with_params */ false, /* type */ ApiCxt_TypeId_Unexecuted>(apicxt_dir);
-    }
-
-    // dumping resources
+    // dumping resources, traced APIs are recorded by the API trace ring instead (see POSApiTraceWriter)
     for(auto &handle_id : this->_ws->resource_type_idx){
         POS_CHECK_POINTER(
             hm = pos_get_client_typed_hm(this, handle_id, POSHandleManager<POSHandle>)
@@ -471,96 +481,81 @@ exit:
 }
 
 
-void POSClient_CUDA::__dump_hm_cuda_functions() {
-    uint64_t nb_functions, i;
+void POSClient_CUDA::__print_lazy_kernel_metrics() {
+    uint64_t i;
     POSHandleManager_CUDA_Function *hm_function;
+    POSHandleManager_CUDA_Module *hm_module;
     POSHandle_CUDA_Function *function_handle;
-    std::ofstream output_file;
-    std::string dump_content;
-
-    auto dump_function_metas = [](POSHandle_CUDA_Function* function_handle) -> std::string {
-        std::string output_str("");
-        std::string delimiter("|");
-        uint64_t i;
-        
-        POS_CHECK_POINTER(function_handle);
-
-        // mangled name of the kernel
-        output_str += function_handle->name + std::string(delimiter);
-        
-        // signature of the kernel
-        output_str += function_handle->signature + std::string(delimiter);
-
-        // number of paramters
-        output_str += std::to_string(function_handle->nb_params);
-        output_str += std::string(delimiter);
-
-        // parameter offsets
-        for(i=0; i<function_handle->nb_params; i++){
-            output_str += std::to_string(function_handle->param_offsets[i]);
-            output_str += std::string(delimiter);
-        }
+    POSHandle_CUDA_Module *module_handle;
+    std::unordered_set<std::string> resolved_names;
 
-        // parameter sizes
-        for(i=0; i<function_handle->nb_params; i++){
-            output_str += std::to_string(function_handle->param_sizes[i]);
-            output_str += std::string(delimiter);
-        }
+    hm_function
+        = (POSHandleManager_CUDA_Function*)(this->handle_managers[kPOS_ResourceTypeId_CUDA_Function]);
+    POS_CHECK_POINTER(hm_function);
+    hm_module
+        = (POSHandleManager_CUDA_Module*)(this->handle_managers[kPOS_ResourceTypeId_CUDA_Module]);
+    POS_CHECK_POINTER(hm_module);
 
-        // input paramters
-        output_str += std::to_string(function_handle->input_pointer_params.size());
-        output_str += std::string(delimiter);
-        for(i=0; i<function_handle->input_pointer_params.size(); i++){
-            output_str += std::to_string(function_handle->input_pointer_params[i]);
-            output_str += std::string(delimiter);
-        }
+    for(i=0; i<hm_function->get_nb_handles(); i++){
+        POS_CHECK_POINTER(function_handle = hm_function->get_handle_by_id(i));
+        if(function_handle->is_resolved){ resolved_names.insert(function_handle->name); }
+    }
 
-        // output paramters
-        output_str += std::to_string(function_handle->output_pointer_params.size());
-        output_str += std::string(delimiter);
-        for(i=0; i<function_handle->output_pointer_params.size(); i++){
-            output_str += std::to_string(function_handle->output_pointer_params[i]);
-            output_str += std::string(delimiter);
+    // kernels left unresolved within the modules are those never launched
+    hm_function->lazy_metric_counters.reset_counter(POSHandleManager_CUDA_Function::LAZY_indexed_kernels);
+    hm_function->lazy_metric_counters.reset_counter(POSHandleManager_CUDA_Function::LAZY_never_resolved_kernels);
+    for(i=0; i<hm_module->get_nb_handles(); i++){
+        POS_CHECK_POINTER(module_handle = hm_module->get_handle_by_id(i));
+        for(POSCudaFunctionDesp *desp : module_handle->function_desps){
+            if(desp->is_resolved){ continue; }
+            hm_function->lazy_metric_counters.add_counter(POSHandleManager_CUDA_Function::LAZY_indexed_kernels);
+            if(resolved_names.count(desp->name) == 0){
+                hm_function->lazy_metric_counters.add_counter(POSHandleManager_CUDA_Function::LAZY_never_resolved_kernels);
+            }
         }
+    }
 
-        // inout parameters
-        output_str += std::to_string(function_handle->inout_pointer_params.size());
-        output_str += std::string(delimiter);
-        for(i=0; i<function_handle->inout_pointer_params.size(); i++){
-            output_str += std::to_string(function_handle->inout_pointer_params[i]);
-            output_str += std::string(delimiter);
-        }
+    hm_function->print_lazy_metrics();
+}
 
-        // suspicious paramters
-        output_str += std::to_string(function_handle->suspicious_params.size());
-        output_str += std::string(delimiter);
-        for(i=0; i<function_handle->suspicious_params.size(); i++){
-            output_str += std::to_string(function_handle->suspicious_params[i]);
-            output_str += std::string(delimiter);
-        }
 
-        // has verified suspicious paramters
-        if(function_handle->has_verified_params){
-            output_str += std::string("1") + std::string(delimiter);
-
-            // inout paramters
-            output_str += std::to_string(function_handle->confirmed_suspicious_params.size());
-            output_str += std::string(delimiter);
-            for(i=0; i<function_handle->confirmed_suspicious_params.size(); i++){
-                output_str += std::to_string(function_handle->confirmed_suspicious_params[i].first);    // param_index
-                output_str += std::string(delimiter);
-                output_str += std::to_string(function_handle->confirmed_suspicious_params[i].second);   // offset
-                output_str += std::string(delimiter);
-            }
-        } else {
-            output_str += std::string("0") + std::string(delimiter);
-        }
+void POSClient_CUDA::__print_arg_cache_metrics() {
+    uint64_t i;
+    POSHandleManager_CUDA_Function *hm_function;
+    POSHandle_CUDA_Function *function_handle;
+    const POSUtil_CUDA_Kernel_Arg_Cache<POSHandle_CUDA_Memory>::pos_kernel_arg_cache_metrics_t *metrics;
 
-        // cbank parameters
-        output_str += std::to_string(function_handle->cbank_param_size);
+    hm_function
+        = (POSHandleManager_CUDA_Function*)(this->handle_managers[kPOS_ResourceTypeId_CUDA_Function]);
+    POS_CHECK_POINTER(hm_function);
+
+    // the counters are kept by the argument cache of each kernel, so that launches needn't touch a shared map
+    hm_function->arg_cache_metric_counters.reset_counters();
+    for(i=0; i<hm_function->get_nb_handles(); i++){
+        POS_CHECK_POINTER(function_handle = hm_function->get_handle_by_id(i));
+        metrics = &function_handle->arg_cache.get_metrics();
+        hm_function->arg_cache_metric_counters.add_counter(POSHandleManager_CUDA_Function::ARG_CACHE_hits, metrics->nb_hits);
+        hm_function->arg_cache_metric_counters.add_counter(POSHandleManager_CUDA_Function::ARG_CACHE_misses, metrics->nb_misses);
+        hm_function->arg_cache_metric_counters.add_counter(
+            POSHandleManager_CUDA_Function::ARG_CACHE_bypasses, metrics->nb_bypasses
+        );
+        hm_function->arg_cache_metric_counters.add_counter(
+            POSHandleManager_CUDA_Function::ARG_CACHE_invalidations, metrics->nb_invalidations
+        );
+    }
+
+    hm_function->print_arg_cache_metrics();
+}
 
-        return output_str;
-    };
+
+void POSClient_CUDA::__dump_hm_cuda_functions() {
+    uint64_t nb_functions, i;
+    POSHandleManager_CUDA_Function *hm_function;
+    POSHandleManager_CUDA_Module *hm_module;
+    POSHandle_CUDA_Function *function_handle;
+    POSCudaFunctionDesp *desp;
+    std::vector<POSCudaFunctionDesp*> function_desps, cached_desps, dumped_desps;
+    pos_retval_t retval;
 
     // if we have already save the kernels, we can skip
     // if(likely(this->_cxt.is_load_kernel_from_cache == true)){
@@ -570,19 +565,49 @@ void POSClient_CUDA::__dump_hm_cuda_functions() {
     hm_function 
         = (POSHandleManager_CUDA_Function*)(this->handle_managers[kPOS_ResourceTypeId_CUDA_Function]);
     POS_CHECK_POINTER(hm_function);
-
-    output_file.open(this->_cxt.kernel_meta_path.c_str(), std::fstream::in | std::fstream::out | std::fstream::app);
+    hm_module
+        = (POSHandleManager_CUDA_Module*)(this->handle_managers[kPOS_ResourceTypeId_CUDA_Module]);
+    POS_CHECK_POINTER(hm_module);
 
     nb_functions = hm_function->get_nb_handles();
     for(i=0; i<nb_functions; i++){
         POS_CHECK_POINTER(function_handle = hm_function->get_handle_by_id(i));
-        output_file << dump_function_metas(function_handle) << std::endl;
+        POS_CHECK_POINTER(desp = new POSCudaFunctionDesp_t());
+        desp->name = function_handle->name;
+        desp->signature = function_handle->signature;
+        desp->nb_params = function_handle->nb_params;
+        desp->param_offsets = function_handle->param_offsets;
+        desp->param_sizes = function_handle->param_sizes;
+        desp->input_pointer_params = function_handle->input_pointer_params;
+        desp->output_pointer_params = function_handle->output_pointer_params;
+        desp->inout_pointer_params = function_handle->inout_pointer_params;
+        desp->suspicious_params = function_handle->suspicious_params;
+        desp->has_verified_params = function_handle->has_verified_params;
+        desp->confirmed_suspicious_params = function_handle->confirmed_suspicious_params;
+        desp->cbank_param_size = function_handle->cbank_param_size;
+        desp->is_resolved = function_handle->is_resolved;
+        function_desps.push_back(desp);
     }
 
-    output_file.flush();
-    output_file.close();
+    if(POSUtil_CUDA_Kernel_Meta_Cache::is_text_path(this->_cxt.kernel_meta_path)){
+        retval = POSUtil_CUDA_Kernel_Meta_Cache::dump_text(
+            /* file_path */ this->_cxt.kernel_meta_path, /* desps */ function_desps, /* append */ true
+        );
+    } else {
+        // merge with the cached kernels, the newly verified metadata of this run goes first
+        hm_module->cached_function_desps.collect(cached_desps);
+        dumped_desps = function_desps;
+        dumped_desps.insert(dumped_desps.end(), cached_desps.begin(), cached_desps.end());
+        retval = POSUtil_CUDA_Kernel_Meta_Cache::dump_binary(
+            /* file_path */ this->_cxt.kernel_meta_path, /* desps */ dumped_desps
+        );
+    }
+    if(unlikely(retval != POS_SUCCESS)){
+        POS_WARN_C("failed to dump kernel metadata to %s", this->_cxt.kernel_meta_path.c_str());
+        goto exit;
+    }
     POS_LOG("finish dump kernel metadata to %s", this->_cxt.kernel_meta_path.c_str());
 
 exit:
-    ;
+    for(POSCudaFunctionDesp *function_desp : function_desps){ delete function_desp; }
 }
@@ -34,12 +34,14 @@ POSHandle_CUDA_Function::POSHandle_CUDA_Function(void *client_addr_, size_t size
 {
     this->resource_type_id = kPOS_ResourceTypeId_CUDA_Function;
     this->has_verified_params = false;
+    this->is_resolved = true;
 }
 
 
 POSHandle_CUDA_Function::POSHandle_CUDA_Function(void* hm) : POSHandle_CUDA(hm)
 {
     this->resource_type_id = kPOS_ResourceTypeId_CUDA_Function;
+    this->is_resolved = true;
 }
 
 
@@ -55,6 +57,32 @@ pos_retval_t POSHandle_CUDA_Function::tear_down(){
 }
 
 
+pos_retval_t POSHandle_CUDA_Function::resolve_params(){
+    pos_retval_t retval = POS_SUCCESS;
+    POSCudaFunctionDesp_t desp;
+
+    if(likely(this->is_resolved)){ goto exit; }
+
+    retval = POSUtil_CUDA_Kernel_Parser::parse_by_prototype(this->name.c_str(), &desp);
+    if(unlikely(retval != POS_SUCCESS)){
+        POS_WARN_C("failed to resolve the parameters of kernel: name(%s)", this->name.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    this->signature = desp.signature;
+    this->input_pointer_params = desp.input_pointer_params;
+    this->inout_pointer_params = desp.inout_pointer_params;
+    this->output_pointer_params = desp.output_pointer_params;
+    this->suspicious_params = desp.suspicious_params;
+    this->is_resolved = true;
+    this->arg_cache.clear();
+
+exit:
+    return retval;
+}
+
+
 pos_retval_t POSHandle_CUDA_Function::__add(uint64_t version_id, uint64_t stream_id){
     return POS_SUCCESS;
 }
@@ -179,6 +207,27 @@ exit:
 }
 
 
+void POSHandleManager_CUDA_Function::print_lazy_metrics(){
+    static std::unordered_map<lazy_metrics_counter_type_t, std::string> counter_names = {
+        { LAZY_indexed_kernels, "# Lazily Indexed Kernels" },
+        { LAZY_resolved_kernels, "# Kernels Resolved on Launch" },
+        { LAZY_never_resolved_kernels, "# Kernels Never Resolved" }
+    };
+    POS_LOG("[Lazy Kernel Meta Metrics]:\n%s", this->lazy_metric_counters.str(counter_names).c_str());
+}
+
+
+void POSHandleManager_CUDA_Function::print_arg_cache_metrics(){
+    static std::unordered_map<arg_cache_metrics_counter_type_t, std::string> counter_names = {
+        { ARG_CACHE_hits, "# Launches Hit the Argument Cache" },
+        { ARG_CACHE_misses, "# Launches Missed the Argument Cache" },
+        { ARG_CACHE_bypasses, "# Launches Bypassed the Argument Cache" },
+        { ARG_CACHE_invalidations, "# Invalidated Argument Cache Entries" }
+    };
+    POS_LOG("[Kernel Argument Cache Metrics]:\n%s", this->arg_cache_metric_counters.str(counter_names).c_str());
+}
+
+
 pos_retval_t POSHandleManager_CUDA_Function::preserve_pooled_handles(uint64_t amount){
     return POS_SUCCESS;
 }
@@ -271,6 +320,9 @@ pos_retval_t POSHandleManager_CUDA_Function::__reallocate_single_handle(void* ma
 
     (*handle)->cbank_param_size = cuda_function_binary.cbank_param_size();
 
+    // kernels persisted before being resolved carry no signature, which are resolved on their next launch
+    (*handle)->is_resolved = (*handle)->signature.size() > 0;
+
 exit:
     return retval;
 }
@@ -208,6 +208,8 @@ pos_retval_t POSHandleManager_CUDA_Module::init(std::map<uint64_t, std::vector<P
     pos_retval_t retval = POS_SUCCESS;
 
     this->_rid = kPOS_ResourceTypeId_CUDA_Module;
+    this->fatbin_cache = nullptr;
+    this->is_lazy_kernel_meta = false;
 
 exit:
     return retval;
@@ -216,144 +218,12 @@ exit:
 
 pos_retval_t POSHandleManager_CUDA_Module::load_cached_function_metas(std::string &file_path){
     pos_retval_t retval = POS_SUCCESS;
-    uint64_t i;
-    std::string line, stream;
-    POSCudaFunctionDesp_t *new_desp;
-    char delimiter = '|';
-
-    auto generate_desp_from_meta = [](std::vector<std::string>& metas) -> POSCudaFunctionDesp_t* {
-        uint64_t i;
-        std::vector<uint32_t> param_offsets;
-        std::vector<uint32_t> param_sizes;
-        std::vector<uint32_t> input_pointer_params;
-        std::vector<uint32_t> output_pointer_params;
-        std::vector<uint32_t> inout_pointer_params;
-        std::vector<uint32_t> suspicious_params;
-        std::vector<std::pair<uint32_t,uint64_t>> confirmed_suspicious_params;
-        bool confirmed;
-        uint64_t nb_input_pointer_params, nb_output_pointer_params, nb_inout_pointer_params, 
-                nb_suspicious_params, nb_confirmed_suspicious_params, has_verified_params;
-        uint64_t ptr;
-
-        POSCudaFunctionDesp_t *new_desp = new POSCudaFunctionDesp_t();
-        POS_CHECK_POINTER(new_desp);
-
-        ptr = 0;
-        
-        // mangled name of the kernel
-        new_desp->name = metas[ptr];
-        ptr++;
-
-        // signature of the kernel
-        new_desp->signature = metas[ptr];
-        ptr++;
-
-        // number of paramters
-        new_desp->nb_params = std::stoul(metas[ptr]);
-        ptr++;
-
-        // parameter offsets
-        for(i=0; i<new_desp->nb_params; i++){
-            param_offsets.push_back(std::stoul(metas[ptr+i]));   
-        }
-        ptr += new_desp->nb_params;
-        new_desp->param_offsets = param_offsets;
-
-        // parameter sizes
-        for(i=0; i<new_desp->nb_params; i++){
-            param_sizes.push_back(std::stoul(metas[ptr+i]));
-        }
-        ptr += new_desp->nb_params;
-        new_desp->param_sizes = param_sizes;
-
-        // input paramters
-        nb_input_pointer_params = std::stoul(metas[ptr]);
-        ptr++;
-        for(i=0; i<nb_input_pointer_params; i++){
-            input_pointer_params.push_back(std::stoul(metas[ptr+i]));
-        }
-        ptr += nb_input_pointer_params;
-        new_desp->input_pointer_params = input_pointer_params;
-
-        // output paramters
-        nb_output_pointer_params = std::stoul(metas[ptr]);
-        ptr++;
-        for(i=0; i<nb_output_pointer_params; i++){
-            output_pointer_params.push_back(std::stoul(metas[ptr+i]));
-        }
-        ptr += nb_output_pointer_params;
-        new_desp->output_pointer_params = output_pointer_params;
-
-        // inout paramters
-        nb_inout_pointer_params = std::stoul(metas[ptr]);
-        ptr++;
-        for(i=0; i<nb_inout_pointer_params; i++){
-            inout_pointer_params.push_back(std::stoul(metas[ptr+i]));
-        }
-        ptr += nb_inout_pointer_params;
-        new_desp->inout_pointer_params = inout_pointer_params;
-
-        // suspicious paramters
-        nb_suspicious_params = std::stoul(metas[ptr]);
-        ptr++;
-        for(i=0; i<nb_suspicious_params; i++){
-            suspicious_params.push_back(std::stoul(metas[ptr+i]));
-        }
-        ptr += nb_suspicious_params;
-        new_desp->suspicious_params = suspicious_params;
-
-        // has verified suspicious paramters
-        has_verified_params = std::stoul(metas[ptr]);
-        ptr++;
-        new_desp->has_verified_params = has_verified_params;
-
-        if(has_verified_params == 1){
-            // index of those parameter which is a structure (contains pointers)
-            nb_confirmed_suspicious_params = std::stoul(metas[ptr]);
-            ptr++;
-            for(i=0; i<nb_confirmed_suspicious_params; i++){
-                confirmed_suspicious_params.push_back({
-                    /* param_index */ std::stoul(metas[ptr+2*i]), /* offset */ std::stoul(metas[ptr+2*i+1])
-                });
-            }
-            ptr += nb_confirmed_suspicious_params;
-            new_desp->confirmed_suspicious_params = confirmed_suspicious_params;
-        }
 
-        // cbank parameter size (p.s., what is this?)
-        new_desp->cbank_param_size = std::stoul(metas[ptr].c_str());
-
-        return new_desp;
-    };
-
-    std::ifstream file(file_path.c_str(), std::ios::in);
-    if(likely(file.is_open())){
-        POS_LOG("parsing cached kernel metas from file %s...", file_path.c_str());
-        i = 0;
-        while (std::getline(file, line)) {
-            // split by ","
-            std::stringstream ss(line);
-            std::string segment;
-            std::vector<std::string> metas;
-            while (std::getline(ss, segment, delimiter)) { metas.push_back(segment); }
-
-            // parse
-            new_desp = generate_desp_from_meta(metas);
-            cached_function_desps.insert(
-                std::pair<std::string, POSCudaFunctionDesp_t*>(new_desp->name, new_desp)
-            );
-
-            i++;
-        }
-
-        POS_LOG("parsed %lu of cached kernel metas from file %s", i, file_path.c_str());
-        file.close();
-    } else {
-        retval = POS_FAILED_NOT_EXIST;
+    retval = this->cached_function_desps.load(file_path);
+    if(unlikely(retval != POS_SUCCESS)){
         POS_WARN("failed to load kernel meta file %s, fall back to slow path", file_path.c_str());
     }
 
-exit:
     return retval;
 }
 
@@ -136,7 +136,9 @@ namespace cu_module_load {
             /* binary_ptr */ (uint8_t*)(pos_api_param_addr(wqe, 1)),
             /* binary_size */ pos_api_param_size(wqe, 1),
             /* deps */ &(module_handle->function_desps),
-            /* cached_desp_map */ hm_module->cached_function_desps
+            /* cached_desp_map */ hm_module->cached_function_desps,
+            /* fatbin_cache */ hm_module->fatbin_cache,
+            /* is_lazy */ hm_module->is_lazy_kernel_meta
         );
         POS_DEBUG(
             "parse(cu_module_load): found %lu functions in the fatbin",
@@ -317,7 +319,9 @@ namespace cu_module_load_data {
             /* binary_ptr */ (uint8_t*)(pos_api_param_addr(wqe, 0)),
             /* binary_size */ pos_api_param_size(wqe, 0),
             /* deps */ &(module_handle->function_desps),
-            /* cached_desp_map */ hm_module->cached_function_desps
+            /* cached_desp_map */ hm_module->cached_function_desps,
+            /* fatbin_cache */ hm_module->fatbin_cache,
+            /* is_lazy */ hm_module->is_lazy_kernel_meta
         );
         if(unlikely(retval != POS_SUCCESS)){
             POS_WARN(
@@ -519,6 +523,7 @@ namespace __register_function {
         function_handle->has_verified_params = function_desp->has_verified_params;
         function_handle->confirmed_suspicious_params = function_desp->confirmed_suspicious_params;
         function_handle->signature = function_desp->signature;
+        function_handle->is_resolved = function_desp->is_resolved;
 
         // set handle state as pending to create
         function_handle->mark_status(kPOS_HandleStatus_Create_Pending);
@@ -665,6 +670,7 @@ namespace cu_module_get_function {
         function_handle->has_verified_params = function_desp->has_verified_params;
         function_handle->confirmed_suspicious_params = function_desp->confirmed_suspicious_params;
         function_handle->signature = function_desp->signature;
+        function_handle->is_resolved = function_desp->is_resolved;
 
         // set handle state as pending to create
         function_handle->mark_status(kPOS_HandleStatus_Create_Pending);
@@ -186,6 +186,11 @@ namespace cuda_launch_kernel {
         uint8_t *struct_base_ptr;
         uint64_t arg_size, struct_offset;
 
+        void **arg_values;
+        uint64_t k, nb_arg_values, memory_offset;
+        const POSUtil_CUDA_Kernel_Arg_Cache<POSHandle_CUDA_Memory>::pos_kernel_arg_cache_entry_t *arg_cache_entry;
+        POSUtil_CUDA_Kernel_Arg_Cache<POSHandle_CUDA_Memory>::pos_kernel_arg_cache_entry_t *new_arg_cache_entry;
+
         POSHandleManager_CUDA_Function *hm_function;
         POSHandleManager_CUDA_Stream *hm_stream;
         POSHandleManager_CUDA_Memory *hm_memory;
@@ -207,6 +212,38 @@ namespace cuda_launch_kernel {
         #undef __ADDR_UNIT
         };
 
+        /*!
+         *  \brief  obtain the memory handle of the k-th pointer argument, from the entry of the argument cache,
+         *          or by looking up the pointer if the argument cache is bypassed
+         *  \param  k           index of the pointer argument
+         *  \param  arg_offset  offset of the pointer within the arguments
+         *  \return true for the pointer points to a memory handle (stored to memory_handle and memory_offset)
+         */
+        auto __resolve_arg = [&](uint64_t k, uint64_t arg_offset) -> bool {
+            if(likely(arg_cache_entry != nullptr)){
+                memory_handle = arg_cache_entry->handles()[k];
+                memory_offset = arg_cache_entry->offsets()[k];
+                return memory_handle != nullptr;
+            }
+
+            arg_value = *((void**)(args + arg_offset));
+
+            /*!
+             *  \note   sometimes one would launch kernel with some pointer params are nullptr (at least pytorch did),
+             *          this is probably normal, so we just ignore this situation
+             */
+            if(unlikely(arg_value == nullptr)){
+                return false;
+            }
+
+            // non-exist memory address would be ignored as well
+            return POS_SUCCESS == hm_memory->get_handle_by_client_addr(
+                /* client_addr */ arg_value,
+                /* handle */ &memory_handle,
+                /* offset */ &memory_offset
+            );
+        };
+
         /*!
          *  \brief  printing the kernels direction after first parsing
          *  \param  function_handle handler of the function to be printed
@@ -303,6 +340,19 @@ namespace cuda_launch_kernel {
             /* handle */ function_handle
         });
 
+        // kernels extracted in lazy mode are resolved on their first launch
+        if(unlikely(!function_handle->is_resolved)){
+            retval = function_handle->resolve_params();
+            if(unlikely(retval != POS_SUCCESS)){
+                POS_WARN(
+                    "parse(cuda_launch_kernel): failed to resolve the parameters of the kernel: name(%s)",
+                    function_handle->name.c_str()
+                );
+                goto exit;
+            }
+            hm_function->lazy_metric_counters.add_counter(POSHandleManager_CUDA_Function::LAZY_resolved_kernels);
+        }
+
         // find out the involved stream
         retval = hm_stream->get_handle_by_client_addr(
             /* client_addr */ (void*)pos_api_param_value(wqe, 5, uint64_t),
@@ -327,121 +377,135 @@ namespace cuda_launch_kernel {
         args += (sizeof(size_t) + sizeof(uint16_t) * function_handle->nb_params);
         
         /*!
-         *  \note   record all input memory areas
+         *  \note   launches with the same pointers since the last malloc / free (e.g., steps of an inference loop)
+         *          hit the argument cache of the kernel, and skip looking up the pointers one by one; the argument
+         *          cache is bypassed while the address map keeps changing between the launches of the kernel
          */
-        for(i=0; i<function_handle->input_pointer_params.size(); i++){
-            param_index = function_handle->input_pointer_params[i];
- 
-            arg_addr = args + function_handle->param_offsets[param_index];
-            POS_CHECK_POINTER(arg_addr);
-            arg_value = *((void**)arg_addr);
-            
-            /*!
-             *  \note   sometimes one would launch kernel with some pointer params are nullptr (at least pytorch did),
-             *          this is probably normal, so we just ignore this situation
-             */
-            if(unlikely(arg_value == nullptr)){
-                continue;
+        arg_cache_entry = nullptr;
+        if(likely(function_handle->arg_cache.arm(hm_memory->get_address_generation()))){
+            // decode the pointer arguments in the order of input, inout, confirmed suspicious (once the parameters
+            // are verified) and output parameters, which forms the key of the argument cache
+            nb_arg_values = function_handle->input_pointer_params.size()
+                            + function_handle->inout_pointer_params.size()
+                            + function_handle->output_pointer_params.size();
+            if(likely(function_handle->has_verified_params)){
+                nb_arg_values += function_handle->confirmed_suspicious_params.size();
+            }
+            arg_values = function_handle->arg_cache.prepare_key(nb_arg_values);
+            k = 0;
+            for(i=0; i<function_handle->input_pointer_params.size(); i++){
+                param_index = function_handle->input_pointer_params[i];
+                arg_values[k++] = *((void**)(args + function_handle->param_offsets[param_index]));
+            }
+            for(i=0; i<function_handle->inout_pointer_params.size(); i++){
+                param_index = function_handle->inout_pointer_params[i];
+                arg_values[k++] = *((void**)(args + function_handle->param_offsets[param_index]));
+            }
+            if(likely(function_handle->has_verified_params)){
+                for(i=0; i<function_handle->confirmed_suspicious_params.size(); i++){
+                    param_index = function_handle->confirmed_suspicious_params[i].first;
+                    struct_offset = function_handle->confirmed_suspicious_params[i].second;
+                    arg_values[k++] = *((void**)(args + function_handle->param_offsets[param_index] + struct_offset));
+                }
+            }
+            for(i=0; i<function_handle->output_pointer_params.size(); i++){
+                param_index = function_handle->output_pointer_params[i];
+                arg_values[k++] = *((void**)(args + function_handle->param_offsets[param_index]));
             }
 
-            tmp_retval = hm_memory->get_handle_by_client_addr(
-                /* client_addr */ arg_value,
-                /* handle */ &memory_handle
+            arg_cache_entry = function_handle->arg_cache.lookup(
+                /* generation */ hm_memory->get_address_generation()
             );
+            if(unlikely(arg_cache_entry == nullptr)){
+                new_arg_cache_entry = function_handle->arg_cache.insert(
+                    /* generation */ hm_memory->get_address_generation()
+                );
+                for(k=0; k<nb_arg_values; k++){
+                    if(unlikely(arg_values[k] == nullptr)){
+                        new_arg_cache_entry->handles()[k] = nullptr;
+                        continue;
+                    }
 
-            if(unlikely(tmp_retval != POS_SUCCESS)){
-                // POS_WARN(
-                //     "%lu(th) parameter of kernel %s is marked as input during kernel parsing phrase, "
-                //     "yet it contains non-exist memory address during launching: given client addr(%p)",
-                //     param_index, function_handle->signature.c_str(), arg_value
-                // );
+                    // the handle is set as nullptr for non-exist memory address
+                    hm_memory->get_handle_by_client_addr(
+                        /* client_addr */ arg_values[k],
+                        /* handle */ &new_arg_cache_entry->handles()[k],
+                        /* offset */ &new_arg_cache_entry->offsets()[k]
+                    );
+                }
+                arg_cache_entry = new_arg_cache_entry;
+            }
+        }
+
+        /*!
+         *  \note   record all input memory areas
+         */
+        k = 0;
+        for(i=0; i<function_handle->input_pointer_params.size(); i++, k++){
+            param_index = function_handle->input_pointer_params[i];
+            if(unlikely(!__resolve_arg(k, function_handle->param_offsets[param_index]))){
                 continue;
             }
 
             wqe->record_handle<kPOS_Edge_Direction_In>({
                 /* handle */ memory_handle,
                 /* param_index */ param_index,
-                /* offset */ (uint64_t)(arg_value) - (uint64_t)(memory_handle->client_addr)
+                /* offset */ memory_offset
             });
         }
-        
+
         /*!
          *  \note   record all inout memory areas
          */
-        for(i=0; i<function_handle->inout_pointer_params.size(); i++){
+        for(i=0; i<function_handle->inout_pointer_params.size(); i++, k++){
             param_index = function_handle->inout_pointer_params[i];
-
-            arg_addr = args + function_handle->param_offsets[param_index];
-            POS_CHECK_POINTER(arg_addr);
-            arg_value = *((void**)arg_addr);
-            
-            /*!
-             *  \note   sometimes one would launch kernel with some pointer params are nullptr (at least pytorch did),
-             *          this is probably normal, so we just ignore this situation
-             */
-            if(unlikely(arg_value == nullptr)){
-                continue;
-            }
-
-            tmp_retval = hm_memory->get_handle_by_client_addr(
-                /* client_addr */ arg_value,
-                /* handle */ &memory_handle
-            );
-
-            if(unlikely(tmp_retval != POS_SUCCESS)){
-                // POS_WARN(
-                //     "%lu(th) parameter of kernel %s is marked as inout during kernel parsing phrase, "
-                //     "yet it contains non-exist memory address during launching: given client addr(%p)",
-                //     param_index, function_handle->signature.c_str(), arg_value
-                // );
+            if(unlikely(!__resolve_arg(k, function_handle->param_offsets[param_index]))){
                 continue;
             }
 
             wqe->record_handle<kPOS_Edge_Direction_InOut>({
                 /* handle */ memory_handle,
                 /* param_index */ param_index,
-                /* offset */ (uint64_t)(arg_value) - (uint64_t)(memory_handle->client_addr)
+                /* offset */ memory_offset
             });
 
             hm_memory->record_modified_handle(memory_handle);
         }
 
         /*!
-         *  \note   record all output memory areas
+         *  \note   record all confirmed suspicious memory areas, which are treated as inout
          */
-        for(i=0; i<function_handle->output_pointer_params.size(); i++){
-            param_index = function_handle->output_pointer_params[i];
+        if(likely(function_handle->has_verified_params)){
+            for(i=0; i<function_handle->confirmed_suspicious_params.size(); i++, k++){
+                param_index = function_handle->confirmed_suspicious_params[i].first;
+                struct_offset = function_handle->confirmed_suspicious_params[i].second;
+                if(unlikely(!__resolve_arg(k, function_handle->param_offsets[param_index] + struct_offset))){
+                    continue;
+                }
 
-            arg_addr = args + function_handle->param_offsets[param_index];
-            POS_CHECK_POINTER(arg_addr);
-            arg_value = *((void**)arg_addr);
-            
-            /*!
-             *  \note   sometimes one would launch kernel with some pointer params are nullptr (at least pytorch did),
-             *          this is probably normal, so we just ignore this situation
-             */
-            if(unlikely(arg_value == nullptr)){
-                continue;
-            }
+                wqe->record_handle<kPOS_Edge_Direction_InOut>({
+                    /* handle */ memory_handle,
+                    /* param_index */ param_index,
+                    /* offset */ memory_offset
+                });
 
-            tmp_retval = hm_memory->get_handle_by_client_addr(
-                /* client_addr */ arg_value,
-                /* handle */ &memory_handle
-            );
+                hm_memory->record_modified_handle(memory_handle);
+            }
+        }
 
-            if(unlikely(tmp_retval != POS_SUCCESS)){
-                // POS_WARN(
-                //     "%lu(th) parameter of kernel %s is marked as output during kernel parsing phrase, "
-                //     "yet it contains non-exist memory address during launching: given client addr(%p)",
-                //     param_index, function_handle->signature.c_str(), arg_value
-                // );
+        /*!
+         *  \note   record all output memory areas
+         */
+        for(i=0; i<function_handle->output_pointer_params.size(); i++, k++){
+            param_index = function_handle->output_pointer_params[i];
+            if(unlikely(!__resolve_arg(k, function_handle->param_offsets[param_index]))){
                 continue;
             }
 
             wqe->record_handle<kPOS_Edge_Direction_Out>({
                 /* handle */ memory_handle,
                 /* param_index */ param_index,
-                /* offset */ (uint64_t)(arg_value) - (uint64_t)(memory_handle->client_addr)
+                /* offset */ memory_offset
             });
 
             hm_memory->record_modified_handle(memory_handle);
@@ -506,47 +570,11 @@ namespace cuda_launch_kernel {
             } // foreach suspicious_params
 
             function_handle->has_verified_params = true;
+
+            // the confirmed suspicious parameters are decoded since the next launch, which changes the key
+            function_handle->arg_cache.clear();
             
             // __print_kernel_directions(function_handle);
-        } else {
-            for(i=0; i<function_handle->confirmed_suspicious_params.size(); i++){
-                param_index = function_handle->confirmed_suspicious_params[i].first;
-                struct_offset = function_handle->confirmed_suspicious_params[i].second;
-
-                arg_addr = args + function_handle->param_offsets[param_index];
-                POS_CHECK_POINTER(arg_addr);
-                arg_value = *((void**)(arg_addr+struct_offset));
-
-                /*!
-                 *  \note   sometimes one would launch kernel with some pointer params are nullptr (at least pytorch did),
-                 *          this is probably normal, so we just ignore this situation
-                 */
-                if(unlikely(arg_value == nullptr)){
-                    continue;
-                }
-
-                tmp_retval = hm_memory->get_handle_by_client_addr(
-                    /* client_addr */ arg_value,
-                    /* handle */ &memory_handle
-                );
-
-                if(unlikely(tmp_retval != POS_SUCCESS)){
-                    // POS_WARN(
-                    //     "%lu(th) parameter of kernel %s is marked as suspicious output during kernel parsing phrase, "
-                    //     "yet it contains non-exist memory address during launching: given client addr(%p)",
-                    //     param_index, function_handle->signature.c_str(), arg_value
-                    // );
-                    continue;
-                }
-
-                wqe->record_handle<kPOS_Edge_Direction_InOut>({
-                    /* handle */ memory_handle,
-                    /* param_index */ param_index,
-                    /* offset */ (uint64_t)(arg_value) - (uint64_t)(memory_handle->client_addr)
-                });
-
-                hm_memory->record_modified_handle(memory_handle);
-            }
         }
 
     #if POS_CONF_RUNTIME_EnableTrace
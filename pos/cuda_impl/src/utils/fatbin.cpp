@@ -21,12 +21,36 @@
 #include "pos/include/log.h"
 #include "pos/include/utils/command_caller.h"
 #include "pos/include/utils/string.h"
+#include "pos/include/utils/demangle.h"
 #include "pos/cuda_impl/utils/fatbin.h"
 
 
 #include <clang-c/Index.h>
 
 
+const std::string& POSUtil_CUDA_Kernel_Parser::get_version_tag(){
+    static const std::string version_tag = [](){
+        CXString clang_version;
+        std::string toolchain;
+        uint64_t hash = 14695981039346656037ull;
+        char tag[64];
+
+        // the in-process demangler comes with the host compiler, the fallback parser comes with libclang
+        clang_version = clang_getClangVersion();
+        toolchain = std::string(__VERSION__) + std::string(";") + std::string(clang_getCString(clang_version));
+        clang_disposeString(clang_version);
+
+        // FNV-1a, which is stable across processes
+        for(const char& c : toolchain){ hash = (hash ^ (uint8_t)(c)) * 1099511628211ull; }
+
+        snprintf(tag, sizeof(tag), "p%u_%016lx", kVersion, hash);
+        return std::string(tag);
+    }();
+
+    return version_tag;
+}
+
+
 /*!
  *  \brief  preprocess a raw demangles name
  *  \param  kernel_str              the raw demangles name
@@ -75,6 +99,18 @@ pos_retval_t POSUtil_CUDA_Kernel_Parser::__generate_prototype(const std::string&
     pos_retval_t retval = POS_SUCCESS;
     std::string cmd;
 
+    // names that aren't mangled (e.g., extern "C" kernels) are prototypes themselves, as cu++filt prints
+    if(kernel_demangles_name.compare(0, 2, "_Z") != 0){
+        kernel_prototype = kernel_demangles_name;
+        goto exit;
+    }
+
+    // fast path: demangle in-process, as forking cu++filt for each kernel dominates module loading
+    if(likely(POS_SUCCESS == POSUtil_Demangle::demangle(kernel_demangles_name, kernel_prototype))){
+        goto exit;
+    }
+
+    // fallback to cu++filt, for names that the demangler of the host toolchain doesn't support
     cmd = std::string("cu++filt ") + kernel_demangles_name;
     kernel_prototype.clear();
     retval = POSUtil_Command_Caller::exec_sync(
@@ -96,6 +132,55 @@ exit:
     return retval;
 }
 
+/*!
+ *  \brief  classify the parameters of the kernel prototype without clang
+ *  \param  kernel_prototype        the generated kernel prototype
+ *  \param  function_desp           pointer to the function descriptor
+ *  \return POS_SUCCESS for successfully classified
+ *          POS_FAILED_INVALID_INPUT for prototype that can't be classified, should fallback to clang
+ */
+pos_retval_t POSUtil_CUDA_Kernel_Parser::__classify_prototype(const std::string& kernel_prototype, POSCudaFunctionDesp *function_desp){
+    pos_retval_t retval = POS_SUCCESS;
+    std::vector<std::string> params;
+    std::vector<uint32_t> input_pointer_params, inout_pointer_params;
+    pos_demangle_param_kind_t kind;
+    uint32_t i;
+
+    POS_CHECK_POINTER(function_desp);
+
+    // prototype of kernel that isn't mangled comes without parameter list
+    if(kernel_prototype.find('(') == std::string::npos){ goto exit; }
+
+    retval = POSUtil_Demangle::split_params(kernel_prototype, params);
+    if(unlikely(retval != POS_SUCCESS)){ goto exit; }
+
+    for(i=0; i<params.size(); i++){
+        retval = POSUtil_Demangle::classify_param(params[i], kind);
+        if(unlikely(retval != POS_SUCCESS)){ goto exit; }
+
+        if(kind == kPOS_DemangleParam_ConstPointer){
+            input_pointer_params.push_back(i);
+        } else if(kind == kPOS_DemangleParam_Pointer){
+            /*!
+             *  \note   for non-const pointers, we need to classify them as non-const
+             *          pointers, as they might also be read by the kernel
+             */
+            inout_pointer_params.push_back(i);
+        }
+    }
+
+    function_desp->input_pointer_params.insert(
+        function_desp->input_pointer_params.end(), input_pointer_params.begin(), input_pointer_params.end()
+    );
+    function_desp->inout_pointer_params.insert(
+        function_desp->inout_pointer_params.end(), inout_pointer_params.begin(), inout_pointer_params.end()
+    );
+
+exit:
+    return retval;
+}
+
+
 /*!
  *  \brief  parsing the kernel prototype
  *  \param  kernel_prototype        the generated kernel prototype
@@ -215,3 +300,117 @@ pos_retval_t POSUtil_CUDA_Kernel_Parser::__parse_prototype(const std::string& ke
 exit:
     return retval;
 }
+
+
+POSUtil_CUDA_Fatbin_Loader_Pool& POSUtil_CUDA_Fatbin_Loader_Pool::get(){
+    static POSUtil_CUDA_Fatbin_Loader_Pool pool;
+    return pool;
+}
+
+
+POSUtil_CUDA_Fatbin_Loader_Pool::~POSUtil_CUDA_Fatbin_Loader_Pool(){
+    uint64_t i;
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_is_stopping = true;
+    }
+    this->_job_cv.notify_all();
+
+    for(i=0; i<this->_threads.size(); i++){
+        if(this->_threads[i]->joinable()){ this->_threads[i]->join(); }
+        delete this->_threads[i];
+    }
+}
+
+
+void POSUtil_CUDA_Fatbin_Loader_Pool::run(
+    uint64_t nb_items, uint64_t nb_threads, uint64_t batch_size, const std::function<void(uint64_t)>& func
+){
+    pos_fatbin_loader_job_t job;
+    uint64_t i;
+
+    POS_ASSERT(batch_size > 0);
+
+    job.func = &func;
+    job.nb_items = nb_items;
+    job.batch_size = batch_size;
+    job.next_item.store(0, std::memory_order_relaxed);
+    job.placement = POSPlacement::current();
+    job.nb_wanted = nb_threads > 1 ? nb_threads - 1 : 0;
+    job.nb_joined = 0;
+    job.nb_done = 0;
+
+    if(job.nb_wanted > 0){
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        // spawn the loader threads on demand, they're kept for following runs
+        for(i=this->_threads.size(); i<job.nb_wanted; i++){
+            this->_threads.push_back(new std::thread(&POSUtil_CUDA_Fatbin_Loader_Pool::__loader_main, this, i));
+            POS_CHECK_POINTER(this->_threads.back());
+        }
+        this->_jobs.push_back(&job);
+    }
+    if(job.nb_wanted == 1){
+        this->_job_cv.notify_one();
+    } else if(job.nb_wanted > 1){
+        this->_job_cv.notify_all();
+    }
+
+    POSUtil_CUDA_Fatbin_Loader_Pool::__drain(job);
+
+    if(job.nb_wanted > 0){
+        std::unique_lock<std::mutex> lock(this->_mutex);
+
+        // all items are grabbed, no more loader threads should join, and wait for those joined
+        this->_jobs.remove(&job);
+        this->_done_cv.wait(lock, [&](){ return job.nb_done == job.nb_joined; });
+    }
+}
+
+
+void POSUtil_CUDA_Fatbin_Loader_Pool::__drain(pos_fatbin_loader_job_t& job){
+    uint64_t begin, end, id;
+
+    while((begin = job.next_item.fetch_add(job.batch_size, std::memory_order_relaxed)) < job.nb_items){
+        end = std::min(begin + job.batch_size, job.nb_items);
+        for(id=begin; id<end; id++){ (*job.func)(id); }
+    }
+}
+
+
+void POSUtil_CUDA_Fatbin_Loader_Pool::__loader_main(uint64_t id){
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    typename std::list<pos_fatbin_loader_job_t*>::iterator job_iter;
+    pos_fatbin_loader_job_t *job;
+
+    while(true){
+        this->_job_cv.wait(lock, [&](){
+            if(this->_is_stopping){ return true; }
+            for(job_iter=this->_jobs.begin(); job_iter!=this->_jobs.end(); job_iter++){
+                if((*job_iter)->nb_joined < (*job_iter)->nb_wanted){ return true; }
+            }
+            return false;
+        });
+        if(unlikely(this->_is_stopping)){ break; }
+
+        job = *job_iter;
+        job->nb_joined += 1;
+        lock.unlock();
+
+        {
+            // placed under the placement of the calling thread only during the run, as the placement
+            // might be destroyed before the pool
+            POSPlacementScope placement_scope(
+                /* placement */ job->placement,
+                /* role */ kPOS_PlacementRole_Loader,
+                /* name */ "fatbin_loader(" + std::to_string(id) + ")"
+            );
+            POSUtil_CUDA_Fatbin_Loader_Pool::__drain(*job);
+        }
+
+        lock.lock();
+        job->nb_done += 1;
+        if(job->nb_done == job->nb_joined){ this->_done_cv.notify_all(); }
+    }
+}
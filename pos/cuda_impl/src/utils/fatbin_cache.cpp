@@ -0,0 +1,567 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <atomic>
+#include <filesystem>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
+
+
+POSUtil_CUDA_Fatbin_Cache::POSUtil_CUDA_Fatbin_Cache()
+    :   _dir_mtime_ns(0), _text_size(0), _text_capacity(kDefaultTextCapacity), _is_text_spill(false),
+        _nb_writing(0), _writer(nullptr), _is_stopping(false) {}
+
+
+POSUtil_CUDA_Fatbin_Cache::~POSUtil_CUDA_Fatbin_Cache(){
+    // write the remaining fatbins and sections before exit
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_is_stopping = true;
+    }
+    this->_cond.notify_all();
+    if(this->_writer != nullptr){
+        if(this->_writer->joinable()){ this->_writer->join(); }
+        delete this->_writer;
+    }
+}
+
+
+pos_retval_t POSUtil_CUDA_Fatbin_Cache::set_dir(const std::string& dir){
+    pos_retval_t retval = POS_SUCCESS;
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    std::error_code ec;
+
+    if(dir == this->_dir){ goto exit; }
+
+    if(dir.size() > 0 && !std::filesystem::exists(dir)){
+        if(unlikely(!std::filesystem::create_directories(dir, ec))){
+            POS_WARN("failed to create kernel meta cache directory, cache disabled: dir(%s), error(%s)", dir.c_str(), ec.message().c_str());
+            this->_dir.clear();
+            retval = POS_FAILED;
+            goto exit;
+        }
+    }
+
+    this->_dir = dir;
+    this->_dir_keys.clear();
+    this->_dir_mtime_ns = 0;
+    this->__list_dir();
+    POS_DEBUG("set kernel meta cache directory: dir(%s), nb_files(%lu)", dir.c_str(), this->_dir_keys.size());
+
+exit:
+    return retval;
+}
+
+
+bool POSUtil_CUDA_Fatbin_Cache::is_enabled(){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_dir.size() > 0;
+}
+
+
+std::string POSUtil_CUDA_Fatbin_Cache::key_of(const uint8_t *content, uint64_t content_size, bool is_compressed){
+    static constexpr uint64_t P1 = 11400714785074694791ull;
+    static constexpr uint64_t P2 = 14029467366897019727ull;
+    static constexpr uint64_t P3 = 1609587929392839161ull;
+    static constexpr uint64_t P4 = 9650029242287828579ull;
+    static constexpr uint64_t P5 = 2870177450012600261ull;
+    const uint8_t *pos = content, *end = content + content_size;
+    uint64_t seed, hash, v1, v2, v3, v4, lane;
+    uint32_t half_lane;
+    char key[64];
+
+    auto __rotl = [](uint64_t x, int r) -> uint64_t { return (x << r) | (x >> (64 - r)); };
+    auto __round = [&](uint64_t acc, uint64_t input) -> uint64_t {
+        acc += input * P2;
+        acc = __rotl(acc, 31);
+        return acc * P1;
+    };
+    auto __merge_round = [&](uint64_t acc, uint64_t val) -> uint64_t {
+        acc ^= __round(0, val);
+        return acc * P1 + P4;
+    };
+
+    POS_CHECK_POINTER(content);
+
+    // XXH64, the same content is keyed differently if it's compressed
+    seed = is_compressed ? 1 : 0;
+    if(content_size >= 32){
+        v1 = seed + P1 + P2;
+        v2 = seed + P2;
+        v3 = seed;
+        v4 = seed - P1;
+        for(; pos + 32 <= end; pos += 32){
+            memcpy(&lane, pos, 8);      v1 = __round(v1, lane);
+            memcpy(&lane, pos + 8, 8);  v2 = __round(v2, lane);
+            memcpy(&lane, pos + 16, 8); v3 = __round(v3, lane);
+            memcpy(&lane, pos + 24, 8); v4 = __round(v4, lane);
+        }
+        hash = __rotl(v1, 1) + __rotl(v2, 7) + __rotl(v3, 12) + __rotl(v4, 18);
+        hash = __merge_round(hash, v1);
+        hash = __merge_round(hash, v2);
+        hash = __merge_round(hash, v3);
+        hash = __merge_round(hash, v4);
+    } else {
+        hash = seed + P5;
+    }
+    hash += content_size;
+
+    for(; pos + 8 <= end; pos += 8){
+        memcpy(&lane, pos, 8);
+        hash ^= __round(0, lane);
+        hash = __rotl(hash, 27) * P1 + P4;
+    }
+    if(pos + 4 <= end){
+        memcpy(&half_lane, pos, 4);
+        hash ^= static_cast<uint64_t>(half_lane) * P1;
+        hash = __rotl(hash, 23) * P2 + P3;
+        pos += 4;
+    }
+    for(; pos < end; pos++){
+        hash ^= (*pos) * P5;
+        hash = __rotl(hash, 11) * P1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= P2;
+    hash ^= hash >> 29;
+    hash *= P3;
+    hash ^= hash >> 32;
+
+    snprintf(key, sizeof(key), "%016lx_%lx", hash, content_size);
+    return std::string(key);
+}
+
+
+pos_retval_t POSUtil_CUDA_Fatbin_Cache::lookup(const std::string& key, std::vector<POSCudaFunctionDesp*>& desps){
+    pos_retval_t retval = POS_SUCCESS;
+    std::unique_ptr<POSUtil_CUDA_Kernel_Meta_Cache> file_cache;
+    std::vector<POSCudaFunctionDesp*> file_desps;
+    typename std::unordered_map<
+        std::string,
+        std::pair<std::unique_ptr<POSUtil_CUDA_Kernel_Meta_Cache>, std::vector<POSCudaFunctionDesp*>>
+    >::iterator iter;
+    std::string dir;
+
+    desps.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if(unlikely(this->_dir.size() == 0)){
+            retval = POS_FAILED_NOT_EXIST;
+            goto exit;
+        }
+        if((iter = this->_fatbins.find(key)) != this->_fatbins.end()){
+            desps = iter->second.second;
+            this->_metric_counters.add_counter(LOOKUP_hit);
+            this->_metric_counters.add_counter(LOOKUP_hit_memory);
+            goto exit;
+        }
+
+        // fatbins not within the directory are missed without opening their files
+        this->__list_dir();
+        if(this->_dir_keys.count(key) == 0){
+            this->_metric_counters.add_counter(LOOKUP_miss);
+            retval = POS_FAILED_NOT_EXIST;
+            goto exit;
+        }
+        dir = this->_dir;
+    }
+
+    // load from the directory without the lock, as other fatbins are looked up concurrently
+    POS_CHECK_POINTER(file_cache = std::make_unique<POSUtil_CUDA_Kernel_Meta_Cache>());
+    if(POS_SUCCESS != file_cache->load(this->__path_of(dir, key), /* binary_only */ true)){
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_metric_counters.add_counter(LOOKUP_miss);
+        retval = POS_FAILED_NOT_EXIST;
+        goto exit;
+    }
+
+    // the kernels are owned by the file, which is kept mapped
+    file_cache->collect(file_desps);
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if(unlikely((iter = this->_fatbins.find(key)) != this->_fatbins.end())){
+            // loaded by another thread concurrently, ours is released on return
+            desps = iter->second.second;
+        } else {
+            desps = file_desps;
+            this->_fatbins[key] = { std::move(file_cache), std::move(file_desps) };
+        }
+        this->_metric_counters.add_counter(LOOKUP_hit);
+    }
+
+exit:
+    return retval;
+}
+
+
+pos_retval_t POSUtil_CUDA_Fatbin_Cache::store(const std::string& key, const std::vector<POSCudaFunctionDesp*>& desps){
+    pos_retval_t retval = POS_SUCCESS;
+    std::vector<POSCudaFunctionDesp*> new_desps;
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if(unlikely(this->_dir.size() == 0)){
+            retval = POS_FAILED_NOT_EXIST;
+            goto exit;
+        }
+        // the same fatbin might be loaded by different modules
+        if(this->_stored_keys.count(key) > 0 || this->_fatbins.count(key) > 0){
+            goto exit;
+        }
+        this->_stored_keys.insert(key);
+    }
+
+    // copy the kernels, as the extracted ones are owned by the module
+    for(POSCudaFunctionDesp *desp : desps){
+        POS_CHECK_POINTER(desp);
+        new_desps.push_back(new POSCudaFunctionDesp_t(*desp));
+        POS_CHECK_POINTER(new_desps.back());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_pending_stores.push_back({ key, std::move(new_desps) });
+        this->__launch_writer();
+    }
+    this->_cond.notify_one();
+
+exit:
+    return retval;
+}
+
+
+pos_retval_t POSUtil_CUDA_Fatbin_Cache::lookup_text(
+    const std::string& key, uint64_t expected_size, std::shared_ptr<const std::vector<uint8_t>>& text
+){
+    pos_retval_t retval = POS_SUCCESS;
+    typename std::unordered_map<
+        std::string, std::pair<std::shared_ptr<const std::vector<uint8_t>>, std::list<std::string>::iterator>
+    >::iterator iter;
+    std::shared_ptr<std::vector<uint8_t>> spilled_text;
+    std::ifstream file;
+    std::string dir;
+
+    text.reset();
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if((iter = this->_texts.find(key)) != this->_texts.end()){
+            if(likely(iter->second.first->size() == expected_size)){
+                // move to the most recently used
+                this->_text_lru.splice(this->_text_lru.end(), this->_text_lru, iter->second.second);
+                text = iter->second.first;
+                this->_metric_counters.add_counter(TEXT_hit);
+                goto exit;
+            }
+        }
+        // only the spilled files listed within the directory are read
+        if(!this->_is_text_spill || this->_dir.size() == 0 || this->_dir_keys.count(std::string("text:") + key) == 0){
+            this->_metric_counters.add_counter(TEXT_miss);
+            retval = POS_FAILED_NOT_EXIST;
+            goto exit;
+        }
+        dir = this->_dir;
+    }
+
+    // read the spilled file without the lock
+    file.open(this->__text_path_of(dir, key), std::ios::binary | std::ios::ate);
+    if(file.is_open() && static_cast<uint64_t>(file.tellg()) == expected_size){
+        POS_CHECK_POINTER(spilled_text = std::make_shared<std::vector<uint8_t>>(expected_size));
+        file.seekg(0);
+        if(!file.read(reinterpret_cast<char*>(spilled_text->data()), expected_size)){ spilled_text.reset(); }
+    }
+    if(spilled_text == nullptr){
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_metric_counters.add_counter(TEXT_miss);
+        retval = POS_FAILED_NOT_EXIST;
+        goto exit;
+    }
+
+    text = spilled_text;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_metric_counters.add_counter(TEXT_hit);
+        this->_metric_counters.add_counter(TEXT_hit_spill);
+        // it's already spilled, needn't to be written again
+        this->_stored_keys.insert(std::string("text:") + key);
+    }
+    this->store_text(key, text);
+
+exit:
+    return retval;
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::store_text(const std::string& key, std::shared_ptr<const std::vector<uint8_t>> text){
+    typename std::unordered_map<
+        std::string, std::pair<std::shared_ptr<const std::vector<uint8_t>>, std::list<std::string>::iterator>
+    >::iterator iter;
+    bool is_spilled = false;
+
+    POS_CHECK_POINTER(text.get());
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        // the section might be stored by another thread concurrently, or spilled by previous daemons
+        if(unlikely(this->_texts.count(key) > 0)){ return; }
+
+        if(text->size() <= this->_text_capacity){
+            // evict the least recently used sections, the evicted content is released once it's unused
+            while(this->_text_size + text->size() > this->_text_capacity){
+                POS_ASSERT(this->_text_lru.size() > 0);
+                iter = this->_texts.find(this->_text_lru.front());
+                POS_ASSERT(iter != this->_texts.end());
+                this->_text_size -= iter->second.first->size();
+                this->_texts.erase(iter);
+                this->_text_lru.pop_front();
+                this->_metric_counters.add_counter(TEXT_evicted);
+            }
+            this->_text_lru.push_back(key);
+            this->_texts[key] = { text, std::prev(this->_text_lru.end()) };
+            this->_text_size += text->size();
+        }
+
+        // keys of the kernel metadata and the decompressed content are the same, prefix to tell them apart
+        if(this->_is_text_spill && this->_dir.size() > 0 && this->_stored_keys.count(std::string("text:") + key) == 0){
+            this->_stored_keys.insert(std::string("text:") + key);
+            this->_pending_texts.push_back({ key, text });
+            this->__launch_writer();
+            is_spilled = true;
+        }
+    }
+    if(is_spilled){ this->_cond.notify_one(); }
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::set_text_spill(bool is_text_spill){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_is_text_spill = is_text_spill;
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::set_text_capacity(uint64_t capacity){
+    typename std::unordered_map<
+        std::string, std::pair<std::shared_ptr<const std::vector<uint8_t>>, std::list<std::string>::iterator>
+    >::iterator iter;
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    this->_text_capacity = capacity;
+    while(this->_text_size > this->_text_capacity){
+        iter = this->_texts.find(this->_text_lru.front());
+        POS_ASSERT(iter != this->_texts.end());
+        this->_text_size -= iter->second.first->size();
+        this->_texts.erase(iter);
+        this->_text_lru.pop_front();
+        this->_metric_counters.add_counter(TEXT_evicted);
+    }
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::flush(){
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    this->_cond.wait(lock, [this](){
+        return this->_pending_stores.size() == 0 && this->_pending_texts.size() == 0 && this->_nb_writing == 0;
+    });
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::__list_dir(){
+    static const std::string text_suffix(".cubin");
+    const std::string& kmeta_suffix = POSUtil_CUDA_Fatbin_Cache::__kmeta_suffix();
+    struct stat dir_stat;
+    std::error_code ec;
+    std::string name;
+    uint64_t mtime_ns;
+
+    auto __has_suffix = [&](const std::string& suffix) -> bool {
+        return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    if(unlikely(this->_dir.size() == 0 || stat(this->_dir.c_str(), &dir_stat) != 0)){ return; }
+    mtime_ns = static_cast<uint64_t>(dir_stat.st_mtim.tv_sec) * 1000000000ull + dir_stat.st_mtim.tv_nsec;
+    if(mtime_ns == this->_dir_mtime_ns){ return; }
+
+    // temporary files (i.e., "<file>.tmp.<pid>.<id>") carry neither suffix
+    this->_dir_keys.clear();
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(this->_dir, ec)){
+        name = entry.path().filename().string();
+        if(__has_suffix(kmeta_suffix)){
+            this->_dir_keys.insert(name.substr(0, name.size() - kmeta_suffix.size()));
+        } else if(__has_suffix(text_suffix)){
+            this->_dir_keys.insert(std::string("text:") + name.substr(0, name.size() - text_suffix.size()));
+        }
+    }
+    this->_dir_mtime_ns = mtime_ns;
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::__launch_writer(){
+    if(unlikely(this->_writer == nullptr)){
+        POS_CHECK_POINTER(this->_writer = new std::thread(
+            &POSUtil_CUDA_Fatbin_Cache::__writer_main, this, POSPlacement::current()
+        ));
+    }
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::__writer_main(POSPlacement *placement){
+    POSPlacementScope placement_scope(
+        /* placement */ placement, /* role */ kPOS_PlacementRole_Loader, /* name */ "kernel_meta_writer"
+    );
+    std::pair<std::string, std::vector<POSCudaFunctionDesp*>> fatbin;
+    std::pair<std::string, std::shared_ptr<const std::vector<uint8_t>>> text;
+    std::string dir;
+    bool is_text;
+    pos_retval_t retval;
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_cond.wait(lock, [this](){
+                return this->_pending_stores.size() > 0 || this->_pending_texts.size() > 0 || this->_is_stopping;
+            });
+            // kernel metadata goes first, as it saves more for the next load
+            if(this->_pending_stores.size() > 0){
+                fatbin = std::move(this->_pending_stores.front());
+                this->_pending_stores.pop_front();
+                is_text = false;
+            } else if(this->_pending_texts.size() > 0){
+                text = std::move(this->_pending_texts.front());
+                this->_pending_texts.pop_front();
+                is_text = true;
+            } else {
+                break;
+            }
+            this->_nb_writing += 1;
+            dir = this->_dir;
+        }
+
+        if(unlikely(dir.size() == 0)){
+            retval = POS_FAILED_NOT_EXIST;
+        } else if(is_text){
+            retval = POSUtil_CUDA_Fatbin_Cache::__dump_text(this->__text_path_of(dir, text.first), *(text.second));
+        } else {
+            retval = POSUtil_CUDA_Kernel_Meta_Cache::dump_binary(this->__path_of(dir, fatbin.first), fatbin.second);
+        }
+        if(unlikely(retval != POS_SUCCESS)){
+            POS_WARN(
+                "failed to write %s to kernel meta cache: dir(%s), key(%s)",
+                is_text ? "decompressed section" : "fatbin", dir.c_str(), is_text ? text.first.c_str() : fatbin.first.c_str()
+            );
+        }
+        if(is_text){
+            text.second.reset();
+        } else {
+            for(POSCudaFunctionDesp *desp : fatbin.second){ delete desp; }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            if(is_text){
+                if(retval == POS_SUCCESS){ this->_metric_counters.add_counter(TEXT_spilled); }
+            } else {
+                this->_metric_counters.add_counter(retval == POS_SUCCESS ? STORE_done : STORE_failed);
+            }
+            this->_nb_writing -= 1;
+        }
+        this->_cond.notify_all();
+    }
+}
+
+
+pos_retval_t POSUtil_CUDA_Fatbin_Cache::__dump_text(const std::string& file_path, const std::vector<uint8_t>& text){
+    pos_retval_t retval = POS_SUCCESS;
+    static std::atomic<uint64_t> nb_dumps(0);
+    std::string tmp_file_path;
+    FILE *file = nullptr;
+
+    tmp_file_path = file_path + std::string(".tmp.") + std::to_string(getpid())
+                    + std::string(".") + std::to_string(nb_dumps.fetch_add(1, std::memory_order_relaxed));
+    file = fopen(tmp_file_path.c_str(), "wb");
+    if(unlikely(file == nullptr)){
+        POS_WARN("failed to open file to spill decompressed section: file_path(%s)", tmp_file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    if(unlikely(fwrite(text.data(), 1, text.size(), file) != text.size() || fflush(file) != 0)){
+        POS_WARN("failed to spill decompressed section: file_path(%s)", tmp_file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+    fclose(file);
+    file = nullptr;
+
+    if(unlikely(rename(tmp_file_path.c_str(), file_path.c_str()) != 0)){
+        POS_WARN("failed to rename spilled section: from(%s), to(%s)", tmp_file_path.c_str(), file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+exit:
+    if(file != nullptr){ fclose(file); }
+    if(unlikely(retval != POS_SUCCESS && tmp_file_path.size() > 0)){ unlink(tmp_file_path.c_str()); }
+    return retval;
+}
+
+
+std::string POSUtil_CUDA_Fatbin_Cache::__path_of(const std::string& dir, const std::string& key){
+    return dir + std::string("/") + key + POSUtil_CUDA_Fatbin_Cache::__kmeta_suffix();
+}
+
+
+const std::string& POSUtil_CUDA_Fatbin_Cache::__kmeta_suffix(){
+    static const std::string suffix
+        = std::string(".") + POSUtil_CUDA_Kernel_Parser::get_version_tag() + std::string(".kmeta");
+    return suffix;
+}
+
+
+void POSUtil_CUDA_Fatbin_Cache::print_metrics(){
+    static std::unordered_map<metrics_counter_type_t, std::string> counter_names = {
+        { LOOKUP_hit, "# Fatbin Hits" },
+        { LOOKUP_hit_memory, "# Fatbin Hits (In Memory)" },
+        { LOOKUP_miss, "# Fatbin Misses" },
+        { STORE_done, "# Stored Fatbins" },
+        { STORE_failed, "# Failed Stores" },
+        { TEXT_hit, "# Decompressed Section Hits" },
+        { TEXT_hit_spill, "# Decompressed Section Hits (Spilled)" },
+        { TEXT_miss, "# Decompressed Section Misses" },
+        { TEXT_evicted, "# Evicted Decompressed Sections" },
+        { TEXT_spilled, "# Spilled Decompressed Sections" }
+    };
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    POS_LOG(
+        "[Kernel Meta Cache Metrics] %s:\n%s",
+        this->_dir.c_str(),
+        this->_metric_counters.str(counter_names).c_str()
+    );
+}
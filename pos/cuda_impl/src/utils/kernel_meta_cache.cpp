@@ -0,0 +1,678 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/cuda_impl/utils/fatbin.h"
+#include "pos/cuda_impl/utils/kernel_meta_cache.h"
+
+
+POSUtil_CUDA_Kernel_Meta_Cache::POSUtil_CUDA_Kernel_Meta_Cache()
+    :   _mapped(nullptr), _mapped_size(0), _header(nullptr), _buckets(nullptr), _kernels(nullptr),
+        _u32_pool(nullptr), _confirmed_pool(nullptr), _strtab(nullptr), _nb_binary_kernels(0) {}
+
+
+POSUtil_CUDA_Kernel_Meta_Cache::~POSUtil_CUDA_Kernel_Meta_Cache(){
+    this->clear();
+}
+
+
+pos_retval_t POSUtil_CUDA_Kernel_Meta_Cache::load(const std::string& file_path, bool binary_only){
+    pos_retval_t retval = POS_SUCCESS;
+    struct stat file_stat;
+    uint64_t magic = 0;
+    int fd = -1;
+
+    // leave the warning to the caller, as a missing file is normal for a cache
+    fd = open(file_path.c_str(), O_RDONLY);
+    if(fd < 0){
+        retval = POS_FAILED_NOT_EXIST;
+        goto exit;
+    }
+
+    if(unlikely(fstat(fd, &file_stat) != 0)){
+        POS_WARN("failed to stat kernel meta file %s", file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    if(static_cast<uint64_t>(file_stat.st_size) < sizeof(uint64_t) || pread(fd, &magic, sizeof(uint64_t), 0) != sizeof(uint64_t)
+        || magic != kBinaryMagic
+    ){
+        if(binary_only){
+            POS_WARN("kernel meta file %s isn't in binary format", file_path.c_str());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        close(fd);
+        fd = -1;
+        retval = this->import_text(file_path);
+        goto exit;
+    }
+
+    if(unlikely(this->_mapped != nullptr)){
+        POS_WARN("kernel meta cache has been loaded from binary file, reload: file_path(%s)", file_path.c_str());
+        this->clear();
+    }
+
+    retval = this->__map_binary(fd, file_stat.st_size);
+    if(unlikely(retval != POS_SUCCESS)){
+        POS_WARN("failed to load binary kernel meta file %s", file_path.c_str());
+        goto exit;
+    }
+
+    POS_DEBUG("mapped %lu of cached kernel metas from binary file %s", this->_nb_binary_kernels, file_path.c_str());
+
+exit:
+    // the mapping remains valid after closing the file
+    if(fd >= 0){ close(fd); }
+    return retval;
+}
+
+
+pos_retval_t POSUtil_CUDA_Kernel_Meta_Cache::__map_binary(int fd, uint64_t file_size){
+    pos_retval_t retval = POS_SUCCESS;
+    const pos_kmeta_header_t *header;
+    uint64_t i;
+
+    // check whether a region of nb_items lies within the file without overflow
+    auto __within_file = [&](uint64_t offset, uint64_t nb_items, uint64_t item_size) -> bool {
+        return offset % 8 == 0 && offset <= file_size && nb_items <= (file_size - offset) / item_size;
+    };
+
+    if(unlikely(file_size < sizeof(pos_kmeta_header_t))){
+        retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+
+    this->_mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(unlikely(this->_mapped == MAP_FAILED)){
+        this->_mapped = nullptr;
+        retval = POS_FAILED;
+        goto exit;
+    }
+    this->_mapped_size = file_size;
+
+    header = (const pos_kmeta_header_t*)(this->_mapped);
+    if(unlikely(
+        header->magic != kBinaryMagic || header->version != kBinaryVersion
+        || header->header_size != sizeof(pos_kmeta_header_t) || header->file_size != file_size
+    )){
+        POS_WARN(
+            "mismatched header of binary kernel meta file: version(%u), expected_version(%u), file_size(%lu), expected_file_size(%lu)",
+            header->version, kBinaryVersion, header->file_size, file_size
+        );
+        retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+
+    if(unlikely(
+        header->nb_buckets == 0 || (header->nb_buckets & (header->nb_buckets - 1)) != 0
+        || header->nb_kernels >= header->nb_buckets || header->nb_kernels >= UINT32_MAX
+        || !__within_file(header->buckets_offset, header->nb_buckets, sizeof(pos_kmeta_bucket_t))
+        || !__within_file(header->kernels_offset, header->nb_kernels, sizeof(pos_kmeta_kernel_t))
+        || !__within_file(header->u32_pool_offset, header->nb_u32s, sizeof(uint32_t))
+        || !__within_file(header->confirmed_pool_offset, header->nb_confirmed, sizeof(pos_kmeta_confirmed_param_t))
+        || !__within_file(header->strtab_offset, header->strtab_size, sizeof(char))
+        || header->strtab_size == 0
+    )){
+        POS_WARN("corrupted layout of binary kernel meta file");
+        retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+
+    this->_header = header;
+    this->_buckets = (const pos_kmeta_bucket_t*)((const uint8_t*)(this->_mapped) + header->buckets_offset);
+    this->_kernels = (const pos_kmeta_kernel_t*)((const uint8_t*)(this->_mapped) + header->kernels_offset);
+    this->_u32_pool = (const uint32_t*)((const uint8_t*)(this->_mapped) + header->u32_pool_offset);
+    this->_confirmed_pool = (const pos_kmeta_confirmed_param_t*)(
+        (const uint8_t*)(this->_mapped) + header->confirmed_pool_offset
+    );
+    this->_strtab = (const char*)(this->_mapped) + header->strtab_offset;
+    this->_nb_binary_kernels = header->nb_kernels;
+
+    this->_materialized.reset(new std::atomic<POSCudaFunctionDesp*>[this->_nb_binary_kernels]);
+    POS_CHECK_POINTER(this->_materialized.get());
+    for(i=0; i<this->_nb_binary_kernels; i++){
+        this->_materialized[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // the index is probed by the loading thread right after, prefetch it
+    madvise(this->_mapped, this->_mapped_size, MADV_WILLNEED);
+
+exit:
+    if(unlikely(retval != POS_SUCCESS && this->_mapped != nullptr)){
+        munmap(this->_mapped, this->_mapped_size);
+        this->_mapped = nullptr;
+        this->_mapped_size = 0;
+    }
+    return retval;
+}
+
+
+POSCudaFunctionDesp* POSUtil_CUDA_Kernel_Meta_Cache::find(const char *name){
+    typename std::unordered_map<std::string, POSCudaFunctionDesp*>::iterator iter;
+    const pos_kmeta_bucket_t *bucket;
+    const pos_kmeta_kernel_t *kernel;
+    uint64_t hash, len, mask, bucket_id, i;
+
+    POS_CHECK_POINTER(name);
+
+    if(this->_nb_binary_kernels > 0){
+        len = strlen(name);
+        hash = POSUtil_CUDA_Kernel_Meta_Cache::__hash(name, len);
+        mask = this->_header->nb_buckets - 1;
+        bucket_id = hash & mask;
+
+        for(i=0; i<this->_header->nb_buckets; i++, bucket_id=(bucket_id+1)&mask){
+            bucket = &this->_buckets[bucket_id];
+            if(bucket->kernel_id == 0){ break; }
+            if(bucket->hash_tag != static_cast<uint32_t>(hash >> 32)){ continue; }
+            if(unlikely(bucket->kernel_id > this->_nb_binary_kernels)){ break; }
+
+            kernel = &this->_kernels[bucket->kernel_id - 1];
+            if(
+                kernel->name_hash == hash && kernel->name_len == len
+                && static_cast<uint64_t>(kernel->name_offset) + len < this->_header->strtab_size
+                && memcmp(this->_strtab + kernel->name_offset, name, len) == 0
+            ){
+                return this->__materialize(bucket->kernel_id - 1);
+            }
+        }
+    }
+
+    if(this->_text_desps.size() > 0){
+        iter = this->_text_desps.find(name);
+        if(iter != this->_text_desps.end()){ return iter->second; }
+    }
+
+    return nullptr;
+}
+
+
+POSCudaFunctionDesp* POSUtil_CUDA_Kernel_Meta_Cache::__materialize(uint64_t kernel_id){
+    POSCudaFunctionDesp *desp, *expected = nullptr;
+    const pos_kmeta_kernel_t *kernel;
+    uint64_t i;
+
+    // check whether an array lies within the pool without overflow
+    auto __within = [](uint64_t id, uint64_t nb, uint64_t pool_size) -> bool {
+        return id <= pool_size && nb <= pool_size - id;
+    };
+
+    POS_ASSERT(kernel_id < this->_nb_binary_kernels);
+
+    if(likely(nullptr != (desp = this->_materialized[kernel_id].load(std::memory_order_acquire)))){
+        return desp;
+    }
+
+    kernel = &this->_kernels[kernel_id];
+    if(unlikely(
+        !__within(kernel->name_offset, kernel->name_len + 1, this->_header->strtab_size)
+        || !__within(kernel->signature_offset, kernel->signature_len + 1, this->_header->strtab_size)
+        || !__within(kernel->params_id, 2 * static_cast<uint64_t>(kernel->nb_params), this->_header->nb_u32s)
+        || !__within(kernel->input_pointer_params_id, kernel->nb_input_pointer_params, this->_header->nb_u32s)
+        || !__within(kernel->output_pointer_params_id, kernel->nb_output_pointer_params, this->_header->nb_u32s)
+        || !__within(kernel->inout_pointer_params_id, kernel->nb_inout_pointer_params, this->_header->nb_u32s)
+        || !__within(kernel->suspicious_params_id, kernel->nb_suspicious_params, this->_header->nb_u32s)
+        || !__within(
+            kernel->confirmed_suspicious_params_id, kernel->nb_confirmed_suspicious_params, this->_header->nb_confirmed
+        )
+    )){
+        POS_WARN("corrupted kernel record within binary kernel meta file: kernel_id(%lu)", kernel_id);
+        return nullptr;
+    }
+
+    POS_CHECK_POINTER(desp = new POSCudaFunctionDesp_t());
+    desp->name.assign(this->_strtab + kernel->name_offset, kernel->name_len);
+    desp->signature.assign(this->_strtab + kernel->signature_offset, kernel->signature_len);
+    desp->nb_params = kernel->nb_params;
+    desp->param_offsets.assign(
+        this->_u32_pool + kernel->params_id, this->_u32_pool + kernel->params_id + kernel->nb_params
+    );
+    desp->param_sizes.assign(
+        this->_u32_pool + kernel->params_id + kernel->nb_params,
+        this->_u32_pool + kernel->params_id + 2 * kernel->nb_params
+    );
+    desp->input_pointer_params.assign(
+        this->_u32_pool + kernel->input_pointer_params_id,
+        this->_u32_pool + kernel->input_pointer_params_id + kernel->nb_input_pointer_params
+    );
+    desp->output_pointer_params.assign(
+        this->_u32_pool + kernel->output_pointer_params_id,
+        this->_u32_pool + kernel->output_pointer_params_id + kernel->nb_output_pointer_params
+    );
+    desp->inout_pointer_params.assign(
+        this->_u32_pool + kernel->inout_pointer_params_id,
+        this->_u32_pool + kernel->inout_pointer_params_id + kernel->nb_inout_pointer_params
+    );
+    desp->suspicious_params.assign(
+        this->_u32_pool + kernel->suspicious_params_id,
+        this->_u32_pool + kernel->suspicious_params_id + kernel->nb_suspicious_params
+    );
+    desp->has_verified_params = kernel->has_verified_params != 0;
+    for(i=0; i<kernel->nb_confirmed_suspicious_params; i++){
+        desp->confirmed_suspicious_params.push_back({
+            /* param_index */ this->_confirmed_pool[kernel->confirmed_suspicious_params_id + i].param_index,
+            /* offset */ this->_confirmed_pool[kernel->confirmed_suspicious_params_id + i].offset
+        });
+    }
+    desp->cbank_param_size = kernel->cbank_param_size;
+    desp->is_resolved = desp->signature.size() > 0;
+
+    // another thread might materialize the same kernel concurrently, the first one wins
+    if(unlikely(!this->_materialized[kernel_id].compare_exchange_strong(
+        expected, desp, std::memory_order_acq_rel, std::memory_order_acquire
+    ))){
+        delete desp;
+        desp = expected;
+    }
+
+    return desp;
+}
+
+
+void POSUtil_CUDA_Kernel_Meta_Cache::collect(std::vector<POSCudaFunctionDesp*>& desps){
+    POSCudaFunctionDesp *desp;
+    uint64_t i;
+
+    desps.clear();
+    for(i=0; i<this->_nb_binary_kernels; i++){
+        if(likely(nullptr != (desp = this->__materialize(i)))){ desps.push_back(desp); }
+    }
+    desps.insert(desps.end(), this->_text_desps_ordered.begin(), this->_text_desps_ordered.end());
+}
+
+
+void POSUtil_CUDA_Kernel_Meta_Cache::clear(){
+    POSCudaFunctionDesp *desp;
+    uint64_t i;
+
+    for(i=0; i<this->_nb_binary_kernels; i++){
+        if(nullptr != (desp = this->_materialized[i].load(std::memory_order_acquire))){ delete desp; }
+    }
+    this->_materialized.reset();
+    this->_nb_binary_kernels = 0;
+
+    if(this->_mapped != nullptr){
+        munmap(this->_mapped, this->_mapped_size);
+        this->_mapped = nullptr;
+        this->_mapped_size = 0;
+    }
+    this->_header = nullptr;
+    this->_buckets = nullptr;
+    this->_kernels = nullptr;
+    this->_u32_pool = nullptr;
+    this->_confirmed_pool = nullptr;
+    this->_strtab = nullptr;
+
+    for(POSCudaFunctionDesp *text_desp : this->_text_desps_ordered){ delete text_desp; }
+    this->_text_desps.clear();
+    this->_text_desps_ordered.clear();
+}
+
+
+pos_retval_t POSUtil_CUDA_Kernel_Meta_Cache::import_text(const std::string& file_path){
+    pos_retval_t retval = POS_SUCCESS;
+    uint64_t nb_lines = 0, nb_malformed = 0;
+    std::string line, segment;
+    std::vector<std::string> metas;
+    POSCudaFunctionDesp *new_desp;
+    std::ifstream file;
+    char delimiter = '|';
+
+    auto generate_desp_from_meta = [](std::vector<std::string>& metas) -> POSCudaFunctionDesp* {
+        uint64_t i, ptr = 0, nb;
+        POSCudaFunctionDesp *new_desp;
+
+        // obtain the next field, throw once the line is exhausted
+        auto __next = [&]() -> uint64_t {
+            if(unlikely(ptr >= metas.size())){ throw std::out_of_range("too few fields"); }
+            return std::stoull(metas[ptr++]);
+        };
+
+        // obtain the next array of fields
+        auto __next_array = [&](uint64_t nb, std::vector<uint32_t>& array){
+            for(i=0; i<nb; i++){ array.push_back(__next()); }
+        };
+
+        if(unlikely(metas.size() < 2)){ return nullptr; }
+
+        POS_CHECK_POINTER(new_desp = new POSCudaFunctionDesp_t());
+
+        try {
+            // mangled name and signature of the kernel
+            new_desp->name = metas[ptr++];
+            new_desp->signature = metas[ptr++];
+
+            // number of paramters, parameter offsets and sizes
+            new_desp->nb_params = __next();
+            __next_array(new_desp->nb_params, new_desp->param_offsets);
+            __next_array(new_desp->nb_params, new_desp->param_sizes);
+
+            // input / output / inout / suspicious paramters
+            nb = __next(); __next_array(nb, new_desp->input_pointer_params);
+            nb = __next(); __next_array(nb, new_desp->output_pointer_params);
+            nb = __next(); __next_array(nb, new_desp->inout_pointer_params);
+            nb = __next(); __next_array(nb, new_desp->suspicious_params);
+
+            // has verified suspicious paramters
+            new_desp->has_verified_params = __next() == 1;
+            if(new_desp->has_verified_params){
+                // index of those parameter which is a structure (contains pointers), and the offset of pointer
+                nb = __next();
+                for(i=0; i<nb; i++){
+                    uint32_t param_index = __next();
+                    new_desp->confirmed_suspicious_params.push_back({ param_index, __next() });
+                }
+            }
+
+            // cbank parameter size (p.s., what is this?)
+            new_desp->cbank_param_size = __next();
+
+            // kernels dumped before being resolved (i.e., lazy mode) carry no signature
+            new_desp->is_resolved = new_desp->signature.size() > 0;
+        } catch (const std::exception& e) {
+            delete new_desp;
+            return nullptr;
+        }
+
+        return new_desp;
+    };
+
+    file.open(file_path.c_str(), std::ios::in);
+    if(unlikely(!file.is_open())){
+        POS_WARN("failed to open kernel meta file %s", file_path.c_str());
+        retval = POS_FAILED_NOT_EXIST;
+        goto exit;
+    }
+
+    POS_LOG("parsing cached kernel metas from text file %s...", file_path.c_str());
+    while(std::getline(file, line)){
+        if(line.size() == 0){ continue; }
+        nb_lines += 1;
+
+        std::stringstream ss(line);
+        metas.clear();
+        while(std::getline(ss, segment, delimiter)){ metas.push_back(segment); }
+
+        if(unlikely(nullptr == (new_desp = generate_desp_from_meta(metas)))){
+            nb_malformed += 1;
+            continue;
+        }
+
+        // the file might be appended by multiple runs, keep the first one
+        if(unlikely(this->_text_desps.count(new_desp->name) > 0)){
+            delete new_desp;
+            continue;
+        }
+        this->_text_desps[new_desp->name] = new_desp;
+        this->_text_desps_ordered.push_back(new_desp);
+    }
+    file.close();
+
+    // the file might be truncated by a crashed run, the remained lines are still usable
+    if(unlikely(nb_malformed > 0)){
+        POS_WARN("skipped %lu malformed lines within kernel meta file %s", nb_malformed, file_path.c_str());
+    }
+    POS_LOG("parsed %lu of cached kernel metas from text file %s", nb_lines - nb_malformed, file_path.c_str());
+
+exit:
+    return retval;
+}
+
+
+pos_retval_t POSUtil_CUDA_Kernel_Meta_Cache::dump_binary(
+    const std::string& file_path, const std::vector<POSCudaFunctionDesp*>& desps
+){
+    pos_retval_t retval = POS_SUCCESS;
+    pos_kmeta_header_t header;
+    std::vector<pos_kmeta_bucket_t> buckets;
+    std::vector<pos_kmeta_kernel_t> kernels;
+    std::vector<uint32_t> u32_pool;
+    std::vector<pos_kmeta_confirmed_param_t> confirmed_pool;
+    std::string strtab, tmp_file_path;
+    std::unordered_set<std::string> names;
+    pos_kmeta_kernel_t kernel;
+    pos_kmeta_confirmed_param_t confirmed;
+    uint64_t nb_buckets, bucket_id, offset, i;
+    const uint8_t zeros[8] = { 0 };
+    FILE *file = nullptr;
+    static std::atomic<uint64_t> nb_dumps(0);
+
+    // append an array to the uint32 pool, and return its index
+    auto __append_u32s = [&](const std::vector<uint32_t>& array) -> uint32_t {
+        uint32_t id = u32_pool.size();
+        u32_pool.insert(u32_pool.end(), array.begin(), array.end());
+        return id;
+    };
+
+    // append a string to the string table, and return its offset
+    auto __append_str = [&](const std::string& str) -> uint32_t {
+        uint32_t str_offset = strtab.size();
+        strtab.append(str);
+        strtab.push_back('\0');
+        return str_offset;
+    };
+
+    // write a region and pad it to 8 bytes
+    auto __write = [&](const void *data, uint64_t size) -> bool {
+        if(size > 0 && fwrite(data, 1, size, file) != size){ return false; }
+        if(size % 8 != 0 && fwrite(zeros, 1, 8 - size % 8, file) != 8 - size % 8){ return false; }
+        return true;
+    };
+
+    auto __aligned = [](uint64_t size) -> uint64_t { return (size + 7) / 8 * 8; };
+
+    // the empty string is at offset 0
+    strtab.push_back('\0');
+
+    for(POSCudaFunctionDesp *desp : desps){
+        POS_CHECK_POINTER(desp);
+        if(unlikely(names.insert(desp->name).second == false)){ continue; }
+
+        memset(&kernel, 0, sizeof(pos_kmeta_kernel_t));
+        kernel.name_hash = POSUtil_CUDA_Kernel_Meta_Cache::__hash(desp->name.c_str(), desp->name.size());
+        kernel.cbank_param_size = desp->cbank_param_size;
+        kernel.name_len = desp->name.size();
+        kernel.name_offset = __append_str(desp->name);
+        kernel.signature_len = desp->signature.size();
+        kernel.signature_offset = __append_str(desp->signature);
+
+        kernel.nb_params = desp->nb_params;
+        POS_ASSERT(desp->param_offsets.size() == desp->nb_params && desp->param_sizes.size() == desp->nb_params);
+        kernel.params_id = __append_u32s(desp->param_offsets);
+        __append_u32s(desp->param_sizes);
+        kernel.nb_input_pointer_params = desp->input_pointer_params.size();
+        kernel.input_pointer_params_id = __append_u32s(desp->input_pointer_params);
+        kernel.nb_output_pointer_params = desp->output_pointer_params.size();
+        kernel.output_pointer_params_id = __append_u32s(desp->output_pointer_params);
+        kernel.nb_inout_pointer_params = desp->inout_pointer_params.size();
+        kernel.inout_pointer_params_id = __append_u32s(desp->inout_pointer_params);
+        kernel.nb_suspicious_params = desp->suspicious_params.size();
+        kernel.suspicious_params_id = __append_u32s(desp->suspicious_params);
+
+        kernel.has_verified_params = desp->has_verified_params ? 1 : 0;
+        kernel.confirmed_suspicious_params_id = confirmed_pool.size();
+        kernel.nb_confirmed_suspicious_params = desp->confirmed_suspicious_params.size();
+        for(i=0; i<desp->confirmed_suspicious_params.size(); i++){
+            memset(&confirmed, 0, sizeof(pos_kmeta_confirmed_param_t));
+            confirmed.param_index = desp->confirmed_suspicious_params[i].first;
+            confirmed.offset = desp->confirmed_suspicious_params[i].second;
+            confirmed_pool.push_back(confirmed);
+        }
+
+        kernels.push_back(kernel);
+    }
+
+    if(unlikely(strtab.size() >= UINT32_MAX || u32_pool.size() >= UINT32_MAX || confirmed_pool.size() >= UINT32_MAX)){
+        POS_WARN("too many kernel metas to be dumped as binary: nb_kernels(%lu)", kernels.size());
+        retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+
+    // build the hash index, keep it at most half full
+    for(nb_buckets=16; nb_buckets<2*kernels.size(); nb_buckets*=2){}
+    buckets.resize(nb_buckets, { /* hash_tag */ 0, /* kernel_id */ 0 });
+    for(i=0; i<kernels.size(); i++){
+        bucket_id = kernels[i].name_hash & (nb_buckets - 1);
+        while(buckets[bucket_id].kernel_id != 0){ bucket_id = (bucket_id + 1) & (nb_buckets - 1); }
+        buckets[bucket_id].hash_tag = static_cast<uint32_t>(kernels[i].name_hash >> 32);
+        buckets[bucket_id].kernel_id = i + 1;
+    }
+
+    memset(&header, 0, sizeof(pos_kmeta_header_t));
+    header.magic = kBinaryMagic;
+    header.version = kBinaryVersion;
+    header.header_size = sizeof(pos_kmeta_header_t);
+    header.nb_kernels = kernels.size();
+    header.nb_buckets = nb_buckets;
+    header.nb_u32s = u32_pool.size();
+    header.nb_confirmed = confirmed_pool.size();
+    header.strtab_size = strtab.size();
+
+    offset = __aligned(sizeof(pos_kmeta_header_t));
+    header.buckets_offset = offset;
+    offset += __aligned(buckets.size() * sizeof(pos_kmeta_bucket_t));
+    header.kernels_offset = offset;
+    offset += __aligned(kernels.size() * sizeof(pos_kmeta_kernel_t));
+    header.u32_pool_offset = offset;
+    offset += __aligned(u32_pool.size() * sizeof(uint32_t));
+    header.confirmed_pool_offset = offset;
+    offset += __aligned(confirmed_pool.size() * sizeof(pos_kmeta_confirmed_param_t));
+    header.strtab_offset = offset;
+    offset += __aligned(strtab.size());
+    header.file_size = offset;
+
+    // write to a temporary file then rename, so that the file mmap-ed by others is untouched
+    tmp_file_path = file_path + std::string(".tmp.") + std::to_string(getpid())
+                    + std::string(".") + std::to_string(nb_dumps.fetch_add(1, std::memory_order_relaxed));
+    file = fopen(tmp_file_path.c_str(), "wb");
+    if(unlikely(file == nullptr)){
+        POS_WARN("failed to open file to dump kernel metas: file_path(%s)", tmp_file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    if(unlikely(
+        !__write(&header, sizeof(pos_kmeta_header_t))
+        || !__write(buckets.data(), buckets.size() * sizeof(pos_kmeta_bucket_t))
+        || !__write(kernels.data(), kernels.size() * sizeof(pos_kmeta_kernel_t))
+        || !__write(u32_pool.data(), u32_pool.size() * sizeof(uint32_t))
+        || !__write(confirmed_pool.data(), confirmed_pool.size() * sizeof(pos_kmeta_confirmed_param_t))
+        || !__write(strtab.data(), strtab.size())
+        || fflush(file) != 0
+    )){
+        POS_WARN("failed to write kernel metas: file_path(%s)", tmp_file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+    fclose(file);
+    file = nullptr;
+
+    if(unlikely(rename(tmp_file_path.c_str(), file_path.c_str()) != 0)){
+        POS_WARN("failed to rename kernel meta file: from(%s), to(%s)", tmp_file_path.c_str(), file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+exit:
+    if(file != nullptr){ fclose(file); }
+    if(unlikely(retval != POS_SUCCESS && tmp_file_path.size() > 0)){ unlink(tmp_file_path.c_str()); }
+    return retval;
+}
+
+
+pos_retval_t POSUtil_CUDA_Kernel_Meta_Cache::dump_text(
+    const std::string& file_path, const std::vector<POSCudaFunctionDesp*>& desps, bool append
+){
+    pos_retval_t retval = POS_SUCCESS;
+    std::ofstream output_file;
+
+    auto dump_function_metas = [](POSCudaFunctionDesp* desp) -> std::string {
+        std::string output_str("");
+        std::string delimiter("|");
+        uint64_t i;
+
+        // dump an array with its size ahead
+        auto __dump_array = [&](const std::vector<uint32_t>& array){
+            output_str += std::to_string(array.size()) + delimiter;
+            for(i=0; i<array.size(); i++){ output_str += std::to_string(array[i]) + delimiter; }
+        };
+
+        POS_CHECK_POINTER(desp);
+
+        // mangled name and signature of the kernel
+        output_str += desp->name + delimiter;
+        output_str += desp->signature + delimiter;
+
+        // number of paramters, parameter offsets and sizes
+        output_str += std::to_string(desp->nb_params) + delimiter;
+        for(i=0; i<desp->nb_params; i++){ output_str += std::to_string(desp->param_offsets[i]) + delimiter; }
+        for(i=0; i<desp->nb_params; i++){ output_str += std::to_string(desp->param_sizes[i]) + delimiter; }
+
+        // input / output / inout / suspicious paramters
+        __dump_array(desp->input_pointer_params);
+        __dump_array(desp->output_pointer_params);
+        __dump_array(desp->inout_pointer_params);
+        __dump_array(desp->suspicious_params);
+
+        // has verified suspicious paramters
+        if(desp->has_verified_params){
+            output_str += std::string("1") + delimiter;
+            output_str += std::to_string(desp->confirmed_suspicious_params.size()) + delimiter;
+            for(i=0; i<desp->confirmed_suspicious_params.size(); i++){
+                output_str += std::to_string(desp->confirmed_suspicious_params[i].first) + delimiter;    // param_index
+                output_str += std::to_string(desp->confirmed_suspicious_params[i].second) + delimiter;   // offset
+            }
+        } else {
+            output_str += std::string("0") + delimiter;
+        }
+
+        // cbank parameters
+        output_str += std::to_string(desp->cbank_param_size);
+
+        return output_str;
+    };
+
+    output_file.open(file_path.c_str(), append ? std::fstream::out | std::fstream::app : std::fstream::out | std::fstream::trunc);
+    if(unlikely(!output_file.is_open())){
+        POS_WARN("failed to open file to dump kernel metas: file_path(%s)", file_path.c_str());
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    for(POSCudaFunctionDesp *desp : desps){
+        output_file << dump_function_metas(desp) << std::endl;
+    }
+
+    output_file.flush();
+    output_file.close();
+
+exit:
+    return retval;
+}
@@ -40,7 +40,10 @@ POSWorker_CUDA::POSWorker_CUDA(POSWorkspace* ws, POSClient* client)
     : POSWorker(ws, client) {}
 
 
-POSWorker_CUDA::~POSWorker_CUDA(){}
+POSWorker_CUDA::~POSWorker_CUDA(){
+    // shutdown here, so that the streams of the worker could be destoried by this derived class
+    this->shutdown();
+}
 
 
 pos_retval_t POSWorker_CUDA::sync(uint64_t stream_id){
@@ -60,6 +63,48 @@ pos_retval_t POSWorker_CUDA::sync(uint64_t stream_id){
 }
 
 
+pos_retval_t POSWorker_CUDA::create_stream(uint64_t& stream_id){
+    pos_retval_t retval = POS_SUCCESS;
+    cudaError_t cuda_rt_retval;
+
+    cuda_rt_retval = cudaStreamCreate((cudaStream_t*)(&stream_id));
+    if(unlikely(cuda_rt_retval != cudaSuccess)){
+        POS_WARN_C_DETAIL("failed to create CUDA stream: cuda_rt_retval(%d)", cuda_rt_retval);
+        retval = POS_FAILED_DRIVER;
+    }
+
+    return retval;
+}
+
+
+pos_retval_t POSWorker_CUDA::destory_stream(uint64_t stream_id){
+    pos_retval_t retval = POS_SUCCESS;
+    cudaError_t cuda_rt_retval;
+
+    cuda_rt_retval = cudaStreamDestroy((cudaStream_t)(stream_id));
+    if(unlikely(cuda_rt_retval != cudaSuccess)){
+        POS_WARN_C_DETAIL(
+            "failed to destory CUDA stream: stream_id(%p), cuda_rt_retval(%d)", stream_id, cuda_rt_retval
+        );
+        retval = POS_FAILED_DRIVER;
+    }
+
+    return retval;
+}
+
+
+pos_retval_t POSWorker_CUDA::bind_thread_context(){
+    pos_retval_t retval = POS_SUCCESS;
+
+    if(unlikely(cudaSetDevice(0) != cudaSuccess)){
+        POS_WARN_C_DETAIL("failed to invoke cudaSetDevice");
+        retval = POS_FAILED_DRIVER;
+    }
+
+    return retval;
+}
+
+
 pos_retval_t POSWorker_CUDA::daemon_init(){
     /*!
         *  \note   make sure the worker thread is bound to a CUDA context
@@ -72,21 +117,11 @@ pos_retval_t POSWorker_CUDA::daemon_init(){
     cudaDeviceSynchronize();
     
 #if POS_CONF_EVAL_CkptOptLevel == 2
-    POS_ASSERT(
-        cudaSuccess == cudaStreamCreate((cudaStream_t*)(&this->_ckpt_stream_id))
-    );
-
     POS_ASSERT(
         cudaSuccess == cudaStreamCreate((cudaStream_t*)(&this->_cow_stream_id))
     );
 #endif
 
-#if POS_CONF_EVAL_CkptOptLevel == 2 && POS_CONF_EVAL_CkptEnablePipeline == 1
-    POS_ASSERT(
-        cudaSuccess == cudaStreamCreate((cudaStream_t*)(&this->_ckpt_commit_stream_id))
-    );
-#endif
-
 #if POS_CONF_EVAL_MigrOptLevel == 2
     POS_ASSERT(
         cudaSuccess == cudaStreamCreate((cudaStream_t*)(&this->_migration_precopy_stream_id))
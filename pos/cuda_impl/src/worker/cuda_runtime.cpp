@@ -291,6 +291,7 @@ namespace cuda_memcpy_h2d {
     // launch function
     POS_WK_FUNC_LAUNCH(){
         pos_retval_t retval = POS_SUCCESS;
+        uint64_t s_tick = 0;
         POSHandle *memory_handle;
 
         POS_CHECK_POINTER(ws);
@@ -315,6 +316,10 @@ namespace cuda_memcpy_h2d {
         }
     #endif
 
+    #if POS_CONF_EVAL_CkptOptLevel == 2
+        s_tick = POSUtilTscTimer::get_tsc();
+    #endif
+
         wqe->api_cxt->return_code = cudaMemcpy(
             /* dst */ pos_api_inout_handle_offset_server_addr(wqe, 0),
             /* src */ pos_api_param_addr(wqe, 1),
@@ -323,7 +328,12 @@ namespace cuda_memcpy_h2d {
         );
 
     #if POS_CONF_EVAL_CkptOptLevel == 2
-        ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.membus_lock = false;
+        // record the application copy traffic, to adapt the rate of checkpoint commits
+        ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.commit_throttle.observe_app_copy(
+            /* bytes */ pos_api_param_size(wqe, 1),
+            /* ticks */ POSUtilTscTimer::get_tsc() - s_tick
+        );
+        ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.release_membus();
     #endif
 
         if(unlikely(cudaSuccess != wqe->api_cxt->return_code)){ 
@@ -347,6 +357,7 @@ namespace cuda_memcpy_d2h {
     // launch function
     POS_WK_FUNC_LAUNCH(){
         pos_retval_t retval = POS_SUCCESS;
+        uint64_t s_tick = 0;
         POSHandle *memory_handle;
 
         POS_CHECK_POINTER(ws);
@@ -371,6 +382,10 @@ namespace cuda_memcpy_d2h {
         }
     #endif
 
+    #if POS_CONF_EVAL_CkptOptLevel == 2
+        s_tick = POSUtilTscTimer::get_tsc();
+    #endif
+
         wqe->api_cxt->return_code = cudaMemcpy(
             /* dst */ wqe->api_cxt->ret_data,
             /* src */ (const void*)(pos_api_input_handle_offset_server_addr(wqe, 0)),
@@ -379,8 +394,13 @@ namespace cuda_memcpy_d2h {
         );
 
     #if POS_CONF_EVAL_CkptOptLevel == 2
+        // record the application copy traffic, to adapt the rate of checkpoint commits
+        ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.commit_throttle.observe_app_copy(
+            /* bytes */ pos_api_param_value(wqe, 1, uint64_t),
+            /* ticks */ POSUtilTscTimer::get_tsc() - s_tick
+        );
         if( ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.TH_actve == true ){
-            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.membus_lock = false;
+            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.release_membus();
         }
     #endif
 
@@ -406,6 +426,7 @@ namespace cuda_memcpy_d2d {
     // launch function
     POS_WK_FUNC_LAUNCH(){
         pos_retval_t retval = POS_SUCCESS;
+        uint64_t s_tick = 0;
         POSHandle *dst_memory_handle, *src_memory_handle;
 
         POS_CHECK_POINTER(ws);
@@ -433,6 +454,10 @@ namespace cuda_memcpy_d2d {
         }
     #endif
 
+    #if POS_CONF_EVAL_CkptOptLevel == 2
+        s_tick = POSUtilTscTimer::get_tsc();
+    #endif
+
         wqe->api_cxt->return_code = cudaMemcpy(
             /* dst */ pos_api_output_handle_offset_server_addr(wqe, 0),
             /* src */ pos_api_input_handle_offset_server_addr(wqe, 0),
@@ -441,8 +466,13 @@ namespace cuda_memcpy_d2d {
         );
 
     #if POS_CONF_EVAL_CkptOptLevel == 2
+        // record the application copy traffic, to adapt the rate of checkpoint commits
+        ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.commit_throttle.observe_app_copy(
+            /* bytes */ pos_api_param_value(wqe, 2, uint64_t),
+            /* ticks */ POSUtilTscTimer::get_tsc() - s_tick
+        );
         if( ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.TH_actve == true ){
-            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.membus_lock = false;
+            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.release_membus();
         }
     #endif
 
@@ -509,7 +539,7 @@ namespace cuda_memcpy_h2d_async {
             if(unlikely(cudaSuccess != wqe->api_cxt->return_code)){ 
                 POS_WARN_DETAIL("failed to sync default stream to avoid ckpt conflict")
             }
-            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.membus_lock = false;
+            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.release_membus();
         }
     #endif
 
@@ -576,7 +606,7 @@ namespace cuda_memcpy_d2h_async {
         );
 
     #if POS_CONF_EVAL_CkptOptLevel == 2
-        ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.membus_lock = false;
+        ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.release_membus();
     #endif
 
         if(unlikely(cudaSuccess != wqe->api_cxt->return_code)){ 
@@ -645,7 +675,7 @@ namespace cuda_memcpy_d2d_async {
             if(unlikely(cudaSuccess != wqe->api_cxt->return_code)){ 
                 POS_WARN_DETAIL("failed to sync default stream to avoid ckpt conflict")
             }
-            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.membus_lock = false;
+            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.release_membus();
         }
     #endif
 
@@ -709,7 +739,7 @@ namespace cuda_memset_async {
             if(unlikely(cudaSuccess != wqe->api_cxt->return_code)){ 
                 POS_WARN_DETAIL("failed to sync default stream to avoid ckpt conflict")
             }
-            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.membus_lock = false;
+            ((POSClient*)(wqe->client))->worker->async_ckpt_cxt.release_membus();
         }
     #endif
 
@@ -26,6 +26,7 @@ pos_retval_t POSWorkspace_CUDA::__init(){
     CUdevice cu_device;
     CUcontext cu_context;
     int device_count, i;
+    char pci_bus_id[32] = { 0 };
 
     // create the api manager
     this->api_mgnr = new POSApiManager_CUDA();
@@ -101,6 +102,14 @@ pos_retval_t POSWorkspace_CUDA::__init(){
                 retval = POS_FAILED_DRIVER;
                 goto exit;
             }
+
+            // daemon threads are placed near the default device
+            dr_retval = cuDeviceGetPCIBusId(pci_bus_id, sizeof(pci_bus_id), cu_device);
+            if (likely(dr_retval == CUDA_SUCCESS)) {
+                this->placement.set_device_numa_node(POSPlacement::get_pci_numa_node(pci_bus_id));
+            } else {
+                POS_WARN_C("failed to obtain PCIe bus id of device %d: dr_retval(%d)", i, dr_retval);
+            }
         }
         this->_cu_contexts.push_back(cu_context);
         POS_DEBUG_C("created CUDA context: device_id(%d)", i);
@@ -160,6 +169,7 @@ pos_retval_t POSWorkspace_CUDA::__create_client(pos_create_client_param_t& param
     pos_retval_t retval = POS_SUCCESS;
     pos_client_cxt_CUDA_t client_cxt;
     std::string runtime_daemon_log_path;
+    std::string kernel_meta_cache_dir;
     std::string conf;
 
     POS_CHECK_POINTER(client);
@@ -188,8 +198,31 @@ pos_retval_t POSWorkspace_CUDA::__create_client(pos_create_client_param_t& param
         goto exit;
     } else {
         client_cxt.cxt_base.kernel_meta_path = runtime_daemon_log_path + std::string("/") 
-                                                + param.job_name + std::string("_kernel_metas.txt");
+                                                + param.job_name + std::string("_kernel_metas.bin");
+    }
+
+    retval = this->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeKernelMetaCacheDir, kernel_meta_cache_dir);
+    if(unlikely(retval != POS_SUCCESS)){
+        POS_ERROR_C("failed to obtain kernel meta cache directory in workspace configuration, this is a bug");
+    }
+    if(kernel_meta_cache_dir == "none"){ kernel_meta_cache_dir.clear(); }
+    if(unlikely(POS_SUCCESS != this->_fatbin_cache.set_dir(kernel_meta_cache_dir))){
+        POS_WARN_C("failed to set kernel meta cache directory, modules would be parsed without the cache");
+    }
+    client_cxt.fatbin_cache = &this->_fatbin_cache;
+
+    retval = this->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeFatbinTextSpill, conf);
+    if(unlikely(retval != POS_SUCCESS)){
+        POS_ERROR_C("failed to obtain fatbin text spilling mode in workspace configuration, this is a bug");
+    }
+    this->_fatbin_cache.set_text_spill(conf == "1");
+
+    retval = this->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeLazyKernelMeta, conf);
+    if(unlikely(retval != POS_SUCCESS)){
+        POS_ERROR_C("failed to obtain lazy kernel metadata mode in workspace configuration, this is a bug");
     }
+    if(conf == "1"){ client_cxt.is_lazy_kernel_meta = true; }
+    else { client_cxt.is_lazy_kernel_meta = false; }
 
     POS_CHECK_POINTER(
         *client = new POSClient_CUDA(
@@ -22,6 +22,15 @@
 #include <algorithm>
 #include <sstream>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <list>
 
 #include <libelf.h>
 #include <gelf.h>
@@ -29,9 +38,13 @@
 
 #include "pos/include/common.h"
 #include "pos/include/log.h"
+#include "pos/include/placement.h"
 
 #include "pos/include/patcher.h"
 
+#include "pos/cuda_impl/utils/kernel_meta_cache.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
+
 #define FATBIN_STRUCT_MAGIC 0x466243b1
 #define FATBIN_TEXT_MAGIC   0xBA55ED50
 
@@ -98,7 +111,15 @@ typedef struct POSCudaFunctionDesp {
     // cbank parameter size (p.s., what is this?)
     uint64_t cbank_param_size;
 
-    POSCudaFunctionDesp() : nb_params(0), cbank_param_size(0), has_verified_params(false) {}
+    /*!
+     *  \brief whether the parameters have been resolved from the prototype (i.e., signature and directions)
+     *  \note  kernels extracted in lazy mode only carry the parameter offsets and sizes, and are resolved on
+     *         their first launch; unresolved kernels carry no signature, so that they're recognized after
+     *         being dumped and loaded again
+     */
+    bool is_resolved;
+
+    POSCudaFunctionDesp() : nb_params(0), cbank_param_size(0), has_verified_params(false), is_resolved(true) {}
     ~POSCudaFunctionDesp(){}
 } POSCudaFunctionDesp_t;
 
@@ -135,6 +156,19 @@ class POSUtil_CUDA_Kernel_Patcher {
  */
 class POSUtil_CUDA_Kernel_Parser {
  public:
+    /*!
+     *  \brief  version of the parsing logic, should be increased once the extracted metadata of the
+     *          same kernel changes, so that the metadata cached by previous versions is abandoned
+     */
+    static constexpr uint32_t kVersion = 1;
+
+    /*!
+     *  \brief  obtain the tag of the parser, which covers kVersion and the toolchain that the parser
+     *          relies on (i.e., the host demangler and libclang)
+     *  \return the tag, which is the same within the process
+     */
+    static const std::string& get_version_tag();
+
     /*!
      *  \brief  analyse the behaviour of an kernel based on its prototype, 
      *          the behaviour is represent by its parameter (i.e., whether it's a pointer), and the direction of the
@@ -143,9 +177,9 @@ class POSUtil_CUDA_Kernel_Parser {
      *  \param  function_desp   pointer of function descriptor
      *  \example    mangles:    _Z8kernel_1PKfPfS1_S1_i
      *              demangles:  kernel_1(const float *, float *, float *, float *, int)
-     *  \note   this function will use binary utilites "cu++filt" to obtain the kernel prototype, and
-     *          use clang to parse the semantics of the prototype
-     *  \todo   use __cu_demangle under CUDA 12.0
+     *  \note   the kernel prototype is demangled in-process and its parameters are classified by their
+     *          declarators, binary utilites "cu++filt" and clang are only used as fallback for names /
+     *          prototypes that can't be handled in-process
      *  \return POS_SUCCESS for successfully parsing
      *          POS_FAILED for failed parsing
      */
@@ -170,6 +204,11 @@ class POSUtil_CUDA_Kernel_Parser {
 
         function_desp->signature = kernel_prototype;
 
+        // fast path: classify the parameters by their declarators, fallback to clang for those can't be classified
+        if(likely(POS_SUCCESS == __classify_prototype(kernel_prototype, function_desp))){
+            goto exit;
+        }
+
         retval = __parse_prototype(kernel_prototype, function_desp);
         if(unlikely(retval != POS_SUCCESS)){
             POS_WARN(
@@ -180,6 +219,7 @@ class POSUtil_CUDA_Kernel_Parser {
         }
 
     exit:
+        if(likely(retval == POS_SUCCESS)){ function_desp->is_resolved = true; }
         return retval;
     }
  
@@ -210,6 +250,93 @@ class POSUtil_CUDA_Kernel_Parser {
      *          POS_FAILED for failed processed
      */
     static pos_retval_t __parse_prototype(const std::string& kernel_prototype, POSCudaFunctionDesp* function_desp);
+
+    /*!
+     *  \brief  classify the parameters of the kernel prototype by their declarators, without clang
+     *  \param  kernel_prototype        the generated kernel prototype
+     *  \param  function_desp           pointer of function descriptor
+     *  \return POS_SUCCESS for successfully classified
+     *          POS_FAILED_INVALID_INPUT for prototype that can't be classified, should fallback to clang
+     */
+    static pos_retval_t __classify_prototype(const std::string& kernel_prototype, POSCudaFunctionDesp* function_desp);
+};
+
+
+/*!
+ *  \brief  persistent pool of loader threads that extract fatbins concurrently, shared by all modules
+ *          loaded within the process, so that loading a module doesn't spawn and join threads
+ */
+class POSUtil_CUDA_Fatbin_Loader_Pool {
+ public:
+    /*!
+     *  \brief  obtain the pool of the process
+     *  \return the pool
+     */
+    static POSUtil_CUDA_Fatbin_Loader_Pool& get();
+
+    /*!
+     *  \brief  run the given function over [0, nb_items) with the loader threads, the calling thread
+     *          also participates, and returns once all items are done
+     *  \note   multiple callers could run concurrently, each of them is helped by at most nb_threads-1
+     *          loader threads, the loader threads are spawned on demand and kept for following runs
+     *  \note   the loader threads are placed as background threads under the placement of the calling
+     *          thread during the run, as the calling thread (i.e., parser) might be pinned to a
+     *          latency-critical core
+     *  \param  nb_items    number of items
+     *  \param  nb_threads  number of threads (including the calling thread)
+     *  \param  batch_size  number of items to be grabbed by a thread at a time
+     *  \param  func        function to run on each item, must be thread-safe among different items
+     */
+    void run(uint64_t nb_items, uint64_t nb_threads, uint64_t batch_size, const std::function<void(uint64_t)>& func);
+
+    ~POSUtil_CUDA_Fatbin_Loader_Pool();
+
+ private:
+    POSUtil_CUDA_Fatbin_Loader_Pool() : _is_stopping(false) {}
+
+    /*!
+     *  \brief  a run issued to the pool
+     */
+    typedef struct pos_fatbin_loader_job {
+        const std::function<void(uint64_t)> *func;
+        uint64_t nb_items;
+        uint64_t batch_size;
+        std::atomic<uint64_t> next_item;
+
+        // placement of the calling thread
+        POSPlacement *placement;
+
+        // number of loader threads wanted / joined / finished, protected by the mutex of the pool
+        uint64_t nb_wanted;
+        uint64_t nb_joined;
+        uint64_t nb_done;
+    } pos_fatbin_loader_job_t;
+
+    /*!
+     *  \brief  grab and run the items of the job until all items are grabbed
+     *  \param  job the job
+     */
+    static void __drain(pos_fatbin_loader_job_t& job);
+
+    /*!
+     *  \brief  main loop of the loader thread
+     *  \param  id  index of the loader thread
+     */
+    void __loader_main(uint64_t id);
+
+    std::mutex _mutex;
+
+    // notified once a job is issued, or the pool is stopping
+    std::condition_variable _job_cv;
+
+    // notified once a loader thread finishes its part of a job
+    std::condition_variable _done_cv;
+
+    // jobs which are still wanting loader threads
+    std::list<pos_fatbin_loader_job_t*> _jobs;
+
+    std::vector<std::thread*> _threads;
+    bool _is_stopping;
 };
 
 
@@ -218,28 +345,67 @@ class POSUtil_CUDA_Kernel_Parser {
  */
 class POSUtil_CUDA_Fatbin {
  public:
+    // automatically decide the number of extraction threads
+    static constexpr uint32_t kAutoNbThreads = 0;
+
+    // maximum number of extraction threads
+    static constexpr uint32_t kMaxNbThreads = 16;
+
+    // minimum number of kernels to be parsed by each extraction thread, as waking up a loader
+    // thread costs more than parsing a few kernels
+    static constexpr uint64_t kMinNbKernelsPerThread = 64;
+
+    // minimum number of payload bytes of the text sections to be extracted by each extraction thread,
+    // for the same reason as above
+    static constexpr uint64_t kMinNbBytesPerThread = 256 << 10;
+
+    // number of kernels to be grabbed by an extraction thread at a time
+    static constexpr uint64_t kKernelBatchSize = 16;
+
+    // merged id of the kernels merged by previous modules
+    static constexpr uint64_t kNoMergedId = UINT64_MAX;
+
     /*!
      *  \brief  obtain metadata of CUDA functions from given fatbin
+     *  \note   the text sections are decompressed and parsed concurrently, then the kernels are merged
+     *          in the order of the sections and the entries within each section, and the prototypes of
+     *          the merged kernels are parsed concurrently, so the result is the same as serial extraction
      *  \param  binary_ptr  pointer to the memory area that stores the fatbin
      *                      (note: the content should start from the fatbin ELF header)
      *  \param  binary_size size of the given binary
      *  \param  desps       vector to store the extracted function metadata
-     *  \param  cached_deps cached function metadata
+     *  \param  cached_desp_map cache of function metadata
+     *  \param  fatbin_cache    node-wide cache of the kernels within each fatbin (optional), the fatbin
+     *                          hits the cache needn't be walked, decompressed and parsed, and the missed
+     *                          one is stored once extracted (except under lazy extraction)
+     *  \param  is_lazy     whether to skip parsing the prototypes of the new kernels, only the parameter
+     *                      offsets and sizes are indexed, and the kernels are resolved on their first launch
+     *  \param  nb_threads  maximum number of threads (including the calling thread) for extraction,
+     *                      kAutoNbThreads for deciding by the number of cores
      *  \return POS_SUCCESS for successfully extraction
      */
     static pos_retval_t obtain_functions_from_cuda_binary(
         uint8_t* binary_ptr,
         uint64_t binary_size,
         std::vector<POSCudaFunctionDesp*>* desps,
-        std::map<std::string, POSCudaFunctionDesp*>& cached_desp_map
+        POSUtil_CUDA_Kernel_Meta_Cache& cached_desp_map,
+        POSUtil_CUDA_Fatbin_Cache* fatbin_cache = nullptr,
+        bool is_lazy = false,
+        uint32_t nb_threads = kAutoNbThreads
     ){
-        pos_retval_t retval = POS_SUCCESS;
-        POSCudaFunctionDesp* new_desp;
+        pos_retval_t retval = POS_SUCCESS, walk_retval = POS_SUCCESS;
         const uint8_t *input_pos = NULL;
-        uint8_t *text_data = NULL;
-        size_t text_data_size = 0;
-        size_t fatbin_total_size = 0;
         uint32_t nb_text_section=1;
+        uint64_t i, j, payload_size = 0;
+        std::vector<pos_fatbin_text_section_t> sections;
+        std::vector<pos_fatbin_kernel_t> merged_kernels;
+        std::vector<pos_retval_t> parse_retvals;
+        std::unordered_map<std::string, uint64_t> merged_names;
+        std::unordered_map<std::string, uint64_t>::iterator merged_iter;
+        std::vector<POSCudaFunctionDesp*> fatbin_desps;
+        POSCudaFunctionDesp *cached_desp;
+        std::string fatbin_key;
+        bool is_fatbin_cache_enabled, is_storable = true;
         
         fat_elf_header_t *fatbin_elf_hdr;
         fat_text_header_t *fatbin_text_hdr;
@@ -256,6 +422,35 @@ class POSUtil_CUDA_Fatbin {
         POS_CHECK_POINTER(input_pos = binary_ptr);
         POS_ASSERT(binary_size > 0);
 
+        if(nb_threads == kAutoNbThreads){
+            nb_threads = std::min<uint32_t>(std::max<uint32_t>(std::thread::hardware_concurrency(), 1), kMaxNbThreads);
+        }
+
+        is_fatbin_cache_enabled = fatbin_cache != nullptr && fatbin_cache->is_enabled();
+        for(j=0; j<desps->size(); j++){ merged_names[(*desps)[j]->name] = kNoMergedId; }
+
+        /* ============ phase 0: look up the whole fatbin from the fatbin cache (serial) ============ */
+        if(is_fatbin_cache_enabled){
+            fatbin_key = POSUtil_CUDA_Fatbin_Cache::key_of(binary_ptr, binary_size, /* is_compressed */ false);
+            if(POS_SUCCESS == fatbin_cache->lookup(fatbin_key, fatbin_desps)){
+                for(POSCudaFunctionDesp *desp : fatbin_desps){
+                    // the same as phase 3, kernels merged by previous modules are skipped
+                    if(unlikely(merged_names.count(desp->name) > 0)){ continue; }
+                    merged_names[desp->name] = kNoMergedId;
+
+                    // kernels within the cached function metadata are preferred, as they might carry
+                    // the parameters verified in previous runs
+                    if(cached_desp_map.size() > 0 && (cached_desp = cached_desp_map.find(desp->name.c_str())) != nullptr){
+                        desps->push_back(cached_desp);
+                    } else {
+                        desps->push_back(desp);
+                    }
+                }
+                goto exit;
+            }
+        }
+
+        /* ============ phase 1: walk the text headers (serial) ============ */
         fatbin_elf_hdr = (fat_elf_header_t*)input_pos;
         retval = POSUtil_CUDA_Fatbin::__verify_fatbin_elf_header(fatbin_elf_hdr);
         if(retval == POS_SUCCESS){
@@ -263,14 +458,13 @@ class POSUtil_CUDA_Fatbin {
              *  \note   case: this is a fatbin that contains multiple cubin
              */
             input_pos += fatbin_elf_hdr->header_size;
-            fatbin_total_size = fatbin_elf_hdr->header_size + fatbin_elf_hdr->size;
 
             do {
                 // verify fatbin text header
                 fatbin_text_hdr = (fat_text_header_t*)input_pos;
-                retval = POSUtil_CUDA_Fatbin::__verify_fatbin_text_header(fatbin_text_hdr);
-                if(unlikely(retval != POS_SUCCESS)){
-                    goto exit;
+                walk_retval = POSUtil_CUDA_Fatbin::__verify_fatbin_text_header(fatbin_text_hdr);
+                if(unlikely(walk_retval != POS_SUCCESS)){
+                    break;
                 }
                 input_pos += fatbin_text_hdr->header_size;
 
@@ -289,38 +483,25 @@ class POSUtil_CUDA_Fatbin {
                         POS_DEBUG("%u(th) fatbin text section contains debug information", nb_text_section);
                     }
 
+                    sections.emplace_back();
+                    sections.back().id = nb_text_section;
+                    sections.back().elf_hdr = fatbin_elf_hdr;
+                    sections.back().text_hdr = fatbin_text_hdr;
+                    sections.back().payload = input_pos;
+
                     if (fatbin_text_hdr->flags & FATBIN_FLAG_COMPRESS){
-                        // the payload of this section is compressed, need to be decompressed
-                        ssize_t input_read;
+                        // the payload of this section is compressed, would be decompressed in phase 2
                         POS_DEBUG(
-                            "%u(th) fatbin text section contains compressed device code, decompressing...",
+                            "%u(th) fatbin text section contains compressed device code",
                             nb_text_section
                         );
-
-                        input_read = POSUtil_CUDA_Fatbin::__decompress_single_text_section(
-                            input_pos, &text_data, &text_data_size, fatbin_elf_hdr, fatbin_text_hdr
+                        sections.back().payload_size = POSUtil_CUDA_Fatbin::__get_compressed_text_section_size(
+                            input_pos, fatbin_text_hdr
                         );
-                        if(unlikely(input_read < 0)){
-                            POS_WARN("failed to decompress %u(th) fatbin text section", nb_text_section);
-                            retval = POS_FAILED;
-                            goto exit;
-                        }
-
-                        input_pos += input_read;
                     } else {
-                        text_data = (uint8_t*)input_pos;
-                        text_data_size = fatbin_text_hdr->size;
-                        input_pos += fatbin_text_hdr->size;
-                    }
-
-                    retval = POSUtil_CUDA_Fatbin::__extract_kernel_infos(text_data, text_data_size, desps, cached_desp_map);
-                    if(unlikely(retval != POS_SUCCESS)){
-                        goto exit;
-                    }
-
-                    if (fatbin_text_hdr->flags & FATBIN_FLAG_COMPRESS) {
-                        free(text_data);
+                        sections.back().payload_size = fatbin_text_hdr->size;
                     }
+                    input_pos += sections.back().payload_size;
 
                     nb_text_section += 1;
                 } else {
@@ -344,18 +525,136 @@ class POSUtil_CUDA_Fatbin {
             /*!
              *  \note   case: this is a single ELF cubin
              */
-            retval = POSUtil_CUDA_Fatbin::__extract_kernel_infos(binary_ptr, binary_size, desps, cached_desp_map);
-            if(unlikely(retval != POS_SUCCESS)){
-                goto exit;
+            sections.emplace_back();
+            sections.back().id = nb_text_section;
+            sections.back().payload = binary_ptr;
+            sections.back().payload_size = binary_size;
+        }
+        retval = POS_SUCCESS;
+
+        /* ========= phase 2: decompress and parse the ELF of each section (concurrent) ========= */
+        for(i=0; i<sections.size(); i++){ payload_size += sections[i].payload_size; }
+        POSUtil_CUDA_Fatbin::__run_concurrently(
+            /* nb_items */ sections.size(),
+            /* nb_threads */ std::min<uint64_t>(
+                std::min<uint64_t>(nb_threads, sections.size()),
+                (payload_size + kMinNbBytesPerThread - 1) / kMinNbBytesPerThread
+            ),
+            /* batch_size */ 1,
+            /* func */ [&](uint64_t id){
+                POSUtil_CUDA_Fatbin::__extract_text_section(
+                    sections[id], cached_desp_map, is_fatbin_cache_enabled ? fatbin_cache : nullptr
+                );
+            }
+        );
+
+        /* ========= phase 3: merge the kernels in the order of sections and entries (serial) ========= */
+        for(i=0; i<sections.size(); i++){
+            for(j=0; j<sections[i].kernels.size(); j++){
+                pos_fatbin_kernel_t& kernel = sections[i].kernels[j];
+
+                /*!
+                 *  \note   make sure no kernels with the same name are recorded at the same time, those
+                 *          kernels with same name are the same definition under different PTX/SASS version,
+                 *          we don't care about the architecture thing under POS, so we just ignore duplication
+                 */
+                if(unlikely(retval != POS_SUCCESS)){
+                    if(!kernel.is_cached){ delete kernel.desp; }
+                    continue;
+                }
+                if(unlikely((merged_iter = merged_names.find(kernel.desp->name)) != merged_names.end())){
+                    // the kernel is merged by previous modules, whose metadata isn't owned by this extraction
+                    if(merged_iter->second == kNoMergedId){ is_storable = false; }
+                    if(!kernel.is_cached){ delete kernel.desp; }
+                    continue;
+                }
+
+                merged_names[kernel.desp->name] = merged_kernels.size();
+                merged_kernels.push_back(kernel);
+            }
+            if(unlikely(retval == POS_SUCCESS && sections[i].retval != POS_SUCCESS)){
+                retval = sections[i].retval;
             }
         }
+        if(retval == POS_SUCCESS){ retval = walk_retval; }
+
+        /* ========= phase 4: parse the prototypes of the new kernels (concurrent, skipped if lazy) ========= */
+        parse_retvals.resize(merged_kernels.size(), POS_SUCCESS);
+        if(is_lazy){
+            // the prototypes are parsed on the first launch of the kernels
+            for(i=0; i<merged_kernels.size(); i++){
+                if(!merged_kernels[i].is_cached){ merged_kernels[i].desp->is_resolved = false; }
+            }
+        } else {
+            POSUtil_CUDA_Fatbin::__run_concurrently(
+                /* nb_items */ merged_kernels.size(),
+                /* nb_threads */ std::min<uint64_t>(
+                    nb_threads, (merged_kernels.size() + kMinNbKernelsPerThread - 1) / kMinNbKernelsPerThread
+                ),
+                /* batch_size */ kKernelBatchSize,
+                /* func */ [&](uint64_t id){
+                    pos_fatbin_kernel_t& kernel = merged_kernels[id];
+
+                    if(kernel.is_cached){
+                        if(likely(kernel.desp->is_resolved)){ return; }
+                        // cached by a lazy run, the cached metadata is shared so we resolve on a copy
+                        POS_CHECK_POINTER(kernel.desp = new POSCudaFunctionDesp_t(*kernel.desp));
+                        kernel.is_cached = false;
+                    }
 
-    #undef __POS_DUMP_FATBIN
+                    // parsing the parameters hints (e.g., whether it's a pointer, direction of the pointer)
+                    parse_retvals[id] = POSUtil_CUDA_Kernel_Parser::parse_by_prototype(kernel.desp->name.c_str(), kernel.desp);
+                }
+            );
+        }
+
+        for(i=0; i<merged_kernels.size(); i++){
+            if(unlikely(parse_retvals[i] != POS_SUCCESS)){
+                POS_WARN_DETAIL(
+                    "failed to extract parameter hints (pointer, direction): kernel_name(%s), won't be recorded!",
+                    merged_kernels[i].desp->name.c_str()
+                );
+                delete merged_kernels[i].desp;
+                continue;
+            }
+            desps->push_back(merged_kernels[i].desp);
+        }
+
+        /* ========= phase 5: store the newly extracted fatbin to the fatbin cache (serial, skipped if lazy) ========= */
+        /*!
+         *  \note   kernels out of the cached function metadata are skipped during extraction if it's given,
+         *          so the extracted fatbin is incomplete, and shouldn't be stored
+         *  \note   the prototypes aren't parsed under lazy extraction, the unresolved kernels shouldn't be
+         *          stored either, as the cache is shared by processes that might not be lazy
+         */
+        if(is_fatbin_cache_enabled && is_storable && !is_lazy && retval == POS_SUCCESS && cached_desp_map.size() == 0){
+            // kernels failed to be parsed are dropped, the same as they're extracted
+            for(i=0; i<merged_kernels.size(); i++){
+                if(parse_retvals[i] == POS_SUCCESS){ fatbin_desps.push_back(merged_kernels[i].desp); }
+            }
+            if(unlikely(POS_SUCCESS != fatbin_cache->store(fatbin_key, fatbin_desps))){
+                POS_WARN("failed to store fatbin to kernel meta cache: key(%s)", fatbin_key.c_str());
+            }
+        }
 
     exit:
+    #undef __POS_DUMP_FATBIN
+
         return retval;
     }
 
+    /*!
+     *  \brief  decompress the payload of a compressed text section (without the padding)
+     *  \param  input       pointer compressed input data
+     *  \param  input_size  size of compressed data
+     *  \param  output      preallocated memory where decompressed output should be stored
+     *  \param  output_size size of output buffer. Should be equal to the size of the decompressed data
+     *  \return size of the decompressed data, 0 for malformed input
+     */
+    static inline size_t decompress(const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size){
+        return POSUtil_CUDA_Fatbin::__decompress(input, input_size, output, output_size);
+    }
+
 
  private:
     /*!
@@ -391,6 +690,44 @@ class POSUtil_CUDA_Fatbin {
                                         // than size.
     } fat_text_header_t;
 
+    /*!
+     *  \brief  a kernel extracted from a text section, before merged into the function metadata
+     */
+    typedef struct pos_fatbin_kernel {
+        // function metadata of the kernel, owned by the extraction if not cached
+        POSCudaFunctionDesp *desp;
+
+        // whether the metadata comes from the cached function metadata
+        bool is_cached;
+    } pos_fatbin_kernel_t;
+
+    /*!
+     *  \brief  a text section (i.e., cubin) to be extracted
+     */
+    typedef struct pos_fatbin_text_section {
+        // index of the section within the fatbin
+        uint32_t id;
+
+        // headers of the section, nullptr for a single ELF cubin
+        fat_elf_header_t *elf_hdr;
+        fat_text_header_t *text_hdr;
+
+        // payload of the section (might be compressed), excluding the text header
+        const uint8_t *payload;
+        uint64_t payload_size;
+
+        // extracted kernels, in the order of the entries within ".nv.info"
+        std::vector<pos_fatbin_kernel_t> kernels;
+        pos_retval_t retval;
+
+        // key of the decompressed content within the fatbin cache
+        std::string cache_key;
+
+        pos_fatbin_text_section()
+            :   id(0), elf_hdr(nullptr), text_hdr(nullptr), payload(nullptr), payload_size(0),
+                retval(POS_SUCCESS) {}
+    } pos_fatbin_text_section_t;
+
     struct __attribute__((__packed__)) nv_info_entry{
         uint8_t format;
         uint8_t attribute;
@@ -482,12 +819,130 @@ class POSUtil_CUDA_Fatbin {
         return retval;
     }
 
+    /*!
+     *  \brief  run the given function over [0, nb_items) with the loader pool, the calling thread
+     *          also participates, and returns once all items are done
+     *  \param  nb_items    number of items
+     *  \param  nb_threads  number of threads (including the calling thread)
+     *  \param  batch_size  number of items to be grabbed by a thread at a time
+     *  \param  func        function to run on each item, must be thread-safe among different items
+     */
+    template<typename T_Func>
+    static void __run_concurrently(uint64_t nb_items, uint64_t nb_threads, uint64_t batch_size, T_Func&& func){
+        uint64_t id;
+
+        // avoid wrapping the function and touching the pool when there's no one to help
+        if(nb_threads <= 1 || nb_items <= batch_size){
+            for(id=0; id<nb_items; id++){ func(id); }
+            return;
+        }
+
+        POSUtil_CUDA_Fatbin_Loader_Pool::get().run(
+            /* nb_items */ nb_items,
+            /* nb_threads */ std::min<uint64_t>(nb_threads, kMaxNbThreads),
+            /* batch_size */ batch_size,
+            /* func */ std::function<void(uint64_t)>(std::forward<T_Func>(func))
+        );
+    }
+
+    /*!
+     *  \brief  compute the key of a text section within the fatbin cache, if it's not computed yet
+     *  \param  section the text section, the key is stored inside
+     */
+    static inline void __key_of_text_section(pos_fatbin_text_section_t& section){
+        bool is_compressed;
+
+        if(section.cache_key.size() > 0){ return; }
+
+        is_compressed = section.text_hdr != nullptr && (section.text_hdr->flags & FATBIN_FLAG_COMPRESS);
+
+        // the padding after the compressed payload depends on its address, so it's excluded from the key
+        section.cache_key = POSUtil_CUDA_Fatbin_Cache::key_of(
+            /* content */ section.payload,
+            /* content_size */ is_compressed ? section.text_hdr->compressed_size : section.payload_size,
+            /* is_compressed */ is_compressed
+        );
+    }
+
+    /*!
+     *  \brief  decompress (if needed) and extract the kernels from a text section
+     *  \param  section         the text section, the extracted kernels and the result are stored inside
+     *  \param  cached_desp_map cache of function metadata
+     *  \param  fatbin_cache    node-wide fatbin cache (optional), the decompressed content of the
+     *                          compressed section is looked up from (and stored to) it
+     */
+    static void __extract_text_section(
+        pos_fatbin_text_section_t& section,
+        POSUtil_CUDA_Kernel_Meta_Cache& cached_desp_map,
+        POSUtil_CUDA_Fatbin_Cache* fatbin_cache = nullptr
+    ){
+        std::shared_ptr<const std::vector<uint8_t>> text;
+        std::shared_ptr<std::vector<uint8_t>> decompressed_text;
+        ssize_t input_read;
+        bool is_compressed;
+
+        is_compressed = section.text_hdr != nullptr && (section.text_hdr->flags & FATBIN_FLAG_COMPRESS);
+
+        if(!is_compressed){
+            section.retval = POSUtil_CUDA_Fatbin::__extract_kernel_infos(
+                (uint8_t*)section.payload, section.payload_size, section.kernels, cached_desp_map
+            );
+            return;
+        }
+
+        if(fatbin_cache != nullptr){
+            POSUtil_CUDA_Fatbin::__key_of_text_section(section);
+            fatbin_cache->lookup_text(
+                /* key */ section.cache_key,
+                /* expected_size */ POSUtil_CUDA_Fatbin::__get_decompressed_text_section_size(section.text_hdr),
+                /* text */ text
+            );
+        }
+
+        if(text == nullptr){
+            POS_CHECK_POINTER(decompressed_text = std::make_shared<std::vector<uint8_t>>());
+            input_read = POSUtil_CUDA_Fatbin::__decompress_single_text_section(
+                section.payload, *decompressed_text, section.elf_hdr, section.text_hdr
+            );
+            if(unlikely(input_read < 0)){
+                POS_WARN("failed to decompress %u(th) fatbin text section", section.id);
+                section.retval = POS_FAILED;
+                return;
+            }
+            POS_ASSERT(input_read == section.payload_size);
+            text = decompressed_text;
+            if(fatbin_cache != nullptr){ fatbin_cache->store_text(section.cache_key, text); }
+        }
+
+        // the ELF is only read, so the cached content could be shared with other extractions
+        section.retval = POSUtil_CUDA_Fatbin::__extract_kernel_infos(
+            const_cast<uint8_t*>(text->data()), text->size(), section.kernels, cached_desp_map
+        );
+    }
+
+    /*!
+     *  \brief  obtain the size of a compressed text section within the fatbin file, including the padding
+     *  \note   this should be consistent with __decompress_single_text_section
+     */
+    static inline size_t __get_compressed_text_section_size(const uint8_t *input, fat_text_header_t *th){
+        return th->compressed_size + ((8 - (size_t)(input + th->compressed_size)) % 8);
+    }
+
+    /*!
+     *  \brief  obtain the size of a decompressed text section, including the padding
+     *  \note   this should be consistent with __decompress_single_text_section
+     */
+    static inline size_t __get_decompressed_text_section_size(fat_text_header_t *th){
+        return th->decompressed_size + ((8 - (size_t)th->decompressed_size) % 8);
+    }
+
     /*! 
      *  \brief  decompresses a single text section within the fatbin file
+     *  \param  output  buffer to store the decompressed section (including the padding), which is resized
+     *  \return number of bytes read from the input, -1 for failed
      */
     static ssize_t __decompress_single_text_section(
-        const uint8_t *input, uint8_t **output, size_t *output_size,
-        fat_elf_header_t *eh, fat_text_header_t *th
+        const uint8_t *input, std::vector<uint8_t>& output, fat_elf_header_t *eh, fat_text_header_t *th
     ){
         size_t padding;
         size_t input_read = 0;
@@ -495,20 +950,22 @@ class POSUtil_CUDA_Fatbin {
         size_t decompress_ret = 0;
         const uint8_t zeroes[8] = {0};
 
-        POS_CHECK_POINTER(input); POS_CHECK_POINTER(output);
+        POS_CHECK_POINTER(input);
         POS_CHECK_POINTER(eh); POS_CHECK_POINTER(th);
 
         // add max padding of 7 bytes
-        POS_CHECK_POINTER(*output = (uint8_t*)malloc(th->decompressed_size + 7)); 
+        output.resize(th->decompressed_size + 7);
 
-        decompress_ret = POSUtil_CUDA_Fatbin::__decompress(input, th->compressed_size, *output, th->decompressed_size);
+        decompress_ret = POSUtil_CUDA_Fatbin::__decompress(
+            input, th->compressed_size, output.data(), th->decompressed_size
+        );
 
         if (unlikely(decompress_ret != th->decompressed_size)) {
             POS_WARN(
                 "decompression failed: decompressed size is %#zx, but header says %#zx", 
                 decompress_ret, th->decompressed_size
             );
-            POS_WARN("input pos: %#zx, output pos: %#zx", input - (uint8_t*)eh, *output);
+            POS_WARN("input pos: %#zx", input - (uint8_t*)eh);
             goto     POSUtil_CUDA_Fatbin___decompress_single_text_section_error;
         }
         input_read += th->compressed_size;
@@ -525,27 +982,33 @@ class POSUtil_CUDA_Fatbin {
 
         // Because we always allocated enough memory for one more elf_header and this is smaller than
         // the maximal padding of 7, we do not have to reallocate here.
-        memset(*output, 0, padding);
+        memset(output.data() + th->decompressed_size, 0, padding);
         output_written += padding;
 
-        *output_size = output_written;
+        output.resize(output_written);
         return input_read;
 
     POSUtil_CUDA_Fatbin___decompress_single_text_section_error:
-        free(*output);
-        *output = NULL;
+        output.clear();
         return -1;
     }
 
     /*! 
      *  \brief  decompresses a fatbin file
+     *  \note   overlapped matches (i.e., the match is longer than its offset) repeat the last bytes, which
+     *          are copied in doubling chunks rather than byte by byte; malformed input (e.g., offsets or
+     *          lengths beyond the buffers) is rejected rather than read / written out of bounds
      *  \param  input       pointer compressed input data
      *  \param  input_size  size of compressed data
      *  \param  output      preallocated memory where decompressed output should be stored
      *  \param  output_size size of output buffer. Should be equal to the size of the decompressed data
+     *  \return size of the decompressed data, 0 for malformed input
      */
     static size_t __decompress(const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size){
+        // overlapped matches up to this length are copied byte by byte
+        constexpr uint64_t kMaxBytewiseMatchLen = 32;
         size_t ipos = 0, opos = 0;  
+        size_t copied, chunk_size;
         uint64_t next_nclen;  // length of next non-compressed segment
         uint64_t next_clen;   // length of next compressed segment
         uint64_t back_offset; // negative offset where redudant data is located, relative to current opos
@@ -555,31 +1018,46 @@ class POSUtil_CUDA_Fatbin {
             next_clen = 4 + (input[ipos] & 0xf);
             if (next_nclen == 0xf) {
                 do {
-                    next_nclen += input[++ipos];
+                    if (unlikely(++ipos >= input_size)) { return 0; }
+                    next_nclen += input[ipos];
                 } while (input[ipos] == 0xff);
             }
-            
-            memcpy(output + opos, input + (++ipos), next_nclen);
+            ipos += 1;
+
+            if (unlikely(next_nclen > input_size - ipos || next_nclen > output_size - opos)) { return 0; }
+            memcpy(output + opos, input + ipos, next_nclen);
 
             ipos += next_nclen;
             opos += next_nclen;
             if (ipos >= input_size || opos >= output_size) {
                 break;
             }
+
+            if (unlikely(input_size - ipos < 2)) { return 0; }
             back_offset = input[ipos] + (input[ipos + 1] << 8);       
             ipos += 2;
             if (next_clen == 0xf+4) {
                 do {
+                    if (unlikely(ipos >= input_size)) { return 0; }
                     next_clen += input[ipos++];
                 } while (input[ipos - 1] == 0xff);
             }
 
+            if (unlikely(back_offset == 0 || back_offset > opos || next_clen > output_size - opos)) { return 0; }
             if (next_clen <= back_offset) {
                 memcpy(output + opos, output + opos - back_offset, next_clen);
+            } else if (next_clen <= kMaxBytewiseMatchLen) {
+                // short overlapped match, which is cheaper to copy byte by byte than calling memcpy many times
+                for (copied = 0; copied < next_clen; copied++) {
+                    output[opos + copied] = output[opos + copied - back_offset];
+                }
             } else {
+                // after the first back_offset bytes, the copied part is a whole number of periods,
+                // so it could be duplicated as is
                 memcpy(output + opos, output + opos - back_offset, back_offset);
-                for (size_t i = back_offset; i < next_clen; i++) {
-                    output[opos + i] = output[opos + i - back_offset];
+                for (copied = back_offset; copied < next_clen; copied += chunk_size) {
+                    chunk_size = std::min<size_t>(copied, next_clen - copied);
+                    memcpy(output + opos + copied, output + opos, chunk_size);
                 }
             }
 
@@ -591,14 +1069,16 @@ class POSUtil_CUDA_Fatbin {
 
     /*!
      *  \brief  extract kernel infos from a given fatbin text section
+     *  \note   this only touches the given section, so different sections could be extracted concurrently;
+     *          the prototypes of the kernels are parsed after merging kernels of all sections
      *  \param  memory          pointer to the target fatbin text section
      *  \param  memsize         size of the given fatbin text section
-     *  \param  desps           vector to store the extracted function metadata
-     *  \param  cached_desp_map map of cached function metadata
+     *  \param  kernels         vector to store the extracted kernels
+     *  \param  cached_desp_map cache of function metadata
      */
     static pos_retval_t __extract_kernel_infos(
-        void* memory, size_t memsize, std::vector<POSCudaFunctionDesp*>* desps,
-        std::map<std::string, POSCudaFunctionDesp*>& cached_desp_map
+        void* memory, size_t memsize, std::vector<pos_fatbin_kernel_t>& kernels,
+        POSUtil_CUDA_Kernel_Meta_Cache& cached_desp_map
     ){
         /* =================== ELF utility functions =================== */
 
@@ -673,6 +1153,36 @@ class POSUtil_CUDA_Fatbin {
 
             return POS_FAILED_NOT_EXIST;
         };
+
+        /*!
+         *  \brief  index all sections within the ELF by their names, as each kernel has its own sections
+         *          and finding them one by one is quadratic to the number of kernels
+         *  \param  elf             the target ELF
+         *  \param  section_index   the resulted index
+         *  \return POS_SUCCESS for successfully indexed;
+         *          POS_FAILED for internal errors
+         */
+        auto index_sections = [](Elf *elf, std::unordered_map<std::string, Elf_Scn*>& section_index) -> pos_retval_t {
+            Elf_Scn *scn = NULL;
+            GElf_Shdr shdr;
+            char *section_name = NULL;
+            size_t str_section_index;
+
+            POS_CHECK_POINTER(elf);
+
+            if (elf_getshdrstrndx(elf, &str_section_index) != 0){ return POS_FAILED; }
+
+            while ((scn = elf_nextscn(elf, scn)) != NULL) {
+                if (gelf_getshdr(scn, &shdr) != &shdr) { return POS_FAILED; }
+                if ((section_name = elf_strptr(elf, str_section_index, shdr.sh_name)) == NULL) {
+                    return POS_FAILED;
+                }
+                // keep the first one as get_section_by_name does
+                section_index.emplace(section_name, scn);
+            }
+
+            return POS_SUCCESS;
+        };
         
         /*!
          *  \brief  extract the symbol table section within the ELF
@@ -734,6 +1244,7 @@ class POSUtil_CUDA_Fatbin {
         /*!
          *  \brief  extract parameter info of the kernel within the ELF
          *  \param  elf             descriptor of target ELF file
+         *  \param  section_index   sections within the ELF indexed by names
          *  \param  function_desp   pointer to the pointer of function descriptor
          *  \param  memory          data area of target ELF file
          *  \param  memsize         size of the data area of target ELF file
@@ -742,12 +1253,14 @@ class POSUtil_CUDA_Fatbin {
          *          POS_FAILED_NOT_EXIST for no section was founded
          */
         auto get_params_for_kernel = [&](
-            Elf *elf, POSCudaFunctionDesp** function_desp, void* memory, size_t memsize
+            Elf *elf, const std::unordered_map<std::string, Elf_Scn*>& section_index,
+            POSCudaFunctionDesp** function_desp, void* memory, size_t memsize
         ) -> pos_retval_t {
             char *section_name = NULL;
             Elf_Scn *section = NULL;
             Elf_Data *data = NULL;
             size_t secpos=0;
+            std::unordered_map<std::string, Elf_Scn*>::const_iterator section_iter;
 
             POS_CHECK_POINTER(elf); POS_CHECK_POINTER(function_desp); POS_CHECK_POINTER(memory);
 
@@ -756,20 +1269,24 @@ class POSUtil_CUDA_Fatbin {
                 POS_WARN("failed to form section name based on kernel's name: kernel_name(%s)", (*function_desp)->name.c_str());
                 return POS_FAILED_NOT_EXIST; 
             }
-            if (get_section_by_name(elf, section_name, &section) != 0) {
+            if ((section_iter = section_index.find(section_name)) == section_index.end()) {
                 POS_WARN(
                     "failed to get section based on kernel's name: kernel_name(%s), section_name(%s)",
                     (*function_desp)->name.c_str(), section_name
                 );
+                free(section_name);
                 return POS_FAILED;
             }
+            section = section_iter->second;
             if ((data = elf_getdata(section, NULL)) == NULL) {
                 POS_WARN(
                     "failed to get kernel section data: kernel_name(%s), section_name(%s)",
                     (*function_desp)->name.c_str(), section_name
                 );
+                free(section_name);
                 return POS_FAILED;
             }
+            free(section_name);
 
             while (secpos < data->d_size) {
                 struct nv_info_kernel_entry *entry = (struct nv_info_kernel_entry*)(data->d_buf+secpos);
@@ -820,13 +1337,14 @@ class POSUtil_CUDA_Fatbin {
         Elf_Data *data = NULL, *symbol_table_data = NULL;
         GElf_Shdr symtab_shdr;
         size_t symnum;
-        int i = 0, j;
+        int i = 0;
         GElf_Sym sym;
         const char *kernel_str;
-        POSCudaFunctionDesp *function_desp;
-        bool is_duplicated;
+        POSCudaFunctionDesp *function_desp, *cached_desp;
+        std::unordered_map<std::string, Elf_Scn*> section_index;
+        std::unordered_set<uint32_t> extracted_kernel_ids;
 
-        POS_CHECK_POINTER(memory); POS_CHECK_POINTER(desps);
+        POS_CHECK_POINTER(memory);
         POS_ASSERT(memsize > 0);
 
         // create elf descriptor for the memory region
@@ -855,6 +1373,12 @@ class POSUtil_CUDA_Fatbin {
             goto exit;
         }
 
+        retval = index_sections(elf, section_index);
+        if(unlikely(retval != POS_SUCCESS)){
+            POS_WARN_DETAIL("failed to index sections within the ELF");
+            goto exit;
+        }
+
         // analyse all kernels within this section
         for (size_t secpos=0; secpos < data->d_size; secpos += sizeof(struct nv_info_entry)){
             struct nv_info_entry *entry = (struct nv_info_entry *)(data->d_buf+secpos);
@@ -884,6 +1408,9 @@ class POSUtil_CUDA_Fatbin {
                 continue;
             }
 
+            // a kernel has multiple entries (i.e., attributes) within the section
+            if(extracted_kernel_ids.insert(entry->kernel_id).second == false){ continue; }
+
             // obtain the kernel name from symbol table by given symbol index (i.e., kernel_id)
             if (gelf_getsym(symbol_table_data, entry->kernel_id, &sym) == NULL) {
                 POS_WARN(
@@ -899,24 +1426,9 @@ class POSUtil_CUDA_Fatbin {
                 continue;
             }
             
-            /*!
-             *  \note   make sure no kernels with the same name are recorded at the same time, those
-             *          kernels with same name are the same definition under different PTX/SASS version,
-             *          we don't care about the architecture thing under POS, so we just ignore duplication
-             */
-            is_duplicated = false;
-            for(j=0; j<desps->size(); j++){
-                if(unlikely(!strcmp(kernel_str, (*desps)[j]->name.c_str()))){
-                    is_duplicated = true;
-                    break;
-                }
-            }
-            if(unlikely(is_duplicated)){ continue; }
-
             // check whether this function is cached
-            if(likely(cached_desp_map.count(std::string(kernel_str)) > 0)){
-                function_desp = cached_desp_map[std::string(kernel_str)];
-                desps->push_back(function_desp);
+            if(likely((cached_desp = cached_desp_map.find(kernel_str)) != nullptr)){
+                kernels.push_back({ /* desp */ cached_desp, /* is_cached */ true });
             } else {
                 /*!
                  *  \note   we can skip those kernels that won't be called
@@ -932,24 +1444,19 @@ class POSUtil_CUDA_Fatbin {
                 function_desp->name = std::string(kernel_str);
 
                 // analyse the parameters of the kernel
-                retval = get_params_for_kernel(elf, &function_desp, memory, memsize);
+                retval = get_params_for_kernel(elf, section_index, &function_desp, memory, memsize);
                 if(unlikely(retval != POS_SUCCESS)){
                     POS_WARN_DETAIL("failed to extract parameter out of the kernel in the ELF: kernel_name(%s)", kernel_str);
+                    delete function_desp;
                     goto exit;
                 }
 
-                // parsing the parameters hints (e.g., whether it's a pointer, direction of the pointer)
-                retval = POSUtil_CUDA_Kernel_Parser::parse_by_prototype(kernel_str, function_desp);
-                if(unlikely(retval != POS_SUCCESS)){
-                    POS_WARN_DETAIL("failed to extract parameter hints (pointer, direction): kernel_name(%s), won't be recorded!", kernel_str);
-                    continue;
-                }
-
-                desps->push_back(function_desp);
+                kernels.push_back({ /* desp */ function_desp, /* is_cached */ false });
             }
         }
 
     exit:
+        if(elf != NULL){ elf_end(elf); }
         return retval;
     }
 };
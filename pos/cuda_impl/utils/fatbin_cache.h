@@ -0,0 +1,249 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/metrics/counter.h"
+#include "pos/include/placement.h"
+#include "pos/cuda_impl/utils/kernel_meta_cache.h"
+
+
+/*!
+ *  \brief  node-wide cache of the kernel metadata extracted from fatbins, keyed by the content hash of
+ *          the fatbin, so that the same framework fatbin loaded by different jobs (or by the same job
+ *          after daemon restarts) needn't be parsed again
+ *  \note   the kernels of each fatbin are stored as a single binary kernel meta file (see
+ *          POSUtil_CUDA_Kernel_Meta_Cache) named by its key and the version tag of the kernel parser under
+ *          the cache directory, which is written to a temporary file then renamed, so concurrent writers
+ *          (even from different daemons) never expose a partial file; the loaded files are kept mapped
+ *          and their kernels are shared by all clients of the daemon
+ *  \note   the keys of the files within the directory are listed once, and listed again only after the
+ *          directory is modified, so that a missed fatbin costs no file system access
+ *  \note   fatbins are written by a background thread, so that loading a module isn't slowed down
+ *  \note   the decompressed content of compressed text sections is also cached under the key of the
+ *          section, so that the sections of a missed fatbin needn't be decompressed again (e.g., the same
+ *          cubin shared by different fatbins); they're kept in memory within a capacity (least recently
+ *          used ones are evicted), and optionally spilled to the directory
+ *  \note   all methods are thread-safe
+ */
+class POSUtil_CUDA_Fatbin_Cache {
+ public:
+    POSUtil_CUDA_Fatbin_Cache();
+    ~POSUtil_CUDA_Fatbin_Cache();
+
+    // default capacity of the decompressed sections kept in memory
+    static constexpr uint64_t kDefaultTextCapacity = 256ull << 20;
+
+    /*!
+     *  \brief  set the directory of the cache, the directory is created if not exist
+     *  \param  dir path to the directory, empty for disabling the cache
+     *  \return POS_SUCCESS for successfully set;
+     *          POS_FAILED for failed to create the directory, the cache is disabled
+     */
+    pos_retval_t set_dir(const std::string& dir);
+
+    /*!
+     *  \brief  obtain the key of a fatbin (or a text section) by its content
+     *  \param  content         content of the fatbin or the text section (compressed or not)
+     *  \param  content_size    size of the content
+     *  \param  is_compressed   whether the content is a compressed text section
+     *  \return the key of the content
+     */
+    static std::string key_of(const uint8_t *content, uint64_t content_size, bool is_compressed);
+
+    /*!
+     *  \brief  look up the kernels of a fatbin
+     *  \note   the returned descriptors are owned by the cache and shared among clients, which
+     *          should be read-only
+     *  \param  key     key of the fatbin
+     *  \param  desps   the kernels of the fatbin, in the order when they're stored
+     *  \return POS_SUCCESS for cache hit;
+     *          POS_FAILED_NOT_EXIST for cache miss (or the cache is disabled)
+     */
+    pos_retval_t lookup(const std::string& key, std::vector<POSCudaFunctionDesp*>& desps);
+
+    /*!
+     *  \brief  store the kernels of a fatbin
+     *  \note   the kernels are copied, and written to the directory asynchronously
+     *  \param  key     key of the fatbin
+     *  \param  desps   the kernels of the fatbin
+     *  \return POS_SUCCESS for successfully queued (or already stored)
+     */
+    pos_retval_t store(const std::string& key, const std::vector<POSCudaFunctionDesp*>& desps);
+
+    /*!
+     *  \brief  look up the decompressed content of a compressed text section
+     *  \note   the spilled file is read if the section isn't in memory, and spilling is enabled
+     *  \param  key             key of the section
+     *  \param  expected_size   expected size of the decompressed content, others are treated as corrupted
+     *  \param  text            the decompressed content, which is read-only and shared among clients
+     *  \return POS_SUCCESS for cache hit;
+     *          POS_FAILED_NOT_EXIST for cache miss
+     */
+    pos_retval_t lookup_text(
+        const std::string& key, uint64_t expected_size, std::shared_ptr<const std::vector<uint8_t>>& text
+    );
+
+    /*!
+     *  \brief  store the decompressed content of a compressed text section
+     *  \note   the content is spilled to the directory asynchronously if spilling is enabled
+     *  \param  key     key of the section
+     *  \param  text    the decompressed content
+     */
+    void store_text(const std::string& key, std::shared_ptr<const std::vector<uint8_t>> text);
+
+    /*!
+     *  \brief  set whether to spill the decompressed sections to the directory
+     */
+    void set_text_spill(bool is_text_spill);
+
+    /*!
+     *  \brief  set the capacity of the decompressed sections kept in memory, 0 for disabling
+     */
+    void set_text_capacity(uint64_t capacity);
+
+    /*!
+     *  \brief  wait until all queued sections are written
+     */
+    void flush();
+
+    /*!
+     *  \brief  whether the cache is enabled
+     */
+    bool is_enabled();
+
+    /*!
+     *  \brief  print the hit / miss metrics of the cache
+     */
+    void print_metrics();
+
+ private:
+    // directory of the cache, empty for disabled
+    std::string _dir;
+
+    // fatbins loaded from the directory: key -> (mapped file, kernels owned by the file)
+    std::unordered_map<
+        std::string,
+        std::pair<std::unique_ptr<POSUtil_CUDA_Kernel_Meta_Cache>, std::vector<POSCudaFunctionDesp*>>
+    > _fatbins;
+
+    // fatbins stored (or queued to be stored) by this cache
+    std::unordered_set<std::string> _stored_keys;
+
+    // keys of the files within the directory (prefixed by "text:" for the spilled sections), and the
+    // modification time of the directory when they're listed
+    std::unordered_set<std::string> _dir_keys;
+    uint64_t _dir_mtime_ns;
+
+    // decompressed sections kept in memory: key -> (content, position within the LRU list)
+    std::unordered_map<
+        std::string,
+        std::pair<std::shared_ptr<const std::vector<uint8_t>>, std::list<std::string>::iterator>
+    > _texts;
+    std::list<std::string> _text_lru;
+    uint64_t _text_size;
+    uint64_t _text_capacity;
+    bool _is_text_spill;
+
+    // fatbins and sections to be written by the writer thread, and the number of those being written
+    std::deque<std::pair<std::string, std::vector<POSCudaFunctionDesp*>>> _pending_stores;
+    std::deque<std::pair<std::string, std::shared_ptr<const std::vector<uint8_t>>>> _pending_texts;
+    uint64_t _nb_writing;
+
+    // writer thread, which is launched on the first store
+    std::thread *_writer;
+    bool _is_stopping;
+    std::condition_variable _cond;
+
+    enum metrics_counter_type_t : uint8_t {
+        __COUNTER_BASE__= 0,
+        LOOKUP_hit,
+        LOOKUP_hit_memory,
+        LOOKUP_miss,
+        STORE_done,
+        STORE_failed,
+        TEXT_hit,
+        TEXT_hit_spill,
+        TEXT_miss,
+        TEXT_evicted,
+        TEXT_spilled
+    };
+    POSMetrics_CounterList<metrics_counter_type_t> _metric_counters;
+
+    // mutex to protect the directory, the loaded / stored fatbins, the decompressed sections and the metrics
+    std::mutex _mutex;
+
+    /*!
+     *  \brief  processing routine of the writer thread
+     *  \param  placement   placement of the thread which launches the writer
+     */
+    void __writer_main(POSPlacement *placement);
+
+    /*!
+     *  \brief  list the keys of the files within the directory if it's modified since last listed
+     *  \note   should be called with the mutex held
+     */
+    void __list_dir();
+
+    /*!
+     *  \brief  launch the writer thread if it's not launched yet
+     *  \note   should be called with the mutex held
+     */
+    void __launch_writer();
+
+    /*!
+     *  \brief  write the decompressed content of a section to file, which is written to a temporary
+     *          file then renamed
+     *  \param  file_path   path to the file
+     *  \param  text        the decompressed content
+     *  \return POS_SUCCESS for successfully written
+     */
+    static pos_retval_t __dump_text(const std::string& file_path, const std::vector<uint8_t>& text);
+
+    /*!
+     *  \brief  path to the file of a fatbin
+     *  \note   the file is tagged by the version of the kernel parser, so that the files stored by other
+     *          versions (or toolchains) are treated as missed
+     */
+    std::string __path_of(const std::string& dir, const std::string& key);
+
+    /*!
+     *  \brief  suffix of the file of a fatbin, following its key
+     */
+    static const std::string& __kmeta_suffix();
+
+    /*!
+     *  \brief  path to the spilled file of a decompressed section
+     */
+    inline std::string __text_path_of(const std::string& dir, const std::string& key){
+        return dir + std::string("/") + key + std::string(".cubin");
+    }
+};
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+
+
+/*!
+ *  \brief  cache of the memory handles resolved from the pointer arguments of a kernel, keyed by the
+ *          decoded pointers, so that launches with the same pointers (e.g., steps of an inference loop)
+ *          could skip looking up the pointers one by one
+ *  \note   each entry is validated against the generation of the address map of the memory handle
+ *          manager, which is bumped on malloc / free
+ *  \note   entries are 2-way set-associative by the hash of the pointers; the cache starts small and grows
+ *          once it keeps evicting valid entries, as kernels launched with many different pointers
+ *          (e.g., the same GEMM kernel of every layer) would keep evicting each other
+ *  \note   the cache is bypassed (i.e., the caller looks up the pointers directly) while the address map keeps
+ *          changing between the launches of the kernel (e.g., a malloc in every layer), as no entry would
+ *          survive until its next use; it's re-armed once the kernel is launched for kArmingNbLaunches times
+ *          without the address map changed
+ *  \note   not thread-safe, the cache is expected to be used by the parser of the client
+ */
+template<class T_POSHandle>
+class POSUtil_CUDA_Kernel_Arg_Cache {
+ public:
+    POSUtil_CUDA_Kernel_Arg_Cache()
+        :   _nb_evictions(0), _tick(0), _key_hash(0), _last_generation(UINT64_MAX), _nb_stable_launches(0),
+            _metrics({ 0, 0, 0, 0 }) {}
+    ~POSUtil_CUDA_Kernel_Arg_Cache() = default;
+
+    // initial and maximum number of entries of each kernel, must be powers of 2
+    static constexpr uint64_t kMinNbEntries = 4;
+    static constexpr uint64_t kMaxNbEntries = 256;
+
+    // number of entries of each set
+    static constexpr uint64_t kNbWays = 2;
+
+    // grow once the evicted valid entries reach 1/kGrowthEvictionRatio of the entries
+    static constexpr uint64_t kGrowthEvictionRatio = 4;
+
+    // number of launches without the address map changed before the cache is re-armed
+    static constexpr uint64_t kArmingNbLaunches = 2;
+
+    /*!
+     *  \brief  counters of the cache, which are plain integers so that they're kept in all builds
+     */
+    typedef struct pos_kernel_arg_cache_metrics {
+        uint64_t nb_hits;
+        uint64_t nb_misses;
+
+        // launches that bypass the cache, which are neither hits nor misses
+        uint64_t nb_bypasses;
+
+        // misses on entries that are filled before the address map changed
+        uint64_t nb_invalidations;
+    } pos_kernel_arg_cache_metrics_t;
+
+    typedef struct pos_kernel_arg_cache_entry {
+        // generation of the address map when the entry is filled
+        uint64_t generation;
+
+        // hash of the pointers
+        uint64_t hash;
+
+        // tick of the last hit / fill, for choosing the victim within the set
+        uint64_t last_used;
+
+        // number of pointers
+        uint64_t nb_values;
+
+        /*!
+         *  \brief  pointers decoded from the arguments (i.e., the key), followed by the handle of each pointer
+         *          (nullptr for nullptr / unknown pointers) and the offset within the handle, kept in a single
+         *          buffer so that a hit only touches one allocation besides the entry
+         */
+        std::vector<uint64_t> buffer;
+
+        bool is_valid;
+
+        inline T_POSHandle** handles() { return reinterpret_cast<T_POSHandle**>(this->buffer.data() + this->nb_values); }
+        inline uint64_t* offsets() { return this->buffer.data() + 2 * this->nb_values; }
+        inline T_POSHandle* const* handles() const {
+            return reinterpret_cast<T_POSHandle* const*>(this->buffer.data() + this->nb_values);
+        }
+        inline const uint64_t* offsets() const { return this->buffer.data() + 2 * this->nb_values; }
+
+        pos_kernel_arg_cache_entry() : generation(0), hash(0), last_used(0), nb_values(0), is_valid(false) {}
+    } pos_kernel_arg_cache_entry_t;
+
+    /*!
+     *  \brief  prepare the key of the next lookup
+     *  \param  nb_values   number of pointers within the key
+     *  \return the key for the caller to fill the decoded pointers
+     */
+    inline void** prepare_key(uint64_t nb_values){
+        if(unlikely(this->_key.size() != nb_values)){
+            this->_key.resize(nb_values);
+        }
+        return this->_key.data();
+    }
+
+    /*!
+     *  \brief  account a launch of the kernel, and decide whether the launch uses the cache
+     *  \note   should be invoked once per launch, before preparing the key
+     *  \param  generation  current generation of the address map
+     *  \return true for using the cache, false for bypassing it
+     */
+    inline bool arm(uint64_t generation){
+        /*!
+         *  \note   generations only grow, so once the generation changed since the last launch, all entries are
+         *          stale; and no entry is filled at the current generation before the cache is re-armed, so
+         *          bypassing misses nothing
+         */
+        if(unlikely(generation != this->_last_generation)){
+            this->_last_generation = generation;
+            this->_nb_stable_launches = 0;
+        } else if(this->_nb_stable_launches < kArmingNbLaunches){
+            this->_nb_stable_launches += 1;
+        }
+        if(unlikely(this->_nb_stable_launches < kArmingNbLaunches)){
+            this->_metrics.nb_bypasses += 1;
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+     *  \brief  lookup the entry of the prepared key
+     *  \param  generation  current generation of the address map
+     *  \return pointer to the entry on hit, nullptr on miss
+     */
+    inline const pos_kernel_arg_cache_entry_t* lookup(uint64_t generation){
+        pos_kernel_arg_cache_entry_t *entry;
+        uint64_t i;
+
+        this->_key_hash = kHashSeed;
+        for(i=0; i<this->_key.size(); i++){
+            this->_key_hash = (this->_key_hash ^ (uint64_t)(this->_key[i])) * kHashMultiplier;
+            this->_key_hash ^= this->_key_hash >> 32;
+        }
+
+        if(unlikely(this->_entries.size() == 0)){
+            return nullptr;
+        }
+
+        entry = this->__set_of(this->_key_hash);
+        for(i=0; i<kNbWays; i++, entry++){
+            if(
+                !entry->is_valid || entry->hash != this->_key_hash || entry->nb_values != this->_key.size()
+                || (this->_key.size() > 0 && memcmp(entry->buffer.data(), this->_key.data(), this->_key.size() * sizeof(void*)) != 0)
+            ){
+                continue;
+            }
+            if(unlikely(entry->generation != generation)){
+                entry->is_valid = false;
+                this->_metrics.nb_invalidations += 1;
+                return nullptr;
+            }
+            entry->last_used = ++this->_tick;
+            this->_metrics.nb_hits += 1;
+            return entry;
+        }
+
+        return nullptr;
+    }
+
+    /*!
+     *  \brief  insert the prepared key after a missed lookup
+     *  \param  generation  current generation of the address map
+     *  \return pointer to the entry for the caller to fill the handles and offsets
+     */
+    inline pos_kernel_arg_cache_entry_t* insert(uint64_t generation){
+        pos_kernel_arg_cache_entry_t *entry;
+
+        this->_metrics.nb_misses += 1;
+
+        if(unlikely(this->_entries.size() == 0)){
+            this->_entries.resize(kMinNbEntries);
+        }
+
+        entry = this->__victim_of(this->_key_hash, generation);
+        if(entry->is_valid && entry->generation == generation){
+            this->_nb_evictions += 1;
+            if(unlikely(
+                this->_nb_evictions >= this->_entries.size() / kGrowthEvictionRatio
+                && this->_entries.size() < kMaxNbEntries
+            )){
+                this->__grow();
+                this->_nb_evictions = 0;
+                entry = this->__victim_of(this->_key_hash, generation);
+            }
+        }
+
+        entry->generation = generation;
+        entry->hash = this->_key_hash;
+        entry->last_used = ++this->_tick;
+        entry->nb_values = this->_key.size();
+        entry->buffer.resize(3 * entry->nb_values);
+        if(likely(entry->nb_values > 0)){
+            memcpy(entry->buffer.data(), this->_key.data(), entry->nb_values * sizeof(void*));
+        }
+        entry->is_valid = true;
+
+        return entry;
+    }
+
+    /*!
+     *  \brief  obtain the counters of the cache
+     *  \return the counters
+     */
+    inline const pos_kernel_arg_cache_metrics_t& get_metrics() const { return this->_metrics; }
+
+    /*!
+     *  \brief  drop all entries, should be called once the parameter directions of the kernel are changed
+     */
+    inline void clear(){
+        this->_entries.clear();
+        this->_entries.shrink_to_fit();
+        this->_nb_evictions = 0;
+    }
+
+ private:
+    static constexpr uint64_t kHashSeed = 0xcbf29ce484222325ull;
+    static constexpr uint64_t kHashMultiplier = 0x9e3779b97f4a7c15ull;
+
+    /*!
+     *  \brief  obtain the first entry of the set of the given hash
+     */
+    inline pos_kernel_arg_cache_entry_t* __set_of(uint64_t hash){
+        return &this->_entries[(hash & (this->_entries.size() / kNbWays - 1)) * kNbWays];
+    }
+
+    /*!
+     *  \brief  choose the entry to be filled within the set of the given hash
+     *  \note   prefer empty / stale entries, otherwise the least recently used one
+     */
+    inline pos_kernel_arg_cache_entry_t* __victim_of(uint64_t hash, uint64_t generation){
+        pos_kernel_arg_cache_entry_t *set, *victim;
+        uint64_t i;
+
+        set = victim = this->__set_of(hash);
+        for(i=0; i<kNbWays; i++){
+            if(!set[i].is_valid || set[i].generation != generation){
+                return &set[i];
+            }
+            if(set[i].last_used < victim->last_used){
+                victim = &set[i];
+            }
+        }
+
+        return victim;
+    }
+
+    /*!
+     *  \brief  double the entries, and move the valid entries to their new sets
+     */
+    inline void __grow(){
+        std::vector<pos_kernel_arg_cache_entry_t> old_entries;
+        pos_kernel_arg_cache_entry_t *entry;
+        uint64_t i;
+
+        old_entries.swap(this->_entries);
+        this->_entries.resize(old_entries.size() * 2);
+        for(pos_kernel_arg_cache_entry_t& old_entry : old_entries){
+            if(!old_entry.is_valid){ continue; }
+            entry = this->__set_of(old_entry.hash);
+            for(i=0; i<kNbWays; i++, entry++){
+                if(!entry->is_valid){
+                    *entry = std::move(old_entry);
+                    break;
+                }
+            }
+        }
+    }
+
+    // entries, allocated on the first insertion
+    std::vector<pos_kernel_arg_cache_entry_t> _entries;
+
+    // number of valid entries evicted since the last growth
+    uint64_t _nb_evictions;
+
+    // tick of the last hit / fill
+    uint64_t _tick;
+
+    // key of the ongoing lookup, and its hash
+    std::vector<void*> _key;
+    uint64_t _key_hash;
+
+    // generation of the address map at the last launch, and the number of launches since it changed
+    uint64_t _last_generation;
+    uint64_t _nb_stable_launches;
+
+    pos_kernel_arg_cache_metrics_t _metrics;
+};
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include <stdint.h>
+
+#include "pos/include/common.h"
+
+
+// defined in pos/cuda_impl/utils/fatbin.h
+struct POSCudaFunctionDesp;
+
+
+/*!
+ *  \brief  cache of kernel metadata dumped by previous runs, which is looked up by the mangled name
+ *          while loading modules, so that the kernels needn't to be parsed again
+ *  \note   the binary format is mmap-ed read-only and looked up in place, the function descriptor of a
+ *          kernel is only materialized when it's hit; the text format ('|'-delimited, one kernel per line)
+ *          is still supported for import / export
+ *  \note   binary layout (little-endian, each region is 8-byte aligned):
+ *              header | hash buckets | kernel records | uint32 pool | confirmed param pool | string table
+ *          the hash index is open-addressing with linear probing, and kept at most half full
+ *  \note   kernels not resolved yet (see POSCudaFunctionDesp::is_resolved) are stored with empty signature
+ *  \note   find is thread-safe, while load / import / clear should not run with others
+ */
+class POSUtil_CUDA_Kernel_Meta_Cache {
+ public:
+    POSUtil_CUDA_Kernel_Meta_Cache();
+    ~POSUtil_CUDA_Kernel_Meta_Cache();
+
+    // magic ("POSKMETA") and version of the binary format
+    static constexpr uint64_t kBinaryMagic = 0x4154454d4b534f50ull;
+    static constexpr uint32_t kBinaryVersion = 1;
+
+    /*!
+     *  \brief  load the cache from file, the format is detected by the magic
+     *  \param  file_path   path to the cache file
+     *  \param  binary_only whether to reject the file in text format
+     *  \return POS_SUCCESS for successfully loaded;
+     *          POS_FAILED_NOT_EXIST for no such file;
+     *          POS_FAILED_INVALID_INPUT for corrupted binary file
+     */
+    pos_retval_t load(const std::string& file_path, bool binary_only = false);
+
+    /*!
+     *  \brief  import kernel metadata from text file, the imported kernels are searched after the binary ones
+     *  \note   malformed lines are skipped
+     *  \param  file_path   path to the text file
+     *  \return POS_SUCCESS for successfully imported;
+     *          POS_FAILED_NOT_EXIST for no such file
+     */
+    pos_retval_t import_text(const std::string& file_path);
+
+    /*!
+     *  \brief  find the metadata of a kernel by its mangled name
+     *  \note   the returned descriptor is owned by the cache, and is the same for the same kernel
+     *  \param  name    mangled name of the kernel
+     *  \return pointer to the function descriptor, nullptr for not cached
+     */
+    POSCudaFunctionDesp* find(const char *name);
+
+    /*!
+     *  \brief  obtain (and materialize) the metadata of all cached kernels
+     *  \param  desps   the cached kernels, in the order of the binary file then the imported text
+     */
+    void collect(std::vector<POSCudaFunctionDesp*>& desps);
+
+    /*!
+     *  \brief  drop all cached kernels and unmap the binary file
+     *  \note   the descriptors returned by find are released
+     */
+    void clear();
+
+    /*!
+     *  \brief  number of cached kernels
+     */
+    inline uint64_t size() const { return this->_nb_binary_kernels + this->_text_desps.size(); }
+
+    /*!
+     *  \brief  dump kernel metadata to a binary file, the file is replaced atomically so that the
+     *          file mmap-ed by others is untouched, and concurrent dumps never expose a partial file
+     *  \param  file_path   path to the binary file
+     *  \param  desps       kernels to be dumped, the first one wins for kernels with the same name
+     *  \return POS_SUCCESS for successfully dumped
+     */
+    static pos_retval_t dump_binary(const std::string& file_path, const std::vector<POSCudaFunctionDesp*>& desps);
+
+    /*!
+     *  \brief  dump kernel metadata to a text file
+     *  \param  file_path   path to the text file
+     *  \param  desps       kernels to be dumped
+     *  \param  append      whether to append to the existing file
+     *  \return POS_SUCCESS for successfully dumped
+     */
+    static pos_retval_t dump_text(
+        const std::string& file_path, const std::vector<POSCudaFunctionDesp*>& desps, bool append
+    );
+
+    /*!
+     *  \brief  whether the kernel metadata should be dumped as text, according to the file extension
+     */
+    static inline bool is_text_path(const std::string& file_path){
+        return file_path.size() >= 4 && file_path.compare(file_path.size() - 4, 4, ".txt") == 0;
+    }
+
+ private:
+    typedef struct __attribute__((__packed__)) pos_kmeta_header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t file_size;
+        uint64_t nb_kernels;
+        uint64_t nb_buckets;
+        uint64_t buckets_offset;
+        uint64_t kernels_offset;
+        uint64_t u32_pool_offset;
+        uint64_t nb_u32s;
+        uint64_t confirmed_pool_offset;
+        uint64_t nb_confirmed;
+        uint64_t strtab_offset;
+        uint64_t strtab_size;
+        uint64_t reserved[3];
+    } pos_kmeta_header_t;
+
+    typedef struct __attribute__((__packed__)) pos_kmeta_bucket {
+        // higher 32 bits of the name hash, to skip most mismatched kernels without touching them
+        uint32_t hash_tag;
+        // index of the kernel plus one, 0 for empty bucket
+        uint32_t kernel_id;
+    } pos_kmeta_bucket_t;
+
+    typedef struct __attribute__((__packed__)) pos_kmeta_kernel {
+        uint64_t name_hash;
+        uint64_t cbank_param_size;
+
+        // strings within the string table (NUL-terminated)
+        uint32_t name_offset;
+        uint32_t name_len;
+        uint32_t signature_offset;
+        uint32_t signature_len;
+
+        // arrays within the uint32 pool, param sizes follow param offsets
+        uint32_t nb_params;
+        uint32_t params_id;
+        uint32_t input_pointer_params_id;
+        uint32_t nb_input_pointer_params;
+        uint32_t output_pointer_params_id;
+        uint32_t nb_output_pointer_params;
+        uint32_t inout_pointer_params_id;
+        uint32_t nb_inout_pointer_params;
+        uint32_t suspicious_params_id;
+        uint32_t nb_suspicious_params;
+
+        // array within the confirmed param pool
+        uint32_t confirmed_suspicious_params_id;
+        uint32_t nb_confirmed_suspicious_params;
+
+        uint32_t has_verified_params;
+        uint32_t reserved;
+    } pos_kmeta_kernel_t;
+
+    typedef struct __attribute__((__packed__)) pos_kmeta_confirmed_param {
+        uint32_t param_index;
+        uint32_t reserved;
+        uint64_t offset;
+    } pos_kmeta_confirmed_param_t;
+
+    /*!
+     *  \brief  hash of the mangled name (FNV-1a)
+     */
+    static inline uint64_t __hash(const char *name, uint64_t len){
+        uint64_t hash = 0xcbf29ce484222325ull, i;
+        for(i=0; i<len; i++){
+            hash ^= static_cast<uint8_t>(name[i]);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /*!
+     *  \brief  map the binary file and verify its layout
+     *  \param  fd          file descriptor of the binary file
+     *  \param  file_size   size of the binary file
+     *  \return POS_SUCCESS for successfully mapped
+     */
+    pos_retval_t __map_binary(int fd, uint64_t file_size);
+
+    /*!
+     *  \brief  materialize the function descriptor of a kernel within the binary file
+     *  \param  kernel_id   index of the kernel
+     *  \return the function descriptor, nullptr for corrupted record
+     */
+    POSCudaFunctionDesp* __materialize(uint64_t kernel_id);
+
+    // the mmap-ed binary file
+    void *_mapped;
+    uint64_t _mapped_size;
+
+    // regions within the binary file
+    const pos_kmeta_header_t *_header;
+    const pos_kmeta_bucket_t *_buckets;
+    const pos_kmeta_kernel_t *_kernels;
+    const uint32_t *_u32_pool;
+    const pos_kmeta_confirmed_param_t *_confirmed_pool;
+    const char *_strtab;
+    uint64_t _nb_binary_kernels;
+
+    // materialized descriptors of the kernels within the binary file
+    std::unique_ptr<std::atomic<POSCudaFunctionDesp*>[]> _materialized;
+
+    // kernels imported from text files
+    std::unordered_map<std::string, POSCudaFunctionDesp*> _text_desps;
+    std::vector<POSCudaFunctionDesp*> _text_desps_ordered;
+};
@@ -98,6 +98,29 @@ class POSWorker_CUDA : public POSWorker {
     pos_retval_t sync(uint64_t stream_id=0) override;
 
 
+    /*!
+     *  \brief  create a new CUDA stream
+     *  \param  stream_id   index of the created stream
+     *  \return POS_SUCCESS for successfully creation
+     */
+    pos_retval_t create_stream(uint64_t& stream_id) override;
+
+
+    /*!
+     *  \brief  destory a CUDA stream created by create_stream
+     *  \param  stream_id   index of the stream to be destoried
+     *  \return POS_SUCCESS for successfully destory
+     */
+    pos_retval_t destory_stream(uint64_t stream_id) override;
+
+
+    /*!
+     *  \brief  bind the calling thread to the CUDA context of this worker (i.e., device 0)
+     *  \return POS_SUCCESS for successfully binding
+     */
+    pos_retval_t bind_thread_context() override;
+
+
  protected:    
     /*!
      *  \brief      initialization of the worker daemon thread
@@ -31,6 +31,7 @@
 #include "pos/cuda_impl/worker.h"
 #include "pos/cuda_impl/handle.h"
 #include "pos/cuda_impl/api_context.h"
+#include "pos/cuda_impl/utils/fatbin_cache.h"
 
 
 class POSWorkspace_CUDA : public POSWorkspace {
@@ -69,6 +70,9 @@ class POSWorkspace_CUDA : public POSWorkspace {
     // one context per device
     std::vector<CUcontext> _cu_contexts;
 
+    // node-wide cache of the kernel metadata, shared by all clients
+    POSUtil_CUDA_Fatbin_Cache _fatbin_cache;
+
     /*!
      *  \brief  initialize the workspace
      *  \note   create device context inside this function, implementation on specific platform
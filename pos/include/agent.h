@@ -116,6 +116,13 @@ class POSAgent {
      */
     inline void set_uuid(pos_client_uuid_t id){ _uuid = id; }
 
+    /*!
+     *  \brief  obtain the uuid of the client
+     *  \note   the remoting framework piggybacks the uuid on each API call, so that
+     *          the daemon could route the call to this client
+     */
+    inline pos_client_uuid_t get_uuid() const { return _uuid; }
+
  private:
     // pointer to the out-of-band client
     POSOobClient *_pos_oob_client;
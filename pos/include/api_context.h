@@ -21,6 +21,9 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <atomic>
+#include <algorithm>
+#include <initializer_list>
 
 #include <string.h>
 #include <stdint.h>
@@ -30,10 +33,12 @@
 #include "pos/include/log.h"
 #include "pos/include/handle.h"
 #include "pos/include/utils/timer.h"
+#include "pos/include/utils/completion.h"
 
 
 // forward declaration
 class POSClient;
+class POSAPIContextPool;
 
 
 /*!
@@ -88,6 +93,97 @@ typedef struct POSAPIMeta {
 } POSAPIMeta_t;
 
 
+/*!
+ *  \brief  dense table indexed by api id, used to dispatch APIs on the critical path
+ *  \note   api ids of each platform are small integers (e.g., pos/cuda_impl/api_index.h), so
+ *          an array lookup replaces the tree walk of std::map; the table is filled once during
+ *          initialization and then only read, so it's safe to be read by multiple threads
+ *  \tparam T  type of the entry (e.g., parser / worker function, API metadata)
+ */
+template<typename T>
+class POSApiDispatchTable {
+ public:
+    POSApiDispatchTable() : _nb_entries(0) {}
+    ~POSApiDispatchTable() = default;
+
+    // upper bound of the api id, to avoid allocating huge table due to a wrong api id
+    static constexpr uint64_t kMaxApiId = 65535;
+
+    /*!
+     *  \brief  insert entries into the table
+     *  \note   inserting an api id that already exists is an error, as the registration lists
+     *          should be one-to-one mapping to the api ids
+     *  \param  entries    entries to be inserted, in the form of {api_id, entry}
+     */
+    void insert(std::initializer_list<std::pair<uint64_t, T>> entries){
+        uint64_t max_api_id = 0;
+
+        for(auto& entry : entries){ max_api_id = std::max(max_api_id, entry.first); }
+        POS_ASSERT(max_api_id <= kMaxApiId);
+        if(max_api_id >= this->_entries.size()){
+            this->_entries.resize(max_api_id + 1);
+            this->_is_set.resize(max_api_id + 1, 0);
+        }
+
+        for(auto& entry : entries){
+            if(unlikely(this->_is_set[entry.first] == 1)){
+                POS_ERROR_C_DETAIL("duplicated registration of api: api_id(%lu)", entry.first);
+            }
+            this->_entries[entry.first] = entry.second;
+            this->_is_set[entry.first] = 1;
+            this->_nb_entries += 1;
+        }
+    }
+
+    /*!
+     *  \brief  check whether the given api id is registered
+     *  \param  api_id  the api id to be checked
+     */
+    inline bool contains(uint64_t api_id) const {
+        return api_id < this->_is_set.size() && this->_is_set[api_id] == 1;
+    }
+
+    /*!
+     *  \brief  obtain the entry of the given api id
+     *  \note   the caller should make sure the api id is registered (see contains)
+     *  \param  api_id  the api id to be looked up
+     */
+    inline const T& operator[](uint64_t api_id) const {
+    #if POS_CONF_RUNTIME_EnableDebugCheck
+        POS_ASSERT(this->contains(api_id));
+    #endif
+        return this->_entries[api_id];
+    }
+
+    /*!
+     *  \brief  obtain the api ids of all registered entries, in ascending order
+     */
+    std::vector<uint64_t> get_api_ids() const {
+        uint64_t i;
+        std::vector<uint64_t> api_ids;
+        for(i=0; i<this->_is_set.size(); i++){
+            if(this->_is_set[i] == 1){ api_ids.push_back(i); }
+        }
+        return api_ids;
+    }
+
+    /*!
+     *  \brief  obtain the number of registered entries
+     */
+    inline uint64_t size() const { return this->_nb_entries; }
+
+ private:
+    // entries indexed by api id
+    std::vector<T> _entries;
+
+    // whether the entry at each index is registered
+    std::vector<uint8_t> _is_set;
+
+    // number of registered entries
+    uint64_t _nb_entries;
+};
+
+
 /*!
  *  \brief  execution type of POSAPIContext_QE
  */
@@ -118,8 +214,16 @@ class POSApiManager {
      */
     virtual int cast_pos_retval(pos_retval_t pos_retval, uint8_t library_id){ return -1; };
 
-    // map: api_id -> metadata of the api
-    std::map<uint64_t, POSAPIMeta_t> api_metas;
+    /*!
+     *  \brief  obtain the metadata of an API
+     *  \note   the caller should make sure the api is registered (see api_metas.contains)
+     *  \param  api_id  index of the API
+     *  \return metadata of the API
+     */
+    inline const POSAPIMeta_t& get_api_meta(uint64_t api_id) const { return this->api_metas[api_id]; }
+
+    // table: api_id -> metadata of the api
+    POSApiDispatchTable<POSAPIMeta_t> api_metas;
 
  protected:
 };
@@ -139,6 +243,12 @@ enum pos_api_execute_status_t : uint8_t {
 
 /*!
  *  \brief  descriptor of one parameter of an API call
+ *  \note   both the descriptor and the payload are located within the parameter
+ *          blob of the API context, see POSAPIContext::set_params
+ *  \note   so small parameters need no inline storage within the descriptor, their payloads
+ *          already follow the descriptors without extra allocations; large parameters (e.g., the
+ *          arguments of kernel launches) are copied into the blob as well rather than referenced,
+ *          as the WQE might be retained for recomputation after the call buffer is reused
  */
 typedef struct POSAPIParam {
     // payload of the parameter
@@ -151,18 +261,14 @@ typedef struct POSAPIParam {
      *  \brief  constructor
      *  \param  src_value   pointer to the actual value of the parameter
      *  \param  size        size of the parameter
+     *  \param  dst_area    area to store the payload of the parameter
      */
-    POSAPIParam(void *src_value, size_t size) : param_size(size) {
-        POS_CHECK_POINTER(param_value = malloc(size));
+    POSAPIParam(void *src_value, size_t size, void *dst_area) : param_value(dst_area), param_size(size) {
+        POS_CHECK_POINTER(param_value);
         memcpy(param_value, src_value, param_size);
     }
 
-    /*!
-     *  \brief  deconstructor
-     */
-    ~POSAPIParam(){
-        POS_CHECK_POINTER(param_value); free(param_value);
-    }
+    ~POSAPIParam() = default;
 } POSAPIParam_t;
 
 
@@ -196,6 +302,14 @@ typedef struct POSAPIContext {
     // parameter list of the called API
     std::vector<POSAPIParam_t*> params;
 
+    // contiguous area that stores descriptors and payloads of all parameters,
+    // reused across calls if the API context is recycled
+    uint8_t *param_blob;
+    uint64_t param_blob_capacity;
+
+    // minimum capacity of the parameter blob
+    static constexpr uint64_t kMinParamBlobCapacity = 512;
+
     // pointer to the area to store the return result
     void *ret_data;
     
@@ -226,9 +340,24 @@ typedef struct POSAPIContext {
     POSAPIContext(uint64_t api_id_, uint64_t retval_size);
 
 
+    /*!
+     *  \brief  constructor
+     *  \note   this constructor is for the pool, the context is setup once it's acquired
+     */
+    POSAPIContext();
+
+
     ~POSAPIContext(){
-        for(auto param : params){ POS_CHECK_POINTER(param); delete param; }
+        if(this->param_blob != nullptr){ free(this->param_blob); }
     }
+
+
+    /*!
+     *  \brief  copy all parameters into the parameter blob
+     *  \note   the blob is only reallocated if it's too small to contain all parameters
+     *  \param  param_desps     descriptors of all involved parameters
+     */
+    void set_params(std::vector<POSAPIParamDesp_t>& param_desps);
 } POSAPIContext_t;
 
 
@@ -305,6 +434,12 @@ typedef struct POSAPIContext_QE {
     // mark whether current WQE has returned to RPC thread
     bool has_return;
 
+    // mark whether the RPC thread is waiting for the completion of this WQE
+    bool is_sync;
+
+    // completion word of this WQE, signaled once it returns to the RPC thread (see POSUtilCompletion)
+    std::atomic<uint32_t> completion;
+
     // execution status of the API call
     pos_api_execute_status_t status;
 
@@ -323,6 +458,18 @@ typedef struct POSAPIContext_QE {
     uint64_t parser_s_tick, parser_e_tick, worker_s_tick, worker_e_tick;
     /* ======= end of profiling fields ======== */
 
+    /* =========== allocation fields =========== */
+    // pool that this WQE is allocated from, nullptr for WQEs not managed by a pool (e.g., restored from checkpoint)
+    POSAPIContextPool *pool;
+
+    // number of holders of this WQE (e.g., the RPC thread, the parser / worker, the ckpt dag),
+    // the WQE is recycled to the pool once all holders released it
+    std::atomic<uint32_t> nb_refs;
+
+    // next WQE within the free list of the pool
+    POSAPIContext_QE *next_free;
+    /* ======= end of allocation fields ======== */
+
 
     /*!
      *  \brief  constructor
@@ -351,12 +498,54 @@ typedef struct POSAPIContext_QE {
     POSAPIContext_QE(POSClient* client, const std::string& ckpt_file, pos_apicxt_typeid_t type);
 
 
+    /*!
+     *  \brief  constructor
+     *  \note   this constructor is for the pool, the WQE is setup by init once it's acquired
+     */
+    POSAPIContext_QE();
+
+
     /*!
      *  \brief  deconstructor
      */
     ~POSAPIContext_QE();
 
 
+    /*!
+     *  \brief  setup this WQE for a new API call
+     *  \note   the parameter blob and the handle view lists are reused if this WQE is recycled
+     *  \param  api_id          index of the called API
+     *  \param  uuid            uuid of the remote client
+     *  \param  param_desps     description of all parameters of the call
+     *  \param  inst_id         uuid of this API call instance within the client
+     *  \param  retval_data     pointer to the memory area that store the returned value
+     *  \param  retval_size     size of the return value
+     *  \param  pos_client      pointer to the POSClient instance
+     */
+    void init(
+        uint64_t api_id, pos_client_uuid_t uuid, std::vector<POSAPIParamDesp_t>& param_desps,
+        uint64_t inst_id, void* retval_data, uint64_t retval_size, POSClient* pos_client
+    );
+
+
+    /*!
+     *  \brief  add a holder of this WQE
+     *  \note   must be invoked by an existing holder before handing over this WQE (e.g., pushing
+     *          to a queue that retains it), so that the WQE isn't recycled in between
+     */
+    inline void retain(){
+        if(this->pool == nullptr){ return; }
+        this->nb_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+
+    /*!
+     *  \brief  remove a holder of this WQE, recycle it to the pool if no holder left
+     *  \note   the WQE shouldn't be accessed by the caller after release
+     */
+    inline void release();
+
+
     /*!
      *  \brief  persist the state of this APIcontext to specified directory
      *  \tparam with_params whether to persist with parameter information,
@@ -393,6 +582,100 @@ typedef struct POSAPIContext_QE {
 } POSAPIContext_QE_t;
 
 
+/*!
+ *  \brief  per-client pool of work queue elements
+ *  \note   WQEs are allocated in slabs and recycled once all holders released them, so that
+ *          the parameter blob and the handle view lists of a WQE are reused without touching
+ *          the heap on the critical path of each API call
+ *  \note   WQEs are only acquired by the RPC thread of the client, while they could be recycled
+ *          by any thread (e.g., parser, worker); recycled WQEs are gathered within a lock-free
+ *          stack, and reclaimed by the RPC thread in batch once its own free list is exhausted
+ */
+class POSAPIContextPool {
+ public:
+    /*!
+     *  \brief  constructor
+     *  \param  slab_size   number of WQEs to be allocated each time the pool is exhausted
+     */
+    POSAPIContextPool(uint64_t slab_size=kDefaultSlabSize);
+    ~POSAPIContextPool();
+
+    // default number of WQEs within each slab
+    static constexpr uint64_t kDefaultSlabSize = 256;
+
+
+    /*!
+     *  \brief  acquire a WQE from the pool and setup it for a new API call
+     *  \note   the returned WQE is held by the caller (i.e., nb_refs is 1)
+     *  \param  api_id          index of the called API
+     *  \param  uuid            uuid of the remote client
+     *  \param  param_desps     description of all parameters of the call
+     *  \param  inst_id         uuid of this API call instance within the client
+     *  \param  retval_data     pointer to the memory area that store the returned value
+     *  \param  retval_size     size of the return value
+     *  \param  pos_client      pointer to the POSClient instance
+     *  \return pointer to the acquired WQE
+     */
+    POSAPIContext_QE* acquire(
+        uint64_t api_id, pos_client_uuid_t uuid, std::vector<POSAPIParamDesp_t>& param_desps,
+        uint64_t inst_id, void* retval_data, uint64_t retval_size, POSClient* pos_client
+    );
+
+
+    /*!
+     *  \brief  return a WQE back to the pool
+     *  \note   this function could be invoked by any thread
+     *  \param  wqe the WQE to be recycled
+     */
+    inline void recycle(POSAPIContext_QE *wqe){
+        POSAPIContext_QE *head;
+
+        POS_CHECK_POINTER(wqe);
+        head = this->_recycled_list.load(std::memory_order_relaxed);
+        do {
+            wqe->next_free = head;
+        } while(!this->_recycled_list.compare_exchange_weak(
+            head, wqe, std::memory_order_release, std::memory_order_relaxed
+        ));
+    }
+
+
+    /*!
+     *  \brief  obtain the number of WQEs allocated by this pool
+     */
+    inline uint64_t get_nb_allocated() const { return this->_nb_allocated; }
+
+ private:
+    /*!
+     *  \brief  allocate a new slab of WQEs into the free list
+     */
+    void __grow();
+
+    // number of WQEs within each slab
+    uint64_t _slab_size;
+
+    // all allocated slabs
+    std::vector<POSAPIContext_QE*> _slabs;
+
+    // number of WQEs allocated by this pool
+    uint64_t _nb_allocated;
+
+    // free list, only accessed by the RPC thread
+    POSAPIContext_QE *_free_list;
+
+    // recycled WQEs from all threads
+    std::atomic<POSAPIContext_QE*> _recycled_list;
+};
+
+
+inline void POSAPIContext_QE::release(){
+    if(this->pool == nullptr){ return; }
+    if(this->nb_refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+        this->pool->recycle(this);
+    }
+}
+
+
 #define pos_api_output_handle_view(qe_ptr, index)           \
     (qe_ptr->output_handle_views[index])
 
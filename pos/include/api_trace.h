@@ -0,0 +1,410 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/placement.h"
+
+
+/*!
+ *  \brief  record of a traced API call, followed by its handles (pos_api_trace_handle_t)
+ *  \note   the parameters are not recorded, so that tracing is cheap enough to be left on
+ */
+typedef struct __attribute__((__packed__)) pos_api_trace_record {
+    // size of the record including its handles (bytes, 8-byte aligned)
+    uint32_t size;
+
+    // index of the API, POSApiTraceRing::kPaddingApiId for the padding at the end of the ring
+    uint32_t api_id;
+
+    // id of the API context
+    uint64_t apicxt_id;
+
+    // ticks when the API is received by the daemon, and when it's parsed
+    uint64_t create_tick;
+    uint64_t parser_s_tick;
+    uint64_t parser_e_tick;
+
+    // number of handles followed
+    uint16_t nb_handles;
+
+    // whether the API is a sync call, and its execution status after parsed (pos_api_execute_status_t)
+    uint8_t is_sync;
+    uint8_t status;
+
+    uint32_t reserved;
+} pos_api_trace_record_t;
+
+
+/*!
+ *  \brief  handle touched by a traced API call
+ */
+typedef struct __attribute__((__packed__)) pos_api_trace_handle {
+    // direction of the handle (pos_edge_direction_t)
+    uint8_t direction;
+    uint8_t reserved;
+
+    // index of the corresponding parameter
+    uint16_t param_index;
+
+    pos_resource_typeid_t resource_type_id;
+    pos_u64id_t handle_id;
+
+    // offset from the base address of the handle
+    uint64_t offset;
+} pos_api_trace_handle_t;
+
+POS_STATIC_ASSERT(sizeof(pos_api_trace_record_t) % 8 == 0);
+POS_STATIC_ASSERT(sizeof(pos_api_trace_handle_t) % 8 == 0);
+
+
+/*!
+ *  \brief  header of the trace file
+ */
+typedef struct __attribute__((__packed__)) pos_api_trace_file_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+
+    // frequency of the ticks within the records (ticks per second)
+    double tsc_freq;
+
+    // tick when the trace file is created
+    uint64_t start_tick;
+
+    uint64_t reserved[3];
+} pos_api_trace_file_header_t;
+
+
+/*!
+ *  \brief  header of a chunk within the trace file, followed by the records flushed from a ring at once
+ */
+typedef struct __attribute__((__packed__)) pos_api_trace_chunk_header {
+    uint32_t magic;
+    uint32_t header_size;
+    pos_client_uuid_t client_id;
+    uint64_t pid;
+
+    // size of the records followed (bytes)
+    uint64_t payload_size;
+
+    // number of records dropped by the ring since the previous chunk
+    uint64_t nb_dropped;
+} pos_api_trace_chunk_header_t;
+
+
+/*!
+ *  \brief  ring of the API trace records of a client
+ *  \note   single producer (the parser of the client) and single consumer (POSApiTraceWriter), the
+ *          producer never blocks: records are dropped (and counted) once the ring is full
+ *  \note   a record never wraps around the end of the ring, the space left at the end is filled
+ *          with a padding record instead, which is skipped by the reader
+ */
+class POSApiTraceRing {
+ public:
+    /*!
+     *  \brief  constructor
+     *  \param  client_id   id of the traced client
+     *  \param  pid         pid of the traced client
+     *  \param  capacity    capacity of the ring (bytes), rounded up to power of 2
+     */
+    POSApiTraceRing(pos_client_uuid_t client_id, uint64_t pid, uint64_t capacity = kDefaultCapacity);
+    ~POSApiTraceRing();
+
+    // default capacity of the ring (bytes)
+    static constexpr uint64_t kDefaultCapacity = 8ull << 20;
+
+    // API index of the padding record
+    static constexpr uint32_t kPaddingApiId = UINT32_MAX;
+
+    /*!
+     *  \brief  reserve a record within the ring, invoked by the producer
+     *  \note   the record should be committed before reserving the next one
+     *  \param  nb_handles  number of handles of the record
+     *  \return pointer to the record (with size and nb_handles filled), nullptr for the ring is full
+     */
+    inline pos_api_trace_record_t* reserve(uint16_t nb_handles){
+        pos_api_trace_record_t *record = nullptr, *padding;
+        uint64_t size, pos, nb_contiguous, nb_required;
+
+        size = sizeof(pos_api_trace_record_t) + nb_handles * sizeof(pos_api_trace_handle_t);
+        pos = this->_produce_head & (this->_capacity - 1);
+        nb_contiguous = this->_capacity - pos;
+        nb_required = nb_contiguous < size ? nb_contiguous + size : size;
+
+        // only touch the tail owned by the consumer if the cached one isn't enough
+        if(unlikely(this->_produce_head + nb_required - this->_cached_tail > this->_capacity)){
+            this->_cached_tail = this->_tail.load(std::memory_order_acquire);
+            if(unlikely(this->_produce_head + nb_required - this->_cached_tail > this->_capacity)){
+                this->_nb_dropped.fetch_add(1, std::memory_order_relaxed);
+                goto exit;
+            }
+        }
+
+        if(unlikely(nb_contiguous < size)){
+            padding = reinterpret_cast<pos_api_trace_record_t*>(this->_buffer + pos);
+            padding->size = nb_contiguous;
+            padding->api_id = kPaddingApiId;
+            this->_produce_head += nb_contiguous;
+            pos = 0;
+        }
+
+        record = reinterpret_cast<pos_api_trace_record_t*>(this->_buffer + pos);
+        record->size = size;
+        record->nb_handles = nb_handles;
+        this->_produce_head += size;
+
+    exit:
+        return record;
+    }
+
+    /*!
+     *  \brief  publish the reserved record to the consumer
+     */
+    inline void commit(){
+        this->_head.store(this->_produce_head, std::memory_order_release);
+    }
+
+    /*!
+     *  \brief  obtain the handles of a record
+     */
+    static inline pos_api_trace_handle_t* handles_of(pos_api_trace_record_t* record){
+        return reinterpret_cast<pos_api_trace_handle_t*>(record + 1);
+    }
+
+    // id and pid of the traced client
+    pos_client_uuid_t client_id;
+    uint64_t pid;
+
+ private:
+    friend class POSApiTraceWriter;
+
+    // buffer of the ring
+    uint8_t *_buffer;
+    uint64_t _capacity;
+
+    // head published to the consumer, head of the producer (including the reserved record),
+    // and the tail observed by the producer
+    alignas(64) std::atomic<uint64_t> _head;
+    uint64_t _produce_head;
+    uint64_t _cached_tail;
+
+    // tail released by the consumer
+    alignas(64) std::atomic<uint64_t> _tail;
+
+    // number of records dropped as the ring is full
+    std::atomic<uint64_t> _nb_dropped;
+};
+
+
+/*!
+ *  \brief  background writer that flushes the trace rings of all clients into a single file
+ *  \note   rings are flushed periodically, each flush of a ring is written as a chunk
+ */
+class POSApiTraceWriter {
+ public:
+    /*!
+     *  \brief  constructor
+     *  \param  placement   placement of the writer thread, nullptr for not placing
+     */
+    POSApiTraceWriter(POSPlacement *placement = nullptr);
+    ~POSApiTraceWriter();
+
+    // magic ("POSATRAC") and version of the trace file
+    static constexpr uint64_t kFileMagic = 0x43415254415f534full;
+    static constexpr uint32_t kFileVersion = 1;
+
+    // magic of each chunk ("CHNK")
+    static constexpr uint32_t kChunkMagic = 0x4b4e4843;
+
+    // interval to flush the rings (ms)
+    static constexpr uint64_t kFlushIntervalMs = 50;
+
+    /*!
+     *  \brief  create the trace file and start the writer thread
+     *  \param  file_path   path to the trace file, which is truncated if exists
+     *  \param  tsc_freq    frequency of the ticks within the records (ticks per second)
+     *  \return POS_SUCCESS for successfully started;
+     *          POS_FAILED for failed to create the file
+     */
+    pos_retval_t init(const std::string& file_path, double tsc_freq);
+
+    /*!
+     *  \brief  flush all rings and stop the writer thread
+     */
+    void deinit();
+
+    /*!
+     *  \brief  add a ring to be flushed
+     *  \param  ring    the ring to be added
+     */
+    void add(POSApiTraceRing *ring);
+
+    /*!
+     *  \brief  flush the remaining records of a ring, and stop flushing it
+     *  \note   once returned, the ring could be released
+     *  \param  ring    the ring to be removed
+     */
+    void remove(POSApiTraceRing *ring);
+
+    /*!
+     *  \brief  path to the trace file
+     */
+    inline const std::string& get_file_path() const { return this->_file_path; }
+
+ private:
+    /*!
+     *  \brief  processing routine of the writer thread
+     */
+    void __flush_main();
+
+    /*!
+     *  \brief  write the published records of a ring to the file as a chunk
+     *  \note   should be invoked with the mutex held
+     *  \param  ring    the ring to be flushed
+     *  \return POS_SUCCESS for successfully flushed
+     */
+    pos_retval_t __flush(POSApiTraceRing *ring);
+
+    // the trace file
+    std::string _file_path;
+    FILE *_file;
+
+    // rings to be flushed
+    std::vector<POSApiTraceRing*> _rings;
+
+    // number of bytes written to the file, and number of records dropped by the rings
+    uint64_t _nb_bytes;
+    uint64_t _nb_dropped;
+
+    // writer thread
+    std::thread *_thread;
+    POSPlacement *_placement;
+    bool _stop_flag;
+    std::condition_variable _cond;
+
+    // mutex to protect the rings and the file
+    std::mutex _mutex;
+};
+
+
+/*!
+ *  \brief  statistics of a trace file
+ */
+typedef struct pos_api_trace_summary {
+    // frequency of the ticks (ticks per second)
+    double tsc_freq;
+
+    // number of records, and records dropped while tracing
+    uint64_t nb_records;
+    uint64_t nb_dropped;
+
+    // range of the ticks when the APIs are received
+    uint64_t first_tick;
+    uint64_t last_tick;
+
+    // statistics of each API: api_id -> (number of calls, ticks spent on parsing, number of handles)
+    typedef struct api_stat {
+        uint64_t nb_calls;
+        uint64_t parse_ticks;
+        uint64_t nb_handles;
+        api_stat() : nb_calls(0), parse_ticks(0), nb_handles(0) {}
+    } api_stat_t;
+    std::map<uint32_t, api_stat_t> apis;
+
+    // number of touches of each handle, in each direction (indexed by pos_edge_direction_t)
+    // (client_id, resource_type_id, handle_id) -> touches
+    typedef struct handle_stat {
+        uint64_t nb_touches[kPOS_Edge_Direction_Delete + 1];
+        handle_stat() : nb_touches{0} {}
+    } handle_stat_t;
+    std::map<std::tuple<pos_client_uuid_t, pos_resource_typeid_t, pos_u64id_t>, handle_stat_t> handles;
+
+    pos_api_trace_summary() : tsc_freq(0), nb_records(0), nb_dropped(0), first_tick(UINT64_MAX), last_tick(0) {}
+} pos_api_trace_summary_t;
+
+
+/*!
+ *  \brief  reader of the trace file written by POSApiTraceWriter
+ */
+class POSApiTraceReader {
+ public:
+    POSApiTraceReader() : _file(nullptr), _tsc_freq(0), _start_tick(0), _data_offset(0) {}
+    ~POSApiTraceReader();
+
+    /*!
+     *  \brief  function to visit each record
+     *  \param  chunk   header of the chunk that contains the record
+     *  \param  record  the record
+     *  \param  handles handles of the record
+     */
+    using visit_func_t = std::function<void(
+        const pos_api_trace_chunk_header_t& chunk,
+        const pos_api_trace_record_t& record,
+        const pos_api_trace_handle_t* handles
+    )>;
+
+    /*!
+     *  \brief  open the trace file
+     *  \param  file_path   path to the trace file
+     *  \return POS_SUCCESS for successfully opened;
+     *          POS_FAILED_NOT_EXIST for no such file;
+     *          POS_FAILED_INVALID_INPUT for not a trace file
+     */
+    pos_retval_t open(const std::string& file_path);
+
+    /*!
+     *  \brief  visit all records within the trace file, in the order of being flushed
+     *  \param  func            function to visit each record
+     *  \param  nb_dropped      number of records dropped while tracing
+     *  \return POS_SUCCESS for successfully visited;
+     *          POS_FAILED_INVALID_INPUT for corrupted trace file (records before are still visited)
+     */
+    pos_retval_t for_each(visit_func_t&& func, uint64_t& nb_dropped);
+
+    /*!
+     *  \brief  summarize the trace file
+     *  \param  summary the summary
+     *  \return POS_SUCCESS for successfully summarized
+     */
+    pos_retval_t summarize(pos_api_trace_summary_t& summary);
+
+    inline double get_tsc_freq() const { return this->_tsc_freq; }
+    inline uint64_t get_start_tick() const { return this->_start_tick; }
+
+ private:
+    FILE *_file;
+    double _tsc_freq;
+    uint64_t _start_tick;
+
+    // offset of the first chunk within the file
+    uint64_t _data_offset;
+};
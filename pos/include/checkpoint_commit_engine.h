@@ -0,0 +1,387 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/timer.h"
+#include "pos/include/utils/wait_event.h"
+
+
+class POSPlacement;
+
+/*!
+ *  \brief  a single commit job to be executed by the commit engine
+ */
+typedef struct pos_ckpt_commit_job {
+    // opaque context of this job for the backend (e.g., the handle to be committed)
+    void *cxt;
+
+    // version of the state to be committed
+    uint64_t version_id;
+
+    // source / destination of the commit, used by backends that copy raw memory
+    void *src;
+    void *dst;
+
+    // size of the state to be committed
+    uint64_t size;
+
+    // index of the lane this job dispatched to
+    uint32_t lane_id;
+
+    // result of the commit
+    pos_retval_t retval;
+
+    pos_ckpt_commit_job()
+        : cxt(nullptr), version_id(0), src(nullptr), dst(nullptr), size(0), lane_id(0), retval(POS_SUCCESS) {}
+} pos_ckpt_commit_job_t;
+
+
+/*!
+ *  \brief  a lane of the commit engine, each lane commits its jobs in order on its own stream
+ */
+typedef struct pos_ckpt_commit_lane {
+    // index of the lane
+    uint32_t id;
+
+    // stream of this lane, created by the backend
+    uint64_t stream_id;
+
+    // staging buffer of this lane, created by the backend (could be null if the backend doesn't need it)
+    void *staging_buf;
+    uint64_t staging_size;
+
+    // jobs dispatched to this lane in current round
+    std::vector<pos_ckpt_commit_job_t*> jobs;
+
+    // bytes dispatched to / committed by this lane in current round
+    uint64_t assigned_bytes;
+    uint64_t committed_bytes;
+
+    // number of committed jobs in current round
+    uint64_t nb_commits;
+
+    // number of times this lane stopped due to memory bus contention in current round
+    uint64_t nb_stops;
+
+    // ticks spent on committing / stalling in current round
+    uint64_t commit_ticks;
+    uint64_t stall_ticks;
+
+    // result of this lane in current round
+    pos_retval_t retval;
+
+    // thread that runs this lane, nullptr for running on the thread that calls the engine (i.e., lane 0)
+    std::thread *thread;
+
+    /*!
+     *  \brief  reset the per-round state of this lane
+     */
+    inline void reset(){
+        this->jobs.clear();
+        this->assigned_bytes = 0;
+        this->committed_bytes = 0;
+        this->nb_commits = 0;
+        this->nb_stops = 0;
+        this->commit_ticks = 0;
+        this->stall_ticks = 0;
+        this->retval = POS_SUCCESS;
+    }
+
+    pos_ckpt_commit_lane()
+        : id(0), stream_id(0), staging_buf(nullptr), staging_size(0), assigned_bytes(0), committed_bytes(0),
+          nb_commits(0), nb_stops(0), commit_ticks(0), stall_ticks(0), retval(POS_SUCCESS), thread(nullptr) {}
+} pos_ckpt_commit_lane_t;
+
+
+/*!
+ *  \brief  backend of the commit engine, which executes the actual data movement on each lane
+ *  \note   the lane logic of the engine is backend-agnostic, each platform (e.g., CUDA) should
+ *          provide its own backend
+ */
+class POSCheckpointCommitBackend {
+ public:
+    POSCheckpointCommitBackend() = default;
+    virtual ~POSCheckpointCommitBackend() = default;
+
+    /*!
+     *  \brief  create the stream and staging buffer of a lane
+     *  \param  lane    the lane to be initialized
+     *  \return POS_SUCCESS for successfully initialization
+     */
+    virtual pos_retval_t init_lane(pos_ckpt_commit_lane_t& lane) = 0;
+
+    /*!
+     *  \brief  destory the stream and staging buffer of a lane
+     *  \param  lane    the lane to be deinitialized
+     *  \return POS_SUCCESS for successfully deinitialization
+     */
+    virtual pos_retval_t deinit_lane(pos_ckpt_commit_lane_t& lane) = 0;
+
+    /*!
+     *  \brief  initialization within the thread that runs the lane
+     *  \example    for CUDA, one need to call cudaSetDevice first to setup the context for a thread
+     *  \param  lane    the lane that the thread runs
+     *  \return POS_SUCCESS for successfully initialization
+     */
+    virtual pos_retval_t init_lane_thread(pos_ckpt_commit_lane_t& lane){ return POS_SUCCESS; }
+
+    /*!
+     *  \brief  commit a job on the given lane
+     *  \note   the commit could be async on the stream of the lane, it's finished after sync_lane
+     *  \param  lane    the lane to commit the job
+     *  \param  job     the job to be committed
+     *  \return POS_SUCCESS for successfully committed
+     */
+    virtual pos_retval_t commit(pos_ckpt_commit_lane_t& lane, pos_ckpt_commit_job_t& job) = 0;
+
+    /*!
+     *  \brief  wait until all commits on the given lane are finished
+     *  \param  lane    the lane to be synced
+     *  \return POS_SUCCESS for successfully synced
+     */
+    virtual pos_retval_t sync_lane(pos_ckpt_commit_lane_t& lane) = 0;
+
+    /*!
+     *  \brief  whether the memory bus is currently used by the application, in which case
+     *          all lanes should be stopped
+     */
+    virtual bool is_bus_contended(){ return false; }
+
+    /*!
+     *  \brief  obtain the event which is notified once the memory bus is released
+     *  \return the event, nullptr for the lanes to poll is_bus_contended instead
+     */
+    virtual POSUtilWaitEvent* get_bus_event(){ return nullptr; }
+
+    /*!
+     *  \brief  whether the commit round should be cancelled (e.g., the worker is shutting down)
+     */
+    virtual bool is_cancelled(){ return false; }
+};
+
+
+/*!
+ *  \brief  commit backend with host-side memcpy, each commit is staged through the
+ *          staging buffer of the lane
+ *  \note   this backend is used for testing the lane logic of the commit engine
+ */
+class POSCheckpointCommitBackend_HostMemcpy : public POSCheckpointCommitBackend {
+ public:
+    POSCheckpointCommitBackend_HostMemcpy() : bus_lock(false), cancel_flag(false), _next_stream_id(1) {}
+    ~POSCheckpointCommitBackend_HostMemcpy() = default;
+
+    // flag to emulate memory bus contention, and the event notified once it's released
+    std::atomic<bool> bus_lock;
+    POSUtilWaitEvent bus_event;
+
+    // flag to emulate cancellation
+    std::atomic<bool> cancel_flag;
+
+    pos_retval_t init_lane(pos_ckpt_commit_lane_t& lane) override {
+        pos_retval_t retval = POS_SUCCESS;
+        POS_ASSERT(lane.staging_size > 0);
+        if(unlikely(nullptr == (lane.staging_buf = malloc(lane.staging_size)))){
+            retval = POS_FAILED_OOM;
+        }
+        lane.stream_id = this->_next_stream_id++;
+        return retval;
+    }
+
+    pos_retval_t deinit_lane(pos_ckpt_commit_lane_t& lane) override {
+        if(lane.staging_buf != nullptr){
+            free(lane.staging_buf);
+            lane.staging_buf = nullptr;
+        }
+        lane.stream_id = 0;
+        return POS_SUCCESS;
+    }
+
+    pos_retval_t commit(pos_ckpt_commit_lane_t& lane, pos_ckpt_commit_job_t& job) override {
+        uint64_t offset, chunk_size;
+
+        POS_CHECK_POINTER(lane.staging_buf);
+        if(unlikely(job.size > 0 && (job.src == nullptr || job.dst == nullptr))){
+            return POS_FAILED_INVALID_INPUT;
+        }
+
+        for(offset=0; offset<job.size; offset+=chunk_size){
+            chunk_size = std::min(lane.staging_size, job.size - offset);
+            memcpy(lane.staging_buf, (uint8_t*)(job.src) + offset, chunk_size);
+            memcpy((uint8_t*)(job.dst) + offset, lane.staging_buf, chunk_size);
+        }
+
+        return POS_SUCCESS;
+    }
+
+    pos_retval_t sync_lane(pos_ckpt_commit_lane_t& lane) override { return POS_SUCCESS; }
+
+    bool is_bus_contended() override { return this->bus_lock; }
+
+    POSUtilWaitEvent* get_bus_event() override { return &this->bus_event; }
+
+    /*!
+     *  \brief  release the emulated memory bus, and wake up the stopped lanes
+     */
+    inline void release_bus(){
+        this->bus_lock = false;
+        this->bus_event.notify();
+    }
+
+    bool is_cancelled() override { return this->cancel_flag; }
+
+ private:
+    uint64_t _next_stream_id;
+};
+
+
+/*!
+ *  \brief  N-lane commit engine, which balances the commit jobs across lanes by bytes and
+ *          commits them concurrently, each lane owns its own stream and staging buffer
+ *  \note   lane 0 runs on the thread that calls the engine, the other lanes run on their own
+ *          threads, which live as long as the lanes and park between rounds
+ */
+class POSCheckpointCommitEngine {
+ public:
+    /*!
+     *  \brief  constructor
+     *  \param  backend         backend to execute the commits
+     *  \param  nb_lanes        number of lanes
+     *  \param  staging_size    size of the staging buffer of each lane
+     */
+    POSCheckpointCommitEngine(
+        POSCheckpointCommitBackend *backend, uint32_t nb_lanes, uint64_t staging_size=kDefaultStagingSize
+    );
+    ~POSCheckpointCommitEngine();
+
+    // default / maximum number of lanes
+    static constexpr uint32_t kDefaultNbLanes = 2;
+    static constexpr uint32_t kMaxNbLanes = 8;
+
+    // default size of the staging buffer of each lane
+    static constexpr uint64_t kDefaultStagingSize = 4 << 20;
+
+    // lanes of this engine
+    std::vector<pos_ckpt_commit_lane_t> lanes;
+
+
+    /*!
+     *  \brief  create all lanes via the backend, and raise the threads of lanes
+     *  \note   lane threads are placed as the thread that invokes this function
+     *  \return POS_SUCCESS for successfully initialization
+     */
+    pos_retval_t init();
+
+
+    /*!
+     *  \brief  stop the threads of lanes, and destory all lanes via the backend
+     */
+    void deinit();
+
+
+    /*!
+     *  \brief  dispatch jobs to lanes, balancing the bytes across lanes
+     *  \note   jobs are dispatched in the given order (e.g., decided by the checkpoint scheduler)
+     *          to the lane with the fewest assigned bytes, so that each lane also commits in that order
+     *  \param  jobs    jobs to be dispatched
+     */
+    void dispatch(std::vector<pos_ckpt_commit_job_t>& jobs);
+
+
+    /*!
+     *  \brief  dispatch and commit jobs on all lanes, return after all lanes are synced
+     *  \note   all lanes stop once the memory bus is contended, and resume once it's released;
+     *          once cancelled, the jobs that not yet committed are marked as POS_FAILED_DRAIN
+     *  \param  jobs    jobs to be committed, the result of each job is stored in its retval
+     *  \return POS_SUCCESS for all jobs are successfully committed
+     */
+    pos_retval_t run(std::vector<pos_ckpt_commit_job_t>& jobs);
+
+
+    /*!
+     *  \brief  obtain the number of lanes
+     */
+    inline uint32_t get_nb_lanes() const { return this->_nb_lanes; }
+
+ private:
+    /*!
+     *  \brief  commit all jobs dispatched to a lane
+     *  \param  lane    the lane to be processed
+     */
+    void __run_lane(pos_ckpt_commit_lane_t& lane);
+
+    /*!
+     *  \brief  mark all jobs dispatched to a lane as failed
+     *  \param  lane    the failed lane
+     *  \param  retval  the reason of the failure
+     */
+    void __fail_lane(pos_ckpt_commit_lane_t& lane, pos_retval_t retval);
+
+    /*!
+     *  \brief  thread function of lanes except lane 0, which runs the lane once a new round
+     *          is raised, until the engine is deinitialized
+     *  \param  lane        the lane to be run
+     *  \param  round       index of the round when the thread is raised
+     *  \param  placement   placement of the thread, could be nullptr
+     */
+    void __lane_thread(pos_ckpt_commit_lane_t& lane, uint64_t round, POSPlacement *placement);
+
+    /*!
+     *  \brief  stop the lane while the memory bus is contended
+     *  \param  lane    the lane to be stopped
+     *  \return POS_SUCCESS for bus released; POS_FAILED_DRAIN for cancelled
+     */
+    pos_retval_t __wait_bus(pos_ckpt_commit_lane_t& lane);
+
+    // backend to execute the commits
+    POSCheckpointCommitBackend *_backend;
+
+    // number of lanes
+    uint32_t _nb_lanes;
+
+    // size of the staging buffer of each lane
+    uint64_t _staging_size;
+
+    // whether the lanes are created
+    bool _is_init;
+
+    // maximum duration (us) of a single park of idle lane threads, they're notified on new rounds
+    static constexpr uint64_t kLaneParkTimeoutUs = 100000;
+
+    // index of current round, lane threads run once it's increased
+    std::atomic<uint64_t> _round;
+
+    // number of lane threads that haven't finished current round
+    std::atomic<uint32_t> _nb_running_lanes;
+
+    // flag to stop the lane threads
+    std::atomic<bool> _stop_lanes;
+
+    // events to raise the lane threads on new rounds, and to wake the caller once they're done
+    POSUtilWaitEvent _round_event;
+    POSUtilWaitEvent _done_event;
+};
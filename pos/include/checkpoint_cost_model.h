@@ -0,0 +1,425 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/timer.h"
+
+
+/*!
+ *  \brief  decision on how to preserve the state of a handle that is modified
+ *          during concurrent checkpoint
+ */
+enum pos_ckpt_decision_t : uint8_t {
+    /*!
+     *  \brief  copy-on-write the checkpointed version before the first write,
+     *          so that the handle doesn't need to be dirty-copied
+     */
+    kPOS_CkptDecision_CoW = 0,
+
+    /*!
+     *  \brief  don't preserve the checkpointed version, the latest state is
+     *          committed by the bottom-half (i.e., dirty copy) while the client
+     *          is stopped
+     */
+    kPOS_CkptDecision_WaitCommit,
+
+    /*!
+     *  \brief  don't commit the latest state, it would be recomputed by replaying
+     *          the APIs executed during concurrent checkpoint while restoring
+     *  \note   only available for the whole round, and only if all modified
+     *          handles have their checkpointed version preserved
+     */
+    kPOS_CkptDecision_Recompute
+};
+
+
+/*!
+ *  \brief  a single decision made by the cost model, along with all its inputs,
+ *          which could be dumped for offline tuning
+ */
+typedef struct pos_ckpt_cost_record {
+    // epoch of the checkpoint round this decision is made in
+    uint64_t epoch;
+
+    // whether this record is for a single handle or for the whole round
+    bool is_round;
+
+    // [handle-level] handle to be decided
+    pos_u64id_t handle_id;
+    pos_resource_typeid_t resource_type_id;
+
+    // [handle-level] size of the state / [round-level] size of all dirty states (bytes)
+    uint64_t state_size;
+
+    // [handle-level] write frequency of the handle (#writes per round)
+    double write_freq;
+
+    // [round-level] number of APIs recorded for recomputation / modified handles that aren't preserved
+    uint64_t nb_recompute_apis;
+    uint64_t nb_unpreserved_handles;
+
+    // bandwidths and per-API recomputation cost that the decision is based on
+    double cow_bw;
+    double commit_bw;
+    double recompute_us_per_api;
+
+    // estimated costs of each choice (us)
+    double cow_cost;
+    double wait_commit_cost;
+    double recompute_cost;
+
+    // output decision
+    pos_ckpt_decision_t decision;
+} pos_ckpt_cost_record_t;
+
+
+/*!
+ *  \brief  cost model to decide among CoW, wait-for-commit and recompute-on-restore
+ *          for handles modified during concurrent checkpoint
+ *  \note   the model is fed with measured CoW / commit bandwidth, the recomputation
+ *          cost of recorded APIs and per-handle write frequency; all costs are
+ *          estimated in microseconds
+ *  \note   the measurements could be fed by both the worker and the checkpoint thread,
+ *          while decisions (and their records) are only made by the worker thread
+ */
+class POSCheckpointCostModel {
+ public:
+    POSCheckpointCostModel()
+        :   cow_bw(kDefaultCoWBandwidth),
+            commit_bw(kDefaultCommitBandwidth),
+            recompute_us_per_api(0),
+            cow_weight(1.0),
+            recompute_weight(1.0),
+            ewma_alpha(0.5)
+    {}
+    ~POSCheckpointCostModel() = default;
+
+
+    /* ============================ model inputs ============================= */
+ public:
+    // default on-device copy bandwidth (bytes/us), used before any CoW is measured
+    static constexpr double kDefaultCoWBandwidth = 100000.0;
+
+    // default device-to-host copy bandwidth (bytes/us), used before any commit is measured
+    static constexpr double kDefaultCommitBandwidth = 10000.0;
+
+    // measured bandwidth of CoW (bytes/us)
+    std::atomic<double> cow_bw;
+
+    // measured bandwidth of commit (bytes/us)
+    std::atomic<double> commit_bw;
+
+    // measured cost to recompute a single recorded API (us), 0 for not measured yet
+    std::atomic<double> recompute_us_per_api;
+
+    /*!
+     *  \brief  weight of worker-side cost (i.e., CoW that slows down the application)
+     *          against the downtime of the bottom-half
+     */
+    double cow_weight;
+
+    /*!
+     *  \brief  weight of restore-side cost (i.e., recomputation) against the downtime
+     *          of the bottom-half, should be lower than 1 if restore is rare
+     */
+    double recompute_weight;
+
+    // smooth factor of all exponentially weighted moving averages
+    double ewma_alpha;
+
+
+    /*!
+     *  \brief  feed the model with a measured CoW
+     *  \param  bytes   number of bytes copied
+     *  \param  ticks   duration of the copy (TSC ticks)
+     */
+    inline void observe_cow(uint64_t bytes, uint64_t ticks){
+        this->__observe_bw(this->cow_bw, bytes, ticks);
+    }
+
+
+    /*!
+     *  \brief  feed the model with a measured commit
+     *  \note   could be called by the checkpoint thread
+     *  \param  bytes   number of bytes committed
+     *  \param  ticks   duration of the commit (TSC ticks)
+     */
+    inline void observe_commit(uint64_t bytes, uint64_t ticks){
+        this->__observe_bw(this->commit_bw, bytes, ticks);
+    }
+
+
+    /*!
+     *  \brief  feed the model with the execution cost of APIs recorded for recomputation
+     *  \param  nb_apis number of recorded APIs
+     *  \param  ticks   overall execution duration of these APIs (TSC ticks)
+     */
+    inline void observe_recompute(uint64_t nb_apis, uint64_t ticks){
+        double us_per_api;
+        if(unlikely(nb_apis == 0)){ return; }
+        us_per_api = this->_tsc_timer.tick_to_us(ticks) / (double)(nb_apis);
+        this->__observe(this->recompute_us_per_api, us_per_api);
+    }
+
+
+    /*!
+     *  \brief  fold the write count of a handle in the last round into its write frequency
+     *  \param  write_freq  previous write frequency of the handle
+     *  \param  nb_writes   number of writes to the handle in the last round
+     *  \return updated write frequency
+     */
+    inline double update_write_freq(double write_freq, uint64_t nb_writes){
+        return this->ewma_alpha * (double)(nb_writes) + (1.0 - this->ewma_alpha) * write_freq;
+    }
+    /* ============================ model inputs ============================= */
+
+
+    /* ============================ model outputs ============================ */
+ public:
+    // all decisions made since last reset, at most kMaxNbRecords are kept
+    std::vector<pos_ckpt_cost_record_t> records;
+
+    // maximum number of kept records
+    static constexpr uint64_t kMaxNbRecords = 1ull << 20;
+
+
+    /*!
+     *  \brief  decide whether to CoW a handle once it's modified during concurrent checkpoint
+     *  \note   a CoW-ed handle costs a on-device copy on the worker thread, and its latest
+     *          state needs to be recomputed by replaying all APIs that write it, while a
+     *          non-preserved handle costs a commit within the bottom-half
+     *  \param  epoch               epoch of current checkpoint round
+     *  \param  handle_id           index of the handle
+     *  \param  resource_type_id    resource type of the handle
+     *  \param  state_size          state size of the handle
+     *  \param  write_freq          write frequency of the handle
+     *  \return kPOS_CkptDecision_CoW or kPOS_CkptDecision_WaitCommit
+     */
+    inline pos_ckpt_decision_t decide_handle(
+        uint64_t epoch, pos_u64id_t handle_id, pos_resource_typeid_t resource_type_id,
+        uint64_t state_size, double write_freq
+    ){
+        pos_ckpt_cost_record_t record = { 0 };
+
+        record.epoch = epoch;
+        record.is_round = false;
+        record.handle_id = handle_id;
+        record.resource_type_id = resource_type_id;
+        record.state_size = state_size;
+        record.write_freq = write_freq;
+        this->__fill_inputs(record);
+
+        record.cow_cost = (double)(state_size) / record.cow_bw * this->cow_weight;
+        record.recompute_cost = write_freq * record.recompute_us_per_api * this->recompute_weight;
+        record.wait_commit_cost = (double)(state_size) / record.commit_bw;
+
+        record.decision = (record.cow_cost + record.recompute_cost <= record.wait_commit_cost)
+                        ? kPOS_CkptDecision_CoW
+                        : kPOS_CkptDecision_WaitCommit;
+
+        this->__keep_record(record);
+        return record.decision;
+    }
+
+
+    /*!
+     *  \brief  decide whether to dirty-copy or recompute the handles modified during
+     *          concurrent checkpoint, invoked by the bottom-half
+     *  \param  epoch                   epoch of current checkpoint round
+     *  \param  dirty_state_size        overall state size of all modified handles
+     *  \param  nb_recompute_apis       number of APIs recorded for recomputation
+     *  \param  nb_unpreserved_handles  number of modified handles without checkpointed version preserved
+     *  \return kPOS_CkptDecision_WaitCommit or kPOS_CkptDecision_Recompute
+     */
+    inline pos_ckpt_decision_t decide_round(
+        uint64_t epoch, uint64_t dirty_state_size, uint64_t nb_recompute_apis, uint64_t nb_unpreserved_handles
+    ){
+        pos_ckpt_cost_record_t record = { 0 };
+
+        record.epoch = epoch;
+        record.is_round = true;
+        record.state_size = dirty_state_size;
+        record.nb_recompute_apis = nb_recompute_apis;
+        record.nb_unpreserved_handles = nb_unpreserved_handles;
+        this->__fill_inputs(record);
+
+        record.wait_commit_cost = (double)(dirty_state_size) / record.commit_bw;
+        record.recompute_cost = (double)(nb_recompute_apis) * record.recompute_us_per_api * this->recompute_weight;
+
+        // recomputation could only be applied if all modified handles have their checkpointed version preserved
+        if(nb_unpreserved_handles > 0){
+            record.decision = kPOS_CkptDecision_WaitCommit;
+        } else {
+            record.decision = (record.recompute_cost < record.wait_commit_cost)
+                            ? kPOS_CkptDecision_Recompute
+                            : kPOS_CkptDecision_WaitCommit;
+        }
+
+        this->__keep_record(record);
+        return record.decision;
+    }
+
+
+    /*!
+     *  \brief  dump all recorded decisions (along with their inputs) to a CSV file
+     *  \note   this function involves file I/O, it shouldn't be invoked on the critical path
+     *          of checkpoint (e.g., within the bottom-half)
+     *  \param  file_path   path to the dumped file
+     *  \return POS_SUCCESS for successfully dumped
+     */
+    inline pos_retval_t dump(std::string file_path){
+        pos_retval_t retval = POS_SUCCESS;
+        std::ofstream output_file;
+
+        output_file.open(file_path.c_str(), std::ios::out | std::ios::trunc);
+        if(unlikely(!output_file.is_open())){
+            POS_WARN_C("failed to dump cost model records, failed to open file: path(%s)", file_path.c_str());
+            retval = POS_FAILED;
+            goto exit;
+        }
+
+        output_file << "epoch,level,handle_id,resource_type_id,state_size,write_freq,"
+                    << "nb_recompute_apis,nb_unpreserved_handles,cow_bw,commit_bw,recompute_us_per_api,"
+                    << "cow_cost,wait_commit_cost,recompute_cost,decision" << std::endl;
+        for(auto &record : this->records){
+            output_file << record.epoch << ","
+                        << (record.is_round ? "round" : "handle") << ","
+                        << record.handle_id << ","
+                        << record.resource_type_id << ","
+                        << record.state_size << ","
+                        << record.write_freq << ","
+                        << record.nb_recompute_apis << ","
+                        << record.nb_unpreserved_handles << ","
+                        << record.cow_bw << ","
+                        << record.commit_bw << ","
+                        << record.recompute_us_per_api << ","
+                        << record.cow_cost << ","
+                        << record.wait_commit_cost << ","
+                        << record.recompute_cost << ","
+                        << POSCheckpointCostModel::decision_str(record.decision) << std::endl;
+        }
+        output_file.close();
+
+    exit:
+        return retval;
+    }
+
+
+    /*!
+     *  \brief  obtain the string of the current model inputs
+     *  \return the string of the current model inputs
+     */
+    inline std::string str(){
+        return    std::string("cow_bw(") + std::to_string(this->cow_bw.load(std::memory_order_relaxed)) + std::string(" B/us), ")
+                + std::string("commit_bw(") + std::to_string(this->commit_bw.load(std::memory_order_relaxed)) + std::string(" B/us), ")
+                + std::string("recompute_us_per_api(") + std::to_string(this->recompute_us_per_api.load(std::memory_order_relaxed)) + std::string(" us), ")
+                + std::string("cow_weight(") + std::to_string(this->cow_weight) + std::string("), ")
+                + std::string("recompute_weight(") + std::to_string(this->recompute_weight) + std::string(")");
+    }
+
+
+    /*!
+     *  \brief  obtain the name of a decision
+     *  \param  decision    the decision
+     *  \return the name of the decision
+     */
+    static inline const char* decision_str(pos_ckpt_decision_t decision){
+        switch (decision)
+        {
+        case kPOS_CkptDecision_CoW:
+            return "cow";
+        case kPOS_CkptDecision_WaitCommit:
+            return "wait_commit";
+        case kPOS_CkptDecision_Recompute:
+            return "recompute";
+        default:
+            return "unknown";
+        }
+    }
+
+
+    /*!
+     *  \brief  clear all recorded decisions
+     */
+    inline void reset_records(){ this->records.clear(); }
+    /* ============================ model outputs ============================ */
+
+
+ private:
+    // timer to cast ticks to durations
+    POSUtilTscTimer _tsc_timer;
+
+
+    /*!
+     *  \brief  fold a measured copy into the given bandwidth
+     *  \param  bw      the bandwidth to be updated (bytes/us)
+     *  \param  bytes   number of bytes copied
+     *  \param  ticks   duration of the copy (TSC ticks)
+     */
+    inline void __observe_bw(std::atomic<double>& bw, uint64_t bytes, uint64_t ticks){
+        double duration_us;
+        if(unlikely(bytes == 0 || ticks == 0)){ return; }
+        duration_us = this->_tsc_timer.tick_to_us(ticks);
+        if(unlikely(duration_us <= 0)){ return; }
+        this->__observe(bw, (double)(bytes) / duration_us);
+    }
+
+
+    /*!
+     *  \brief  fold a measurement into the exponentially weighted moving average
+     *  \note   could be invoked concurrently by the worker and the checkpoint thread
+     *  \param  value   the average to be updated, taken as the measurement if it's 0
+     *  \param  sample  the measurement
+     */
+    inline void __observe(std::atomic<double>& value, double sample){
+        double prev, next;
+        prev = value.load(std::memory_order_relaxed);
+        do {
+            next = prev == 0 ? sample : this->ewma_alpha * sample + (1.0 - this->ewma_alpha) * prev;
+        } while(!value.compare_exchange_weak(prev, next, std::memory_order_relaxed));
+    }
+
+
+    /*!
+     *  \brief  fill the model inputs to the given record
+     *  \param  record  the record to be filled
+     */
+    inline void __fill_inputs(pos_ckpt_cost_record_t& record){
+        record.cow_bw = this->cow_bw.load(std::memory_order_relaxed);
+        record.commit_bw = this->commit_bw.load(std::memory_order_relaxed);
+        record.recompute_us_per_api = this->recompute_us_per_api.load(std::memory_order_relaxed);
+    }
+
+
+    /*!
+     *  \brief  keep a decision record, dropped once too many records are kept
+     *  \param  record  the record to be kept
+     */
+    inline void __keep_record(const pos_ckpt_cost_record_t& record){
+        if(unlikely(this->records.size() >= kMaxNbRecords)){ return; }
+        this->records.push_back(record);
+    }
+};
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <string>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+
+
+// forward declaration
+class POSHandle;
+
+
+/*!
+ *  \brief  policy to order the commits of stateful handles within the checkpoint thread
+ */
+enum pos_ckpt_sched_policy_t : uint8_t {
+    // commit in the order of collection (i.e., order of the handle set)
+    kPOS_CkptSchedPolicy_FIFO = 0,
+
+    // commit handles with smaller state first
+    kPOS_CkptSchedPolicy_Size,
+
+    // commit handles that are predicted to be written sooner first, to avoid CoW on them
+    kPOS_CkptSchedPolicy_PredictedWrite,
+
+    kPOS_CkptSchedPolicy_Unknown
+};
+
+
+/*!
+ *  \brief  scheduler to order the commits of stateful handles within the checkpoint thread
+ */
+class POSCheckpointScheduler {
+ public:
+    POSCheckpointScheduler() : policy(kPOS_CkptSchedPolicy_PredictedWrite) {}
+    ~POSCheckpointScheduler() = default;
+
+    // policy used by this scheduler
+    pos_ckpt_sched_policy_t policy;
+
+    /*!
+     *  \brief  predicted distance (in number of APIs) to the next write of handles that have
+     *          no pending write, but have been written in previous checkpoint rounds
+     *  \note   scaled by the inverse of the write frequency of the handle
+     */
+    static constexpr uint64_t kNoPendingWriteDistance = 8192;
+
+
+    /*!
+     *  \brief  order the given handles to be committed
+     *  \param  handles         handles to be committed
+     *  \param  current_wqe_id  index of the latest API executed by the worker thread
+     *  \param  ordered_handles the ordered handles to be committed
+     */
+    void schedule(
+        std::set<POSHandle*>& handles, pos_u64id_t current_wqe_id, std::vector<POSHandle*>& ordered_handles
+    );
+
+
+    /*!
+     *  \brief  predict the distance (in number of APIs) to the next write of the given handle
+     *  \note   a handle that has pending write (i.e., recorded by the parser but not yet executed
+     *          by the worker) is predicted by the index of the pending API; otherwise it's predicted
+     *          by its write frequency in previous checkpoint rounds
+     *  \param  handle          the handle to be predicted
+     *  \param  current_wqe_id  index of the latest API executed by the worker thread
+     *  \return the predicted distance, UINT64_MAX for never written
+     */
+    static uint64_t predict_next_write(POSHandle *handle, pos_u64id_t current_wqe_id);
+
+
+    /*!
+     *  \brief  parse the policy from string
+     *  \param  str     the string to be parsed (i.e., "fifo", "size" or "predicted_write")
+     *  \param  policy  the parsed policy
+     *  \return POS_SUCCESS for successfully parsed;
+     *          POS_FAILED_INVALID_INPUT for unknown policy
+     */
+    static inline pos_retval_t parse_policy(const std::string& str, pos_ckpt_sched_policy_t& policy){
+        pos_retval_t retval = POS_SUCCESS;
+        if(str == "fifo"){
+            policy = kPOS_CkptSchedPolicy_FIFO;
+        } else if(str == "size"){
+            policy = kPOS_CkptSchedPolicy_Size;
+        } else if(str == "predicted_write"){
+            policy = kPOS_CkptSchedPolicy_PredictedWrite;
+        } else {
+            retval = POS_FAILED_INVALID_INPUT;
+        }
+        return retval;
+    }
+
+
+    /*!
+     *  \brief  obtain the name of the policy
+     *  \param  policy  the policy
+     *  \return name of the policy
+     */
+    static inline const char* policy_str(pos_ckpt_sched_policy_t policy){
+        switch (policy)
+        {
+        case kPOS_CkptSchedPolicy_FIFO:
+            return "fifo";
+        case kPOS_CkptSchedPolicy_Size:
+            return "size";
+        case kPOS_CkptSchedPolicy_PredictedWrite:
+            return "predicted_write";
+        default:
+            return "unknown";
+        }
+    }
+};
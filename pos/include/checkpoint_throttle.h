@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/timer.h"
+
+
+/*!
+ *  \brief  token-bucket rate limiter for checkpoint traffic (e.g., commit and persist)
+ *  \note   the bucket is shared by all threads that issue checkpoint traffic of a client
+ *          (e.g., lanes of the commit engine), so it's thread-safe
+ *  \note   optionally, the rate could be adapted to the observed application copy traffic, so that
+ *          the slowdown of the application copies is bounded by a given percentage:
+ *          the application copies take fraction u of the time with bandwidth B, checkpoint traffic of
+ *          rate r steals roughly r/B of the bus during that fraction, so the slowdown s ~= u * r / B,
+ *          and the adapted rate is r = s * B / u
+ *  \note   the slowdown bound also works without a configured rate, the rate is then derived from the
+ *          observed application copy traffic only, and unlimited until any application copy is observed
+ */
+class POSCheckpointThrottle {
+ public:
+    POSCheckpointThrottle();
+    ~POSCheckpointThrottle() = default;
+
+    // window to update the adapted rate (us)
+    static constexpr uint64_t kAdaptWindowUs = 10000;
+
+    // smooth factor of the observed application copy traffic
+    static constexpr double kAdaptEwmaAlpha = 0.5;
+
+    // waiting longer than this duration (us) would sleep instead of spinning
+    static constexpr uint64_t kSleepThresholdUs = 50;
+
+    // maximum duration (us) of a single sleep, so that cancellation and rate changes are noticed
+    static constexpr uint64_t kMaxSleepUs = 1000;
+
+
+    /*!
+     *  \brief  configure the rate limiter
+     *  \note   the bucket is refilled if any of the parameters changed
+     *  \param  rate_bps        rate (bytes per second), 0 for unlimited (or derived from max_slowdown_pct)
+     *  \param  burst_bytes     maximum number of bytes could be issued at once (i.e., bucket size),
+     *                          0 for the bytes of 1ms under the given (or derived) rate
+     *  \param  max_slowdown_pct    maximum slowdown (%) of the application copies, used to adapt the
+     *                              rate to the observed application copy traffic, 0 for disabled
+     */
+    void configure(uint64_t rate_bps, uint64_t burst_bytes, uint32_t max_slowdown_pct=0);
+
+
+    /*!
+     *  \brief  acquire tokens for issuing the given bytes, block until the tokens are available
+     *  \note   a request larger than the bucket is admitted once the bucket is full, and leaves the
+     *          bucket in debt, so that following requests wait until it's paid off
+     *  \param  bytes           number of bytes to be issued
+     *  \param  throttled_ticks number of ticks blocked by the rate limiter
+     *  \param  cancel_flag     flag to stop waiting, could be nullptr
+     *  \return POS_SUCCESS for successfully acquired; POS_FAILED_DRAIN for cancelled
+     */
+    pos_retval_t acquire(uint64_t bytes, uint64_t& throttled_ticks, const volatile bool *cancel_flag=nullptr);
+
+
+    /*!
+     *  \brief  record an application copy, used to adapt the rate
+     *  \note   should be invoked by the worker thread after a synchronous application copy,
+     *          it's lock-free as it's on the critical path
+     *  \param  bytes   number of bytes copied
+     *  \param  ticks   duration of the copy
+     */
+    inline void observe_app_copy(uint64_t bytes, uint64_t ticks){
+        if(this->_max_slowdown_pct.load(std::memory_order_relaxed) == 0){ return; }
+        this->_app_copy_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        this->_app_copy_ticks.fetch_add(ticks, std::memory_order_relaxed);
+    }
+
+
+    /*!
+     *  \brief  whether this rate limiter is enabled
+     */
+    inline bool is_enabled(){
+        return      this->_rate_bps.load(std::memory_order_relaxed) > 0
+                ||  this->_max_slowdown_pct.load(std::memory_order_relaxed) > 0;
+    }
+
+
+    /*!
+     *  \brief  obtain the current effective rate (bytes per second), 0 for unlimited
+     */
+    uint64_t get_effective_rate();
+
+ private:
+    /*!
+     *  \brief  refill the bucket and update the adapted rate
+     *  \note   should be invoked with _mutex held
+     *  \param  tick    current tick
+     */
+    void __refill(uint64_t tick);
+
+    // configured rate (bytes per second) and bucket size (bytes)
+    std::atomic<uint64_t> _rate_bps;
+    uint64_t _burst_bytes;
+
+    // whether the bucket size follows the effective rate, as neither the rate nor the bucket size is configured
+    bool _is_derived_burst;
+
+    // maximum slowdown (%) of the application copies
+    std::atomic<uint32_t> _max_slowdown_pct;
+
+    // effective rate (bytes per tick), might be adapted from the configured one, infinity for unlimited
+    double _rate_bpt;
+
+    // tokens in the bucket (bytes), negative for debt
+    double _tokens;
+
+    // last tick to refill the bucket / update the adapted rate
+    uint64_t _last_refill_tick;
+    uint64_t _last_adapt_tick;
+
+    // accumulated application copy traffic within current adaptation window
+    std::atomic<uint64_t> _app_copy_bytes;
+    std::atomic<uint64_t> _app_copy_ticks;
+
+    // smoothed application copy bandwidth (bytes per tick) and utilization of the bus
+    double _app_copy_bpt;
+    double _app_copy_util;
+
+    std::mutex _mutex;
+
+    POSUtilTscTimer _tsc_timer;
+};
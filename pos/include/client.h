@@ -30,8 +30,11 @@
 #include "pos/include/command.h"
 #include "pos/include/transport.h"
 #include "pos/include/api_context.h"
+#include "pos/include/api_trace.h"
 #include "pos/include/utils/lockfree_queue.h"
 #include "pos/include/utils/timer.h"
+#include "pos/include/utils/wait_event.h"
+#include "pos/include/utils/completion.h"
 
 
 // forward declaration
@@ -47,7 +50,6 @@ enum pos_queue_direction_t : uint8_t {
     kPOS_QueueDirection_Rpc2Worker,
     kPOS_QueueDirection_Parser2Worker,
     kPOS_QueueDirection_Oob2Parser,
-    kPOS_QueueDirection_ParserLocal,
     kPOS_QueueDirection_WorkerLocal
 };
 
@@ -61,7 +63,6 @@ enum pos_queue_type_t : uint8_t {
     kPOS_QueueType_ApiCxt_WQ,
     kPOS_QueueType_ApiCxt_CQ,
     kPOS_QueueType_ApiCxt_CkptDag_WQ,
-    kPOS_QueueType_ApiCxt_Trace_WQ,
     kPOS_QueueType_Cmd_WQ,
     kPOS_QueueType_Cmd_CQ
 };
@@ -253,6 +254,56 @@ class POSClient {
     inline uint64_t get_and_move_api_inst_pc(){ _api_inst_pc++; return (_api_inst_pc-1); }
 
 
+    /*!
+     *  \brief  update the status of this client, and wake up all threads waiting on it
+     *  \param  status  the new status
+     */
+    inline void set_status(pos_client_status_t status){
+        this->status = status;
+        this->parser_wait_event.notify();
+        this->worker_wait_event.notify();
+        this->rpc_wait_event.notify();
+    }
+
+
+    /*!
+     *  \brief  return a WQE back to the RPC thread, invoked by the parser / worker once the WQE
+     *          is executed (or failed)
+     *  \note   the caller should still hold its reference to the WQE, as the RPC thread might release
+     *          the WQE right after it's completed
+     *  \param  wqe the returned WQE
+     */
+    inline void complete_wqe(POSAPIContext_QE_t *wqe){
+        wqe->return_tick = POSUtilTscTimer::get_tsc();
+
+        // failure of async call would be reported by the following sync call
+        if(unlikely(
+            wqe->is_sync == false && (
+                wqe->status == kPOS_API_Execute_Status_Parser_Failed
+                || wqe->status == kPOS_API_Execute_Status_Worker_Failed
+            )
+        )){
+            this->_async_error_code.store(wqe->api_cxt->return_code, std::memory_order_relaxed);
+            this->_has_async_error.store(true, std::memory_order_release);
+        }
+
+        POSUtilCompletion::signal(wqe->completion);
+    }
+
+
+    /*!
+     *  \brief  obtain and clear the error of previous async calls, invoked by the RPC thread
+     *  \param  error_code the error code of the latest failed async call
+     *  \return whether there's any failed async call since last obtained
+     */
+    inline bool consume_async_error(int& error_code){
+        if(likely(this->_has_async_error.load(std::memory_order_relaxed) == false)){ return false; }
+        if(this->_has_async_error.exchange(false, std::memory_order_acq_rel) == false){ return false; }
+        error_code = this->_async_error_code.load(std::memory_order_relaxed);
+        return true;
+    }
+
+
     // client identifier
     pos_client_uuid_t id;
 
@@ -274,6 +325,22 @@ class POSClient {
     // counter for mark whether a client is offline
     volatile uint8_t offline_counter;
 
+    // number of RPC threads holding the client outside read sections of the client registry,
+    // the client is only destoried once no RPC thread holds it (see POSWorkspace::remove_client)
+    std::atomic<uint32_t> nb_rpc_refs;
+
+    // mark whether the client is unregistered, so that RPC threads waiting for it give up
+    std::atomic<bool> is_removed;
+
+    // events for the parser / worker daemon and the RPC thread to wait on while idle,
+    // notified by the producers of the queues they consume
+    POSUtilWaitEvent parser_wait_event;
+    POSUtilWaitEvent worker_wait_event;
+    POSUtilWaitEvent rpc_wait_event;
+
+    // completion of sync calls that the RPC thread waits on, with the round-trip latencies
+    POSUtilCompletion sync_completion;
+
  protected:
     friend class POSWorkspace;
     friend class POSParser;
@@ -287,6 +354,13 @@ class POSClient {
 
     // the global workspace
     POSWorkspace *_ws;
+
+    // error of the latest failed async call, not reported to the frontend yet
+    std::atomic<bool> _has_async_error;
+    std::atomic<int> _async_error_code;
+
+    // ring recording the parsed APIs under resource trace mode, nullptr for not tracing
+    POSApiTraceRing *_api_trace_ring;
     /* ====================== basic ====================== */
 
 
@@ -424,6 +498,43 @@ class POSClient {
     template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
     pos_retval_t poll_q(std::vector<POSCommand_QE_t*>* qes);
 
+    /*!
+     *  \brief  push a batch of apicxt queue elements to specified queue
+     *  \note   the batch is published to the consumer at once, which is cheaper than
+     *          pushing the elements one by one under high API rates
+     *  \tparam qdir    queue direction
+     *  \tparam qtype   type of the queue
+     *  \param  qes     queue elements to be pushed, in order
+     *  \param  nb_qes  number of queue elements to be pushed
+     *  \return POS_SUCCESS for successfully pushed
+     */
+    template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+    pos_retval_t push_q_bulk(POSAPIContext_QE_t** qes, uint64_t nb_qes);
+
+    /*!
+     *  \brief  poll a batch of apicxt queue elements from specified queue
+     *  \tparam qdir        queue direction
+     *  \tparam qtype       type of the queue
+     *  \param  qes         caller-provided buffer to store the polled queue elements
+     *  \param  max_nb_qes  maximum number of queue elements to be polled (i.e., size of the buffer)
+     *  \param  nb_qes      number of polled queue elements
+     *  \return POS_SUCCESS for successfully polling
+     */
+    template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+    pos_retval_t poll_q(POSAPIContext_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+
+    /*!
+     *  \brief  poll a batch of cmd queue elements from specified queue
+     *  \tparam qdir        queue direction
+     *  \tparam qtype       type of the queue
+     *  \param  qes         caller-provided buffer to store the polled queue elements
+     *  \param  max_nb_qes  maximum number of queue elements to be polled (i.e., size of the buffer)
+     *  \param  nb_qes      number of polled queue elements
+     *  \return POS_SUCCESS for successfully polling
+     */
+    template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+    pos_retval_t poll_q(POSCommand_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+
     /*!
      *  \brief  clear all elements inside the queue
      *  \tparam qdir    queue direction
@@ -445,9 +556,6 @@ class POSClient {
     // api context work queue in worker, record during ckpt
     POSLockFreeQueue<POSAPIContext_QE_t*> *_apicxt_workerlocal_ckptdag_wq;
 
-    // api context work queue in parser, record during resource trace mode
-    POSLockFreeQueue<POSAPIContext_QE_t*> *_apicxt_parserlocal_trace_wq;
-
     // api context completion queue from worker to RPC frontend
     POSLockFreeQueue<POSAPIContext_QE_t*> *_apicxt_rpc2worker_cq;
 
@@ -459,7 +567,54 @@ class POSClient {
     POSLockFreeQueue<POSCommand_QE_t*> *_cmd_oob2parser_wq;
     POSLockFreeQueue<POSCommand_QE_t*> *_cmd_oob2parser_cq;
 
+    // pool of api context queue elements
+    POSAPIContextPool *_apicxt_pool;
+
  private:
+    /*!
+     *  \brief  obtain the apicxt queue of specified direction and type
+     *  \tparam qdir    queue direction
+     *  \tparam qtype   type of the queue
+     *  \return pointer to the queue
+     */
+    template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+    POSLockFreeQueue<POSAPIContext_QE_t*>* __get_apicxt_q();
+
+    /*!
+     *  \brief  obtain the cmd queue of specified direction and type
+     *  \tparam qdir    queue direction
+     *  \tparam qtype   type of the queue
+     *  \return pointer to the queue
+     */
+    template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+    POSLockFreeQueue<POSCommand_QE_t*>* __get_cmd_q();
+
+    /*!
+     *  \brief  wake up the consumer of specified queue after pushing to it
+     *  \tparam qdir    queue direction
+     *  \tparam qtype   type of the queue
+     */
+    template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+    inline void __notify_consumer(){
+        if constexpr (
+                (qdir == kPOS_QueueDirection_Rpc2Parser && qtype == kPOS_QueueType_ApiCxt_WQ)
+            ||  (qdir == kPOS_QueueDirection_Parser2Worker && qtype == kPOS_QueueType_Cmd_CQ)
+            ||  (qdir == kPOS_QueueDirection_Oob2Parser && qtype == kPOS_QueueType_Cmd_WQ)
+        ){
+            this->parser_wait_event.notify();
+        } else if constexpr (
+                qdir == kPOS_QueueDirection_Parser2Worker
+            &&  (qtype == kPOS_QueueType_ApiCxt_WQ || qtype == kPOS_QueueType_Cmd_WQ)
+        ){
+            this->worker_wait_event.notify();
+        } else if constexpr (
+                (qdir == kPOS_QueueDirection_Rpc2Parser || qdir == kPOS_QueueDirection_Rpc2Worker)
+            &&  qtype == kPOS_QueueType_ApiCxt_CQ
+        ){
+            this->rpc_wait_event.notify();
+        }
+    }
+
     /*!
      *  \brief  create queue group for this client
      *  \return POS_SUCCESS for successfully creation
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+
+
+// forward declaration
+class POSClient;
+
+
+/*!
+ *  \brief  registry of the clients in the workspace, indexed by uuid and by pid
+ *  \note   lookups are lock-free and never blocked by registering / removing clients (RCU-style):
+ *          -   uuid index: a two-level array whose chunks are allocated once and never moved,
+ *              so it can grow while being read;
+ *          -   pid index: an open-addressing table of packed (pid, uuid) words, which is rebuilt
+ *              into a new table and republished once it's filled up with removed entries;
+ *          writers are serialized by a mutex
+ *  \note   a client (or a retired pid table) is only released after a grace period, i.e., once all
+ *          threads that were in a read section (read_lock / read_unlock) when it was unpublished
+ *          have left; so a client obtained within a read section stays valid until read_unlock
+ */
+class POSClientRegistry {
+ public:
+    POSClientRegistry();
+    ~POSClientRegistry();
+
+    // number of uuid slots in a chunk, and maximum number of chunks
+    static constexpr uint64_t kChunkSize = 1024;
+    static constexpr uint64_t kMaxNbChunks = 1024;
+
+    // maximum number of clients could be registered
+    static constexpr uint64_t kMaxNbClients = kChunkSize * kMaxNbChunks;
+
+    // maximum number of threads in read sections at the same time
+    static constexpr uint32_t kMaxNbReaders = 1024;
+
+    // minimum capacity of the pid index
+    static constexpr uint64_t kMinPidIndexCapacity = 64;
+
+    /*!
+     *  \brief  allocate a new uuid for a client to be registered
+     *  \return the allocated uuid
+     */
+    inline pos_client_uuid_t alloc_uuid(){ return this->_max_uuid.fetch_add(1, std::memory_order_relaxed); }
+
+    /*!
+     *  \brief  obtain the upper bound of all allocated uuids, used to iterate all clients
+     */
+    inline pos_client_uuid_t get_max_uuid() const { return this->_max_uuid.load(std::memory_order_acquire); }
+
+    /*!
+     *  \brief  register a client
+     *  \note   should not be invoked within a read section, as it might wait for the retired pid index
+     *  \param  uuid    uuid of the client
+     *  \param  pid     pid of the client process, a registered client of the same pid is no longer indexed by pid
+     *  \param  client  the client to be registered
+     *  \return POS_SUCCESS for successfully registered;
+     *          POS_FAILED_INVALID_INPUT for uuid out of range;
+     *          POS_FAILED_ALREADY_EXIST for uuid already registered
+     */
+    pos_retval_t insert(pos_client_uuid_t uuid, __pid_t pid, POSClient *client);
+
+    /*!
+     *  \brief  unregister a client, and wait until no reader could access it
+     *  \note   should not be invoked within a read section
+     *  \param  uuid    uuid of the client
+     *  \return the unregistered client, which could be released by the caller;
+     *          nullptr for no client registered with the uuid
+     */
+    POSClient* erase(pos_client_uuid_t uuid);
+
+    /*!
+     *  \brief  obtain client by uuid
+     *  \note   the client is only guaranteed to be valid within a read section
+     *  \param  uuid    uuid of the client
+     *  \return the client, nullptr for not registered
+     */
+    inline POSClient* get_by_uuid(pos_client_uuid_t uuid) const {
+        std::atomic<POSClient*> *chunk;
+
+        if(unlikely(uuid >= kMaxNbClients)){ return nullptr; }
+        chunk = this->_chunks[uuid / kChunkSize].load(std::memory_order_acquire);
+        if(unlikely(chunk == nullptr)){ return nullptr; }
+        return chunk[uuid % kChunkSize].load(std::memory_order_acquire);
+    }
+
+    /*!
+     *  \brief  obtain client by pid
+     *  \note   the client is only guaranteed to be valid within a read section
+     *  \param  pid     pid of the client process
+     *  \return the client, nullptr for not registered
+     */
+    POSClient* get_by_pid(__pid_t pid);
+
+    /*!
+     *  \brief  enter a read section, could be nested
+     */
+    static void read_lock();
+
+    /*!
+     *  \brief  leave a read section
+     */
+    static void read_unlock();
+
+    /*!
+     *  \brief  wait for a grace period, i.e., until all read sections that started before have left
+     *  \note   should not be invoked within a read section
+     */
+    static void synchronize();
+
+ private:
+    /*!
+     *  \brief  open-addressing table that index uuid by pid
+     *  \note   each entry packs pid (high 32 bits) and uuid (low 32 bits), 0 for empty and
+     *          kTombstone for removed entry; entries are never reused within a table
+     */
+    typedef struct pid_index {
+        uint64_t capacity;
+        uint64_t nb_used;
+        std::atomic<uint64_t> *entries;
+    } pid_index_t;
+
+    static constexpr uint64_t kTombstone = UINT64_MAX;
+
+    static inline uint64_t __pid_hash(__pid_t pid, uint64_t capacity){
+        return (static_cast<uint64_t>(static_cast<uint32_t>(pid)) * 0x9E3779B97F4A7C15ull) & (capacity - 1);
+    }
+
+    /*!
+     *  \brief  create a pid index, with all live entries in the given index
+     *  \param  from        the index to copy live entries from, nullptr for creating an empty index
+     *  \param  nb_reserved number of entries to be inserted afterwards
+     *  \return the created index
+     */
+    static pid_index_t* __create_pid_index(pid_index_t *from, uint64_t nb_reserved);
+
+    /*!
+     *  \brief  insert an entry to the pid index, the index should have free entries
+     *  \note   should be invoked with the mutex held
+     */
+    static void __pid_index_insert(pid_index_t *index, __pid_t pid, pos_client_uuid_t uuid);
+
+    /*!
+     *  \brief  remove the entry of the given pid (and uuid) from the pid index
+     *  \note   should be invoked with the mutex held
+     *  \param  uuid    uuid of the entry, UINT64_MAX for any uuid
+     */
+    static void __pid_index_remove(pid_index_t *index, __pid_t pid, pos_client_uuid_t uuid);
+
+    // uuid index
+    std::atomic<std::atomic<POSClient*>*> _chunks[kMaxNbChunks];
+
+    // pid index
+    std::atomic<pid_index_t*> _pid_index;
+
+    // pid of each registered client, for removing the entry from the pid index, protected by the mutex
+    __pid_t *_pids[kMaxNbChunks];
+
+    // upper bound of allocated uuids
+    std::atomic<pos_client_uuid_t> _max_uuid;
+
+    // mutex to serialize writers
+    std::mutex _mutex;
+};
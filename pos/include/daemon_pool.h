@@ -0,0 +1,231 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/timer.h"
+#include "pos/include/utils/wait_event.h"
+#include "pos/include/placement.h"
+
+
+/*!
+ *  \brief  a daemon (e.g., parser / worker of a client) served by the daemon pool
+ */
+typedef struct pos_daemon_pool_task {
+    // name of the task, for logging
+    std::string name;
+
+    /*!
+     *  \brief  run one round of the daemon
+     *  \return whether any work was done in this round
+     */
+    std::function<bool()> step;
+
+    /*!
+     *  \brief  bind the running thread to the daemon (e.g., setup device context),
+     *          invoked before the task runs on a new thread
+     *  \param  is_first    whether this is the first time the task runs
+     *  \return POS_SUCCESS for successfully binding
+     */
+    std::function<pos_retval_t(bool)> bind;
+
+    // whether the task is running by any pool thread, at most one thread runs the task at a time
+    std::atomic<bool> is_running;
+
+    // whether the task is removed from the pool
+    std::atomic<bool> is_removed;
+
+    // index of the pool thread that owns this task, protected by the mutex of the pool
+    uint32_t owner_tid;
+
+    // index of the pool thread that the task was bound to, -1 for never bound
+    int64_t bound_tid;
+
+    // tick of the last round that did any work, used to decide whether the task is hot
+    std::atomic<uint64_t> last_busy_tick;
+
+    // statistics
+    uint64_t nb_busy_steps;
+    uint64_t nb_migrations;
+
+    pos_daemon_pool_task()
+        :   is_running(false), is_removed(false), owner_tid(0), bound_tid(-1), last_busy_tick(0),
+            nb_busy_steps(0), nb_migrations(0) {}
+} pos_daemon_pool_task_t;
+
+
+/*!
+ *  \brief  fixed pool of threads serving the daemons of many clients
+ *  \note   each task is owned by a pool thread, which runs a round of the task in turn,
+ *          and a task is only run by one thread at a time, so the order within a client is kept
+ *  \note   a task sticks to its owner thread; an idle thread only steals a hot task (i.e., busy
+ *          within kHotUs) from a thread that has at least two more hot tasks than itself, or a
+ *          task from a thread that is stuck in a long round (e.g., checkpointing) of another task
+ *  \note   the pool threads park on a shared event, the events of the served clients should be
+ *          chained to it (see get_wait_event)
+ */
+class POSDaemonPool {
+ public:
+    /*!
+     *  \brief  constructor
+     *  \param  name        name of the pool, for logging
+     *  \param  nb_threads  number of threads in the pool
+     *  \param  tsc_timer   timer of the workspace
+     *  \param  placement   placement of the pool threads, nullptr for not placing
+     *  \param  role        role of the pool threads to be placed as
+     */
+    POSDaemonPool(
+        std::string name, uint32_t nb_threads, POSUtilTscTimer *tsc_timer,
+        POSPlacement *placement, pos_placement_role_t role
+    );
+    ~POSDaemonPool();
+
+    // maximum number of threads in a pool
+    static constexpr uint32_t kMaxNbThreads = 256;
+
+    // a task is hot if it did any work within this duration (us)
+    static constexpr uint64_t kHotUs = 1000;
+
+    // minimum interval (us) for an idle thread to try stealing
+    static constexpr uint64_t kStealIntervalUs = 100;
+
+    /*!
+     *  \brief  start the pool threads
+     *  \return POS_SUCCESS for successfully started
+     */
+    pos_retval_t init();
+
+    /*!
+     *  \brief  stop the pool threads
+     *  \note   all tasks should be removed before
+     */
+    void deinit();
+
+    /*!
+     *  \brief  add a task to the pool, which is assigned to the thread with the fewest tasks
+     *  \param  name    name of the task
+     *  \param  step    function to run one round of the task
+     *  \param  bind    function to bind a thread to the task
+     *  \return the added task
+     */
+    std::shared_ptr<pos_daemon_pool_task_t> add(
+        std::string name, std::function<bool()> step, std::function<pos_retval_t(bool)> bind
+    );
+
+    /*!
+     *  \brief  remove a task from the pool
+     *  \note   once returned, the task won't be run by any pool thread
+     *  \param  task    the task to be removed
+     */
+    void remove(std::shared_ptr<pos_daemon_pool_task_t>& task);
+
+    /*!
+     *  \brief  setup the waiting budgets of the pool threads
+     *  \param  spin_ticks      ticks to spin before yielding
+     *  \param  yield_ticks     ticks to yield before parking
+     *  \param  park_timeout_us maximum duration (us) of a single park
+     */
+    inline void set_wait_budget(uint64_t spin_ticks, uint64_t yield_ticks, uint64_t park_timeout_us){
+        this->_wait_event.set_budget(spin_ticks, yield_ticks, park_timeout_us);
+    }
+
+    /*!
+     *  \brief  obtain the event that the pool threads wait on
+     */
+    inline POSUtilWaitEvent* get_wait_event(){ return &this->_wait_event; }
+
+    /*!
+     *  \brief  obtain the number of threads in the pool
+     */
+    inline uint32_t get_nb_threads() const { return this->_nb_threads; }
+
+ private:
+    /*!
+     *  \brief  a thread of the pool
+     */
+    typedef struct pos_daemon_pool_thread {
+        uint32_t id;
+        std::thread *thread;
+
+        // tasks owned by this thread, protected by the mutex of the pool
+        std::vector<std::shared_ptr<pos_daemon_pool_task_t>> tasks;
+
+        // version of the task list, bumped once the list is changed
+        std::atomic<uint64_t> version;
+
+        // start tick of the round currently running, 0 for not running any round
+        std::atomic<uint64_t> step_s_tick;
+
+        // statistics
+        pos_wait_event_stat_t wait_stat;
+        uint64_t nb_steals;
+
+        pos_daemon_pool_thread() : id(0), thread(nullptr), version(0), step_s_tick(0), nb_steals(0) {}
+    } pos_daemon_pool_thread_t;
+
+    /*!
+     *  \brief  processing daemon of a pool thread
+     *  \param  tid index of the thread
+     */
+    void __daemon(uint32_t tid);
+
+    /*!
+     *  \brief  steal a task from a stuck thread, or a hot task from the thread with the most hot tasks
+     *  \param  tid     index of the stealing thread
+     *  \param  tick    current tick
+     *  \return whether any task is stolen
+     */
+    bool __steal(uint32_t tid, uint64_t tick);
+
+    // name of the pool
+    std::string _name;
+
+    // pool threads
+    uint32_t _nb_threads;
+    std::vector<pos_daemon_pool_thread_t*> _threads;
+
+    // event that the pool threads wait on
+    POSUtilWaitEvent _wait_event;
+
+    // duration (ticks) for a task to be hot, and interval (ticks) of stealing
+    uint64_t _hot_ticks;
+    uint64_t _steal_interval_ticks;
+
+    // stop flag to indicate the pool threads to stop
+    volatile bool _stop_flag;
+
+    // mutex to protect the task lists
+    std::mutex _mutex;
+
+    // timer of the workspace
+    POSUtilTscTimer *_tsc_timer;
+
+    // placement of the pool threads, and their role
+    POSPlacement *_placement;
+    pos_placement_role_t _role;
+};
@@ -38,7 +38,9 @@
 #include "pos/include/common.h"
 #include "pos/include/log.h"
 #include "pos/include/utils/lockfree_queue.h"
+#include "pos/include/utils/address_index.h"
 #include "pos/include/checkpoint.h"
+#include "pos/include/checkpoint_cost_model.h"
 #include "pos/include/metrics.h"
 
 
@@ -157,6 +159,16 @@ class POSHandle {
         state_size(state_size_),
         latest_version(0),
         ckpt_bag(nullptr),
+        ckpt_epoch(0),
+        ckpt_version(0),
+        dirty_epoch(0),
+        dirty_next(nullptr),
+        ckpt_decision(kPOS_CkptDecision_CoW),
+        ckpt_write_freq(0),
+        nb_ckpt_writes(0),
+        nb_pending_writes(0),
+        pending_write_id(0),
+        last_pending_write_id(0),
         _hm(hm),
         _persist_thread(nullptr),
         _persist_promise(nullptr)
@@ -185,6 +197,16 @@ class POSHandle {
         state_size(state_size_),
         latest_version(0),
         ckpt_bag(nullptr),
+        ckpt_epoch(0),
+        ckpt_version(0),
+        dirty_epoch(0),
+        dirty_next(nullptr),
+        ckpt_decision(kPOS_CkptDecision_CoW),
+        ckpt_write_freq(0),
+        nb_ckpt_writes(0),
+        nb_pending_writes(0),
+        pending_write_id(0),
+        last_pending_write_id(0),
         _hm(hm),
         _persist_thread(nullptr),
         _persist_promise(nullptr)
@@ -210,6 +232,16 @@ class POSHandle {
         state_size(0),
         latest_version(0),
         ckpt_bag(nullptr),
+        ckpt_epoch(0),
+        ckpt_version(0),
+        dirty_epoch(0),
+        dirty_next(nullptr),
+        ckpt_decision(kPOS_CkptDecision_CoW),
+        ckpt_write_freq(0),
+        nb_ckpt_writes(0),
+        nb_pending_writes(0),
+        pending_write_id(0),
+        last_pending_write_id(0),
         _hm(hm),
         _persist_thread(nullptr),
         _persist_promise(nullptr)
@@ -473,6 +505,91 @@ class POSHandle {
     POSCheckpointBag *ckpt_bag;
 
 
+    /*!
+     *  \brief  epoch of the latest checkpoint round that includes this handle
+     *  \note   the handle is a member of checkpoint round E only when ckpt_epoch == E, so
+     *          starting a new round invalidates all previous membership without any clearance
+     *  \note   this field is only written by the worker thread before raising the checkpoint thread
+     */
+    uint64_t ckpt_epoch;
+
+    // version of the state to be checkpointed within round ckpt_epoch
+    pos_u64id_t ckpt_version;
+
+    /*!
+     *  \brief  epoch of the latest checkpoint round in which this handle was modified
+     *  \note   the handle is dirty in round E only when dirty_epoch == E
+     */
+    uint64_t dirty_epoch;
+
+    // next handle within the intrusive dirty list of the checkpoint round dirty_epoch
+    POSHandle *dirty_next;
+
+    /*!
+     *  \brief  how to preserve the state of this handle once it's modified within round ckpt_epoch
+     *  \note   decided by the checkpoint cost model at the start of each round
+     */
+    pos_ckpt_decision_t ckpt_decision;
+
+    // write frequency of this handle during concurrent checkpoint (#writes per round)
+    double ckpt_write_freq;
+
+    // number of writes to this handle within current checkpoint round
+    uint64_t nb_ckpt_writes;
+
+    /*!
+     *  \brief  number of APIs that have been parsed but not yet executed to write this handle
+     *  \note   increased by the parser thread, and decreased by the worker thread once the API is executed
+     */
+    std::atomic<uint32_t> nb_pending_writes;
+
+    /*!
+     *  \brief  index of the earliest API that has been parsed but not yet executed to write this handle
+     *  \note   only valid when nb_pending_writes is non-zero; it's used for predicting the next write of this handle
+     */
+    std::atomic<pos_u64id_t> pending_write_id;
+
+    // index of the latest API that has been parsed to write this handle
+    std::atomic<pos_u64id_t> last_pending_write_id;
+
+
+    /*!
+     *  \brief  record a parsed API which writes this handle (invoked by the parser thread)
+     *  \param  wqe_id  index of the parsed API
+     */
+    inline void add_pending_write(pos_u64id_t wqe_id){
+        this->last_pending_write_id.store(wqe_id, std::memory_order_relaxed);
+        if(this->nb_pending_writes.fetch_add(1, std::memory_order_acq_rel) == 0){
+            this->pending_write_id.store(wqe_id, std::memory_order_release);
+        }
+    }
+
+
+    /*!
+     *  \brief  remove an executed API which writes this handle (invoked by the worker thread)
+     *  \note   the earliest pending write is re-stamped to the next write we could infer, as
+     *          the writes in between aren't tracked one by one
+     *  \note   APIs replayed during restore never pass the parser, so we never drop below zero
+     *  \param  wqe_id  index of the executed API
+     */
+    inline void remove_pending_write(pos_u64id_t wqe_id){
+        uint32_t nb_pending = this->nb_pending_writes.load(std::memory_order_acquire);
+        pos_u64id_t last_id;
+
+        do {
+            if(nb_pending == 0){ return; }
+        } while(!this->nb_pending_writes.compare_exchange_weak(nb_pending, nb_pending - 1, std::memory_order_acq_rel));
+
+        if(nb_pending > 1){
+            // the only write left is the latest parsed one, otherwise it's at least the next API
+            last_id = this->last_pending_write_id.load(std::memory_order_relaxed);
+            this->pending_write_id.store(
+                nb_pending == 2 ? std::max(last_id, wqe_id + 1) : wqe_id + 1, std::memory_order_release
+            );
+        }
+    }
+
+
     /*!
      *  \brief  reset the state preserve counter to zero, to start a new checkpoint round
      */
@@ -738,7 +855,8 @@ class POSHandleManager {
      *                      are equal (true for hardware resource, false for software resource)
      */
     POSHandleManager(bool passthrough = false)
-        : _base_ptr(kPOS_ResourceBaseAddr), _passthrough(passthrough), _rid(kPOS_ResourceTypeId_Unknown) {}
+        : _base_ptr(kPOS_ResourceBaseAddr), _passthrough(passthrough), _rid(kPOS_ResourceTypeId_Unknown),
+          _address_generation(0) {}
 
 
     ~POSHandleManager() = default;
@@ -905,7 +1023,8 @@ class POSHandleManager {
         POS_CHECK_POINTER(handle);
 
         if(likely(POS_FAILED_NOT_EXIST == __get_handle_by_client_addr(addr, &__tmp))){
-            _handle_address_map[addr_u64] = handle;
+            _handle_address_index.insert(addr_u64, handle);
+            _address_generation += 1;
         } else {
             POS_CHECK_POINTER(__tmp);
 
@@ -924,6 +1043,16 @@ class POSHandleManager {
         return retval;
     }
 
+
+    /*!
+     *  \brief  obtain the generation of the address map, which is bumped once a handle is recorded to
+     *          or removed from the address map (e.g., on malloc / free)
+     *  \note   the results of get_handle_by_client_addr could be cached along with the generation, and
+     *          stay valid as long as the generation is unchanged
+     *  \return the generation of the address map
+     */
+    inline uint64_t get_address_generation() const { return _address_generation; }
+
  protected:
     uint64_t _base_ptr;
     
@@ -935,7 +1064,11 @@ class POSHandleManager {
 
 
  private:
-    std::map<uint64_t, T_POSHandle*> _handle_address_map;
+    // index of handles by client-side base address, only accessed by the parser thread
+    POSUtilAddressIndex<T_POSHandle> _handle_address_index;
+
+    // generation of the address map, see get_address_generation
+    uint64_t _address_generation;
     /* ======================== address management =========================== */
 
 
@@ -982,7 +1115,7 @@ class POSHandleManager {
  public:
     inline pos_retval_t mark_handle_status(T_POSHandle *handle, pos_handle_status_t status){
         pos_retval_t retval = POS_SUCCESS;
-        typename std::map<uint64_t, T_POSHandle*>::iterator handle_map_iter;
+        T_POSHandle *erased_handle;
         
         POS_CHECK_POINTER(handle);
         
@@ -1016,13 +1149,13 @@ class POSHandleManager {
             handle->status = kPOS_HandleStatus_Delete_Pending;
 
             // remove the handle from the address map
-            handle_map_iter = _handle_address_map.find((uint64_t)(handle->client_addr));
-            if (likely(handle_map_iter != _handle_address_map.end())) {
+            erased_handle = _handle_address_index.erase((uint64_t)(handle->client_addr));
+            if (likely(erased_handle != nullptr)) {
+                _address_generation += 1;
                 _deleted_handle_address_map.insert({
                     /* client_addr */ (uint64_t)(handle->client_addr),
-                    /* handle */ handle_map_iter->second
+                    /* handle */ erased_handle
                 });
-                _handle_address_map.erase((uint64_t)(handle->client_addr));   
             }
 
             POS_DEBUG_C(
@@ -1035,14 +1168,14 @@ class POSHandleManager {
             handle->status = kPOS_HandleStatus_Deleted;
 
             // remove the handle from the address map (should be already deleted in the last case)
-            handle_map_iter = _handle_address_map.find((uint64_t)(handle->client_addr));
-            if (unlikely(handle_map_iter != _handle_address_map.end())) {
+            erased_handle = _handle_address_index.erase((uint64_t)(handle->client_addr));
+            if (unlikely(erased_handle != nullptr)) {
                 POS_WARN_C_DETAIL("remove handle from address map when mark it as deleted, is this a bug?");
+                _address_generation += 1;
                 _deleted_handle_address_map.insert({
                     /* client_addr */ (uint64_t)(handle->client_addr),
-                    /* handle */ handle_map_iter->second
+                    /* handle */ erased_handle
                 });
-                _handle_address_map.erase((uint64_t)(handle->client_addr));
             }
 
             POS_DEBUG_C(
@@ -1310,57 +1443,47 @@ template<class T_POSHandle>
 pos_retval_t POSHandleManager<T_POSHandle>::__get_handle_by_client_addr(void* client_addr, T_POSHandle** handle, uint64_t* offset){
     pos_retval_t ret = POS_SUCCESS;
     T_POSHandle *handle_ptr;
-    uint64_t i;
+    uint64_t base_addr, next_base_addr;
     uint64_t client_addr_u64 = (uint64_t)(client_addr);
 
-    typename std::map<uint64_t, T_POSHandle*>::iterator handle_map_iter;
-
     POS_CHECK_POINTER(handle);
-    
+
     /*!
-     *  \note   direct case: the given address is exactly the base address
+     *  \note   fast path: the given address falls in the range of a recently hit handle,
+     *          which is common as consecutive APIs (e.g., kernel launches) reuse the same buffers
      */
-    if(unlikely(this->_handle_address_map.count(client_addr_u64) > 0)){
-        *handle = this->_handle_address_map[client_addr_u64];
-
-        /*!
-         *  \note   those handle that has been deleted (i.e., kPOS_HandleStatus_Deleted) and 
-         *          are going to be deleted (i.e., kPOS_HandleStatus_Delete_Pending) must be
-         *          not in the map! 
-         */
-        POS_ASSERT(
-            (*handle)->status != kPOS_HandleStatus_Deleted 
-            && (*handle)->status != kPOS_HandleStatus_Delete_Pending
-        );
-
-        if(unlikely(offset != nullptr)){
-            *offset = 0;
+    handle_ptr = this->_handle_address_index.lookup_cache(client_addr_u64, base_addr);
+    if(likely(handle_ptr != nullptr)){
+        *handle = handle_ptr;
+        if(offset != nullptr){
+            *offset = client_addr_u64 - base_addr;
         }
         goto exit;
     }
-    
+
     /*!
-     *  \brief  indirect case: the given address is beyond the base address
-     *  \note   most of query will fall back to this part
+     *  \brief  get the handle with the largest base address that isn't larger than the given address
+     *  \note   those handle that has been deleted (i.e., kPOS_HandleStatus_Deleted) and 
+     *          are going to be deleted (i.e., kPOS_HandleStatus_Delete_Pending) must be
+     *          not in the index! 
      */
-    handle_map_iter = this->_handle_address_map.lower_bound(client_addr_u64);
-    if(handle_map_iter != this->_handle_address_map.begin()){
-        // get the first handle less than the given address
-        handle_map_iter--;
-        handle_ptr = handle_map_iter->second;
-
+    handle_ptr = this->_handle_address_index.floor(client_addr_u64, base_addr, next_base_addr);
+    if(handle_ptr != nullptr){
         POS_ASSERT(
             handle_ptr->status != kPOS_HandleStatus_Deleted && handle_ptr->status != kPOS_HandleStatus_Delete_Pending
         );
 
+        // the given address is exactly the base address, or is beyond the base address
         if(likely(
-            (uint64_t)(handle_ptr->client_addr) <= client_addr_u64 
-            && client_addr_u64 < (uint64_t)(handle_ptr->client_addr) + handle_ptr->size
+            base_addr == client_addr_u64 || client_addr_u64 < base_addr + handle_ptr->size
         )){
+            this->_handle_address_index.fill_cache(
+                base_addr, base_addr + handle_ptr->size, next_base_addr, handle_ptr
+            );
             *handle = handle_ptr;
 
             if(offset != nullptr){
-                *offset = client_addr_u64 - (uint64_t)(handle_ptr->client_addr);
+                *offset = client_addr_u64 - base_addr;
             }
 
             goto exit;
@@ -14,12 +14,12 @@ class POSMetrics_CounterList {
     ~POSMetrics_CounterList() = default;
 
 
-    inline void add_counter(K index){
+    inline void add_counter(K index, uint64_t value=1){
         auto it = this->_map.find(index);
         if(unlikely(it == this->_map.end())){
-            this->_map[index] = 1;
+            this->_map[index] = value;
         } else {
-            this->_map[index] += 1;
+            this->_map[index] += value;
         }
     }
 
@@ -32,6 +32,7 @@
 
 #include "pos/include/common.h"
 #include "pos/include/log.h"
+#include "pos/include/placement.h"
 
 class POSWorkspace;
 class POSAgent;
@@ -92,6 +93,10 @@ enum pos_oob_msg_typeid_t {
     kPOS_OOB_Msg_CLI_Migration_RemotePrepare,
     kPOS_OOB_Msg_CLI_Migration_LocalPrepare,
     kPOS_OOB_Msg_CLI_Migration_Signal,
+    /*!
+     *  \note   runtime configuration
+     */
+    kPOS_OOB_Msg_CLI_Config,
 
     // ========== util message ==========
     kPOS_OOB_Msg_Utils_MockAPICall
@@ -225,13 +230,15 @@ class POSOobServer {
      *  \param  callback_handlers   callback handlers of this OOB server
      *  \param  ip_str              ip address to bind
      *  \param  port                udp port to bind
+     *  \param  placement           placement of the session threads, nullptr for not placing
      */
     POSOobServer(
         POSWorkspace* ws,
         std::map<pos_oob_msg_typeid_t, oob_server_function_t> callback_handlers,
         const char *ip_str=POS_OOB_SERVER_DEFAULT_IP,
-        uint16_t port=POS_OOB_SERVER_DEFAULT_PORT
-    ) : _ws(ws) {
+        uint16_t port=POS_OOB_SERVER_DEFAULT_PORT,
+        POSPlacement *placement=nullptr
+    ) : _ws(ws), _placement(placement) {
         pos_retval_t retval;
         POSOobSession_t *session;
 
@@ -292,6 +299,12 @@ class POSOobServer {
 
         POS_CHECK_POINTER(session);
 
+        POSPlacementScope placement_scope(
+            /* placement */ this->_placement,
+            /* role */ kPOS_PlacementRole_Oob,
+            /* name */ "oob(" + std::to_string(session->server_port) + ")"
+        );
+
         while(session->quit_flag == false){
             memset(recvbuf, 0, sizeof(recvbuf));
             sock_retval = recvfrom(session->fd, recvbuf, sizeof(recvbuf), 0, (struct sockaddr*)&remote_addr, &len);
@@ -516,6 +529,9 @@ class POSOobServer {
     // pointer to the server-side workspace
     POSWorkspace *_ws;
 
+    // placement of the session threads
+    POSPlacement *_placement;
+
     // map of sessions (udp port -> session context)
     std::map<uint16_t, POSOobSession_t*> _session_map;
 
@@ -28,6 +28,7 @@
 #include "pos/include/api_context.h"
 #include "pos/include/command.h"
 #include "pos/include/metrics.h"
+#include "pos/include/daemon_pool.h"
 
 // forward declaration
 class POSClient;
@@ -107,14 +108,24 @@ class POSParser {
     // the daemon thread of the runtime
     std::thread *_daemon_thread;
 
+    // the pool serving the daemon, and the corresponding task, nullptr for running on its own thread
+    POSDaemonPool *_pool;
+    std::shared_ptr<pos_daemon_pool_task_t> _pool_task;
+
+    // maximum number of queue elements polled / pushed at once, and the preallocated batch buffers
+    uint64_t _batch_size;
+    std::vector<POSAPIContext_QE*> _apicxt_wqes;
+    std::vector<POSAPIContext_QE*> _worker_wqes;
+    std::vector<POSCommand_QE_t*> _cmd_wqes;
+
     // global workspace
     POSWorkspace *_ws;
     
     // the coressponding client
     POSClient *_client;
 
-    // parser function map
-    std::map<uint64_t, pos_runtime_parser_function_t> _parser_functions;
+    // parser function table
+    POSApiDispatchTable<pos_runtime_parser_function_t> _parser_functions;
     
     /*!
      *  \brief  insertion of parse functions
@@ -134,6 +145,13 @@ class POSParser {
      */
     void __daemon();
 
+    /*!
+     *  \brief  run one round of the parser daemon
+     *  \note   invoked by the daemon thread of the parser, or by a thread of the parser pool
+     *  \return whether any queue element was digested in this round
+     */
+    bool __daemon_step();
+
     /*!
      *  \brief  insert checkpoint op to the DAG based on certain conditions
      *  \note   aware of the macro POS_CONF_EVAL_CkptEnableIncremental
@@ -165,4 +183,11 @@ class POSParser {
      *  \return POS_SUCCESS for successfully process the command
      */
     pos_retval_t __process_cmd(POSCommand_QE_t *cmd);
+
+    /*!
+     *  \brief  record a parsed API into the trace ring of the client
+     *  \note   invoked under resource trace mode, the record is dropped if the ring is full
+     *  \param  wqe the parsed API context
+     */
+    void __trace_api(POSAPIContext_QE *wqe);
 };
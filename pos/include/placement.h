@@ -0,0 +1,214 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <string>
+#include <mutex>
+#include <stdint.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+
+
+/*!
+ *  \brief  role of a thread, which decides where the thread is placed
+ */
+enum pos_placement_role_t : uint8_t {
+    // latency-critical roles, each thread is pinned to a dedicated critical core
+    kPOS_PlacementRole_Parser = 0,
+    kPOS_PlacementRole_Worker,
+
+    // background roles, which share the cores left by the latency-critical roles
+    kPOS_PlacementRole_Checkpoint,
+    kPOS_PlacementRole_Persist,
+    kPOS_PlacementRole_CommitLane,
+    kPOS_PlacementRole_Oob,
+    kPOS_PlacementRole_Loader,
+
+    kPOS_PlacementRole_Unknown
+};
+
+
+/*!
+ *  \brief  policy to place the threads
+ */
+enum pos_placement_policy_t : uint8_t {
+    // keep the affinity inherited from the creating thread
+    kPOS_PlacementPolicy_None = 0,
+
+    // place all threads on the NUMA node of the device, and keep the
+    // background roles off the cores of the latency-critical roles
+    kPOS_PlacementPolicy_Numa,
+
+    kPOS_PlacementPolicy_Unknown
+};
+
+
+/*!
+ *  \brief  placement of the threads of the workspace onto cpu cores
+ *  \note   threads register themselves once started (see POSPlacementScope), and all
+ *          registered threads are re-placed once the placement is reconfigured
+ *  \note   with the NUMA policy, the cores of the NUMA node are split into critical cores
+ *          and background cores; each parser / worker thread is pinned to the least-loaded
+ *          critical core, while checkpoint / persist / commit / OOB threads float on the
+ *          background cores
+ */
+class POSPlacement {
+ public:
+    POSPlacement();
+    ~POSPlacement() = default;
+
+    // automatically use the NUMA node of the device
+    static constexpr int32_t kAutoNumaNode = -1;
+
+    // maximum index of NUMA node to be configured
+    static constexpr int32_t kMaxNumaNode = 1023;
+
+    /*!
+     *  \brief  reconfigure the placement, and re-place all registered threads
+     *  \param  policy              the placement policy
+     *  \param  numa_node           index of the NUMA node to place the threads, kAutoNumaNode for the node of the device
+     *  \param  nb_critical_cores   number of cores reserved for parser / worker threads, 0 for half of the node
+     */
+    void configure(pos_placement_policy_t policy, int32_t numa_node, uint32_t nb_critical_cores);
+
+    /*!
+     *  \brief  record the NUMA node of the device, used when the NUMA node is configured as auto
+     *  \param  numa_node   index of the NUMA node, negative for unknown
+     */
+    void set_device_numa_node(int32_t numa_node);
+
+    /*!
+     *  \brief  register the calling thread, and place it according to its role
+     *  \param  role    role of the calling thread
+     *  \param  name    name of the calling thread, for logging
+     *  \return id of the registration, to be passed to leave
+     */
+    uint64_t enter(pos_placement_role_t role, std::string name);
+
+    /*!
+     *  \brief  deregister a thread, invoked by the thread before it exits
+     *  \param  id  id of the registration
+     */
+    void leave(uint64_t id);
+
+    /*!
+     *  \brief  obtain the placement that placed the calling thread
+     *  \note   used by threads without access to the workspace (e.g., persisting threads of handles)
+     *          to place their child threads
+     *  \return the placement, nullptr for the calling thread isn't registered
+     */
+    static POSPlacement* current();
+
+    /*!
+     *  \brief  summarize the actual placement of the registered threads by their roles
+     *  \return the summary
+     */
+    std::string str();
+
+    /*!
+     *  \brief  obtain the NUMA node of a PCIe device from sysfs
+     *  \param  pci_bus_id  bus id of the device (e.g., 0000:3b:00.0)
+     *  \return index of the NUMA node, negative for unknown
+     */
+    static int32_t get_pci_numa_node(std::string pci_bus_id);
+
+    static const char* policy_str(pos_placement_policy_t policy);
+    static pos_placement_policy_t policy_from_str(const std::string& str);
+    static const char* role_str(pos_placement_role_t role);
+
+ private:
+    /*!
+     *  \brief  a registered thread
+     */
+    typedef struct pos_placement_thread {
+        pos_placement_role_t role;
+        std::string name;
+        pthread_t handle;
+
+        // the critical core that the thread is pinned to, -1 for not pinned to any single core
+        int32_t cpu;
+    } pos_placement_thread_t;
+
+    /*!
+     *  \brief  split the cores into critical / background cores according to the configuration
+     *  \note   should be invoked with the mutex held
+     */
+    void __compute();
+
+    /*!
+     *  \brief  place a registered thread
+     *  \note   should be invoked with the mutex held
+     *  \param  thread  the thread to be placed
+     *  \param  restore whether to restore the default affinity under the none policy
+     */
+    void __apply(pos_placement_thread_t& thread, bool restore);
+
+    static std::vector<int32_t> __parse_cpu_list(const std::string& str);
+    static std::string __format_cpu_list(const std::vector<int32_t>& cpus);
+
+    // configuration
+    pos_placement_policy_t _policy;
+    int32_t _numa_node;
+    int32_t _device_numa_node;
+    uint32_t _nb_critical_cores;
+
+    // cores allowed for the process when the placement is created
+    std::vector<int32_t> _allowed_cpus;
+
+    // NUMA node in use, and the split of its cores
+    int32_t _used_numa_node;
+    std::vector<int32_t> _critical_cpus;
+    std::vector<int32_t> _background_cpus;
+
+    // number of threads pinned to each critical core
+    std::map<int32_t, uint32_t> _critical_loads;
+
+    // registered threads
+    std::map<uint64_t, pos_placement_thread_t> _threads;
+    uint64_t _max_thread_id;
+
+    std::mutex _mutex;
+};
+
+
+/*!
+ *  \brief  registration of the calling thread to a placement within a scope
+ *  \note   declared at the beginning of the thread function, a nullptr placement is ignored
+ */
+class POSPlacementScope {
+ public:
+    POSPlacementScope(POSPlacement *placement, pos_placement_role_t role, std::string name)
+        :   _placement(placement), _id(0)
+    {
+        if(this->_placement != nullptr){ this->_id = this->_placement->enter(role, name); }
+    }
+
+    ~POSPlacementScope(){
+        if(this->_placement != nullptr){ this->_placement->leave(this->_id); }
+    }
+
+ private:
+    POSPlacement *_placement;
+    uint64_t _id;
+};
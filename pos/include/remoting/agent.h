@@ -44,3 +44,14 @@ static int pos_destory_agent(POSAgent* pos_agent){
     delete pos_agent;
     return 0;
 }
+
+
+/*!
+ *  \brief  obtain the uuid of the client, to be piggybacked on each API call
+ *  \param  pos_agent   pointer to the agent
+ *  \return uuid of the client
+ */
+static pos_client_uuid_t pos_agent_get_uuid(POSAgent* pos_agent){
+    POS_CHECK_POINTER(pos_agent);
+    return pos_agent->get_uuid();
+}
@@ -0,0 +1,414 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+
+
+/*!
+ *  \brief  ordered index from base address to value, for looking up the value whose range covers an address
+ *  \note   it's a two-level B+-tree: keys are kept in sorted blocks of at most kBlockCapacity entries,
+ *          and a flat array of fence keys (the first key of each block) locates the block, so a lookup
+ *          is two binary searches over contiguous arrays instead of chasing tree nodes
+ *  \note   a small last-hit cache in front of the index serves repeated lookups into the same ranges,
+ *          which is the common case of pointer arguments of consecutive API calls; the cache is kept
+ *          consistent by invalidating entries affected by insert / erase
+ *  \note   not thread-safe, the index is expected to be accessed by a single thread (e.g., the parser)
+ *  \tparam T_Value type of the indexed value
+ */
+template<typename T_Value>
+class POSUtilAddressIndex {
+ public:
+    POSUtilAddressIndex() : _nb_keys(0), _next_cache_slot(0) { this->__clear_cache(); }
+    ~POSUtilAddressIndex(){ this->clear(); }
+
+    POSUtilAddressIndex(const POSUtilAddressIndex&) = delete;
+    POSUtilAddressIndex& operator=(const POSUtilAddressIndex&) = delete;
+
+    // maximum number of keys within a block
+    static constexpr uint32_t kBlockCapacity = 128;
+
+    // number of entries within the last-hit cache
+    static constexpr uint32_t kNbCacheEntries = 4;
+
+    /*!
+     *  \brief  insert a key, or update the value if the key already exists
+     *  \param  key     the key (base address)
+     *  \param  value   the value
+     */
+    inline void insert(uint64_t key, T_Value *value){
+        block_t *block;
+        uint64_t bid;
+        uint32_t pos;
+
+        POS_CHECK_POINTER(value);
+
+        this->__invalidate_cache_on_insert(key);
+
+        if(unlikely(this->_blocks.empty())){
+            block = new block_t();
+            block->keys[0] = key;
+            block->values[0] = value;
+            block->nb_keys = 1;
+            this->_blocks.push_back(block);
+            this->_fences.push_back(key);
+            this->_nb_keys = 1;
+            return;
+        }
+
+        // keys smaller than all existing keys go to the first block
+        bid = this->__locate_block(key);
+        if(bid == UINT64_MAX){ bid = 0; }
+        block = this->_blocks[bid];
+
+        pos = std::lower_bound(block->keys, block->keys + block->nb_keys, key) - block->keys;
+        if(pos < block->nb_keys && block->keys[pos] == key){
+            block->values[pos] = value;
+            return;
+        }
+
+        // split the full block into two halves
+        if(unlikely(block->nb_keys == kBlockCapacity)){
+            this->__split_block(bid);
+            if(pos > kBlockCapacity / 2){
+                bid += 1;
+                pos -= kBlockCapacity / 2;
+            }
+            block = this->_blocks[bid];
+        }
+
+        memmove(&block->keys[pos+1], &block->keys[pos], (block->nb_keys - pos) * sizeof(uint64_t));
+        memmove(&block->values[pos+1], &block->values[pos], (block->nb_keys - pos) * sizeof(T_Value*));
+        block->keys[pos] = key;
+        block->values[pos] = value;
+        block->nb_keys += 1;
+        if(pos == 0){ this->_fences[bid] = key; }
+        this->_nb_keys += 1;
+    }
+
+    /*!
+     *  \brief  erase a key
+     *  \param  key the key (base address)
+     *  \return the erased value, nullptr for key not exist
+     */
+    inline T_Value* erase(uint64_t key){
+        T_Value *value;
+        block_t *block;
+        uint64_t bid;
+        uint32_t pos;
+
+        bid = this->__locate_block(key);
+        if(unlikely(bid == UINT64_MAX)){ return nullptr; }
+        block = this->_blocks[bid];
+
+        pos = std::lower_bound(block->keys, block->keys + block->nb_keys, key) - block->keys;
+        if(unlikely(pos == block->nb_keys || block->keys[pos] != key)){ return nullptr; }
+
+        this->__invalidate_cache_on_erase(key);
+
+        value = block->values[pos];
+        memmove(&block->keys[pos], &block->keys[pos+1], (block->nb_keys - pos - 1) * sizeof(uint64_t));
+        memmove(&block->values[pos], &block->values[pos+1], (block->nb_keys - pos - 1) * sizeof(T_Value*));
+        block->nb_keys -= 1;
+        this->_nb_keys -= 1;
+
+        if(block->nb_keys == 0){
+            delete block;
+            this->_blocks.erase(this->_blocks.begin() + bid);
+            this->_fences.erase(this->_fences.begin() + bid);
+        } else {
+            if(pos == 0){ this->_fences[bid] = block->keys[0]; }
+            this->__try_merge_block(bid);
+        }
+
+        return value;
+    }
+
+    /*!
+     *  \brief  obtain the value of the given key
+     *  \param  key the key (base address)
+     *  \return the value, nullptr for key not exist
+     */
+    inline T_Value* find(uint64_t key) const {
+        const block_t *block;
+        uint64_t bid;
+        uint32_t pos;
+
+        bid = this->__locate_block(key);
+        if(bid == UINT64_MAX){ return nullptr; }
+        block = this->_blocks[bid];
+        pos = std::upper_bound(block->keys, block->keys + block->nb_keys, key) - block->keys;
+        return (pos > 0 && block->keys[pos-1] == key) ? block->values[pos-1] : nullptr;
+    }
+
+    /*!
+     *  \brief  obtain the value with the largest key that isn't larger than the given key
+     *  \param  key         the key (address)
+     *  \param  floor_key   the found key
+     *  \return the value, nullptr for no key is smaller than or equal to the given key
+     */
+    inline T_Value* floor(uint64_t key, uint64_t& floor_key) const {
+        const block_t *block;
+        uint64_t bid;
+        uint32_t pos;
+
+        bid = this->__locate_block(key);
+        if(bid == UINT64_MAX){ return nullptr; }
+        block = this->_blocks[bid];
+
+        // the fence guarantees at least one key within the block is not larger
+        pos = std::upper_bound(block->keys, block->keys + block->nb_keys, key) - block->keys;
+        floor_key = block->keys[pos-1];
+        return block->values[pos-1];
+    }
+
+    /*!
+     *  \brief  obtain the value with the largest key that isn't larger than the given key, along with
+     *          the next key after it, which bounds the range to be cached by fill_cache
+     *  \param  key         the key (address)
+     *  \param  floor_key   the found key
+     *  \param  next_key    the smallest key that is larger than the found key, UINT64_MAX for none
+     *  \return the value, nullptr for no key is smaller than or equal to the given key
+     */
+    inline T_Value* floor(uint64_t key, uint64_t& floor_key, uint64_t& next_key) const {
+        const block_t *block;
+        uint64_t bid;
+        uint32_t pos;
+
+        bid = this->__locate_block(key);
+        if(bid == UINT64_MAX){ return nullptr; }
+        block = this->_blocks[bid];
+
+        pos = std::upper_bound(block->keys, block->keys + block->nb_keys, key) - block->keys;
+        floor_key = block->keys[pos-1];
+        if(pos < block->nb_keys){
+            next_key = block->keys[pos];
+        } else {
+            next_key = bid + 1 < this->_fences.size() ? this->_fences[bid + 1] : UINT64_MAX;
+        }
+        return block->values[pos-1];
+    }
+
+    /*!
+     *  \brief  lookup the last-hit cache
+     *  \param  addr    the address to lookup
+     *  \param  base    the base address of the hit range
+     *  \return the cached value whose range covers the address, nullptr for cache miss
+     */
+    inline T_Value* lookup_cache(uint64_t addr, uint64_t& base) const {
+        uint32_t i;
+        for(i=0; i<kNbCacheEntries; i++){
+            if(this->_cache[i].base <= addr && addr < this->_cache[i].end){
+                base = this->_cache[i].base;
+                return this->_cache[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    /*!
+     *  \brief  record a lookup result to the last-hit cache
+     *  \note   ranges of values could overlap (e.g., a lower range covering the base of another one),
+     *          so the cached range is clipped to the next key, within which floor() always returns
+     *          the same value, hence a cache hit returns what the index would
+     *  \param  base    base address (key) of the found value
+     *  \param  end     end address of the range of the found value (exclusive)
+     *  \param  value   the found value
+     */
+    inline void fill_cache(uint64_t base, uint64_t end, T_Value *value){
+        this->fill_cache(base, end, this->__successor(base), value);
+    }
+
+    /*!
+     *  \brief  record a lookup result to the last-hit cache, with the next key already obtained by floor()
+     *  \param  base        base address (key) of the found value
+     *  \param  end         end address of the range of the found value (exclusive)
+     *  \param  next_key    the smallest key that is larger than the base
+     *  \param  value       the found value
+     */
+    inline void fill_cache(uint64_t base, uint64_t end, uint64_t next_key, T_Value *value){
+        end = std::min(end, next_key);
+        if(unlikely(end <= base)){ return; }
+        this->_cache[this->_next_cache_slot].base = base;
+        this->_cache[this->_next_cache_slot].end = end;
+        this->_cache[this->_next_cache_slot].value = value;
+        this->_next_cache_slot = (this->_next_cache_slot + 1) % kNbCacheEntries;
+    }
+
+    /*!
+     *  \brief  obtain the number of keys
+     */
+    inline uint64_t size() const { return this->_nb_keys; }
+
+    /*!
+     *  \brief  remove all keys
+     */
+    inline void clear(){
+        for(block_t *block : this->_blocks){ delete block; }
+        this->_blocks.clear();
+        this->_fences.clear();
+        this->_nb_keys = 0;
+        this->__clear_cache();
+    }
+
+    /*!
+     *  \brief  iterate all key-value pairs in ascending order of keys
+     *  \param  func    the function to be invoked on each pair
+     */
+    template<typename T_Func>
+    inline void for_each(T_Func&& func) const {
+        uint32_t i;
+        for(const block_t *block : this->_blocks){
+            for(i=0; i<block->nb_keys; i++){ func(block->keys[i], block->values[i]); }
+        }
+    }
+
+ private:
+    typedef struct block {
+        uint64_t keys[kBlockCapacity];
+        T_Value *values[kBlockCapacity];
+        uint32_t nb_keys;
+        block() : nb_keys(0) {}
+    } block_t;
+
+    typedef struct cache_entry {
+        uint64_t base;
+        uint64_t end;
+        T_Value *value;
+    } cache_entry_t;
+
+    /*!
+     *  \brief  locate the block that might contain the given key
+     *  \return index of the block, UINT64_MAX for the key is smaller than all keys
+     */
+    inline uint64_t __locate_block(uint64_t key) const {
+        uint64_t bid = std::upper_bound(this->_fences.begin(), this->_fences.end(), key) - this->_fences.begin();
+        return bid == 0 ? UINT64_MAX : bid - 1;
+    }
+
+    /*!
+     *  \brief  obtain the smallest key that is larger than the given key
+     *  \return the found key, UINT64_MAX for no key is larger than the given key
+     */
+    inline uint64_t __successor(uint64_t key) const {
+        const block_t *block;
+        uint64_t bid;
+        uint32_t pos;
+
+        bid = this->__locate_block(key);
+        if(bid == UINT64_MAX){ return this->_fences.empty() ? UINT64_MAX : this->_fences[0]; }
+        block = this->_blocks[bid];
+        pos = std::upper_bound(block->keys, block->keys + block->nb_keys, key) - block->keys;
+        if(pos < block->nb_keys){ return block->keys[pos]; }
+        return bid + 1 < this->_fences.size() ? this->_fences[bid + 1] : UINT64_MAX;
+    }
+
+    /*!
+     *  \brief  split a full block into two halves
+     *  \param  bid index of the block
+     */
+    inline void __split_block(uint64_t bid){
+        block_t *block = this->_blocks[bid], *new_block;
+        const uint32_t half = kBlockCapacity / 2;
+
+        new_block = new block_t();
+        memcpy(new_block->keys, &block->keys[half], (block->nb_keys - half) * sizeof(uint64_t));
+        memcpy(new_block->values, &block->values[half], (block->nb_keys - half) * sizeof(T_Value*));
+        new_block->nb_keys = block->nb_keys - half;
+        block->nb_keys = half;
+
+        this->_blocks.insert(this->_blocks.begin() + bid + 1, new_block);
+        this->_fences.insert(this->_fences.begin() + bid + 1, new_block->keys[0]);
+    }
+
+    /*!
+     *  \brief  merge a sparse block with its next block, to keep blocks dense after erasing
+     *  \param  bid index of the block
+     */
+    inline void __try_merge_block(uint64_t bid){
+        block_t *block, *next;
+
+        if(this->_blocks[bid]->nb_keys >= kBlockCapacity / 4){ return; }
+        if(bid + 1 >= this->_blocks.size()){
+            if(bid == 0){ return; }
+            bid -= 1;
+        }
+        block = this->_blocks[bid];
+        next = this->_blocks[bid + 1];
+        if(block->nb_keys + next->nb_keys > kBlockCapacity / 2){ return; }
+
+        memcpy(&block->keys[block->nb_keys], next->keys, next->nb_keys * sizeof(uint64_t));
+        memcpy(&block->values[block->nb_keys], next->values, next->nb_keys * sizeof(T_Value*));
+        block->nb_keys += next->nb_keys;
+        delete next;
+        this->_blocks.erase(this->_blocks.begin() + bid + 1);
+        this->_fences.erase(this->_fences.begin() + bid + 1);
+    }
+
+    /*!
+     *  \brief  invalidate cached ranges that a newly inserted key falls in, as lookups within
+     *          those ranges might now be resolved to the new key
+     */
+    inline void __invalidate_cache_on_insert(uint64_t key){
+        uint32_t i;
+        for(i=0; i<kNbCacheEntries; i++){
+            if(this->_cache[i].base <= key && key < this->_cache[i].end){ this->__reset_cache_entry(i); }
+        }
+    }
+
+    /*!
+     *  \brief  invalidate cached range of an erased key
+     */
+    inline void __invalidate_cache_on_erase(uint64_t key){
+        uint32_t i;
+        for(i=0; i<kNbCacheEntries; i++){
+            if(this->_cache[i].base == key && this->_cache[i].end > key){ this->__reset_cache_entry(i); }
+        }
+    }
+
+    inline void __reset_cache_entry(uint32_t i){
+        this->_cache[i].base = 0;
+        this->_cache[i].end = 0;
+        this->_cache[i].value = nullptr;
+    }
+
+    inline void __clear_cache(){
+        uint32_t i;
+        for(i=0; i<kNbCacheEntries; i++){ this->__reset_cache_entry(i); }
+    }
+
+    // fence keys, i.e., the first key of each block
+    std::vector<uint64_t> _fences;
+
+    // sorted blocks of keys
+    std::vector<block_t*> _blocks;
+
+    // number of keys
+    uint64_t _nb_keys;
+
+    // last-hit cache, replaced in round-robin
+    cache_entry_t _cache[kNbCacheEntries];
+    uint32_t _next_cache_slot;
+};
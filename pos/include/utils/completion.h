@@ -0,0 +1,260 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <algorithm>
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "pos/include/common.h"
+#include "pos/include/utils/timer.h"
+#include "pos/include/utils/wait_event.h"
+
+
+/*!
+ *  \brief  statistics of waiting completions, only updated by the waiting thread
+ */
+typedef struct pos_completion_stat {
+    // latency histogram: each power of two is split into kNbSubBuckets linear buckets,
+    // so a percentile is reported with an error below 1/kNbSubBuckets
+    static constexpr uint32_t kNbSubBucketsShift = 2;
+    static constexpr uint32_t kNbSubBuckets = 1u << kNbSubBucketsShift;
+    static constexpr uint32_t kNbBuckets = 64 * kNbSubBuckets;
+
+    // number of waits, and how they ended
+    uint64_t nb_waits;
+    uint64_t nb_spin_wakeups;
+    uint64_t nb_yield_wakeups;
+    uint64_t nb_park_wakeups;
+
+    // round-trip latencies (ticks)
+    uint64_t nb_latencies;
+    uint64_t total_latency_ticks;
+    uint64_t max_latency_ticks;
+    uint64_t latency_hist[kNbBuckets];
+
+    pos_completion_stat()
+        :   nb_waits(0), nb_spin_wakeups(0), nb_yield_wakeups(0), nb_park_wakeups(0),
+            nb_latencies(0), total_latency_ticks(0), max_latency_ticks(0), latency_hist{0} {}
+} pos_completion_stat_t;
+
+
+/*!
+ *  \brief  waiting a single completion word (e.g., of a WQE) to be signaled by another thread,
+ *          which spins briefly, then yields, then parks on the word itself (futex)
+ *  \note   the word is owned by the object to be completed, and is only waited by one thread;
+ *          the futex syscall is only issued by the signaler when the waiter is parked
+ *  \note   usage:
+ *              POSUtilCompletion::reset(word);     // before publishing the object
+ *              ... the completer: POSUtilCompletion::signal(word);
+ *              ... the waiter: completion.wait(word);
+ */
+class POSUtilCompletion {
+ public:
+    POSUtilCompletion()
+        :   _spin_ticks(0), _yield_ticks(0), _park_timeout_us(POSUtilWaitEvent::kDefaultParkTimeoutUs) {}
+    ~POSUtilCompletion() = default;
+
+    // states of the completion word
+    static constexpr uint32_t kPending = 0;
+    static constexpr uint32_t kPendingParked = 1;
+    static constexpr uint32_t kCompleted = 2;
+
+    /*!
+     *  \brief  setup the waiting budgets
+     *  \param  spin_ticks      ticks to spin before yielding
+     *  \param  yield_ticks     ticks to yield before parking
+     *  \param  park_timeout_us maximum duration (us) of a single park, after which the word is rechecked
+     */
+    inline void set_budget(uint64_t spin_ticks, uint64_t yield_ticks, uint64_t park_timeout_us){
+        this->_spin_ticks = spin_ticks;
+        this->_yield_ticks = yield_ticks;
+        this->_park_timeout_us = std::max<uint64_t>(park_timeout_us, 1);
+    }
+
+    /*!
+     *  \brief  reset the completion word as pending
+     */
+    static inline void reset(std::atomic<uint32_t>& word){ word.store(kPending, std::memory_order_relaxed); }
+
+    /*!
+     *  \brief  mark the completion word as completed, and wake up the waiter if it's parked
+     *  \note   the object owning the word might be released by the waiter right after, so the signaler
+     *          shouldn't access the object afterwards unless it holds a reference to the object
+     */
+    static inline void signal(std::atomic<uint32_t>& word){
+        if(unlikely(word.exchange(kCompleted, std::memory_order_acq_rel) == kPendingParked)){
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+    }
+
+    /*!
+     *  \brief  check whether the completion word is completed
+     */
+    static inline bool is_completed(const std::atomic<uint32_t>& word){
+        return word.load(std::memory_order_acquire) == kCompleted;
+    }
+
+    /*!
+     *  \brief  wait until the completion word is completed
+     *  \param  word    the completion word
+     */
+    inline void wait(std::atomic<uint32_t>& word){
+        uint64_t s_tick, tick;
+        uint32_t expected;
+        struct timespec timeout;
+
+        this->_stat.nb_waits += 1;
+        s_tick = POSUtilTscTimer::get_tsc();
+
+        // phase 1: spin
+        do {
+            if(POSUtilCompletion::is_completed(word)){
+                this->_stat.nb_spin_wakeups += 1;
+                return;
+            }
+            __builtin_ia32_pause();
+            tick = POSUtilTscTimer::get_tsc();
+        } while(tick - s_tick < this->_spin_ticks);
+
+        // phase 2: yield
+        while(tick - s_tick < this->_spin_ticks + this->_yield_ticks){
+            if(POSUtilCompletion::is_completed(word)){
+                this->_stat.nb_yield_wakeups += 1;
+                return;
+            }
+            std::this_thread::yield();
+            tick = POSUtilTscTimer::get_tsc();
+        }
+
+        // phase 3: park, the signaler wakes us once it sees the parked state
+        timeout.tv_sec = this->_park_timeout_us / 1000000;
+        timeout.tv_nsec = (this->_park_timeout_us % 1000000) * 1000;
+        while(true){
+            expected = kPending;
+            if(!word.compare_exchange_strong(expected, kPendingParked, std::memory_order_acq_rel)
+                && expected == kCompleted
+            ){
+                break;
+            }
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, kPendingParked, &timeout, nullptr, 0);
+            if(POSUtilCompletion::is_completed(word)){ break; }
+        }
+        this->_stat.nb_park_wakeups += 1;
+    }
+
+    /*!
+     *  \brief  record the round-trip latency of a completion
+     *  \param  ticks   the latency (ticks)
+     */
+    inline void record_latency(uint64_t ticks){
+        this->_stat.nb_latencies += 1;
+        this->_stat.total_latency_ticks += ticks;
+        this->_stat.max_latency_ticks = std::max(this->_stat.max_latency_ticks, ticks);
+        this->_stat.latency_hist[POSUtilCompletion::__bucket_of(ticks)] += 1;
+    }
+
+    /*!
+     *  \brief  obtain the statistics, should be invoked by the waiting thread or after it stopped
+     */
+    inline const pos_completion_stat_t& get_stat() const { return this->_stat; }
+
+    /*!
+     *  \brief  obtain the latency (ticks) at the given percentile
+     *  \param  pct the percentile, within [0, 100]
+     *  \return the upper bound of the bucket containing the percentile
+     */
+    inline uint64_t get_percentile_ticks(double pct) const {
+        uint64_t target, count = 0;
+        uint32_t i;
+
+        if(this->_stat.nb_latencies == 0){ return 0; }
+        target = std::max<uint64_t>(1, static_cast<uint64_t>(pct / 100.0 * this->_stat.nb_latencies + 0.5));
+        for(i=0; i<pos_completion_stat_t::kNbBuckets; i++){
+            count += this->_stat.latency_hist[i];
+            if(count >= target){
+                return std::min(POSUtilCompletion::__bucket_upper(i), this->_stat.max_latency_ticks);
+            }
+        }
+        return this->_stat.max_latency_ticks;
+    }
+
+    /*!
+     *  \brief  format the statistics
+     *  \param  tsc_timer   timer to translate ticks to duration
+     *  \return the formatted string
+     */
+    inline std::string str(POSUtilTscTimer& tsc_timer) const {
+        auto __us = [&](uint64_t ticks) -> std::string {
+            return std::to_string(static_cast<uint64_t>(tsc_timer.tick_to_us(ticks)));
+        };
+
+        return    "waits("              + std::to_string(this->_stat.nb_waits)
+                + "), spin_wakeups("    + std::to_string(this->_stat.nb_spin_wakeups)
+                + "), yield_wakeups("   + std::to_string(this->_stat.nb_yield_wakeups)
+                + "), park_wakeups("    + std::to_string(this->_stat.nb_park_wakeups)
+                + "), avg_us("
+                + __us(this->_stat.nb_latencies > 0 ? this->_stat.total_latency_ticks / this->_stat.nb_latencies : 0)
+                + "), p50_us("          + __us(this->get_percentile_ticks(50))
+                + "), p90_us("          + __us(this->get_percentile_ticks(90))
+                + "), p99_us("          + __us(this->get_percentile_ticks(99))
+                + "), p999_us("         + __us(this->get_percentile_ticks(99.9))
+                + "), max_us("          + __us(this->_stat.max_latency_ticks)
+                + ")";
+    }
+
+ private:
+    /*!
+     *  \brief  obtain the histogram bucket of a latency
+     */
+    static inline uint32_t __bucket_of(uint64_t ticks){
+        uint32_t msb;
+
+        if(ticks < pos_completion_stat_t::kNbSubBuckets){ return ticks; }
+        msb = 63 - __builtin_clzll(ticks);
+        return    (msb - pos_completion_stat_t::kNbSubBucketsShift + 1) * pos_completion_stat_t::kNbSubBuckets
+                + ((ticks >> (msb - pos_completion_stat_t::kNbSubBucketsShift)) & (pos_completion_stat_t::kNbSubBuckets - 1));
+    }
+
+    /*!
+     *  \brief  obtain the (inclusive) upper bound of a histogram bucket
+     */
+    static inline uint64_t __bucket_upper(uint32_t bucket){
+        uint32_t shift;
+
+        if(bucket < pos_completion_stat_t::kNbSubBuckets){ return bucket; }
+        shift = bucket / pos_completion_stat_t::kNbSubBuckets - 1;
+        return    ((static_cast<uint64_t>(pos_completion_stat_t::kNbSubBuckets + bucket % pos_completion_stat_t::kNbSubBuckets + 1)) << shift)
+                - 1;
+    }
+
+    // budgets of spinning / yielding (ticks) and the park timeout (us)
+    uint64_t _spin_ticks;
+    uint64_t _yield_ticks;
+    uint64_t _park_timeout_us;
+
+    // statistics of the waits
+    pos_completion_stat_t _stat;
+};
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+#include <cxxabi.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+
+
+/*!
+ *  \brief  kind of a function parameter, regarding whether it's a pointer and the constness of the pointee
+ */
+enum pos_demangle_param_kind_t : uint8_t {
+    kPOS_DemangleParam_Value = 0,
+    kPOS_DemangleParam_ConstPointer,
+    kPOS_DemangleParam_Pointer
+};
+
+
+/*!
+ *  \brief  in-process demangling of Itanium C++ ABI names (e.g., CUDA kernels), and lightweight
+ *          classification of the parameters within the demangled prototype
+ */
+class POSUtil_Demangle {
+ public:
+    /*!
+     *  \brief  demangle a mangled name
+     *  \example    mangled:    _Z8kernel_1PKfPfS1_S1_i
+     *              demangled:  kernel_1(float const*, float*, float*, float*, int)
+     *  \param  mangled     the mangled name
+     *  \param  demangled   the demangled name
+     *  \return POS_SUCCESS for successfully demangled;
+     *          POS_FAILED_INVALID_INPUT for not a valid mangled name
+     */
+    static pos_retval_t demangle(const std::string& mangled, std::string& demangled){
+        pos_retval_t retval = POS_SUCCESS;
+        char *buffer;
+        int status;
+
+        demangled.clear();
+
+        buffer = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+        if(unlikely(status != 0 || buffer == nullptr)){
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        demangled = buffer;
+
+    exit:
+        if(buffer != nullptr){ free(buffer); }
+        return retval;
+    }
+
+
+    /*!
+     *  \brief  split the parameter list of a demangled function prototype
+     *  \example    void at::native::foo<float, 4>(float const*, at::Array<char*, 2>, int)
+     *              -> { "float const*", "at::Array<char*, 2>", "int" }
+     *  \param  prototype   the demangled prototype
+     *  \param  params      the split parameters
+     *  \return POS_SUCCESS for successfully split;
+     *          POS_FAILED_INVALID_INPUT for no parameter list or unbalanced brackets within the prototype
+     */
+    static pos_retval_t split_params(const std::string& prototype, std::vector<std::string>& params){
+        pos_retval_t retval = POS_SUCCESS;
+        int64_t i, end, begin, depth;
+        std::string param;
+
+        params.clear();
+
+        // skip suffixes like " [clone .cold]"
+        end = POSUtil_Demangle::__rtrim(prototype, prototype.size());
+        while(end > 0 && prototype[end-1] == ']'){
+            depth = 0;
+            for(i=end-1; i>=0; i--){
+                if(prototype[i] == ']'){ depth++; }
+                else if(prototype[i] == '[' && --depth == 0){ break; }
+            }
+            if(unlikely(i < 0)){ retval = POS_FAILED_INVALID_INPUT; goto exit; }
+            end = POSUtil_Demangle::__rtrim(prototype, i);
+        }
+        if(unlikely(end == 0 || prototype[end-1] != ')')){
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+
+        // match the parameter list backward
+        depth = 0;
+        for(begin=end-1; begin>=0; begin--){
+            if(POSUtil_Demangle::__is_close(prototype[begin])){ depth++; }
+            else if(POSUtil_Demangle::__is_open(prototype[begin]) && --depth == 0){ break; }
+        }
+        if(unlikely(begin < 0 || prototype[begin] != '(')){
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+
+        // split by top-level commas
+        depth = 0;
+        for(i=begin+1; i<end-1; i++){
+            if(POSUtil_Demangle::__is_open(prototype[i])){ depth++; }
+            else if(POSUtil_Demangle::__is_close(prototype[i])){ depth--; }
+            if(unlikely(depth < 0)){ retval = POS_FAILED_INVALID_INPUT; goto exit; }
+            if(depth == 0 && prototype[i] == ','){
+                params.push_back(POSUtil_Demangle::__trim(param));
+                param.clear();
+            } else {
+                param.push_back(prototype[i]);
+            }
+        }
+        if(unlikely(depth != 0)){ retval = POS_FAILED_INVALID_INPUT; goto exit; }
+
+        param = POSUtil_Demangle::__trim(param);
+        if(param.size() > 0){
+            params.push_back(param);
+        } else if(unlikely(params.size() > 0)){
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(params.size() == 1 && params[0] == "void"){ params.clear(); }
+
+    exit:
+        return retval;
+    }
+
+
+    /*!
+     *  \brief  classify a parameter by its declarator, i.e., whether it's a pointer at the top level
+     *          (e.g., "float const*", "at::Foo<float*>*", "void (*)(int)"), and whether the pointee
+     *          is const qualified (e.g., "float const*" or "const float *", but not "float const**")
+     *  \note   only the top-level declarator matters, pointers nested in template arguments or
+     *          within a struct passed by value are not pointer parameters
+     *  \param  param   the demangled parameter type
+     *  \param  kind    the resulted kind of the parameter
+     *  \return POS_SUCCESS for successfully classified;
+     *          POS_FAILED_INVALID_INPUT for declarators that can't be classified (e.g., unbalanced brackets)
+     */
+    static pos_retval_t classify_param(const std::string& param, pos_demangle_param_kind_t& kind){
+        pos_retval_t retval = POS_SUCCESS;
+        std::string type, pointee, group;
+        int64_t i, end, depth, group_begin = -1, group_end = -1;
+
+        type = POSUtil_Demangle::__strip_top_level_qualifiers(param);
+
+        // locate the top-level parenthesized group, e.g., "(*)" within "void (*)(int)"
+        depth = 0;
+        for(i=0; i<(int64_t)type.size(); i++){
+            if(type.compare(i, kAnonymousNamespace.size(), kAnonymousNamespace) == 0){
+                i += kAnonymousNamespace.size() - 1;
+                continue;
+            }
+            if(POSUtil_Demangle::__is_open(type[i])){
+                if(depth == 0 && type[i] == '(' && group_end < 0){ group_begin = i; }
+                depth++;
+            } else if(POSUtil_Demangle::__is_close(type[i])){
+                depth--;
+                if(depth == 0 && type[i] == ')' && group_end < 0 && group_begin >= 0){
+                    // parameter list of the enclosing function of a local entity, e.g., "foo(int)::{lambda(int)#1}"
+                    if(type.compare(i + 1, 2, "::") == 0){
+                        group_begin = -1;
+                    } else {
+                        group_end = i;
+                    }
+                }
+            }
+            if(unlikely(depth < 0)){ retval = POS_FAILED_INVALID_INPUT; goto exit; }
+        }
+        if(unlikely(depth != 0)){ retval = POS_FAILED_INVALID_INPUT; goto exit; }
+
+        // pointer to function / array, e.g., "void (*)(int)", "float const (*) [4]"
+        if(group_begin >= 0){
+            group = POSUtil_Demangle::__trim(type.substr(group_begin + 1, group_end - group_begin - 1));
+            if(group.size() > 0 && group[0] == '*'){
+                pointee = POSUtil_Demangle::__trim(type.substr(0, group_begin));
+                kind = (POSUtil_Demangle::__trim(type.substr(group_end + 1)).compare(0, 1, "(") != 0
+                            && POSUtil_Demangle::__is_const(pointee))
+                        ? kPOS_DemangleParam_ConstPointer : kPOS_DemangleParam_Pointer;
+            } else if(group.size() > 0 && group[0] == '&'){
+                kind = kPOS_DemangleParam_Value;
+            } else {
+                retval = POS_FAILED_INVALID_INPUT;
+            }
+            goto exit;
+        }
+
+        end = type.size();
+        if(end > 0 && type[end-1] == '*'){
+            pointee = POSUtil_Demangle::__trim(type.substr(0, end-1));
+            kind = POSUtil_Demangle::__is_const(pointee) ? kPOS_DemangleParam_ConstPointer : kPOS_DemangleParam_Pointer;
+        } else {
+            kind = kPOS_DemangleParam_Value;
+        }
+
+    exit:
+        return retval;
+    }
+
+ private:
+    static inline const std::string kAnonymousNamespace = "(anonymous namespace)";
+
+    static inline bool __is_open(char c){ return c == '(' || c == '<' || c == '[' || c == '{'; }
+    static inline bool __is_close(char c){ return c == ')' || c == '>' || c == ']' || c == '}'; }
+    static inline bool __is_ident(char c){ return isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+    static inline int64_t __rtrim(const std::string& str, int64_t end){
+        while(end > 0 && isspace(static_cast<unsigned char>(str[end-1]))){ end--; }
+        return end;
+    }
+
+    static inline std::string __trim(const std::string& str){
+        uint64_t begin = 0, end = str.size();
+        while(begin < end && isspace(static_cast<unsigned char>(str[begin]))){ begin++; }
+        while(end > begin && isspace(static_cast<unsigned char>(str[end-1]))){ end--; }
+        return str.substr(begin, end - begin);
+    }
+
+    /*!
+     *  \brief  check whether the type ends with the given keyword as a separated token
+     */
+    static inline bool __ends_with_token(const std::string& type, const char *token){
+        uint64_t len = strlen(token);
+        if(type.size() < len || type.compare(type.size() - len, len, token) != 0){ return false; }
+        return type.size() == len || !POSUtil_Demangle::__is_ident(type[type.size() - len - 1]);
+    }
+
+    /*!
+     *  \brief  remove qualifiers of the parameter itself, e.g., "float* __restrict" -> "float*"
+     */
+    static inline std::string __strip_top_level_qualifiers(const std::string& param){
+        std::string type = POSUtil_Demangle::__trim(param);
+        bool stripped = true;
+
+        while(stripped){
+            stripped = false;
+            for(const char *qualifier : { "const", "volatile", "__restrict__", "__restrict", "restrict" }){
+                if(POSUtil_Demangle::__ends_with_token(type, qualifier)){
+                    type = POSUtil_Demangle::__trim(type.substr(0, type.size() - strlen(qualifier)));
+                    stripped = true;
+                }
+            }
+        }
+
+        return type;
+    }
+
+    /*!
+     *  \brief  check whether a (pointee) type is const qualified at the top level,
+     *          i.e., "float const", "const float", but not "float const*"
+     */
+    static inline bool __is_const(const std::string& type){
+        std::string t = type;
+        bool stripped = true;
+
+        while(stripped){
+            stripped = false;
+            for(const char *qualifier : { "const", "volatile", "__restrict__", "__restrict", "restrict" }){
+                if(POSUtil_Demangle::__ends_with_token(t, qualifier)){
+                    if(strcmp(qualifier, "const") == 0){ return true; }
+                    t = POSUtil_Demangle::__trim(t.substr(0, t.size() - strlen(qualifier)));
+                    stripped = true;
+                }
+            }
+        }
+        if(t.size() > 0 && (t.back() == '*' || t.back() == '&')){ return false; }
+        return t.compare(0, 6, "const ") == 0 || t.compare(0, 15, "volatile const ") == 0;
+    }
+};
@@ -23,6 +23,10 @@
 
 #define POS_LOCKLESS_QUEUE_LEN  8192
 
+// default / maximum number of elements to be polled / pushed at once by the daemon threads
+#define POS_LOCKLESS_QUEUE_DEFAULT_BATCH_SIZE   64
+#define POS_LOCKLESS_QUEUE_MAX_BATCH_SIZE       4096
+
 /*!
  *  \brief  lock-free queue
  *  \tparam T   elemenet type
@@ -61,6 +65,42 @@ class POSLockFreeQueue {
         }
     }
 
+    /*!
+     *  \brief  append a batch of elements to the tail of the queue
+     *  \note   elements fit into the current ring block are published at once, which saves
+     *          the per-element atomic traffic compared to push
+     *  \param  elements    elements to be appended, in order
+     *  \param  nb_elements number of elements to be appended
+     *  \return number of appended elements
+     */
+    uint64_t enqueue_bulk(const T* elements, uint64_t nb_elements){
+        if(this->_is_enqueue_locked == true){ return 0; }
+        return _q->enqueue_bulk(elements, nb_elements);
+    }
+
+    /*!
+     *  \brief  dequeue a batch of elements from the head of the queue
+     *  \param  elements        caller-provided buffer to store the dequeued elements
+     *  \param  max_nb_elements maximum number of elements to be dequeued (i.e., size of the buffer)
+     *  \return number of dequeued elements, 0 for empty queue
+     */
+    uint64_t dequeue_bulk(T* elements, uint64_t max_nb_elements){
+        if(this->_is_dequeue_locked == true){ return 0; }
+        return _q->try_dequeue_bulk(elements, max_nb_elements);
+    }
+
+    /*!
+     *  \brief  copy a batch of elements from the head of the queue without removing them
+     *  \note   only elements within the front-most ring block are visible, so it might
+     *          return fewer elements than those in the queue
+     *  \param  elements        caller-provided buffer to store the copied elements
+     *  \param  max_nb_elements maximum number of elements to be copied (i.e., size of the buffer)
+     *  \return number of copied elements, 0 for empty queue
+     */
+    uint64_t peek_bulk(T* elements, uint64_t max_nb_elements){
+        return _q->peek_bulk(elements, max_nb_elements);
+    }
+
     /*!
      *  \brief  removes the front element from the queue, if any, without returning it
      *  \return true if an element is successfully removed, false if the queue is empty
@@ -503,6 +503,159 @@ public:
 		return true;
 	}
 	
+	// Enqueues a batch of elements (allocating more memory if necessary),
+	// copying them in order. The elements that fit into the tail block are
+	// published with a single release of the block tail; the remaining ones
+	// take the one-by-one path, which may move to (or allocate) the next block.
+	// Returns the number of enqueued elements, which is only less than count
+	// if memory allocation failed.
+	// Must be called only from the producer thread.
+	size_t enqueue_bulk(T const* elements, size_t count) AE_NO_TSAN
+	{
+		size_t i = 0;
+
+		while (i < count) {
+			Block* tailBlock_ = tailBlock.load();
+			size_t blockFront = tailBlock_->localFront;
+			size_t blockTail = tailBlock_->tail.load();
+
+			size_t nextBlockTail = (blockTail + 1) & tailBlock_->sizeMask;
+			if (nextBlockTail != blockFront || nextBlockTail != (blockFront = tailBlock_->localFront = tailBlock_->front.load())) {
+				fence(memory_order_acquire);
+				// Fill this block as much as possible, then publish all at once
+				do {
+					new (tailBlock_->data + blockTail * sizeof(T)) T(elements[i]);
+					++i;
+					blockTail = nextBlockTail;
+					nextBlockTail = (blockTail + 1) & tailBlock_->sizeMask;
+				} while (i < count && nextBlockTail != blockFront);
+
+				fence(memory_order_release);
+				tailBlock_->tail = blockTail;
+			}
+			else {
+				// Tail block is full, let the regular path advance to the next block
+				if (!inner_enqueue<CanAlloc>(elements[i])) {
+					break;
+				}
+				++i;
+			}
+		}
+
+		return i;
+	}
+
+	// Attempts to dequeue up to max elements into the given buffer, in order.
+	// The elements within a block are consumed with a single release of the
+	// block front. Returns the number of dequeued elements (0 if the queue
+	// appeared empty).
+	// Must be called only from the consumer thread.
+	template<typename U>
+	size_t try_dequeue_bulk(U* results, size_t max) AE_NO_TSAN
+	{
+#ifndef NDEBUG
+		ReentrantGuard guard(this->dequeuing);
+#endif
+		// See try_dequeue() for reasoning
+
+		size_t count = 0;
+
+		while (count < max) {
+			Block* frontBlock_ = frontBlock.load();
+			size_t blockTail = frontBlock_->localTail;
+			size_t blockFront = frontBlock_->front.load();
+
+			if (blockFront != blockTail || blockFront != (blockTail = frontBlock_->localTail = frontBlock_->tail.load())) {
+				fence(memory_order_acquire);
+
+				do {
+					auto element = reinterpret_cast<T*>(frontBlock_->data + blockFront * sizeof(T));
+					results[count++] = std::move(*element);
+					element->~T();
+					blockFront = (blockFront + 1) & frontBlock_->sizeMask;
+				} while (count < max && blockFront != blockTail);
+
+				fence(memory_order_release);
+				frontBlock_->front = blockFront;
+			}
+			else if (frontBlock_ != tailBlock.load()) {
+				fence(memory_order_acquire);
+
+				frontBlock_ = frontBlock.load();
+				blockTail = frontBlock_->localTail = frontBlock_->tail.load();
+				blockFront = frontBlock_->front.load();
+				fence(memory_order_acquire);
+
+				if (blockFront != blockTail) {
+					// The front block isn't empty after all
+					continue;
+				}
+
+				// Front block is empty but there's another block ahead, advance to it;
+				// it's for sure non-empty as the tailBlock is only advanced after being written
+				Block* nextBlock = frontBlock_->next;
+				nextBlock->localTail = nextBlock->tail.load();
+				fence(memory_order_acquire);
+
+				fence(memory_order_release);
+				frontBlock = nextBlock;
+
+				compiler_fence(memory_order_release);
+			}
+			else {
+				// No elements in current block and no other block to advance to
+				break;
+			}
+		}
+
+		return count;
+	}
+
+	// Copies up to max elements from the front of the queue into the given
+	// buffer without removing them, in order. Only the elements within the
+	// front-most non-empty block are visible, so fewer than the queued
+	// elements might be returned. Returns the number of copied elements.
+	// Must be called only from the consumer thread.
+	template<typename U>
+	size_t peek_bulk(U* results, size_t max) const AE_NO_TSAN
+	{
+#ifndef NDEBUG
+		ReentrantGuard guard(this->dequeuing);
+#endif
+		// See try_dequeue() for reasoning
+
+		size_t count = 0;
+		Block* frontBlock_ = frontBlock.load();
+		size_t blockTail = frontBlock_->localTail;
+		size_t blockFront = frontBlock_->front.load();
+
+		if (blockFront == blockTail && blockFront == (blockTail = frontBlock_->localTail = frontBlock_->tail.load())) {
+			if (frontBlock_ == tailBlock.load()) {
+				return 0;
+			}
+			fence(memory_order_acquire);
+			frontBlock_ = frontBlock.load();
+			blockTail = frontBlock_->localTail = frontBlock_->tail.load();
+			blockFront = frontBlock_->front.load();
+			fence(memory_order_acquire);
+
+			if (blockFront == blockTail) {
+				// The front block is drained, peek the next block instead
+				frontBlock_ = frontBlock_->next;
+				blockFront = frontBlock_->front.load();
+				blockTail = frontBlock_->tail.load();
+			}
+		}
+		fence(memory_order_acquire);
+
+		while (count < max && blockFront != blockTail) {
+			results[count++] = *reinterpret_cast<T*>(frontBlock_->data + blockFront * sizeof(T));
+			blockFront = (blockFront + 1) & frontBlock_->sizeMask;
+		}
+
+		return count;
+	}
+
 	// Returns the approximate number of items currently in the queue.
 	// Safe to call from both the producer and consumer threads.
 	inline size_t size_approx() const AE_NO_TSAN
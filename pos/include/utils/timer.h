@@ -190,6 +190,14 @@ class POSUtilTscTimer {
         return (double)(ticks) / (double) this->_tsc_freq * (double)1000000.0f;
     }
 
+    /*!
+     *  \brief  obtain the frequency of TSC register
+     *  \return frequency of TSC register (ticks per second)
+     */
+    inline double get_tsc_freq() const {
+        return this->_tsc_freq;
+    }
+
  private:
     // frequency of TSC register
     double _tsc_freq_g;
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <algorithm>
+
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "pos/include/common.h"
+#include "pos/include/utils/timer.h"
+
+
+/*!
+ *  \brief  statistics of a wait event, only updated by the waiting thread
+ */
+typedef struct pos_wait_event_stat {
+    // number of waits, and how they ended
+    uint64_t nb_waits;
+    uint64_t nb_spin_wakeups;
+    uint64_t nb_yield_wakeups;
+    uint64_t nb_park_wakeups;
+    uint64_t nb_park_timeouts;
+
+    // latency from the last notification to the wakeup of a parked waiter (ticks)
+    uint64_t park_wake_latency_ticks;
+    uint64_t max_park_wake_latency_ticks;
+
+    pos_wait_event_stat()
+        :   nb_waits(0), nb_spin_wakeups(0), nb_yield_wakeups(0), nb_park_wakeups(0), nb_park_timeouts(0),
+            park_wake_latency_ticks(0), max_park_wake_latency_ticks(0) {}
+} pos_wait_event_stat_t;
+
+
+/*!
+ *  \brief  event for threads to wait on, which spins briefly, then yields,
+ *          then parks on a futex until a producer notifies or the park timeout expires
+ *  \note   usage on the waiting side:
+ *              seq = event.prepare();
+ *              ... poll the queues, and if nothing is obtained ...
+ *              event.wait(seq);
+ *          any notification after prepare() makes wait() return immediately, so no
+ *          notification would be missed between polling and waiting
+ *  \note   the park timeout bounds the waiting of conditions that aren't notified
+ *          (e.g., stop flags, status changed by other threads)
+ */
+class POSUtilWaitEvent {
+ public:
+    POSUtilWaitEvent()
+        :   _seq(0), _nb_parked(0), _notify_tick(0), _chained(nullptr),
+            _spin_ticks(0), _yield_ticks(0), _park_timeout_us(kDefaultParkTimeoutUs) {}
+    ~POSUtilWaitEvent() = default;
+
+    // default budgets of spinning / yielding before parking, and the park timeout (us)
+    static constexpr uint64_t kDefaultSpinUs = 50;
+    static constexpr uint64_t kDefaultYieldUs = 200;
+    static constexpr uint64_t kDefaultParkTimeoutUs = 1000;
+
+    // maximum configurable budget / park timeout (us)
+    static constexpr uint64_t kMaxBudgetUs = 1000000;
+
+    /*!
+     *  \brief  setup the waiting budgets
+     *  \note   should be invoked before the waiting thread starts to wait
+     *  \param  spin_ticks      ticks to spin before yielding
+     *  \param  yield_ticks     ticks to yield before parking
+     *  \param  park_timeout_us maximum duration (us) of a single park
+     */
+    inline void set_budget(uint64_t spin_ticks, uint64_t yield_ticks, uint64_t park_timeout_us){
+        this->_spin_ticks = spin_ticks;
+        this->_yield_ticks = yield_ticks;
+        this->_park_timeout_us = std::max<uint64_t>(park_timeout_us, 1);
+    }
+
+    /*!
+     *  \brief  chain another event to this event, so that notifying this event also notifies the chained one
+     *  \note   used when the consumer waits on a shared event (e.g., threads of a daemon pool)
+     *  \param  event   the event to be chained, nullptr for unchaining
+     */
+    inline void set_chained(POSUtilWaitEvent *event){
+        this->_chained.store(event, std::memory_order_release);
+    }
+
+    /*!
+     *  \brief  notify the waiting thread, invoked by producers
+     *  \note   the futex syscall is only issued when the waiter is parked
+     */
+    inline void notify(){
+        POSUtilWaitEvent *chained;
+
+        this->_notify_tick.store(POSUtilTscTimer::get_tsc(), std::memory_order_relaxed);
+        this->_seq.fetch_add(1, std::memory_order_seq_cst);
+        if(unlikely(this->_nb_parked.load(std::memory_order_seq_cst) > 0)){
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->_seq), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        }
+
+        chained = this->_chained.load(std::memory_order_acquire);
+        if(chained != nullptr){ chained->notify(); }
+    }
+
+    /*!
+     *  \brief  obtain the sequence before checking the waiting condition
+     *  \return the sequence to be passed to wait
+     */
+    inline uint32_t prepare() const { return this->_seq.load(std::memory_order_acquire); }
+
+    /*!
+     *  \brief  wait until notified after the given sequence, or the park timeout expires
+     *  \param  seq the sequence obtained by prepare
+     */
+    inline void wait(uint32_t seq){ this->wait(seq, this->_stat); }
+
+    /*!
+     *  \brief  wait until notified after the given sequence, or the park timeout expires
+     *  \note   used when multiple threads wait on the same event, each records its own statistics
+     *  \param  seq     the sequence obtained by prepare
+     *  \param  stat    statistics to record this wait
+     */
+    inline void wait(uint32_t seq, pos_wait_event_stat_t& stat){
+        uint64_t s_tick, tick, latency;
+        struct timespec timeout;
+
+        stat.nb_waits += 1;
+        s_tick = POSUtilTscTimer::get_tsc();
+
+        // phase 1: spin
+        do {
+            if(this->_seq.load(std::memory_order_acquire) != seq){
+                stat.nb_spin_wakeups += 1;
+                return;
+            }
+            __builtin_ia32_pause();
+            tick = POSUtilTscTimer::get_tsc();
+        } while(tick - s_tick < this->_spin_ticks);
+
+        // phase 2: yield
+        while(tick - s_tick < this->_spin_ticks + this->_yield_ticks){
+            if(this->_seq.load(std::memory_order_acquire) != seq){
+                stat.nb_yield_wakeups += 1;
+                return;
+            }
+            std::this_thread::yield();
+            tick = POSUtilTscTimer::get_tsc();
+        }
+
+        // phase 3: park
+        timeout.tv_sec = this->_park_timeout_us / 1000000;
+        timeout.tv_nsec = (this->_park_timeout_us % 1000000) * 1000;
+        this->_nb_parked.fetch_add(1, std::memory_order_seq_cst);
+        if(this->_seq.load(std::memory_order_seq_cst) == seq){
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->_seq), FUTEX_WAIT_PRIVATE, seq, &timeout, nullptr, 0);
+        }
+        this->_nb_parked.fetch_sub(1, std::memory_order_relaxed);
+
+        if(this->_seq.load(std::memory_order_acquire) != seq){
+            tick = POSUtilTscTimer::get_tsc();
+            latency = tick - std::min(tick, this->_notify_tick.load(std::memory_order_relaxed));
+            stat.nb_park_wakeups += 1;
+            stat.park_wake_latency_ticks += latency;
+            stat.max_park_wake_latency_ticks = std::max(stat.max_park_wake_latency_ticks, latency);
+        } else {
+            stat.nb_park_timeouts += 1;
+        }
+    }
+
+    /*!
+     *  \brief  obtain the statistics of this event
+     *  \note   should be invoked by the waiting thread, or after it stopped
+     */
+    inline const pos_wait_event_stat_t& get_stat() const { return this->_stat; }
+
+    /*!
+     *  \brief  format the statistics of this event
+     *  \param  tsc_timer   timer to translate ticks to duration
+     *  \return the formatted string
+     */
+    inline std::string str(POSUtilTscTimer& tsc_timer) const { return POSUtilWaitEvent::str(this->_stat, tsc_timer); }
+
+    /*!
+     *  \brief  format the given statistics of waits
+     *  \param  stat        the statistics to be formatted
+     *  \param  tsc_timer   timer to translate ticks to duration
+     *  \return the formatted string
+     */
+    static inline std::string str(const pos_wait_event_stat_t& stat, POSUtilTscTimer& tsc_timer){
+        return    "waits("              + std::to_string(stat.nb_waits)
+                + "), spin_wakeups("    + std::to_string(stat.nb_spin_wakeups)
+                + "), yield_wakeups("   + std::to_string(stat.nb_yield_wakeups)
+                + "), park_wakeups("    + std::to_string(stat.nb_park_wakeups)
+                + "), park_timeouts("   + std::to_string(stat.nb_park_timeouts)
+                + "), avg_park_wake_latency_us("
+                + std::to_string(
+                    stat.nb_park_wakeups > 0
+                    ? (uint64_t)(tsc_timer.tick_to_us(stat.park_wake_latency_ticks / stat.nb_park_wakeups))
+                    : 0
+                )
+                + "), max_park_wake_latency_us("
+                + std::to_string((uint64_t)(tsc_timer.tick_to_us(stat.max_park_wake_latency_ticks)))
+                + ")";
+    }
+
+ private:
+    // sequence of notifications, also the futex word
+    std::atomic<uint32_t> _seq;
+
+    // number of parked waiting threads
+    std::atomic<uint32_t> _nb_parked;
+
+    // tick of the last notification
+    std::atomic<uint64_t> _notify_tick;
+
+    // event to be notified together with this event
+    std::atomic<POSUtilWaitEvent*> _chained;
+
+    // budgets of spinning / yielding (ticks) and the park timeout (us)
+    uint64_t _spin_ticks;
+    uint64_t _yield_ticks;
+    uint64_t _park_timeout_us;
+
+    // statistics of this event
+    pos_wait_event_stat_t _stat;
+};
@@ -28,12 +28,19 @@
 #include "pos/include/log.h"
 #include "pos/include/trace.h"
 #include "pos/include/metrics.h"
+#include "pos/include/api_context.h"
+#include "pos/include/checkpoint_cost_model.h"
+#include "pos/include/checkpoint_scheduler.h"
+#include "pos/include/checkpoint_commit_engine.h"
+#include "pos/include/checkpoint_throttle.h"
+#include "pos/include/daemon_pool.h"
 
 
 // forward declaration
 class POSClient;
 class POSHandle;
 class POSWorkspace;
+class POSWorker;
 typedef struct POSAPIMeta POSAPIMeta_t;
 typedef struct POSAPIContext_QE POSAPIContext_QE_t;
 typedef struct POSCommand_QE POSCommand_QE_t;
@@ -73,6 +80,77 @@ typedef struct checkpoint_sync_cxt {
 
 #if POS_CONF_EVAL_CkptOptLevel == 2
 
+/*!
+ *  \brief  commit backend of the worker, which adds & commits stateful handles on the lanes
+ *          of the commit engine within the overlapped checkpoint thread
+ *  \note   the states are committed into the pinned host-side checkpoint slots of each handle
+ *          directly, so the lanes need no staging buffer
+ */
+class POSCheckpointCommitBackend_Worker : public POSCheckpointCommitBackend {
+ public:
+    /*!
+     *  \brief  constructor
+     *  \param  worker  the worker that owns this backend
+     */
+    POSCheckpointCommitBackend_Worker(POSWorker *worker);
+    ~POSCheckpointCommitBackend_Worker() = default;
+
+    /*!
+     *  \brief  statistics of adding states to the on-device cache within a lane
+     *  \note   each lane only updates its own entry, which is folded by the checkpoint thread after
+     *          each round, so no lock is needed
+     */
+    typedef struct lane_add_stat {
+        uint64_t nb_done;
+        uint64_t done_bytes;
+        uint64_t done_ticks;
+        uint64_t nb_blocked;
+        uint64_t blocked_ticks;
+    } lane_add_stat_t;
+    lane_add_stat_t lane_add_stats[POSCheckpointCommitEngine::kMaxNbLanes];
+
+    // ticks of each lane blocked by the commit rate limiter
+    uint64_t lane_throttled_ticks[POSCheckpointCommitEngine::kMaxNbLanes];
+
+    /*!
+     *  \brief  reset the statistics of all lanes
+     */
+    inline void reset_stats(){
+        memset(this->lane_add_stats, 0, sizeof(this->lane_add_stats));
+        memset(this->lane_throttled_ticks, 0, sizeof(this->lane_throttled_ticks));
+    }
+
+    pos_retval_t init_lane(pos_ckpt_commit_lane_t& lane) override;
+    pos_retval_t deinit_lane(pos_ckpt_commit_lane_t& lane) override;
+    pos_retval_t init_lane_thread(pos_ckpt_commit_lane_t& lane) override;
+    pos_retval_t commit(pos_ckpt_commit_lane_t& lane, pos_ckpt_commit_job_t& job) override;
+    pos_retval_t sync_lane(pos_ckpt_commit_lane_t& lane) override;
+    bool is_bus_contended() override;
+    POSUtilWaitEvent* get_bus_event() override;
+    bool is_cancelled() override;
+
+    /*!
+     *  \brief  whether to stop the lanes while memcpy APIs use the memory bus
+     *  \note   disabled as the overlapped checkpoint process used to be, the memcpy APIs still
+     *          raise the flag, so that it could be enabled here
+     */
+    static constexpr bool TMP_enable_mem_lock = false;
+
+ private:
+    // the worker that owns this backend
+    POSWorker *_worker;
+
+    #if POS_CONF_EVAL_CkptEnablePipeline == 1
+        /*!
+         *  \brief  stream of each lane to add states to the on-device cache
+         *  \note   the adding process is sync, we use a separate stream so that it won't
+         *          wait for the ongoing commits of the lane
+         */
+        uint64_t _add_stream_ids[POSCheckpointCommitEngine::kMaxNbLanes];
+    #endif
+};
+
+
 /*!
  *  \brief  context of the overlapped checkpoint thread
  */
@@ -84,19 +162,74 @@ typedef struct checkpoint_async_cxt {
     // checkpoint cmd
     POSCommand_QE_t *cmd;
 
-    // (latest) version of each handle to be checkpointed
-    std::map<POSHandle*, pos_u64id_t> checkpoint_version_map;
+    /*!
+     *  \brief  epoch of current checkpoint round, bumped by every checkpoint command
+     *  \note   handles to be checkpointed in this round are stamped with this epoch
+     *          (POSHandle::ckpt_epoch), along with their (latest) version (POSHandle::ckpt_version)
+     *  \note   epoch 0 is reserved for "never included", so this value starts from 1
+     */
+    uint64_t epoch;
 
     // all handles persisted in async checkpoint thread
     std::set<POSHandle*> persist_handles;
 
-    // all dirty handles since start of concurrent checkpoint
-    std::set<POSHandle*> dirty_handles;
+    /*!
+     *  \brief  all dirty handles since start of concurrent checkpoint
+     *  \note   this is an intrusive list chained by POSHandle::dirty_next, a handle is
+     *          within this list only when its dirty_epoch equals to current epoch
+     */
+    POSHandle *dirty_handles;
+    uint64_t nb_dirty_handles;
     uint64_t dirty_handle_state_size;
 
+    // number of dirty handles whose checkpointed version isn't preserved (i.e., not CoW-ed)
+    uint64_t nb_unpreserved_dirty_handles;
+
+    // number and overall execution ticks of APIs recorded for recomputation
+    uint64_t nb_recompute_apis;
+    uint64_t recompute_ticks;
+
+    /*!
+     *  \brief cost model to decide among CoW, wait-for-commit and recompute-on-restore
+     *  \note  the model lives across checkpoint rounds to accumulate its measurements
+     */
+    POSCheckpointCostModel cost_model;
+
+    // directory to dump the decisions of the cost model, i.e., the directory of the latest checkpoint
+    std::string cost_model_dump_dir;
+
+    // scheduler to order the commits within the checkpoint thread
+    POSCheckpointScheduler scheduler;
+
+    /*!
+     *  \brief  engine to commit handles on multiple lanes within the checkpoint thread
+     *  \note   created by the worker thread before raising the checkpoint thread, and re-created
+     *          once the number of lanes is changed
+     */
+    POSCheckpointCommitBackend_Worker *commit_backend;
+    POSCheckpointCommitEngine *commit_engine;
+
+    /*!
+     *  \brief  rate limiters of the checkpoint commit / persist traffic
+     *  \note   configured by the worker thread before raising the checkpoint thread
+     */
+    POSCheckpointThrottle commit_throttle;
+    POSCheckpointThrottle persist_throttle;
+
     //  this flag should be raise by memcpy API worker function, to avoid slow down by
     //  overlapped checkpoint process
-    volatile bool membus_lock;
+    std::atomic<bool> membus_lock;
+
+    // event to wake up the stopped commit lanes once the memory bus is released
+    POSUtilWaitEvent membus_event;
+
+    /*!
+     *  \brief  release the memory bus after the memcpy API is done, invoked by the worker function
+     */
+    inline void release_membus(){
+        this->membus_lock = false;
+        this->membus_event.notify();
+    }
 
     // thread handle
     std::thread *thread;
@@ -107,7 +240,8 @@ typedef struct checkpoint_async_cxt {
             CKPT_cow_bytes_by_ckpt_thread = 0,
             CKPT_cow_bytes_by_worker_thread,
             CKPT_commit_bytes_by_ckpt_thread,
-            CKPT_dirty_commit_bytes
+            CKPT_dirty_commit_bytes,
+            CKPT_commit_lane_bytes
         };
         POSMetrics_ReducerList<metrics_reducer_type_t, uint64_t> metric_reducers;
     
@@ -116,10 +250,15 @@ typedef struct checkpoint_async_cxt {
             CKPT_cow_block_times_by_ckpt_thread,
             CKPT_cow_done_times_by_worker_thread,
             CKPT_cow_block_times_by_worker_thread,
+            CKPT_cow_avoided_times_by_worker_thread,
             CKPT_commit_times_by_ckpt_thread,
+            CKPT_commit_lane_stops,
             CKPT_dirty_commit_times,
             CKPT_nb_recomputation_apis,
             CKPT_nb_unexecuted_apis,
+            CKPT_cow_decisions,
+            CKPT_wait_commit_decisions,
+            CKPT_recompute_decisions,
             PERSIST_handle_times,
             PERSIST_wqe_times
         };
@@ -132,9 +271,12 @@ typedef struct checkpoint_async_cxt {
             CKPT_cow_done_ticks_by_worker_thread,
             CKPT_cow_block_ticks_by_worker_thread,
             CKPT_commit_ticks_by_ckpt_thread,
+            CKPT_commit_lane_stall_ticks,
+            CKPT_commit_throttle_ticks,
             CKPT_dirty_commit_ticks,
             PERSIST_handle_ticks,
-            PERSIST_wqe_ticks
+            PERSIST_wqe_ticks,
+            PERSIST_throttle_ticks
         };
         POSMetrics_TickerList<metrics_ticker_type_t> metric_tickers;
 
@@ -148,6 +290,7 @@ typedef struct checkpoint_async_cxt {
                 { CKPT_cow_bytes_by_worker_thread, "CoW Bytes (by Worker Thread)" },
                 { CKPT_commit_bytes_by_ckpt_thread, "Commit Bytes Bytes (by Ckpt Thread)" },
                 { CKPT_dirty_commit_bytes, "Dirty Copy Bytes (by Worker Thread)" },
+                { CKPT_commit_lane_bytes, "Commit Bytes (per Lane)" },
             };
 
             static std::unordered_map<metrics_counter_type_t, std::string> counter_names = {
@@ -155,10 +298,15 @@ typedef struct checkpoint_async_cxt {
                 { CKPT_cow_block_times_by_ckpt_thread, "# Handles (Cow Block by Ckpt Thread)" },
                 { CKPT_cow_done_times_by_worker_thread, "# Handles (Cow Done by Worker Thread)" },
                 { CKPT_cow_block_times_by_worker_thread, "# Handles (Cow Block by Worker Thread)" },
+                { CKPT_cow_avoided_times_by_worker_thread, "# Handles (Cow Avoided by Worker Thread)" },
                 { CKPT_commit_times_by_ckpt_thread, "# Handles (Commit by Ckpt Thread)" },
+                { CKPT_commit_lane_stops, "# Commit Lane Stops (Memory Bus Contended)" },
                 { CKPT_dirty_commit_times, "# Dirty-copied Handles (Commit by Worker Thread)" },
                 { CKPT_nb_recomputation_apis, "# Recomputation APIs" },
                 { CKPT_nb_unexecuted_apis, "# Unexecuted APIs" },
+                { CKPT_cow_decisions, "# Handles (Decided to CoW)" },
+                { CKPT_wait_commit_decisions, "# Handles (Decided to Wait Commit)" },
+                { CKPT_recompute_decisions, "# Rounds (Decided to Recompute)" },
                 { PERSIST_handle_times, "# Persisted Handles" },
                 { PERSIST_wqe_times, "# Persisted WQEs" },
             };
@@ -170,9 +318,12 @@ typedef struct checkpoint_async_cxt {
                 { CKPT_cow_done_ticks_by_worker_thread, "CoW Done (by Worker Thread)" },
                 { CKPT_cow_block_ticks_by_worker_thread, "CoW Block (by Worker Thread)" },
                 { CKPT_commit_ticks_by_ckpt_thread, "Commit (by Ckpt Thread)" },
+                { CKPT_commit_lane_stall_ticks, "Commit Lane Stall (Memory Bus Contended)" },
+                { CKPT_commit_throttle_ticks, "Commit Lane Throttled (Rate Limited)" },
                 { CKPT_dirty_commit_ticks, "Dirty Copy Commit (by Worker Thread)" },
                 { PERSIST_handle_ticks, "Persist Handles" },
                 { PERSIST_wqe_ticks, "Persist WQEs" },
+                { PERSIST_throttle_ticks, "Persist Throttled (Rate Limited)" },
             };
 
             POS_LOG(
@@ -184,7 +335,11 @@ typedef struct checkpoint_async_cxt {
         }
     #endif
 
-    checkpoint_async_cxt() : TH_actve(false), BH_active(false), dirty_handle_state_size(0) {}
+    checkpoint_async_cxt()
+        : TH_actve(false), BH_active(false), epoch(0),
+          dirty_handles(nullptr), nb_dirty_handles(0), dirty_handle_state_size(0),
+          nb_unpreserved_dirty_handles(0), nb_recompute_apis(0), recompute_ticks(0),
+          commit_backend(nullptr), commit_engine(nullptr), membus_lock(false), thread(nullptr) {}
 } checkpoint_async_cxt_t;
 
 #endif // POS_CONF_EVAL_CkptOptLevel == 2
@@ -257,35 +412,69 @@ class POSWorker {
         return POS_FAILED_NOT_IMPLEMENTED;
     }
 
+    /*!
+     *  \brief  create a new stream
+     *  \param  stream_id   index of the created stream
+     *  \return POS_SUCCESS for successfully creation
+     */
+    virtual pos_retval_t create_stream(uint64_t& stream_id){
+        return POS_FAILED_NOT_IMPLEMENTED;
+    }
+
+    /*!
+     *  \brief  destory a stream created by create_stream
+     *  \param  stream_id   index of the stream to be destoried
+     *  \return POS_SUCCESS for successfully destory
+     */
+    virtual pos_retval_t destory_stream(uint64_t stream_id){
+        return POS_FAILED_NOT_IMPLEMENTED;
+    }
+
+    /*!
+     *  \brief      bind the calling thread to the device context of this worker
+     *  \note       should be invoked by threads other than the worker thread that issue device operations
+     *  \example    for CUDA, one need to call cudaSetDevice first to setup the context for a thread
+     *  \return     POS_SUCCESS for successfully binding
+     */
+    virtual pos_retval_t bind_thread_context(){
+        return POS_SUCCESS;
+    }
+
  protected:
+    #if POS_CONF_EVAL_CkptOptLevel == 2
+        friend class POSCheckpointCommitBackend_Worker;
+    #endif
+
     // stop flag to indicate the daemon thread to stop
     volatile bool _stop_flag;
 
     // the daemon thread of the runtime
     std::thread *_daemon_thread;
 
+    // the pool serving the daemon, and the corresponding task, nullptr for running on its own thread
+    POSDaemonPool *_pool;
+    std::shared_ptr<pos_daemon_pool_task_t> _pool_task;
+
+    // maximum number of queue elements polled at once, and the preallocated batch buffers
+    uint64_t _batch_size;
+    std::vector<POSAPIContext_QE*> _wqes;
+    std::vector<POSCommand_QE_t*> _cmd_wqes;
+
     // global workspace
     POSWorkspace *_ws;
 
     // corresonding client
     POSClient *_client;
 
-    // worker function map
-    std::map<uint64_t, pos_worker_launch_function_t> _launch_functions;
+    // worker function table
+    POSApiDispatchTable<pos_worker_launch_function_t> _launch_functions;
 
     #if POS_CONF_EVAL_CkptOptLevel == 2
-        // stream for overlapped memcpy while computing happens
-        uint64_t _ckpt_stream_id;
-
         // stream for doing CoW
+        //  note: checkpoint commits are issued on the streams of the commit engine lanes
         uint64_t _cow_stream_id;
     #endif
 
-    #if POS_CONF_EVAL_CkptOptLevel == 2 && POS_CONF_EVAL_CkptEnablePipeline == 1
-        // stream for commiting checkpoint from device
-        uint64_t _ckpt_commit_stream_id;
-    #endif
-
 
     /*!
      *  \brief  insertion of worker functions
@@ -334,13 +523,21 @@ class POSWorker {
      */
     void __daemon();
 
+    /*!
+     *  \brief  run one round of the worker daemon
+     *  \note   invoked by the daemon thread of the worker, or by a thread of the worker pool
+     *  \return whether any queue element was digested in this round
+     */
+    bool __daemon_step();
+
 
     #if POS_CONF_EVAL_CkptOptLevel == 0 || POS_CONF_EVAL_CkptOptLevel == 1
         /*!
-         *  \brief  worker daemon with / without SYNC checkpoint support 
+         *  \brief  one round of worker daemon with / without SYNC checkpoint support 
          *          (checkpoint optimization level 0 and 1)
+         *  \return whether any queue element was digested in this round
          */
-        void __daemon_ckpt_sync();
+        bool __daemon_step_ckpt_sync();
 
         /*!
          *  \brief  checkpoint procedure, should be implemented by each platform
@@ -351,9 +548,16 @@ class POSWorker {
         pos_retval_t __checkpoint_handle_sync(POSCommand_QE_t *cmd);
     #elif POS_CONF_EVAL_CkptOptLevel == 2
         /*!
-         *  \brief  worker daemon with ASYNC checkpoint support (checkpoint optimization level 2)
+         *  \brief  one round of worker daemon with ASYNC checkpoint support (checkpoint optimization level 2)
+         *  \return whether any queue element was digested in this round
+         */
+        bool __daemon_step_ckpt_async();
+
+        /*!
+         *  \brief  remove the pending writes recorded by the parser for an API that the worker is done with
+         *  \param  wqe the API that has been executed (or dropped)
          */
-        void __daemon_ckpt_async();
+        void __remove_pending_writes(POSAPIContext_QE_t* wqe);
 
         /*!
          *  \brief  [Top-half] overlapped checkpoint procedure, should be implemented by each platform
@@ -372,9 +576,10 @@ class POSWorker {
 
     #if POS_CONF_EVAL_MigrOptLevel > 0
         /*!
-         *  \brief  worker daemon with optimized migration support (POS)
+         *  \brief  one round of worker daemon with optimized migration support (POS)
+         *  \return whether any queue element was digested in this round
          */
-        void __daemon_migration_opt();
+        bool __daemon_step_migration_opt();
     #endif
 
     /*!
@@ -390,7 +595,7 @@ class POSWorker {
      *  \param  api_meta    metadata of the called API
      *  \return POS_SUCCESS for successfully checking and restoring
      */
-    pos_retval_t __restore_broken_handles(POSAPIContext_QE_t* wqe, POSAPIMeta_t *api_meta); 
+    pos_retval_t __restore_broken_handles(POSAPIContext_QE_t* wqe, const POSAPIMeta_t *api_meta); 
 
     // maximum index of processed wqe index
     uint64_t _max_wqe_id;
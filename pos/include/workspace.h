@@ -31,11 +31,15 @@
 #include "pos/include/command.h"
 #include "pos/include/handle.h"
 #include "pos/include/client.h"
+#include "pos/include/client_registry.h"
 #include "pos/include/parser.h"
 #include "pos/include/worker.h"
 #include "pos/include/transport.h"
 #include "pos/include/oob.h"
 #include "pos/include/api_context.h"
+#include "pos/include/daemon_pool.h"
+#include "pos/include/api_trace.h"
+#include "pos/include/placement.h"
 #include "pos/include/utils/timer.h"
 
 
@@ -53,6 +57,7 @@ namespace oob_functions {
     POS_OOB_DECLARE_SVR_FUNCTIONS(cli_ckpt_dump);
     POS_OOB_DECLARE_SVR_FUNCTIONS(cli_restore);
     POS_OOB_DECLARE_SVR_FUNCTIONS(cli_trace_resource);
+    POS_OOB_DECLARE_SVR_FUNCTIONS(cli_config);
 }; // namespace oob_functions
 
 
@@ -71,10 +76,38 @@ class POSWorkspaceConf {
         kRuntimeTraceResourceEnabled,
         kRuntimeTracePerformanceEnabled,
         kRuntimeTraceDir,
+        kRuntimeKernelMetaCacheDir,
+        kRuntimeLazyKernelMeta,
+        kRuntimeFatbinTextSpill,
+        kRuntimeDaemonBatchSize,
+        kRuntimeWaitSpinUs,
+        kRuntimeWaitYieldUs,
+        kRuntimeWaitParkTimeoutUs,
+        kRuntimeDaemonPoolThreads,
+        kRuntimePlacementPolicy,
+        kRuntimePlacementNumaNode,
+        kRuntimePlacementCriticalCores,
+        kRuntimePlacement,
         kEvalCkptIntervfalMs,
+        kEvalCkptSchedPolicy,
+        kEvalCkptCommitLanes,
+        kEvalCkptCommitBandwidth,
+        kEvalCkptCommitBurst,
+        kEvalCkptPersistBandwidth,
+        kEvalCkptPersistBurst,
+        kEvalCkptMaxSlowdownPct,
         kUnknown
     }; 
 
+    /*!
+     *  \brief  obtain the configuration type by its name (e.g., used by CLI)
+     *  \param  name        name of the configuration
+     *  \param  conf_type   the obtained configuration type
+     *  \return POS_SUCCESS for successfully obtained;
+     *          POS_FAILED_NOT_EXIST for unknown name
+     */
+    static pos_retval_t get_config_type_by_name(const std::string& name, ConfigType& conf_type);
+
     /*!
      *  \brief  set sepecific configuration in the workspace
      *  \note   should be thread-safe
@@ -103,11 +136,43 @@ class POSWorkspaceConf {
     bool _runtime_trace_resource;
     bool _runtime_trace_performance;
     std::string _runtime_trace_dir;
+    // directory of the node-wide kernel metadata cache shared by all jobs, empty for disabled
+    std::string _runtime_kernel_meta_cache_dir;
+    // whether to parse the kernel prototypes on their first launch instead of while loading modules
+    bool _runtime_lazy_kernel_meta;
+    // whether to spill the decompressed fatbin sections to the kernel metadata cache directory
+    bool _runtime_fatbin_text_spill;
+    // maximum number of queue elements polled / pushed at once by the parser and worker daemons
+    uint32_t _runtime_daemon_batch_size;
+    // budgets (us) of spinning / yielding before the daemons and RPC threads park while idle,
+    // and the maximum duration (us) of a single park
+    uint64_t _runtime_wait_spin_us;
+    uint64_t _runtime_wait_yield_us;
+    uint64_t _runtime_wait_park_timeout_us;
+    // number of threads in the parser / worker pool serving all clients, 0 for each client runs
+    // its own parser and worker threads
+    uint32_t _runtime_daemon_pool_threads;
+    // policy to place the daemon threads onto cpu cores, the NUMA node to place them (kAutoNumaNode for the
+    // node of the device), and number of cores reserved for parser / worker threads (0 for half of the node)
+    pos_placement_policy_t _runtime_placement_policy;
+    int32_t _runtime_placement_numa_node;
+    uint32_t _runtime_placement_critical_cores;
 
     // ====== evaluation configurations ======
     // continuous checkpoint interval (ticks)
     uint64_t _eval_ckpt_interval_ms;
     uint64_t _eval_ckpt_interval_tick;
+    // policy to order the commits within the checkpoint thread
+    pos_ckpt_sched_policy_t _eval_ckpt_sched_policy;
+    // number of lanes to commit checkpoints concurrently
+    uint32_t _eval_ckpt_commit_lanes;
+    // rate limit (bytes per second, 0 for unlimited) and burst (bytes) of checkpoint commit / persist traffic
+    uint64_t _eval_ckpt_commit_bw;
+    uint64_t _eval_ckpt_commit_burst;
+    uint64_t _eval_ckpt_persist_bw;
+    uint64_t _eval_ckpt_persist_burst;
+    // maximum slowdown (%) of application copies caused by checkpoint commits, 0 for not adapting the commit rate
+    uint32_t _eval_ckpt_max_slowdown_pct;
 
     // workspace that this configuration container attached to
     POSWorkspace *_root_ws;
@@ -173,28 +238,63 @@ class POSWorkspace {
 
     /*!
      *  \brief  obtain client by given uuid
+     *  \note   lock-free, the client is only guaranteed to be valid within a read section of
+     *          the client registry (see POSClientRegistry::read_lock) or on the thread that removes it
      *  \param  uuid    uuid of the client
      *  \return pointer to the corresponding POSClient
      */
     inline POSClient* get_client_by_uuid(pos_client_uuid_t uuid){
-        POSClient *retval = nullptr;
-
-        if(uuid >= this->_client_list.size()){
-            goto exit;
-        }
-        retval = this->_client_list[uuid];
-        
-    exit:
-        return retval;
+        return this->_client_registry.get_by_uuid(uuid);
     }
 
 
     /*!
      *  \brief  obtain client by given pid
+     *  \note   lock-free, the client is only guaranteed to be valid within a read section of
+     *          the client registry (see POSClientRegistry::read_lock) or on the thread that removes it
      *  \param  pid     pid of the client
      *  \return pointer to the corresponding POSClient
      */
-    POSClient* get_client_by_pid(__pid_t pid);
+    inline POSClient* get_client_by_pid(__pid_t pid){
+        return this->_client_registry.get_by_pid(pid);
+    }
+
+
+    /*!
+     *  \brief  obtain the pool of threads serving the parsers of clients
+     *  \note   the pool is created once a client is created with daemon pool enabled
+     *  \return pointer to the pool, nullptr for daemon pool disabled
+     */
+    inline POSDaemonPool* get_parser_pool(){
+        return this->__get_daemon_pool(this->_parser_pool, "parser", kPOS_PlacementRole_Parser);
+    }
+
+
+    /*!
+     *  \brief  obtain the pool of threads serving the workers of clients
+     *  \note   the pool is created once a client is created with daemon pool enabled
+     *  \return pointer to the pool, nullptr for daemon pool disabled
+     */
+    inline POSDaemonPool* get_worker_pool(){
+        return this->__get_daemon_pool(this->_worker_pool, "worker", kPOS_PlacementRole_Worker);
+    }
+
+    /*!
+     *  \brief  attach the API trace ring of a client to the writer, which flushes the rings of all
+     *          clients into a single file
+     *  \note   the writer is created under the current trace directory once the first ring is attached,
+     *          rings attached later share its file until all of them are detached
+     *  \param  ring    the ring to be attached
+     *  \return POS_SUCCESS for successfully attached
+     */
+    pos_retval_t add_api_trace_ring(POSApiTraceRing *ring);
+
+    /*!
+     *  \brief  detach the API trace ring of a client from the writer, the ring is drained before return
+     *  \note   the writer is stopped (and its file is closed) once the last ring is detached
+     *  \param  ring    the ring to be detached
+     */
+    void remove_api_trace_ring(POSApiTraceRing *ring);
 
  protected:
     /*!
@@ -217,12 +317,28 @@ class POSWorkspace {
     }
 
 
-    // map of clients
-    std::vector<POSClient*> _client_list;
-    std::map<__pid_t, POSClient*> _pid_client_map;
+    // registry of clients, indexed by uuid and pid
+    POSClientRegistry _client_registry;
 
-    // the max uuid that has been recorded
-    pos_client_uuid_t _current_max_uuid;
+    // pools of threads serving the parsers / workers of clients, nullptr for not created
+    POSDaemonPool *_parser_pool;
+    POSDaemonPool *_worker_pool;
+    std::mutex _daemon_pool_mutex;
+
+    // writer of API trace rings of all clients, and the number of attached rings, nullptr for no ring attached
+    POSApiTraceWriter *_api_trace_writer;
+    uint64_t _nb_api_trace_rings;
+    std::mutex _api_trace_writer_mutex;
+
+    /*!
+     *  \brief  obtain the daemon pool, create it if the daemon pool is enabled but not created yet
+     *  \note   once created, the number of threads in the pool is fixed
+     *  \param  pool    the pool to be obtained
+     *  \param  name    name of the pool
+     *  \param  role    role of the pool threads to be placed as
+     *  \return pointer to the pool, nullptr for daemon pool disabled
+     */
+    POSDaemonPool* __get_daemon_pool(POSDaemonPool*& pool, const char *name, pos_placement_role_t role);
 
     /* ============ end of client management functions =========== */
 
@@ -252,12 +368,9 @@ class POSWorkspace {
         volatile POSClient *client;
         int retval = 1;
 
-        if(unlikely(this->_client_list.size() <= uuid)){
-            // POS_WARN_C("try to require access to non-exist client: uuid(%lu)", uuid);
-            return 0;
-        }
+        POSClientRegistry::read_lock();
 
-        client = this->_client_list[uuid];
+        client = this->_client_registry.get_by_uuid(uuid);
         if(unlikely(client == nullptr)){
             // POS_WARN_C("try to require access to non-exist client: uuid(%lu)", uuid);
             retval = 0; goto exit;
@@ -273,6 +386,7 @@ class POSWorkspace {
         }
 
     exit:
+        POSClientRegistry::read_unlock();
         return retval;
     }
 
@@ -294,6 +408,9 @@ class POSWorkspace {
     // TSC timer of the workspace
     POSUtilTscTimer tsc_timer;
 
+    // placement of the daemon threads onto cpu cores
+    POSPlacement placement;
+
  protected:
     /*!
      *  \brief  out-of-band server
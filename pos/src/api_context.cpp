@@ -20,6 +20,8 @@
 #include <string>
 #include <memory>
 #include <filesystem>
+#include <algorithm>
+#include <new>
 #include <string.h>
 #include <stdint.h>
 #include <assert.h>
@@ -36,39 +38,64 @@
 POSAPIContext::POSAPIContext(
     uint64_t api_id_, std::vector<POSAPIParamDesp_t>& param_desps, void* ret_data_, uint64_t retval_size_
 ) 
-    : api_id(api_id_), ret_data(ret_data_), retval_size(retval_size_)
+    : api_id(api_id_), param_blob(nullptr), param_blob_capacity(0), ret_data(ret_data_), retval_size(retval_size_)
 {
-    POSAPIParam_t *param;
-
     params.reserve(16);
-
-    // insert parameters
-    for(auto& param_desp : param_desps){
-        POS_CHECK_POINTER(param = new POSAPIParam_t(param_desp.value, param_desp.size));
-        params.push_back(param);
-    }
+    this->set_params(param_desps);
 }
 
 
 POSAPIContext::POSAPIContext(uint64_t api_id_, uint64_t retval_size) 
-    : api_id(api_id_)
+    : api_id(api_id_), param_blob(nullptr), param_blob_capacity(0)
 {
     if(retval_size > 0)
         POS_CHECK_POINTER(this->ret_data = malloc(retval_size));
 }
 
 
+POSAPIContext::POSAPIContext()
+    : api_id(0), param_blob(nullptr), param_blob_capacity(0), ret_data(nullptr), retval_size(0), return_code(0)
+{
+    params.reserve(16);
+}
+
+
+void POSAPIContext::set_params(std::vector<POSAPIParamDesp_t>& param_desps){
+    uint64_t i, blob_size, offset;
+    POSAPIParam_t *param;
+
+    // descriptors are placed at the head of the blob, followed by 8-byte aligned payloads
+    blob_size = param_desps.size() * sizeof(POSAPIParam_t);
+    for(i=0; i<param_desps.size(); i++){
+        blob_size += (param_desps[i].size + 7) & ~((uint64_t)7);
+    }
+
+    if(unlikely(blob_size > this->param_blob_capacity)){
+        if(this->param_blob != nullptr){ free(this->param_blob); }
+        this->param_blob_capacity = std::max(blob_size, kMinParamBlobCapacity);
+        POS_CHECK_POINTER(this->param_blob = (uint8_t*)malloc(this->param_blob_capacity));
+    }
+
+    this->params.clear();
+    offset = param_desps.size() * sizeof(POSAPIParam_t);
+    for(i=0; i<param_desps.size(); i++){
+        param = new (this->param_blob + i * sizeof(POSAPIParam_t)) POSAPIParam_t(
+            /* src_value */ param_desps[i].value,
+            /* size */ param_desps[i].size,
+            /* dst_area */ this->param_blob + offset
+        );
+        this->params.push_back(param);
+        offset += (param_desps[i].size + 7) & ~((uint64_t)7);
+    }
+}
+
+
 POSAPIContext_QE::POSAPIContext_QE(
     uint64_t api_id, pos_client_uuid_t uuid, std::vector<POSAPIParamDesp_t>& param_desps,
     uint64_t inst_id, void* retval_data, uint64_t retval_size, POSClient* pos_client
-) : client_id(uuid), client(pos_client), id(inst_id), has_return(false),
-    status(kPOS_API_Execute_Status_Init), type(ApiCxt_TypeId_Normal)
+) : completion(POSUtilCompletion::kPending), pool(nullptr), nb_refs(0), next_free(nullptr)
 {
-    POS_CHECK_POINTER(pos_client);
-    this->api_cxt = new POSAPIContext_t(api_id, param_desps, retval_data, retval_size);
-    POS_CHECK_POINTER(this->api_cxt);
-    create_tick = POSUtilTscTimer::get_tsc();
-    parser_s_tick = parser_e_tick = worker_s_tick = worker_e_tick = 0;
+    POS_CHECK_POINTER(this->api_cxt = new POSAPIContext_t());
 
     // reserve space
     input_handle_views.reserve(5);
@@ -76,19 +103,72 @@ POSAPIContext_QE::POSAPIContext_QE(
     inout_handle_views.reserve(5);
     create_handle_views.reserve(1);
     delete_handle_views.reserve(1);
+
+    this->init(api_id, uuid, param_desps, inst_id, retval_data, retval_size, pos_client);
+}
+
+
+POSAPIContext_QE::POSAPIContext_QE()
+    : client_id(0), client(nullptr), id(0), has_return(false), is_sync(false),
+      completion(POSUtilCompletion::kPending), status(kPOS_API_Execute_Status_Init),
+      type(ApiCxt_TypeId_Normal), pool(nullptr), nb_refs(0), next_free(nullptr)
+{
+    POS_CHECK_POINTER(this->api_cxt = new POSAPIContext_t());
+
+    // reserve space
+    input_handle_views.reserve(5);
+    output_handle_views.reserve(5);
+    inout_handle_views.reserve(5);
+    create_handle_views.reserve(1);
+    delete_handle_views.reserve(1);
+}
+
+
+void POSAPIContext_QE::init(
+    uint64_t api_id, pos_client_uuid_t uuid, std::vector<POSAPIParamDesp_t>& param_desps,
+    uint64_t inst_id, void* retval_data, uint64_t retval_size, POSClient* pos_client
+){
+    POS_CHECK_POINTER(pos_client);
+    POS_CHECK_POINTER(this->api_cxt);
+
+    this->client_id = uuid;
+    this->client = pos_client;
+    this->id = inst_id;
+    this->has_return = false;
+    this->is_sync = false;
+    POSUtilCompletion::reset(this->completion);
+    this->status = kPOS_API_Execute_Status_Init;
+    this->type = ApiCxt_TypeId_Normal;
+
+    this->api_cxt->api_id = api_id;
+    this->api_cxt->ret_data = retval_data;
+    this->api_cxt->retval_size = retval_size;
+    this->api_cxt->return_code = 0;
+    this->api_cxt->set_params(param_desps);
+
+    this->input_handle_views.clear();
+    this->output_handle_views.clear();
+    this->inout_handle_views.clear();
+    this->create_handle_views.clear();
+    this->delete_handle_views.clear();
+
+    create_tick = POSUtilTscTimer::get_tsc();
+    return_tick = 0;
+    parser_s_tick = parser_e_tick = worker_s_tick = worker_e_tick = 0;
 }
 
 
 POSAPIContext_QE::POSAPIContext_QE(
     POSClient* client, const std::string& ckpt_file, pos_apicxt_typeid_t type
-){
+) : api_cxt(nullptr), has_return(false), is_sync(false), completion(POSUtilCompletion::kPending),
+    pool(nullptr), nb_refs(0), next_free(nullptr)
+{
     pos_retval_t retval = POS_SUCCESS;
     pos_protobuf::Bin_POSAPIContext apicxt_binary;
     POSHandleView_t hv;
     std::ifstream input;
     uint64_t i, param_size;
-    void *param_area;
-    POSAPIParam_t *api_param;
+    std::vector<POSAPIParamDesp_t> param_desps;
 
     POS_CHECK_POINTER(client);
     POS_ASSERT(type == ApiCxt_TypeId_Unexecuted || type == ApiCxt_TypeId_Recomputation);
@@ -169,16 +249,12 @@ POSAPIContext_QE::POSAPIContext_QE(
 
     for(i=0; i<apicxt_binary.params_size(); i++){
         POS_ASSERT((param_size = apicxt_binary.params(i).size()) > 0);
-        POS_CHECK_POINTER(param_area = malloc(param_size));
-        memcpy(
-            param_area, 
-            reinterpret_cast<const void*>(apicxt_binary.params(i).state().c_str()),
-            param_size
-        );
-
-        POS_CHECK_POINTER(api_param = new POSAPIParam_t(param_area, param_size));
-        this->api_cxt->params.push_back(api_param);
+        param_desps.push_back({
+            /* value */ const_cast<char*>(apicxt_binary.params(i).state().c_str()),
+            /* size */ param_size
+        });
     }
+    this->api_cxt->set_params(param_desps);
 
 exit:
     if(input.is_open()){ input.close(); }
@@ -191,7 +267,59 @@ exit:
 
 
 POSAPIContext_QE::~POSAPIContext_QE(){
-    // TODO: release handle views
+    if(this->api_cxt != nullptr){ delete this->api_cxt; }
+}
+
+
+POSAPIContextPool::POSAPIContextPool(uint64_t slab_size)
+    : _slab_size(slab_size), _nb_allocated(0), _free_list(nullptr), _recycled_list(nullptr)
+{
+    POS_ASSERT(slab_size > 0);
+}
+
+
+POSAPIContextPool::~POSAPIContextPool(){
+    for(auto slab : this->_slabs){ delete[] slab; }
+}
+
+
+void POSAPIContextPool::__grow(){
+    uint64_t i;
+    POSAPIContext_QE *slab;
+
+    POS_CHECK_POINTER(slab = new POSAPIContext_QE[this->_slab_size]);
+    for(i=0; i<this->_slab_size; i++){
+        slab[i].pool = this;
+        slab[i].next_free = (i+1 < this->_slab_size) ? &slab[i+1] : this->_free_list;
+    }
+    this->_free_list = slab;
+    this->_slabs.push_back(slab);
+    this->_nb_allocated += this->_slab_size;
+}
+
+
+POSAPIContext_QE* POSAPIContextPool::acquire(
+    uint64_t api_id, pos_client_uuid_t uuid, std::vector<POSAPIParamDesp_t>& param_desps,
+    uint64_t inst_id, void* retval_data, uint64_t retval_size, POSClient* pos_client
+){
+    POSAPIContext_QE *wqe;
+
+    // reclaim all WQEs recycled by other threads
+    if(unlikely(this->_free_list == nullptr)){
+        this->_free_list = this->_recycled_list.exchange(nullptr, std::memory_order_acquire);
+    }
+    if(unlikely(this->_free_list == nullptr)){
+        this->__grow();
+    }
+
+    POS_CHECK_POINTER(wqe = this->_free_list);
+    this->_free_list = wqe->next_free;
+    wqe->next_free = nullptr;
+
+    wqe->init(api_id, uuid, param_desps, inst_id, retval_data, retval_size, pos_client);
+    wqe->nb_refs.store(1, std::memory_order_relaxed);
+
+    return wqe;
 }
 
 
@@ -0,0 +1,337 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/placement.h"
+#include "pos/include/utils/timer.h"
+#include "pos/include/api_trace.h"
+
+
+POSApiTraceRing::POSApiTraceRing(pos_client_uuid_t client_id, uint64_t pid, uint64_t capacity)
+    :   client_id(client_id), pid(pid), _head(0), _produce_head(0), _cached_tail(0), _tail(0), _nb_dropped(0)
+{
+    this->_capacity = 1;
+    while(this->_capacity < std::max<uint64_t>(capacity, 4096)){ this->_capacity <<= 1; }
+    POS_CHECK_POINTER(this->_buffer = static_cast<uint8_t*>(aligned_alloc(64, this->_capacity)));
+
+    // touch the ring in advance, so that the parser won't take page faults while recording
+    memset(this->_buffer, 0, this->_capacity);
+}
+
+
+POSApiTraceRing::~POSApiTraceRing(){
+    free(this->_buffer);
+}
+
+
+POSApiTraceWriter::POSApiTraceWriter(POSPlacement *placement)
+    :   _file(nullptr), _nb_bytes(0), _nb_dropped(0), _thread(nullptr), _placement(placement), _stop_flag(false)
+{}
+
+
+POSApiTraceWriter::~POSApiTraceWriter(){
+    this->deinit();
+}
+
+
+pos_retval_t POSApiTraceWriter::init(const std::string& file_path, double tsc_freq){
+    pos_retval_t retval = POS_SUCCESS;
+    pos_api_trace_file_header_t header;
+
+    POS_ASSERT(this->_file == nullptr && this->_thread == nullptr);
+
+    this->_file_path = file_path;
+    this->_file = fopen(file_path.c_str(), "wb");
+    if(unlikely(this->_file == nullptr)){
+        POS_WARN("failed to create api trace file: path(%s), error(%s)", file_path.c_str(), strerror(errno));
+        retval = POS_FAILED;
+        goto exit;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = kFileMagic;
+    header.version = kFileVersion;
+    header.header_size = sizeof(header);
+    header.tsc_freq = tsc_freq;
+    header.start_tick = POSUtilTscTimer::get_tsc();
+    if(unlikely(fwrite(&header, sizeof(header), 1, this->_file) != 1)){
+        POS_WARN("failed to write api trace file header: path(%s)", file_path.c_str());
+        fclose(this->_file);
+        this->_file = nullptr;
+        retval = POS_FAILED;
+        goto exit;
+    }
+    this->_nb_bytes = sizeof(header);
+
+    this->_stop_flag = false;
+    POS_CHECK_POINTER(this->_thread = new std::thread(&POSApiTraceWriter::__flush_main, this));
+
+    POS_LOG("api trace writer started: path(%s)", file_path.c_str());
+
+exit:
+    return retval;
+}
+
+
+void POSApiTraceWriter::deinit(){
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_stop_flag = true;
+    }
+    this->_cond.notify_all();
+
+    if(this->_thread != nullptr){
+        if(this->_thread->joinable()){ this->_thread->join(); }
+        delete this->_thread;
+        this->_thread = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if(this->_file != nullptr){
+        for(POSApiTraceRing *ring : this->_rings){ this->__flush(ring); }
+        fclose(this->_file);
+        this->_file = nullptr;
+        POS_LOG(
+            "api trace writer stopped: path(%s), written(%lu bytes), dropped(%lu records)",
+            this->_file_path.c_str(), this->_nb_bytes, this->_nb_dropped
+        );
+    }
+    this->_rings.clear();
+}
+
+
+void POSApiTraceWriter::add(POSApiTraceRing *ring){
+    POS_CHECK_POINTER(ring);
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_rings.push_back(ring);
+}
+
+
+void POSApiTraceWriter::remove(POSApiTraceRing *ring){
+    std::vector<POSApiTraceRing*>::iterator iter;
+
+    POS_CHECK_POINTER(ring);
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    iter = std::find(this->_rings.begin(), this->_rings.end(), ring);
+    if(unlikely(iter == this->_rings.end())){ return; }
+
+    if(this->_file != nullptr){
+        this->__flush(ring);
+        fflush(this->_file);
+    }
+    this->_rings.erase(iter);
+}
+
+
+void POSApiTraceWriter::__flush_main(){
+    POSPlacementScope placement_scope(
+        /* placement */ this->_placement, /* role */ kPOS_PlacementRole_Persist, /* name */ "api_trace_writer"
+    );
+    std::unique_lock<std::mutex> lock(this->_mutex);
+
+    while(this->_stop_flag == false){
+        this->_cond.wait_for(
+            lock, std::chrono::milliseconds(kFlushIntervalMs), [this](){ return this->_stop_flag; }
+        );
+        for(POSApiTraceRing *ring : this->_rings){ this->__flush(ring); }
+        fflush(this->_file);
+    }
+}
+
+
+pos_retval_t POSApiTraceWriter::__flush(POSApiTraceRing *ring){
+    pos_retval_t retval = POS_SUCCESS;
+    pos_api_trace_chunk_header_t chunk;
+    uint64_t head, tail, pos, nb_contiguous;
+
+    POS_CHECK_POINTER(ring);
+    POS_CHECK_POINTER(this->_file);
+
+    head = ring->_head.load(std::memory_order_acquire);
+    tail = ring->_tail.load(std::memory_order_relaxed);
+
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.magic = kChunkMagic;
+    chunk.header_size = sizeof(chunk);
+    chunk.client_id = ring->client_id;
+    chunk.pid = ring->pid;
+    chunk.payload_size = head - tail;
+    chunk.nb_dropped = ring->_nb_dropped.exchange(0, std::memory_order_relaxed);
+    if(chunk.payload_size == 0 && chunk.nb_dropped == 0){ goto exit; }
+
+    // the published records might wrap around the end of the ring, but none of them is split
+    pos = tail & (ring->_capacity - 1);
+    nb_contiguous = std::min(chunk.payload_size, ring->_capacity - pos);
+    if(unlikely(
+        fwrite(&chunk, sizeof(chunk), 1, this->_file) != 1
+        || fwrite(ring->_buffer + pos, 1, nb_contiguous, this->_file) != nb_contiguous
+        || fwrite(ring->_buffer, 1, chunk.payload_size - nb_contiguous, this->_file) != chunk.payload_size - nb_contiguous
+    )){
+        POS_WARN("failed to write api trace chunk: path(%s), client_id(%lu)", this->_file_path.c_str(), ring->client_id);
+        retval = POS_FAILED;
+    }
+    this->_nb_bytes += sizeof(chunk) + chunk.payload_size;
+    this->_nb_dropped += chunk.nb_dropped;
+
+    ring->_tail.store(head, std::memory_order_release);
+
+exit:
+    return retval;
+}
+
+
+POSApiTraceReader::~POSApiTraceReader(){
+    if(this->_file != nullptr){ fclose(this->_file); }
+}
+
+
+pos_retval_t POSApiTraceReader::open(const std::string& file_path){
+    pos_retval_t retval = POS_SUCCESS;
+    pos_api_trace_file_header_t header;
+
+    if(this->_file != nullptr){ fclose(this->_file); }
+
+    this->_file = fopen(file_path.c_str(), "rb");
+    if(unlikely(this->_file == nullptr)){
+        retval = POS_FAILED_NOT_EXIST;
+        goto exit;
+    }
+
+    if(unlikely(
+        fread(&header, sizeof(header), 1, this->_file) != 1
+        || header.magic != POSApiTraceWriter::kFileMagic
+        || header.version != POSApiTraceWriter::kFileVersion
+        || header.header_size < sizeof(header)
+    )){
+        POS_WARN("not an api trace file: path(%s)", file_path.c_str());
+        fclose(this->_file);
+        this->_file = nullptr;
+        retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+    fseek(this->_file, header.header_size, SEEK_SET);
+
+    this->_tsc_freq = header.tsc_freq;
+    this->_start_tick = header.start_tick;
+    this->_data_offset = header.header_size;
+
+exit:
+    return retval;
+}
+
+
+pos_retval_t POSApiTraceReader::for_each(visit_func_t&& func, uint64_t& nb_dropped){
+    pos_retval_t retval = POS_SUCCESS;
+    pos_api_trace_chunk_header_t chunk;
+    pos_api_trace_record_t *record;
+    std::vector<uint8_t> payload;
+    uint64_t offset;
+
+    POS_CHECK_POINTER(this->_file);
+
+    nb_dropped = 0;
+
+    while(fread(&chunk, sizeof(chunk), 1, this->_file) == 1){
+        if(unlikely(chunk.magic != POSApiTraceWriter::kChunkMagic || chunk.header_size < sizeof(chunk))){
+            POS_WARN("corrupted api trace chunk: offset(%ld)", ftell(this->_file) - (long)(sizeof(chunk)));
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        fseek(this->_file, chunk.header_size - sizeof(chunk), SEEK_CUR);
+
+        nb_dropped += chunk.nb_dropped;
+
+        payload.resize(chunk.payload_size);
+        if(unlikely(fread(payload.data(), 1, chunk.payload_size, this->_file) != chunk.payload_size)){
+            POS_WARN("truncated api trace chunk: client_id(%lu)", chunk.client_id);
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+
+        for(offset=0; offset+8<=chunk.payload_size; offset+=record->size){
+            record = reinterpret_cast<pos_api_trace_record_t*>(payload.data() + offset);
+            if(unlikely(record->size < 8 || record->size % 8 != 0 || offset + record->size > chunk.payload_size)){
+                POS_WARN("corrupted api trace record: client_id(%lu), offset(%lu)", chunk.client_id, offset);
+                retval = POS_FAILED_INVALID_INPUT;
+                goto exit;
+            }
+            if(record->api_id == POSApiTraceRing::kPaddingApiId){ continue; }
+            if(unlikely(
+                record->size < sizeof(pos_api_trace_record_t)
+                || record->size != sizeof(pos_api_trace_record_t) + record->nb_handles * sizeof(pos_api_trace_handle_t)
+            )){
+                POS_WARN("corrupted api trace record: client_id(%lu), offset(%lu)", chunk.client_id, offset);
+                retval = POS_FAILED_INVALID_INPUT;
+                goto exit;
+            }
+            func(chunk, *record, POSApiTraceRing::handles_of(record));
+        }
+    }
+
+exit:
+    // rewind, so that the records could be visited again
+    fseek(this->_file, this->_data_offset, SEEK_SET);
+    return retval;
+}
+
+
+pos_retval_t POSApiTraceReader::summarize(pos_api_trace_summary_t& summary){
+    pos_retval_t retval;
+
+    summary = pos_api_trace_summary_t();
+    summary.tsc_freq = this->_tsc_freq;
+
+    retval = this->for_each(
+        /* func */ [&](
+            const pos_api_trace_chunk_header_t& chunk,
+            const pos_api_trace_record_t& record,
+            const pos_api_trace_handle_t* handles
+        ){
+            pos_api_trace_summary_t::api_stat_t& api_stat = summary.apis[record.api_id];
+            uint16_t i;
+
+            summary.nb_records += 1;
+            summary.first_tick = std::min(summary.first_tick, record.create_tick);
+            summary.last_tick = std::max(summary.last_tick, record.create_tick);
+
+            api_stat.nb_calls += 1;
+            api_stat.parse_ticks += record.parser_e_tick - record.parser_s_tick;
+            api_stat.nb_handles += record.nb_handles;
+
+            for(i=0; i<record.nb_handles; i++){
+                if(unlikely(handles[i].direction > kPOS_Edge_Direction_Delete)){ continue; }
+                summary.handles[
+                    std::make_tuple(chunk.client_id, handles[i].resource_type_id, handles[i].handle_id)
+                ].nb_touches[handles[i].direction] += 1;
+            }
+        },
+        /* nb_dropped */ summary.nb_dropped
+    );
+
+    return retval;
+}
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/timer.h"
+#include "pos/include/placement.h"
+#include "pos/include/checkpoint_commit_engine.h"
+
+
+POSCheckpointCommitEngine::POSCheckpointCommitEngine(
+    POSCheckpointCommitBackend *backend, uint32_t nb_lanes, uint64_t staging_size
+) : _nb_lanes(nb_lanes), _staging_size(staging_size), _is_init(false), _round(0), _nb_running_lanes(0), _stop_lanes(false)
+{
+    POS_CHECK_POINTER(this->_backend = backend);
+    POS_ASSERT(nb_lanes > 0 && nb_lanes <= kMaxNbLanes);
+    this->_round_event.set_budget(/* spin_ticks */ 0, /* yield_ticks */ 0, /* park_timeout_us */ kLaneParkTimeoutUs);
+}
+
+
+POSCheckpointCommitEngine::~POSCheckpointCommitEngine(){
+    this->deinit();
+}
+
+
+pos_retval_t POSCheckpointCommitEngine::init(){
+    pos_retval_t retval = POS_SUCCESS;
+    uint32_t i;
+    POSPlacement *placement;
+
+    POS_ASSERT(this->_is_init == false);
+
+    this->lanes.resize(this->_nb_lanes);
+    for(i=0; i<this->_nb_lanes; i++){
+        this->lanes[i].id = i;
+        this->lanes[i].staging_size = this->_staging_size;
+        if(unlikely(POS_SUCCESS != (retval = this->_backend->init_lane(this->lanes[i])))){
+            POS_WARN_C("failed to init commit lane: lane_id(%u), retval(%u)", i, retval);
+            goto exit;
+        }
+    }
+
+    // lane 0 runs on the calling thread, the others run on their own threads
+    placement = POSPlacement::current();
+    this->_stop_lanes.store(false, std::memory_order_release);
+    for(i=1; i<this->_nb_lanes; i++){
+        this->lanes[i].thread = new std::thread(
+            &POSCheckpointCommitEngine::__lane_thread, this,
+            std::ref(this->lanes[i]), this->_round.load(std::memory_order_acquire), placement
+        );
+        POS_CHECK_POINTER(this->lanes[i].thread);
+    }
+    this->_is_init = true;
+
+exit:
+    if(unlikely(retval != POS_SUCCESS)){
+        for(; i>0; i--){ this->_backend->deinit_lane(this->lanes[i-1]); }
+        this->lanes.clear();
+    }
+    return retval;
+}
+
+
+void POSCheckpointCommitEngine::deinit(){
+    uint32_t i;
+    pos_retval_t retval;
+
+    if(this->_is_init == false){ return; }
+
+    this->_stop_lanes.store(true, std::memory_order_release);
+    this->_round_event.notify();
+    for(i=0; i<this->lanes.size(); i++){
+        if(this->lanes[i].thread == nullptr){ continue; }
+        if(this->lanes[i].thread->joinable()){ this->lanes[i].thread->join(); }
+        delete this->lanes[i].thread;
+        this->lanes[i].thread = nullptr;
+    }
+
+    for(i=0; i<this->lanes.size(); i++){
+        if(unlikely(POS_SUCCESS != (retval = this->_backend->deinit_lane(this->lanes[i])))){
+            POS_WARN_C("failed to deinit commit lane: lane_id(%u), retval(%u)", i, retval);
+        }
+    }
+    this->lanes.clear();
+    this->_is_init = false;
+}
+
+
+void POSCheckpointCommitEngine::dispatch(std::vector<pos_ckpt_commit_job_t>& jobs){
+    uint64_t i;
+    uint32_t j, lane_id;
+
+    for(j=0; j<this->lanes.size(); j++){ this->lanes[j].reset(); }
+
+    for(i=0; i<jobs.size(); i++){
+        // pick the lane with the fewest assigned bytes, the lane with smaller index wins if tied
+        lane_id = 0;
+        for(j=1; j<this->lanes.size(); j++){
+            if(this->lanes[j].assigned_bytes < this->lanes[lane_id].assigned_bytes){ lane_id = j; }
+        }
+        jobs[i].lane_id = lane_id;
+        jobs[i].retval = POS_SUCCESS;
+        this->lanes[lane_id].jobs.push_back(&jobs[i]);
+        this->lanes[lane_id].assigned_bytes += jobs[i].size;
+    }
+}
+
+
+pos_retval_t POSCheckpointCommitEngine::run(std::vector<pos_ckpt_commit_job_t>& jobs){
+    pos_retval_t retval = POS_SUCCESS;
+    uint32_t i, seq;
+    pos_wait_event_stat_t wait_stat;
+
+    POS_ASSERT(this->_is_init == true);
+
+    this->dispatch(jobs);
+
+    /*!
+     *  \note  every lane thread reports the round, even if no job is dispatched to it, so that
+     *         none of them still reads its jobs once we dispatch the next round
+     */
+    this->_nb_running_lanes.store(this->_nb_lanes - 1, std::memory_order_release);
+    this->_round.fetch_add(1, std::memory_order_acq_rel);
+    this->_round_event.notify();
+
+    if(this->lanes[0].jobs.size() > 0){
+        if(unlikely(POS_SUCCESS != (retval = this->_backend->init_lane_thread(this->lanes[0])))){
+            POS_WARN_C("failed to init thread of commit lane: lane_id(%u), retval(%u)", 0, retval);
+            this->__fail_lane(this->lanes[0], retval);
+        } else {
+            this->__run_lane(this->lanes[0]);
+        }
+    }
+
+    // wait until all lane threads are done with this round
+    while(true){
+        seq = this->_done_event.prepare();
+        if(this->_nb_running_lanes.load(std::memory_order_acquire) == 0){ break; }
+        this->_done_event.wait(seq, wait_stat);
+    }
+
+    retval = POS_SUCCESS;
+    for(i=0; i<this->lanes.size(); i++){
+        if(unlikely(this->lanes[i].retval != POS_SUCCESS)){
+            retval = this->lanes[i].retval;
+        }
+    }
+
+    return retval;
+}
+
+
+void POSCheckpointCommitEngine::__lane_thread(pos_ckpt_commit_lane_t& lane, uint64_t round, POSPlacement *placement){
+    pos_retval_t init_retval;
+    uint64_t new_round;
+    uint32_t seq;
+    pos_wait_event_stat_t wait_stat;
+
+    POSPlacementScope placement_scope(
+        /* placement */ placement,
+        /* role */ kPOS_PlacementRole_CommitLane,
+        /* name */ "commit_lane(" + std::to_string(lane.id) + ")"
+    );
+
+    if(unlikely(POS_SUCCESS != (init_retval = this->_backend->init_lane_thread(lane)))){
+        POS_WARN_C("failed to init thread of commit lane: lane_id(%u), retval(%u)", lane.id, init_retval);
+    }
+
+    while(true){
+        seq = this->_round_event.prepare();
+
+        new_round = this->_round.load(std::memory_order_acquire);
+        if(new_round != round){
+            round = new_round;
+            if(lane.jobs.size() > 0){
+                if(unlikely(init_retval != POS_SUCCESS)){
+                    this->__fail_lane(lane, init_retval);
+                } else {
+                    this->__run_lane(lane);
+                }
+            }
+            if(this->_nb_running_lanes.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                this->_done_event.notify();
+            }
+            continue;
+        }
+
+        if(this->_stop_lanes.load(std::memory_order_acquire) == true){ break; }
+
+        this->_round_event.wait(seq, wait_stat);
+    }
+}
+
+
+void POSCheckpointCommitEngine::__run_lane(pos_ckpt_commit_lane_t& lane){
+    pos_retval_t retval;
+    uint64_t i, j;
+    uint64_t s_tick, e_tick;
+    pos_ckpt_commit_job_t *job;
+
+    for(i=0; i<lane.jobs.size(); i++){
+        POS_CHECK_POINTER(job = lane.jobs[i]);
+
+        // stop this lane once the memory bus is used by the application
+        if(unlikely(this->_backend->is_bus_contended())){
+            retval = this->__wait_bus(lane);
+        } else if(unlikely(this->_backend->is_cancelled())){
+            retval = POS_FAILED_DRAIN;
+        } else {
+            retval = POS_SUCCESS;
+        }
+        if(unlikely(retval != POS_SUCCESS)){
+            // mark the remaining jobs as not committed
+            lane.retval = retval;
+            for(j=i; j<lane.jobs.size(); j++){ lane.jobs[j]->retval = retval; }
+            break;
+        }
+
+        s_tick = POSUtilTscTimer::get_tsc();
+        job->retval = this->_backend->commit(lane, *job);
+        e_tick = POSUtilTscTimer::get_tsc();
+        lane.commit_ticks += e_tick - s_tick;
+
+        if(unlikely(job->retval != POS_SUCCESS)){
+            lane.retval = job->retval;
+            continue;
+        }
+        lane.committed_bytes += job->size;
+        lane.nb_commits += 1;
+    }
+
+    s_tick = POSUtilTscTimer::get_tsc();
+    retval = this->_backend->sync_lane(lane);
+    e_tick = POSUtilTscTimer::get_tsc();
+    lane.commit_ticks += e_tick - s_tick;
+
+    if(unlikely(retval != POS_SUCCESS)){
+        // we can't tell which of the async commits failed, so mark all of them
+        POS_WARN_C("failed to sync commit lane: lane_id(%u), retval(%u)", lane.id, retval);
+        lane.retval = retval;
+        for(i=0; i<lane.jobs.size(); i++){
+            if(lane.jobs[i]->retval == POS_SUCCESS){ lane.jobs[i]->retval = retval; }
+        }
+        lane.committed_bytes = 0;
+        lane.nb_commits = 0;
+    }
+}
+
+
+void POSCheckpointCommitEngine::__fail_lane(pos_ckpt_commit_lane_t& lane, pos_retval_t retval){
+    uint64_t i;
+
+    lane.retval = retval;
+    for(i=0; i<lane.jobs.size(); i++){ lane.jobs[i]->retval = retval; }
+}
+
+
+pos_retval_t POSCheckpointCommitEngine::__wait_bus(pos_ckpt_commit_lane_t& lane){
+    pos_retval_t retval = POS_SUCCESS;
+    uint64_t s_tick, e_tick;
+    uint32_t seq = 0;
+    POSUtilWaitEvent *bus_event;
+    pos_wait_event_stat_t wait_stat;
+
+    s_tick = POSUtilTscTimer::get_tsc();
+    lane.nb_stops += 1;
+
+    // drain the commits already issued on this lane, so that none of them overlaps with the application
+    if(unlikely(POS_SUCCESS != (retval = this->_backend->sync_lane(lane)))){
+        POS_WARN_C("failed to sync commit lane before stopping: lane_id(%u), retval(%u)", lane.id, retval);
+        goto exit;
+    }
+
+    /*!
+     *  \note  the lane parks on the bus event of the backend, the cancellation isn't notified,
+     *         it's checked once the park timeout of the event expires
+     */
+    bus_event = this->_backend->get_bus_event();
+    while(true){
+        if(bus_event != nullptr){ seq = bus_event->prepare(); }
+        if(this->_backend->is_bus_contended() == false){ break; }
+        if(unlikely(this->_backend->is_cancelled())){
+            retval = POS_FAILED_DRAIN;
+            break;
+        }
+        if(bus_event != nullptr){
+            bus_event->wait(seq, wait_stat);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+exit:
+    e_tick = POSUtilTscTimer::get_tsc();
+    lane.stall_ticks += e_tick - s_tick;
+    return retval;
+}
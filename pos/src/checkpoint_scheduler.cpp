@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/handle.h"
+#include "pos/include/checkpoint_scheduler.h"
+
+
+uint64_t POSCheckpointScheduler::predict_next_write(POSHandle *handle, pos_u64id_t current_wqe_id){
+    uint64_t distance = UINT64_MAX;
+    pos_u64id_t pending_write_id;
+
+    POS_CHECK_POINTER(handle);
+
+    if(handle->nb_pending_writes.load(std::memory_order_acquire) > 0){
+        // case: there's pending API to write this handle
+        pending_write_id = handle->pending_write_id.load(std::memory_order_acquire);
+        distance = pending_write_id > current_wqe_id ? pending_write_id - current_wqe_id : 1;
+    } else if(handle->ckpt_write_freq > 0){
+        // case: no pending write, predict by write frequency in previous rounds
+        distance = kNoPendingWriteDistance + (uint64_t)((double)(kNoPendingWriteDistance) / handle->ckpt_write_freq);
+    }
+
+    return distance;
+}
+
+
+void POSCheckpointScheduler::schedule(
+    std::set<POSHandle*>& handles, pos_u64id_t current_wqe_id, std::vector<POSHandle*>& ordered_handles
+){
+    std::vector<std::pair<uint64_t, POSHandle*>> predicted_handles;
+
+    ordered_handles.clear();
+    ordered_handles.reserve(handles.size());
+
+    switch (this->policy)
+    {
+    case kPOS_CkptSchedPolicy_FIFO:
+        ordered_handles.insert(ordered_handles.end(), handles.begin(), handles.end());
+        break;
+
+    case kPOS_CkptSchedPolicy_Size:
+        ordered_handles.insert(ordered_handles.end(), handles.begin(), handles.end());
+        std::stable_sort(ordered_handles.begin(), ordered_handles.end(), [](POSHandle *a, POSHandle *b){
+            return a->state_size < b->state_size;
+        });
+        break;
+
+    case kPOS_CkptSchedPolicy_PredictedWrite:
+        // note: we predict once for each handle, as the prediction is based on fields updated concurrently
+        predicted_handles.reserve(handles.size());
+        for(auto &handle : handles){
+            predicted_handles.push_back({ POSCheckpointScheduler::predict_next_write(handle, current_wqe_id), handle });
+        }
+        std::stable_sort(
+            predicted_handles.begin(), predicted_handles.end(),
+            [](const std::pair<uint64_t, POSHandle*>& a, const std::pair<uint64_t, POSHandle*>& b){
+                // commit the handles to be written sooner first, and commit the smaller one first if tied
+                if(a.first != b.first)
+                    return a.first < b.first;
+                return a.second->state_size < b.second->state_size;
+            }
+        );
+        for(auto &predicted_handle : predicted_handles){
+            ordered_handles.push_back(predicted_handle.second);
+        }
+        break;
+
+    default:
+        POS_ERROR_C_DETAIL("unknown checkpoint scheduling policy %u, this is a bug", this->policy);
+    }
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/timer.h"
+#include "pos/include/checkpoint_throttle.h"
+
+
+POSCheckpointThrottle::POSCheckpointThrottle()
+    :   _rate_bps(0), _burst_bytes(0), _is_derived_burst(false), _max_slowdown_pct(0), _rate_bpt(0), _tokens(0),
+        _app_copy_bytes(0), _app_copy_ticks(0), _app_copy_bpt(0), _app_copy_util(0)
+{
+    this->_last_refill_tick = POSUtilTscTimer::get_tsc();
+    this->_last_adapt_tick = this->_last_refill_tick;
+}
+
+
+void POSCheckpointThrottle::configure(uint64_t rate_bps, uint64_t burst_bytes, uint32_t max_slowdown_pct){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    bool is_derived_burst;
+
+    // without a configured rate, the bucket size follows the rate derived from the slowdown bound
+    is_derived_burst = rate_bps == 0 && burst_bytes == 0 && max_slowdown_pct > 0;
+    if(burst_bytes == 0){ burst_bytes = rate_bps / 1000; }
+
+    // keep the bucket and the adaptation state if nothing changed
+    if(     rate_bps == this->_rate_bps.load(std::memory_order_relaxed)
+        &&  burst_bytes == this->_burst_bytes
+        &&  max_slowdown_pct == this->_max_slowdown_pct.load(std::memory_order_relaxed)
+    ){
+        return;
+    }
+
+    this->_rate_bps.store(rate_bps, std::memory_order_relaxed);
+    this->_burst_bytes = burst_bytes;
+    this->_is_derived_burst = is_derived_burst;
+    this->_max_slowdown_pct.store(max_slowdown_pct, std::memory_order_relaxed);
+    this->_rate_bpt = rate_bps > 0
+                    ? (double)(rate_bps) / this->_tsc_timer.us_to_tick(1000000)
+                    : std::numeric_limits<double>::infinity();
+
+    // start with a full bucket
+    this->_tokens = (double)(burst_bytes);
+    this->_last_refill_tick = POSUtilTscTimer::get_tsc();
+    this->_last_adapt_tick = this->_last_refill_tick;
+    this->_app_copy_bytes.store(0, std::memory_order_relaxed);
+    this->_app_copy_ticks.store(0, std::memory_order_relaxed);
+    this->_app_copy_bpt = 0;
+    this->_app_copy_util = 0;
+}
+
+
+void POSCheckpointThrottle::__refill(uint64_t tick){
+    uint64_t window_ticks, app_bytes, app_ticks;
+    double rate_bpt, app_util;
+
+    // update the adapted rate once per window
+    window_ticks = tick - this->_last_adapt_tick;
+    if(this->_max_slowdown_pct.load(std::memory_order_relaxed) > 0 && window_ticks >= this->_tsc_timer.us_to_tick(kAdaptWindowUs)){
+        app_bytes = this->_app_copy_bytes.exchange(0, std::memory_order_relaxed);
+        app_ticks = this->_app_copy_ticks.exchange(0, std::memory_order_relaxed);
+
+        app_util = std::min(1.0, (double)(app_ticks) / (double)(window_ticks));
+        this->_app_copy_util = kAdaptEwmaAlpha * app_util + (1.0 - kAdaptEwmaAlpha) * this->_app_copy_util;
+        if(app_ticks > 0){
+            this->_app_copy_bpt = kAdaptEwmaAlpha * ((double)(app_bytes) / (double)(app_ticks))
+                                + (1.0 - kAdaptEwmaAlpha) * this->_app_copy_bpt;
+        }
+
+        rate_bpt = this->_rate_bps.load(std::memory_order_relaxed) > 0
+                 ? (double)(this->_rate_bps.load(std::memory_order_relaxed)) / this->_tsc_timer.us_to_tick(1000000)
+                 : std::numeric_limits<double>::infinity();
+        if(this->_app_copy_util > 0 && this->_app_copy_bpt > 0){
+            rate_bpt = std::min(
+                rate_bpt,
+                (double)(this->_max_slowdown_pct.load(std::memory_order_relaxed)) / 100.0
+                    * this->_app_copy_bpt / this->_app_copy_util
+            );
+        }
+        this->_rate_bpt = rate_bpt;
+        this->_last_adapt_tick = tick;
+
+        if(this->_is_derived_burst && !std::isinf(rate_bpt)){
+            this->_burst_bytes = std::max<uint64_t>((uint64_t)(rate_bpt * this->_tsc_timer.us_to_tick(1000)), 1);
+        }
+    }
+
+    if(std::isinf(this->_rate_bpt)){
+        this->_tokens = (double)(this->_burst_bytes);
+    } else {
+        this->_tokens = std::min(
+            (double)(this->_burst_bytes),
+            this->_tokens + (double)(tick - this->_last_refill_tick) * this->_rate_bpt
+        );
+    }
+    this->_last_refill_tick = tick;
+}
+
+
+pos_retval_t POSCheckpointThrottle::acquire(uint64_t bytes, uint64_t& throttled_ticks, const volatile bool *cancel_flag){
+    pos_retval_t retval = POS_SUCCESS;
+    uint64_t s_tick, tick, wait_us;
+    double needed;
+    bool has_waited = false;
+
+    throttled_ticks = 0;
+    if(this->is_enabled() == false){ goto exit; }
+
+    s_tick = POSUtilTscTimer::get_tsc();
+    while(true){
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+
+            // the rate limiter might be disabled while waiting
+            if(unlikely(this->is_enabled() == false)){ break; }
+
+            tick = POSUtilTscTimer::get_tsc();
+            this->__refill(tick);
+
+            // no rate is configured, and no application copy is observed to derive one
+            if(std::isinf(this->_rate_bpt)){ break; }
+
+            needed = (double)(std::min(bytes, this->_burst_bytes));
+            if(this->_tokens >= needed){
+                this->_tokens -= (double)(bytes);
+                break;
+            }
+            wait_us = this->_rate_bpt > 0
+                    ? (uint64_t)(this->_tsc_timer.tick_to_us((uint64_t)((needed - this->_tokens) / this->_rate_bpt)))
+                    : kSleepThresholdUs;
+        }
+
+        if(cancel_flag != nullptr && unlikely(*cancel_flag == true)){
+            retval = POS_FAILED_DRAIN;
+            break;
+        }
+
+        has_waited = true;
+        if(wait_us >= kSleepThresholdUs){
+            std::this_thread::sleep_for(std::chrono::microseconds(std::min(wait_us, kMaxSleepUs)));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    if(has_waited){
+        throttled_ticks = POSUtilTscTimer::get_tsc() - s_tick;
+    }
+
+exit:
+    return retval;
+}
+
+
+uint64_t POSCheckpointThrottle::get_effective_rate(){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if(this->is_enabled() == false || std::isinf(this->_rate_bpt)){ return 0; }
+    return (uint64_t)(this->_rate_bpt * this->_tsc_timer.us_to_tick(1000000));
+}
@@ -39,9 +39,14 @@ POSClient::POSClient(pos_client_uuid_t id, __pid_t pid, pos_client_cxt_t cxt, PO
         status(kPOS_ClientStatus_CreatePending),
         is_under_sync_call(false),
         offline_counter(0),
+        nb_rpc_refs(0),
+        is_removed(false),
         _api_inst_pc(0), 
         _cxt(cxt),
-        _ws(ws)
+        _ws(ws),
+        _has_async_error(false),
+        _async_error_code(0),
+        _api_trace_ring(nullptr)
 {}
 
 
@@ -51,7 +56,12 @@ POSClient::POSClient()
         status(kPOS_ClientStatus_CreatePending),
         is_under_sync_call(false),
         offline_counter(0),
-        _ws(nullptr)
+        nb_rpc_refs(0),
+        is_removed(false),
+        _ws(nullptr),
+        _has_async_error(false),
+        _async_error_code(0),
+        _api_trace_ring(nullptr)
 {
     POS_ERROR_C("shouldn't call, just for passing compilation");
 }
@@ -61,6 +71,34 @@ void POSClient::init(bool is_restoring){
     pos_retval_t retval = POS_SUCCESS;
     std::map<pos_u64id_t, POSAPIContext_QE_t*> apicxt_sequence_map;
     std::multimap<pos_u64id_t, POSHandle*> missing_handle_map;
+    uint64_t spin_us, yield_us, park_timeout_us;
+    std::string conf_val;
+
+    // setup the budgets of waiting while idle
+    spin_us = POSUtilWaitEvent::kDefaultSpinUs;
+    yield_us = POSUtilWaitEvent::kDefaultYieldUs;
+    park_timeout_us = POSUtilWaitEvent::kDefaultParkTimeoutUs;
+    if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeWaitSpinUs, conf_val))){
+        spin_us = std::stoull(conf_val);
+    }
+    if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeWaitYieldUs, conf_val))){
+        yield_us = std::stoull(conf_val);
+    }
+    if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeWaitParkTimeoutUs, conf_val))){
+        park_timeout_us = std::stoull(conf_val);
+    }
+    for(POSUtilWaitEvent *event : { &this->parser_wait_event, &this->worker_wait_event, &this->rpc_wait_event }){
+        event->set_budget(
+            /* spin_ticks */ this->_ws->tsc_timer.us_to_tick(spin_us),
+            /* yield_ticks */ this->_ws->tsc_timer.us_to_tick(yield_us),
+            /* park_timeout_us */ park_timeout_us
+        );
+    }
+    this->sync_completion.set_budget(
+        /* spin_ticks */ this->_ws->tsc_timer.us_to_tick(spin_us),
+        /* yield_ticks */ this->_ws->tsc_timer.us_to_tick(yield_us),
+        /* park_timeout_us */ park_timeout_us
+    );
 
     if(unlikely(POS_SUCCESS != (
         retval = this->init_handle_managers(is_restoring)
@@ -76,6 +114,16 @@ void POSClient::init(bool is_restoring){
         goto exit;
     }
 
+    // record parsed APIs into the trace ring under resource trace mode
+    if(this->_cxt.trace_resource){
+        POS_CHECK_POINTER(this->_api_trace_ring = new POSApiTraceRing(this->id, this->pid));
+        if(unlikely(POS_SUCCESS != this->_ws->add_api_trace_ring(this->_api_trace_ring))){
+            POS_WARN_C("failed to start API trace writer, APIs of the client won't be traced");
+            delete this->_api_trace_ring;
+            this->_api_trace_ring = nullptr;
+        }
+    }
+
 exit:
     if(unlikely(retval != POS_SUCCESS)){
         this->status = kPOS_ClientStatus_Hang;
@@ -89,7 +137,7 @@ exit:
         if(is_restoring == true){
             this->status = kPOS_ClientStatus_Hang;
         } else {
-            this->status = kPOS_ClientStatus_Active;
+            this->set_status(kPOS_ClientStatus_Active);
         }
     }
 }
@@ -109,12 +157,24 @@ void POSClient::deinit(){
     // stop parser and worker to poll
     this->status = kPOS_ClientStatus_Hang;
 
-    // destory queue group
+    // shutdown parser and worker, their daemons (and the checkpoint thread) are joined
+    if(this->parser != nullptr){ delete this->parser; this->parser = nullptr; }
+    if(this->worker != nullptr){ delete this->worker; this->worker = nullptr; }
+
+    // drain the API trace ring once the parser is stopped
+    if(this->_api_trace_ring != nullptr){
+        this->_ws->remove_api_trace_ring(this->_api_trace_ring);
+        delete this->_api_trace_ring;
+        this->_api_trace_ring = nullptr;
+    }
+
+    // destory queue group, along with the pool of WQEs, after no daemon could access them
     this->__destory_qgroup();
 
-    // shutdown parser and worker
-    if(this->parser != nullptr){ delete this->parser; }
-    if(this->worker != nullptr){ delete this->worker; }
+    POS_LOG_C("parser wait event: %s", this->parser_wait_event.str(this->_ws->tsc_timer).c_str());
+    POS_LOG_C("worker wait event: %s", this->worker_wait_event.str(this->_ws->tsc_timer).c_str());
+    POS_LOG_C("rpc wait event: %s", this->rpc_wait_event.str(this->_ws->tsc_timer).c_str());
+    POS_LOG_C("sync call completion: %s", this->sync_completion.str(this->_ws->tsc_timer).c_str());
 
 exit:
     ;
@@ -396,7 +456,6 @@ pos_retval_t POSClient::push_q(void *qe){
     static_assert(
             qtype == kPOS_QueueType_ApiCxt_WQ || qtype == kPOS_QueueType_ApiCxt_CQ
         ||  qtype == kPOS_QueueType_ApiCxt_CkptDag_WQ
-        ||  qtype == kPOS_QueueType_ApiCxt_Trace_WQ
         ||  qtype == kPOS_QueueType_Cmd_WQ || qtype == kPOS_QueueType_Cmd_CQ,
         "unknown queue type obtained"
     );
@@ -447,18 +506,6 @@ pos_retval_t POSClient::push_q(void *qe){
         this->_apicxt_workerlocal_ckptdag_wq->push(apictx_qe);
     }
 
-    // api context trace queue 
-    if constexpr (qtype == kPOS_QueueType_ApiCxt_Trace_WQ) {
-        POS_CHECK_POINTER(apictx_qe = reinterpret_cast<POSAPIContext_QE_t*>(qe));
-
-        static_assert(
-            qdir == kPOS_QueueDirection_ParserLocal,
-            "ApiCxt_Trace_WQE can only be pushed to parser local queue"
-        );
-
-        this->_apicxt_parserlocal_trace_wq->push(apictx_qe);
-    }
-
     // command work queue
     if constexpr (qtype == kPOS_QueueType_Cmd_WQ){
         POS_CHECK_POINTER(cmd_qe = reinterpret_cast<POSCommand_QE_t*>(qe));
@@ -491,6 +538,8 @@ pos_retval_t POSClient::push_q(void *qe){
         }
     }
 
+    this->__notify_consumer<qdir, qtype>();
+
 exit:
     return retval;
 }
@@ -499,7 +548,6 @@ template pos_retval_t POSClient::push_q<kPOS_QueueDirection_Rpc2Parser, kPOS_Que
 template pos_retval_t POSClient::push_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(void *qe);
 template pos_retval_t POSClient::push_q<kPOS_QueueDirection_Rpc2Worker, kPOS_QueueType_ApiCxt_CQ>(void *qe);
 template pos_retval_t POSClient::push_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>(void *qe);
-template pos_retval_t POSClient::push_q<kPOS_QueueDirection_ParserLocal, kPOS_QueueType_ApiCxt_Trace_WQ>(void *qe);
 template pos_retval_t POSClient::push_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_WQ>(void *qe);
 template pos_retval_t POSClient::push_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_CQ>(void *qe);
 template pos_retval_t POSClient::push_q<kPOS_QueueDirection_Oob2Parser, kPOS_QueueType_Cmd_WQ>(void *qe);
@@ -513,7 +561,6 @@ pos_retval_t POSClient::clear_q(){
     static_assert(
             qtype == kPOS_QueueType_ApiCxt_WQ || qtype == kPOS_QueueType_ApiCxt_CQ
         ||  qtype == kPOS_QueueType_ApiCxt_CkptDag_WQ
-        ||  qtype == kPOS_QueueType_ApiCxt_Trace_WQ
         ||  qtype == kPOS_QueueType_Cmd_WQ || qtype == kPOS_QueueType_Cmd_CQ,
         "unknown queue type obtained"
     );
@@ -553,15 +600,6 @@ pos_retval_t POSClient::clear_q(){
         this->_apicxt_workerlocal_ckptdag_wq->drain();
     }
 
-    // api context trace queue 
-    if constexpr (qtype == kPOS_QueueType_ApiCxt_Trace_WQ) {
-        static_assert(
-            qdir == kPOS_QueueDirection_ParserLocal,
-            "ApiCxt_CkptDag_WQE can only be located within parser local queue"
-        );
-        this->_apicxt_parserlocal_trace_wq->drain();
-    }
-
     // command work queue
     if constexpr (qtype == kPOS_QueueType_Cmd_WQ){
         static_assert(
@@ -598,7 +636,6 @@ template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_Rpc2Parser, kPOS_Qu
 template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>();
 template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_Rpc2Worker, kPOS_QueueType_ApiCxt_CQ>();
 template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>();
-template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_ParserLocal, kPOS_QueueType_ApiCxt_Trace_WQ>();
 template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_WQ>();
 template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_CQ>();
 template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_Oob2Parser, kPOS_QueueType_Cmd_WQ>();
@@ -606,31 +643,24 @@ template pos_retval_t POSClient::clear_q<kPOS_QueueDirection_Oob2Parser, kPOS_Qu
 
 
 template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
-pos_retval_t POSClient::poll_q(std::vector<POSAPIContext_QE*>* qes){
-    pos_retval_t retval = POS_SUCCESS;
-    POSAPIContext_QE *apicxt_qe;
-    POSLockFreeQueue<POSAPIContext_QE_t*> *apicxt_q;
-
+POSLockFreeQueue<POSAPIContext_QE_t*>* POSClient::__get_apicxt_q(){
     static_assert(
             qtype == kPOS_QueueType_ApiCxt_WQ 
         ||  qtype == kPOS_QueueType_ApiCxt_CQ 
-        ||  qtype == kPOS_QueueType_ApiCxt_CkptDag_WQ
-        ||  qtype == kPOS_QueueType_ApiCxt_Trace_WQ,
+        ||  qtype == kPOS_QueueType_ApiCxt_CkptDag_WQ,
         "invalid queue type obtained"
     );
 
-    POS_CHECK_POINTER(qes);
-
     // api context work queue
     if constexpr (qtype == kPOS_QueueType_ApiCxt_WQ){
         static_assert(
             qdir == kPOS_QueueDirection_Rpc2Parser || qdir == kPOS_QueueDirection_Parser2Worker,
-            "POSAPIContext_WQE can only be poll from rpc2parser or parser2worker queue"
+            "POSAPIContext_WQE can only be located within rpc2parser or parser2worker queue"
         );
         if constexpr (qdir == kPOS_QueueDirection_Rpc2Parser){
-            apicxt_q = this->_apicxt_rpc2parser_wq;
+            return this->_apicxt_rpc2parser_wq;
         } else { // kPOS_QueueDirection_Parser2Worker
-            apicxt_q = this->_apicxt_parser2worker_wq;
+            return this->_apicxt_parser2worker_wq;
         }
     }
 
@@ -638,12 +668,12 @@ pos_retval_t POSClient::poll_q(std::vector<POSAPIContext_QE*>* qes){
     if constexpr (qtype == kPOS_QueueType_ApiCxt_CQ){
         static_assert(
             qdir == kPOS_QueueDirection_Rpc2Parser || qdir == kPOS_QueueDirection_Rpc2Worker,
-            "POSAPIContext_CQE can only be poll from rpc2parser or parser2worker queue"
+            "POSAPIContext_CQE can only be located within rpc2parser or rpc2worker queue"
         );
         if constexpr (qdir == kPOS_QueueDirection_Rpc2Parser){
-            apicxt_q = this->_apicxt_rpc2parser_cq;
+            return this->_apicxt_rpc2parser_cq;
         } else { // kPOS_QueueDirection_Rpc2Worker
-            apicxt_q = this->_apicxt_rpc2worker_cq;
+            return this->_apicxt_rpc2worker_cq;
         }
     }
 
@@ -653,18 +683,77 @@ pos_retval_t POSClient::poll_q(std::vector<POSAPIContext_QE*>* qes){
             qdir == kPOS_QueueDirection_WorkerLocal,
             "ApiCxt_CkptDag_WQE can only be passed within worker local queue"
         );
-        apicxt_q = this->_apicxt_workerlocal_ckptdag_wq;
+        return this->_apicxt_workerlocal_ckptdag_wq;
     }
+}
 
-    // api context trace work queue
-    if constexpr (qtype == kPOS_QueueType_ApiCxt_Trace_WQ){
-        static_assert(
-            qdir == kPOS_QueueDirection_ParserLocal,
-            "ApiCxt_CkptDag_WQE can only be passed within parser local queue"
-        );
-        apicxt_q = this->_apicxt_parserlocal_trace_wq;
+
+template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+POSLockFreeQueue<POSCommand_QE_t*>* POSClient::__get_cmd_q(){
+    static_assert(
+        qtype == kPOS_QueueType_Cmd_WQ || qtype == kPOS_QueueType_Cmd_CQ,
+        "invalid queue type obtained"
+    );
+    static_assert(
+        qdir == kPOS_QueueDirection_Parser2Worker || qdir == kPOS_QueueDirection_Oob2Parser,
+        "POSCommand_QE can only be located within parser2worker or oob2parser queue"
+    );
+
+    // command work queue
+    if constexpr (qtype == kPOS_QueueType_Cmd_WQ){
+        if constexpr (qdir == kPOS_QueueDirection_Parser2Worker){
+            return this->_cmd_parser2worker_wq;
+        } else { // kPOS_QueueDirection_Oob2Parser
+            return this->_cmd_oob2parser_wq;
+        }
     }
 
+    // command completion queue
+    if constexpr (qtype == kPOS_QueueType_Cmd_CQ){
+        if constexpr (qdir == kPOS_QueueDirection_Parser2Worker){
+            return this->_cmd_parser2worker_cq;
+        } else { // kPOS_QueueDirection_Oob2Parser
+            return this->_cmd_oob2parser_cq;
+        }
+    }
+}
+
+
+template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+pos_retval_t POSClient::push_q_bulk(POSAPIContext_QE_t** qes, uint64_t nb_qes){
+    pos_retval_t retval = POS_SUCCESS;
+    POSLockFreeQueue<POSAPIContext_QE_t*> *apicxt_q;
+
+    POS_CHECK_POINTER(qes);
+    if(nb_qes == 0){ goto exit; }
+
+    apicxt_q = this->__get_apicxt_q<qdir, qtype>();
+    POS_CHECK_POINTER(apicxt_q);
+    if(unlikely(apicxt_q->enqueue_bulk(qes, nb_qes) != nb_qes)){
+        POS_WARN_C("failed to push all queue elements: nb_qes(%lu)", nb_qes);
+        retval = POS_FAILED;
+    }
+    this->__notify_consumer<qdir, qtype>();
+
+exit:
+    return retval;
+}
+template pos_retval_t POSClient::push_q_bulk<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_WQ>(POSAPIContext_QE_t** qes, uint64_t nb_qes);
+template pos_retval_t POSClient::push_q_bulk<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_CQ>(POSAPIContext_QE_t** qes, uint64_t nb_qes);
+template pos_retval_t POSClient::push_q_bulk<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(POSAPIContext_QE_t** qes, uint64_t nb_qes);
+template pos_retval_t POSClient::push_q_bulk<kPOS_QueueDirection_Rpc2Worker, kPOS_QueueType_ApiCxt_CQ>(POSAPIContext_QE_t** qes, uint64_t nb_qes);
+template pos_retval_t POSClient::push_q_bulk<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>(POSAPIContext_QE_t** qes, uint64_t nb_qes);
+
+
+template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+pos_retval_t POSClient::poll_q(std::vector<POSAPIContext_QE*>* qes){
+    pos_retval_t retval = POS_SUCCESS;
+    POSAPIContext_QE *apicxt_qe;
+    POSLockFreeQueue<POSAPIContext_QE_t*> *apicxt_q;
+
+    POS_CHECK_POINTER(qes);
+
+    apicxt_q = this->__get_apicxt_q<qdir, qtype>();
     POS_CHECK_POINTER(apicxt_q);
     while(POS_SUCCESS == apicxt_q->dequeue(apicxt_qe)){
         qes->push_back(apicxt_qe);
@@ -676,50 +765,40 @@ exit:
 template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_WQ>(std::vector<POSAPIContext_QE*>* qes);
 template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(std::vector<POSAPIContext_QE*>* qes);
 template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>(std::vector<POSAPIContext_QE*>* qes);
-template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_ParserLocal, kPOS_QueueType_ApiCxt_Trace_WQ>(std::vector<POSAPIContext_QE*>* qes);
 template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_CQ>(std::vector<POSAPIContext_QE*>* qes);
 template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Rpc2Worker, kPOS_QueueType_ApiCxt_CQ>(std::vector<POSAPIContext_QE*>* qes);
 
 
+template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+pos_retval_t POSClient::poll_q(POSAPIContext_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes){
+    pos_retval_t retval = POS_SUCCESS;
+    POSLockFreeQueue<POSAPIContext_QE_t*> *apicxt_q;
+
+    POS_CHECK_POINTER(qes);
+
+    apicxt_q = this->__get_apicxt_q<qdir, qtype>();
+    POS_CHECK_POINTER(apicxt_q);
+    nb_qes = apicxt_q->dequeue_bulk(qes, max_nb_qes);
+
+exit:
+    return retval;
+}
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_WQ>(POSAPIContext_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(POSAPIContext_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>(POSAPIContext_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_CQ>(POSAPIContext_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Rpc2Worker, kPOS_QueueType_ApiCxt_CQ>(POSAPIContext_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+
+
 template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
 pos_retval_t POSClient::poll_q(std::vector<POSCommand_QE_t*>* qes){
     pos_retval_t retval = POS_SUCCESS;
     POSCommand_QE_t *cmd_qe;
     POSLockFreeQueue<POSCommand_QE_t*> *cmd_q;
-    
-    static_assert(
-        qtype == kPOS_QueueType_Cmd_WQ || qtype == kPOS_QueueType_Cmd_CQ,
-        "invalid queue type obtained"
-    );
 
     POS_CHECK_POINTER(qes);
 
-    // command work queue
-    if constexpr (qtype == kPOS_QueueType_Cmd_WQ){
-        static_assert(
-            qdir == kPOS_QueueDirection_Parser2Worker || qdir == kPOS_QueueDirection_Oob2Parser,
-            "POSCommand_WQE can only be polled from parser2worker or oob2parser queue"
-        );
-        if constexpr (qdir == kPOS_QueueDirection_Parser2Worker){
-            cmd_q = this->_cmd_parser2worker_wq;
-        } else { // kPOS_QueueDirection_Oob2Parser
-            cmd_q = this->_cmd_oob2parser_wq;
-        }
-    }
-
-    // command completion queue
-    if constexpr (qtype == kPOS_QueueType_Cmd_CQ){
-        static_assert(
-            qdir == kPOS_QueueDirection_Parser2Worker || qdir == kPOS_QueueDirection_Oob2Parser,
-            "POSCommand_CQE can only be polled from parser2worker or oob2parser queue"
-        );
-        if constexpr (qdir == kPOS_QueueDirection_Parser2Worker){
-            cmd_q = this->_cmd_parser2worker_cq;
-        } else { // kPOS_QueueDirection_Oob2Parser
-            cmd_q = this->_cmd_oob2parser_cq;
-        }
-    }
-
+    cmd_q = this->__get_cmd_q<qdir, qtype>();
     POS_CHECK_POINTER(cmd_q);
     while(POS_SUCCESS == cmd_q->dequeue(cmd_qe)){
         qes->push_back(cmd_qe);
@@ -734,6 +813,26 @@ template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_
 template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Oob2Parser, kPOS_QueueType_Cmd_CQ>(std::vector<POSCommand_QE_t*>* qes);
 
 
+template<pos_queue_direction_t qdir, pos_queue_type_t qtype>
+pos_retval_t POSClient::poll_q(POSCommand_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes){
+    pos_retval_t retval = POS_SUCCESS;
+    POSLockFreeQueue<POSCommand_QE_t*> *cmd_q;
+
+    POS_CHECK_POINTER(qes);
+
+    cmd_q = this->__get_cmd_q<qdir, qtype>();
+    POS_CHECK_POINTER(cmd_q);
+    nb_qes = cmd_q->dequeue_bulk(qes, max_nb_qes);
+
+exit:
+    return retval;
+}
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_WQ>(POSCommand_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Oob2Parser, kPOS_QueueType_Cmd_WQ>(POSCommand_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_CQ>(POSCommand_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+template pos_retval_t POSClient::poll_q<kPOS_QueueDirection_Oob2Parser, kPOS_QueueType_Cmd_CQ>(POSCommand_QE_t** qes, uint64_t max_nb_qes, uint64_t& nb_qes);
+
+
 pos_retval_t POSClient::__create_qgroup(){
     pos_retval_t retval = POS_SUCCESS;
 
@@ -762,11 +861,6 @@ pos_retval_t POSClient::__create_qgroup(){
     POS_CHECK_POINTER(this->_apicxt_workerlocal_ckptdag_wq);
     POS_DEBUG_C("created workerlocal ckptdag apicxt WQ: uuid(%lu)", this->id);
 
-    // parserlocal apicxt trace queue
-    this->_apicxt_parserlocal_trace_wq = new POSLockFreeQueue<POSAPIContext_QE_t*>();
-    POS_CHECK_POINTER(this->_apicxt_parserlocal_trace_wq);
-    POS_DEBUG_C("created parserlocal trace apicxt WQ: uuid(%lu)", this->id);
-
     // parser2worker cmd work queue
     this->_cmd_parser2worker_wq = new POSLockFreeQueue<POSCommand_QE_t*>();
     POS_CHECK_POINTER(this->_cmd_parser2worker_wq);
@@ -787,6 +881,11 @@ pos_retval_t POSClient::__create_qgroup(){
     POS_CHECK_POINTER(this->_cmd_oob2parser_cq);
     POS_DEBUG_C("created oob2parser cmd CQ: uuid(%lu)", this->id);
 
+    // pool of apicxt queue elements
+    this->_apicxt_pool = new POSAPIContextPool();
+    POS_CHECK_POINTER(this->_apicxt_pool);
+    POS_DEBUG_C("created apicxt pool: uuid(%lu)", this->id);
+
     return retval;
 }
 
@@ -824,12 +923,6 @@ pos_retval_t POSClient::__destory_qgroup(){
     delete this->_apicxt_workerlocal_ckptdag_wq;
     POS_DEBUG_C("destoryed workerlocal_ckptdag apicxt WQ: uuid(%lu)", this->id);
 
-    // parserlocal trace apicxt work queue
-    POS_CHECK_POINTER(this->_apicxt_parserlocal_trace_wq);
-    this->_apicxt_parserlocal_trace_wq->lock();
-    delete this->_apicxt_parserlocal_trace_wq;
-    POS_DEBUG_C("destoryed parserlocal trace apicxt WQ: uuid(%lu)", this->id);
-
     // parser2worker cmd work queue
     POS_CHECK_POINTER(this->_cmd_parser2worker_wq);
     this->_cmd_parser2worker_wq->lock();
@@ -854,6 +947,12 @@ pos_retval_t POSClient::__destory_qgroup(){
     delete this->_cmd_oob2parser_cq;
     POS_DEBUG_C("destoryed oob2parser cmd CQ: uuid(%lu)", this->id);
 
+    // pool of apicxt queue elements, all WQEs are dropped along with it
+    POS_CHECK_POINTER(this->_apicxt_pool);
+    delete this->_apicxt_pool;
+    this->_apicxt_pool = nullptr;
+    POS_DEBUG_C("destoryed apicxt pool: uuid(%lu)", this->id);
+
 exit:
     return retval;
 }
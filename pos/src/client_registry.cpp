@@ -0,0 +1,318 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/client_registry.h"
+
+
+/*!
+ *  \brief  slot of a thread that enters read sections
+ *  \note   epoch is the global epoch when the thread entered the outermost read section, 0 for not in any
+ */
+typedef struct alignas(64) pos_client_registry_reader_slot {
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool> is_used;
+} pos_client_registry_reader_slot_t;
+
+static pos_client_registry_reader_slot_t __reader_slots[POSClientRegistry::kMaxNbReaders];
+
+// number of slots ever used, so that writers don't have to scan all slots
+static std::atomic<uint32_t> __nb_reader_slots(0);
+
+// global epoch, bumped by each grace period
+static std::atomic<uint64_t> __epoch(1);
+
+/*!
+ *  \brief  read-side state of a thread, its slot is returned once the thread exits
+ */
+typedef struct pos_client_registry_reader {
+    int64_t slot;
+    uint64_t depth;
+
+    pos_client_registry_reader() : slot(-1), depth(0) {}
+    ~pos_client_registry_reader(){
+        if(this->slot >= 0){
+            __reader_slots[this->slot].epoch.store(0, std::memory_order_release);
+            __reader_slots[this->slot].is_used.store(false, std::memory_order_release);
+        }
+    }
+} pos_client_registry_reader_t;
+
+static thread_local pos_client_registry_reader_t __reader;
+
+
+POSClientRegistry::POSClientRegistry() : _max_uuid(0) {
+    uint64_t i;
+
+    for(i=0; i<kMaxNbChunks; i++){
+        this->_chunks[i].store(nullptr, std::memory_order_relaxed);
+        this->_pids[i] = nullptr;
+    }
+    this->_pid_index.store(
+        POSClientRegistry::__create_pid_index(/* from */ nullptr, /* nb_reserved */ 0), std::memory_order_release
+    );
+}
+
+
+POSClientRegistry::~POSClientRegistry(){
+    uint64_t i;
+
+    for(i=0; i<kMaxNbChunks; i++){
+        if(this->_chunks[i].load(std::memory_order_relaxed) != nullptr){
+            delete[] this->_chunks[i].load(std::memory_order_relaxed);
+        }
+        if(this->_pids[i] != nullptr){ delete[] this->_pids[i]; }
+    }
+    delete[] this->_pid_index.load(std::memory_order_relaxed)->entries;
+    delete this->_pid_index.load(std::memory_order_relaxed);
+}
+
+
+pos_retval_t POSClientRegistry::insert(pos_client_uuid_t uuid, __pid_t pid, POSClient *client){
+    pos_retval_t retval = POS_SUCCESS;
+    std::atomic<POSClient*> *chunk;
+    pid_index_t *index, *new_index = nullptr;
+    pos_client_uuid_t max_uuid;
+    uint64_t i;
+
+    POS_CHECK_POINTER(client);
+
+    if(unlikely(uuid >= kMaxNbClients)){
+        POS_WARN_C("failed to register client, uuid out of range: uuid(%lu), max(%lu)", uuid, kMaxNbClients);
+        retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        // allocate the chunk if it's the first client within it
+        chunk = this->_chunks[uuid / kChunkSize].load(std::memory_order_relaxed);
+        if(unlikely(chunk == nullptr)){
+            POS_CHECK_POINTER(chunk = new std::atomic<POSClient*>[kChunkSize]);
+            for(i=0; i<kChunkSize; i++){ chunk[i].store(nullptr, std::memory_order_relaxed); }
+            POS_CHECK_POINTER(this->_pids[uuid / kChunkSize] = new __pid_t[kChunkSize]);
+            this->_chunks[uuid / kChunkSize].store(chunk, std::memory_order_release);
+        }
+
+        if(unlikely(chunk[uuid % kChunkSize].load(std::memory_order_relaxed) != nullptr)){
+            POS_WARN_C("failed to register client, uuid already registered: uuid(%lu)", uuid);
+            retval = POS_FAILED_ALREADY_EXIST;
+            goto exit;
+        }
+
+        // index by pid, a new table is published if the current one is filled up
+        POS_CHECK_POINTER(index = this->_pid_index.load(std::memory_order_relaxed));
+        POSClientRegistry::__pid_index_remove(index, pid, /* uuid */ UINT64_MAX);
+        if(unlikely((index->nb_used + 1) * 4 > index->capacity * 3)){
+            new_index = POSClientRegistry::__create_pid_index(/* from */ index, /* nb_reserved */ 1);
+            POSClientRegistry::__pid_index_insert(new_index, pid, uuid);
+            this->_pid_index.store(new_index, std::memory_order_seq_cst);
+        } else {
+            POSClientRegistry::__pid_index_insert(index, pid, uuid);
+        }
+        this->_pids[uuid / kChunkSize][uuid % kChunkSize] = pid;
+
+        // publish the client
+        chunk[uuid % kChunkSize].store(client, std::memory_order_release);
+
+        // restored clients come with their own uuid, so the allocated uuids should go beyond
+        max_uuid = this->_max_uuid.load(std::memory_order_relaxed);
+        while(max_uuid <= uuid && !this->_max_uuid.compare_exchange_weak(max_uuid, uuid + 1));
+    }
+
+    // release the retired pid index once no reader could access it, without blocking other writers
+    if(unlikely(new_index != nullptr)){
+        POSClientRegistry::synchronize();
+        delete[] index->entries;
+        delete index;
+    }
+
+exit:
+    return retval;
+}
+
+
+POSClient* POSClientRegistry::erase(pos_client_uuid_t uuid){
+    POSClient *client = nullptr;
+    std::atomic<POSClient*> *chunk;
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        if(unlikely(uuid >= kMaxNbClients)){ goto exit; }
+        chunk = this->_chunks[uuid / kChunkSize].load(std::memory_order_relaxed);
+        if(unlikely(chunk == nullptr)){ goto exit; }
+        client = chunk[uuid % kChunkSize].load(std::memory_order_relaxed);
+        if(unlikely(client == nullptr)){ goto exit; }
+
+        POSClientRegistry::__pid_index_remove(
+            this->_pid_index.load(std::memory_order_relaxed), this->_pids[uuid / kChunkSize][uuid % kChunkSize], uuid
+        );
+        chunk[uuid % kChunkSize].store(nullptr, std::memory_order_seq_cst);
+    }
+
+    // wait until readers that might have obtained the client left
+    POSClientRegistry::synchronize();
+
+exit:
+    return client;
+}
+
+
+POSClient* POSClientRegistry::get_by_pid(__pid_t pid){
+    pid_index_t *index;
+    uint64_t i, idx, entry;
+
+    if(unlikely(pid <= 0)){ return nullptr; }
+
+    index = this->_pid_index.load(std::memory_order_acquire);
+    idx = POSClientRegistry::__pid_hash(pid, index->capacity);
+    for(i=0; i<index->capacity; i++){
+        entry = index->entries[idx].load(std::memory_order_acquire);
+        if(entry == 0){ break; }
+        if(entry != kTombstone && static_cast<__pid_t>(entry >> 32) == pid){
+            return this->get_by_uuid(entry & 0xFFFFFFFFull);
+        }
+        idx = (idx + 1) & (index->capacity - 1);
+    }
+
+    return nullptr;
+}
+
+
+void POSClientRegistry::read_lock(){
+    uint32_t i, nb_slots;
+
+    if(__reader.depth++ > 0){ return; }
+
+    // obtain a slot for the thread at its first read section
+    if(unlikely(__reader.slot < 0)){
+        for(i=0; i<kMaxNbReaders; i++){
+            if(__reader_slots[i].is_used.load(std::memory_order_relaxed) == false
+                && __reader_slots[i].is_used.exchange(true, std::memory_order_acq_rel) == false
+            ){
+                __reader.slot = i;
+                break;
+            }
+        }
+        if(unlikely(__reader.slot < 0)){
+            POS_ERROR_DETAIL("too many threads reading the client registry: max(%u)", kMaxNbReaders);
+        }
+        nb_slots = __nb_reader_slots.load(std::memory_order_relaxed);
+        while(nb_slots <= __reader.slot && !__nb_reader_slots.compare_exchange_weak(nb_slots, __reader.slot + 1));
+    }
+
+    // the store must be visible before any pointer is read within the section
+    __reader_slots[__reader.slot].epoch.store(__epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+}
+
+
+void POSClientRegistry::read_unlock(){
+    POS_ASSERT(__reader.depth > 0);
+    if(--__reader.depth > 0){ return; }
+    __reader_slots[__reader.slot].epoch.store(0, std::memory_order_release);
+}
+
+
+void POSClientRegistry::synchronize(){
+    uint64_t target, epoch;
+    uint32_t i, nb_slots;
+
+    POS_ASSERT(__reader.depth == 0);
+
+    target = __epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    nb_slots = __nb_reader_slots.load(std::memory_order_seq_cst);
+    for(i=0; i<nb_slots; i++){
+        while(true){
+            epoch = __reader_slots[i].epoch.load(std::memory_order_seq_cst);
+            if(epoch == 0 || epoch >= target){ break; }
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+POSClientRegistry::pid_index_t* POSClientRegistry::__create_pid_index(pid_index_t *from, uint64_t nb_reserved){
+    pid_index_t *index;
+    uint64_t i, nb_live = 0, entry;
+
+    if(from != nullptr){
+        for(i=0; i<from->capacity; i++){
+            entry = from->entries[i].load(std::memory_order_relaxed);
+            if(entry != 0 && entry != kTombstone){ nb_live++; }
+        }
+    }
+
+    POS_CHECK_POINTER(index = new pid_index_t);
+    index->capacity = kMinPidIndexCapacity;
+    while(index->capacity < (nb_live + nb_reserved) * 2){ index->capacity *= 2; }
+    index->nb_used = 0;
+    POS_CHECK_POINTER(index->entries = new std::atomic<uint64_t>[index->capacity]);
+    for(i=0; i<index->capacity; i++){ index->entries[i].store(0, std::memory_order_relaxed); }
+
+    if(from != nullptr){
+        for(i=0; i<from->capacity; i++){
+            entry = from->entries[i].load(std::memory_order_relaxed);
+            if(entry != 0 && entry != kTombstone){
+                POSClientRegistry::__pid_index_insert(index, static_cast<__pid_t>(entry >> 32), entry & 0xFFFFFFFFull);
+            }
+        }
+    }
+
+    return index;
+}
+
+
+void POSClientRegistry::__pid_index_insert(pid_index_t *index, __pid_t pid, pos_client_uuid_t uuid){
+    uint64_t idx;
+
+    POS_ASSERT(pid > 0 && uuid < kMaxNbClients);
+    POS_ASSERT(index->nb_used < index->capacity);
+
+    idx = POSClientRegistry::__pid_hash(pid, index->capacity);
+    while(index->entries[idx].load(std::memory_order_relaxed) != 0){ idx = (idx + 1) & (index->capacity - 1); }
+    index->entries[idx].store(
+        (static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32) | uuid, std::memory_order_release
+    );
+    index->nb_used += 1;
+}
+
+
+void POSClientRegistry::__pid_index_remove(pid_index_t *index, __pid_t pid, pos_client_uuid_t uuid){
+    uint64_t i, idx, entry;
+
+    idx = POSClientRegistry::__pid_hash(pid, index->capacity);
+    for(i=0; i<index->capacity; i++){
+        entry = index->entries[idx].load(std::memory_order_relaxed);
+        if(entry == 0){ break; }
+        if(entry != kTombstone && static_cast<__pid_t>(entry >> 32) == pid
+            && (uuid == UINT64_MAX || (entry & 0xFFFFFFFFull) == uuid)
+        ){
+            index->entries[idx].store(kTombstone, std::memory_order_release);
+            break;
+        }
+        idx = (idx + 1) & (index->capacity - 1);
+    }
+}
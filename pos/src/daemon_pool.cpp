@@ -0,0 +1,313 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <stdint.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/utils/timer.h"
+#include "pos/include/utils/wait_event.h"
+#include "pos/include/placement.h"
+#include "pos/include/daemon_pool.h"
+
+
+POSDaemonPool::POSDaemonPool(
+    std::string name, uint32_t nb_threads, POSUtilTscTimer *tsc_timer,
+    POSPlacement *placement, pos_placement_role_t role
+)
+    :   _name(name), _nb_threads(nb_threads), _stop_flag(false), _placement(placement), _role(role)
+{
+    POS_CHECK_POINTER(this->_tsc_timer = tsc_timer);
+    POS_ASSERT(nb_threads > 0 && nb_threads <= kMaxNbThreads);
+
+    this->_hot_ticks = this->_tsc_timer->us_to_tick(kHotUs);
+    this->_steal_interval_ticks = this->_tsc_timer->us_to_tick(kStealIntervalUs);
+}
+
+
+POSDaemonPool::~POSDaemonPool(){
+    this->deinit();
+}
+
+
+pos_retval_t POSDaemonPool::init(){
+    pos_retval_t retval = POS_SUCCESS;
+    uint32_t i;
+    pos_daemon_pool_thread_t *pool_thread;
+
+    POS_ASSERT(this->_threads.size() == 0);
+
+    // create all thread contexts before starting, as threads access each other while stealing
+    for(i=0; i<this->_nb_threads; i++){
+        POS_CHECK_POINTER(pool_thread = new pos_daemon_pool_thread_t());
+        pool_thread->id = i;
+        this->_threads.push_back(pool_thread);
+    }
+
+    for(i=0; i<this->_nb_threads; i++){
+        this->_threads[i]->thread = new std::thread(&POSDaemonPool::__daemon, this, i);
+        POS_CHECK_POINTER(this->_threads[i]->thread);
+    }
+
+    POS_LOG_C("daemon pool started: name(%s), #threads(%u)", this->_name.c_str(), this->_nb_threads);
+
+    return retval;
+}
+
+
+void POSDaemonPool::deinit(){
+    uint32_t i;
+    pos_daemon_pool_thread_t *pool_thread;
+
+    if(this->_threads.size() == 0){ return; }
+
+    this->_stop_flag = true;
+    this->_wait_event.notify();
+
+    for(i=0; i<this->_threads.size(); i++){
+        POS_CHECK_POINTER(pool_thread = this->_threads[i]);
+        if(pool_thread->thread != nullptr){
+            if(pool_thread->thread->joinable()){ pool_thread->thread->join(); }
+            delete pool_thread->thread;
+        }
+        if(unlikely(pool_thread->tasks.size() > 0)){
+            POS_WARN_C(
+                "daemon pool stopped with tasks remained: name(%s), tid(%u), #tasks(%lu)",
+                this->_name.c_str(), i, pool_thread->tasks.size()
+            );
+        }
+        POS_LOG_C(
+            "daemon pool thread stopped: name(%s), tid(%u), steals(%lu), %s",
+            this->_name.c_str(), i, pool_thread->nb_steals,
+            POSUtilWaitEvent::str(pool_thread->wait_stat, *this->_tsc_timer).c_str()
+        );
+        delete pool_thread;
+    }
+    this->_threads.clear();
+}
+
+
+std::shared_ptr<pos_daemon_pool_task_t> POSDaemonPool::add(
+    std::string name, std::function<bool()> step, std::function<pos_retval_t(bool)> bind
+){
+    std::shared_ptr<pos_daemon_pool_task_t> task;
+    uint32_t i, tid;
+
+    POS_ASSERT(this->_threads.size() > 0);
+
+    task = std::make_shared<pos_daemon_pool_task_t>();
+    task->name = name;
+    task->step = step;
+    task->bind = bind;
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        tid = 0;
+        for(i=1; i<this->_threads.size(); i++){
+            if(this->_threads[i]->tasks.size() < this->_threads[tid]->tasks.size()){ tid = i; }
+        }
+        task->owner_tid = tid;
+        this->_threads[tid]->tasks.push_back(task);
+        this->_threads[tid]->version.fetch_add(1, std::memory_order_release);
+    }
+
+    // wake up the owner to refresh its task list
+    this->_wait_event.notify();
+
+    POS_DEBUG_C("added task to daemon pool: name(%s), task(%s), tid(%u)", this->_name.c_str(), name.c_str(), tid);
+
+    return task;
+}
+
+
+void POSDaemonPool::remove(std::shared_ptr<pos_daemon_pool_task_t>& task){
+    pos_daemon_pool_thread_t *pool_thread;
+    typename std::vector<std::shared_ptr<pos_daemon_pool_task_t>>::iterator iter;
+
+    POS_CHECK_POINTER(task.get());
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+
+        POS_CHECK_POINTER(pool_thread = this->_threads[task->owner_tid]);
+        iter = std::find(pool_thread->tasks.begin(), pool_thread->tasks.end(), task);
+        if(likely(iter != pool_thread->tasks.end())){
+            pool_thread->tasks.erase(iter);
+            pool_thread->version.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    /*!
+     *  \note   the pool thread checks the removed flag after marking the task as running,
+     *          so either it sees the task removed, or we see it running and wait
+     */
+    task->is_removed.store(true, std::memory_order_seq_cst);
+    while(task->is_running.load(std::memory_order_seq_cst)){ std::this_thread::yield(); }
+
+    POS_DEBUG_C(
+        "removed task from daemon pool: name(%s), task(%s), busy_steps(%lu), migrations(%lu)",
+        this->_name.c_str(), task->name.c_str(), task->nb_busy_steps, task->nb_migrations
+    );
+}
+
+
+void POSDaemonPool::__daemon(uint32_t tid){
+    pos_retval_t retval;
+    pos_daemon_pool_thread_t *self;
+    std::vector<std::shared_ptr<pos_daemon_pool_task_t>> tasks;
+    uint64_t version = UINT64_MAX, tick, last_steal_tick = 0;
+    uint32_t wait_seq;
+    bool has_work;
+    POSPlacementScope placement_scope(
+        /* placement */ this->_placement,
+        /* role */ this->_role,
+        /* name */ this->_name + "_pool(" + std::to_string(tid) + ")"
+    );
+
+    POS_CHECK_POINTER(self = this->_threads[tid]);
+
+    while(!this->_stop_flag){
+        wait_seq = this->_wait_event.prepare();
+
+        // refresh the snapshot of owned tasks once the list changed
+        if(unlikely(self->version.load(std::memory_order_acquire) != version)){
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            tasks = self->tasks;
+            version = self->version.load(std::memory_order_relaxed);
+        }
+
+        has_work = false;
+        for(auto &task : tasks){
+            // the task might be run by the thread that stole it
+            if(task->is_running.exchange(true, std::memory_order_seq_cst) == true){ continue; }
+            if(unlikely(task->is_removed.load(std::memory_order_seq_cst) == true)){
+                task->is_running.store(false, std::memory_order_release);
+                continue;
+            }
+
+            if(unlikely(task->bound_tid != (int64_t)(tid))){
+                if(unlikely(POS_SUCCESS != (retval = task->bind(/* is_first */ task->bound_tid < 0)))){
+                    // the task can't run without the thread being bound, so it's no longer served
+                    POS_WARN_C(
+                        "failed to bind daemon pool thread, task disabled: name(%s), task(%s), tid(%u), retval(%u)",
+                        this->_name.c_str(), task->name.c_str(), tid, retval
+                    );
+                    task->is_removed.store(true, std::memory_order_seq_cst);
+                    task->is_running.store(false, std::memory_order_release);
+                    continue;
+                }
+                task->bound_tid = tid;
+            }
+
+            self->step_s_tick.store(POSUtilTscTimer::get_tsc(), std::memory_order_relaxed);
+            if(task->step()){
+                has_work = true;
+                task->nb_busy_steps += 1;
+                task->last_busy_tick.store(POSUtilTscTimer::get_tsc(), std::memory_order_relaxed);
+            }
+            self->step_s_tick.store(0, std::memory_order_relaxed);
+
+            task->is_running.store(false, std::memory_order_release);
+        }
+        if(has_work){ continue; }
+
+        // nothing to do, try to share the load of other threads before waiting
+        tick = POSUtilTscTimer::get_tsc();
+        if(tick - last_steal_tick >= this->_steal_interval_ticks){
+            last_steal_tick = tick;
+            if(this->__steal(tid, tick)){ continue; }
+        }
+
+        this->_wait_event.wait(wait_seq, self->wait_stat);
+    }
+}
+
+
+bool POSDaemonPool::__steal(uint32_t tid, uint64_t tick){
+    uint32_t i, victim_tid, nb_hot, max_nb_hot;
+    uint64_t j, task_idx, step_s_tick;
+    pos_daemon_pool_thread_t *victim;
+    std::shared_ptr<pos_daemon_pool_task_t> task;
+
+    auto __is_hot = [&](std::shared_ptr<pos_daemon_pool_task_t>& t) -> bool {
+        return tick - std::min(tick, t->last_busy_tick.load(std::memory_order_relaxed)) < this->_hot_ticks;
+    };
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    victim = nullptr;
+    task_idx = 0;
+
+    // case 1: a thread stuck in a long round, the other tasks it owns are starving
+    for(i=0; i<this->_threads.size() && victim == nullptr; i++){
+        if(i == tid || this->_threads[i]->tasks.size() < 2){ continue; }
+        step_s_tick = this->_threads[i]->step_s_tick.load(std::memory_order_relaxed);
+        if(step_s_tick == 0 || tick - std::min(tick, step_s_tick) < this->_hot_ticks){ continue; }
+        for(j=0; j<this->_threads[i]->tasks.size(); j++){
+            if(this->_threads[i]->tasks[j]->is_running.load(std::memory_order_relaxed) == false){
+                victim = this->_threads[i];
+                task_idx = j;
+                break;
+            }
+        }
+    }
+
+    // case 2: the thread with the most hot tasks, which should have at least two more hot tasks
+    //         than this thread (so that tasks won't bounce between threads), take its last hot task
+    if(victim == nullptr){
+        max_nb_hot = 1;
+        for(auto &t : this->_threads[tid]->tasks){
+            if(__is_hot(t)){ max_nb_hot++; }
+        }
+        victim_tid = tid;
+        for(i=0; i<this->_threads.size(); i++){
+            if(i == tid){ continue; }
+            nb_hot = 0;
+            for(auto &t : this->_threads[i]->tasks){
+                if(__is_hot(t)){ nb_hot++; }
+            }
+            if(nb_hot > max_nb_hot){
+                max_nb_hot = nb_hot;
+                victim_tid = i;
+            }
+        }
+        if(victim_tid == tid){ return false; }
+
+        victim = this->_threads[victim_tid];
+        for(j=0; j<victim->tasks.size(); j++){
+            if(__is_hot(victim->tasks[j])){ task_idx = j; }
+        }
+    }
+
+    task = victim->tasks[task_idx];
+    victim->tasks.erase(victim->tasks.begin() + task_idx);
+    victim->version.fetch_add(1, std::memory_order_release);
+
+    task->owner_tid = tid;
+    task->nb_migrations += 1;
+    this->_threads[tid]->tasks.push_back(task);
+    this->_threads[tid]->version.fetch_add(1, std::memory_order_release);
+    this->_threads[tid]->nb_steals += 1;
+
+    return true;
+}
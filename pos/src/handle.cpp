@@ -28,6 +28,7 @@
 #include "pos/include/log.h"
 #include "pos/include/api_context.h"
 #include "pos/include/checkpoint.h"
+#include "pos/include/placement.h"
 #include "pos/include/proto/handle.pb.h"
 #include "google/protobuf/port_def.inc"
 
@@ -258,13 +259,19 @@ pos_retval_t POSHandle::checkpoint_persist_async(std::string ckpt_dir, bool with
     this->_persist_promise = new std::promise<pos_retval_t>;
     POS_CHECK_POINTER(this->_persist_promise);
 
-    // persist asynchronously
+    // persist asynchronously, the persisting thread is placed as the calling daemon thread is
     this->_persist_thread = new std::thread(
-        [](POSHandle* handle, POSCheckpointSlot* ckpt_slot, std::string ckpt_dir){
-            pos_retval_t retval = handle->__persist_async_thread(ckpt_slot, ckpt_dir);
+        [](POSHandle* handle, POSCheckpointSlot* ckpt_slot, std::string ckpt_dir, POSPlacement *placement){
+            pos_retval_t retval;
+            POSPlacementScope placement_scope(
+                /* placement */ placement,
+                /* role */ kPOS_PlacementRole_Persist,
+                /* name */ "persist(" + std::to_string(handle->id) + ")"
+            );
+            retval = handle->__persist_async_thread(ckpt_slot, ckpt_dir);
             handle->_persist_promise->set_value(retval);
         },
-        this, ckpt_slot, ckpt_dir
+        this, ckpt_slot, ckpt_dir, POSPlacement::current()
     );
     POS_CHECK_POINTER(this->_persist_thread);
 
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "pos/include/common.h"
+#include "pos/include/oob.h"
+#include "pos/include/oob/config.h"
+#include "pos/include/log.h"
+#include "pos/include/workspace.h"
+#include "pos/include/agent.h"
+
+
+namespace oob_functions {
+
+/*!
+ *  \related    kPOS_OOB_Msg_CLI_Config
+ *  \brief      signal for getting / setting the runtime configuration of the workspace
+ */
+namespace cli_config {
+    // server
+    pos_retval_t sv(int fd, struct sockaddr_in* remote, POSOobMsg_t* msg, POSWorkspace* ws, POSOobServer* oob_server){
+        pos_retval_t retval = POS_SUCCESS;
+        oob_payload_t *payload;
+        std::string retmsg, name, value;
+        POSWorkspaceConf::ConfigType conf_type;
+
+        payload = (oob_payload_t*)msg->payload;
+        payload->name[kConfigNameMaxLen-1] = '\0';
+        payload->value[kConfigValueMaxLen-1] = '\0';
+        name = std::string(payload->name);
+        value = std::string(payload->value);
+
+        if(unlikely(POS_SUCCESS != POSWorkspaceConf::get_config_type_by_name(name, conf_type))){
+            retmsg = std::string("unknown configuration: ") + name.substr(0, kConfigNameMaxLen);
+            payload->retval = POS_FAILED_NOT_EXIST;
+            goto response;
+        }
+
+        if(payload->action == kConfig_Set){
+            if(unlikely(POS_SUCCESS != (payload->retval = ws->ws_conf.set(conf_type, value)))){
+                retmsg = std::string("invalid value for configuration ") + name;
+                goto response;
+            }
+            POS_LOG("set workspace configuration via OOB: name(%s), value(%s)", name.c_str(), value.c_str());
+        }
+
+        // reply the (updated) value of the configuration
+        if(unlikely(POS_SUCCESS != (payload->retval = ws->ws_conf.get(conf_type, value)))){
+            retmsg = std::string("failed to get configuration ") + name;
+            goto response;
+        }
+        memset(payload->value, 0, kConfigValueMaxLen);
+        memcpy(payload->value, value.c_str(), std::min<size_t>(value.size(), kConfigValueMaxLen-1));
+
+    response:
+        POS_ASSERT(retmsg.size() < kServerRetMsgMaxLen);
+        memset(payload->retmsg, 0, kServerRetMsgMaxLen);
+        memcpy(payload->retmsg, retmsg.c_str(), retmsg.size());
+        __POS_OOB_SEND();
+
+    exit:
+        return retval;
+    }
+
+    // client
+    pos_retval_t clnt(
+        int fd, struct sockaddr_in* remote, POSOobMsg_t* msg, POSAgent* agent, POSOobClient* oob_clnt, void* call_data
+    ){
+        pos_retval_t retval = POS_SUCCESS;
+        oob_call_data_t *cm;
+        oob_payload_t *payload;
+
+        msg->msg_type = kPOS_OOB_Msg_CLI_Config;
+
+        POS_CHECK_POINTER(call_data);
+        cm = (oob_call_data_t*)call_data;
+
+        // setup payload
+        memset(msg->payload, 0, sizeof(msg->payload));
+        payload = (oob_payload_t*)msg->payload;
+        payload->action = cm->action;
+        memcpy(payload->name, cm->name, kConfigNameMaxLen);
+        memcpy(payload->value, cm->value, kConfigValueMaxLen);
+
+        __POS_OOB_SEND();
+
+        // wait until the posd finished 
+        __POS_OOB_RECV();
+        cm->retval = payload->retval;
+        memcpy(cm->value, payload->value, kConfigValueMaxLen);
+        memcpy(cm->retmsg, payload->retmsg, kServerRetMsgMaxLen);
+
+    exit:
+        return retval;
+    }
+} // namespace cli_config
+
+} // namespace oob_functions
@@ -24,14 +24,28 @@
 
 
 POSParser::POSParser(POSWorkspace* ws, POSClient* client) 
-    : _ws(ws), _client(client), _stop_flag(false)
+    : _ws(ws), _client(client), _stop_flag(false), _daemon_thread(nullptr), _pool(nullptr)
 {
+    std::string conf_val;
+
     POS_CHECK_POINTER(ws);
     POS_CHECK_POINTER(client);
 
-    // start daemon thread
-    this->_daemon_thread = new std::thread(&POSParser::__daemon, this);
-    POS_CHECK_POINTER(this->_daemon_thread);
+    // preallocate the batch buffers, so that polling never reallocates on the critical path
+    this->_batch_size = POS_LOCKLESS_QUEUE_DEFAULT_BATCH_SIZE;
+    if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeDaemonBatchSize, conf_val))){
+        this->_batch_size = std::stoul(conf_val);
+    }
+    this->_apicxt_wqes.resize(this->_batch_size);
+    this->_worker_wqes.resize(this->_batch_size);
+    this->_cmd_wqes.resize(this->_batch_size);
+
+    // start daemon thread, unless the daemon is served by the parser pool of the workspace
+    this->_pool = this->_ws->get_parser_pool();
+    if(this->_pool == nullptr){
+        this->_daemon_thread = new std::thread(&POSParser::__daemon, this);
+        POS_CHECK_POINTER(this->_daemon_thread);
+    }
 
     POS_LOG_C("parser started");
 };
@@ -44,15 +58,46 @@ POSParser::~POSParser(){
 
 pos_retval_t POSParser::init(){
     pos_retval_t retval;
+    uint64_t i;
+    std::vector<uint64_t> api_ids;
+
     if(unlikely(POS_SUCCESS != (retval = this->init_ps_functions()))){
         POS_ERROR_C_DETAIL("failed to insert functions: retval(%u)", retval);
     }
+
+    // the daemon looks up the metadata of each parsed API without checking,
+    // so every API with a parser function must have its metadata registered
+    api_ids = this->_parser_functions.get_api_ids();
+    for(i=0; i<api_ids.size(); i++){
+        if(unlikely(!this->_ws->api_mgnr->api_metas.contains(api_ids[i]))){
+            POS_ERROR_C_DETAIL("no metadata registered for api with parser function: api_id(%lu)", api_ids[i]);
+        }
+    }
+
+    // the pool runs the daemon right after adding, so it's added after the functions are inserted
+    if(this->_pool != nullptr){
+        this->_client->parser_wait_event.set_chained(this->_pool->get_wait_event());
+        this->_pool_task = this->_pool->add(
+            /* name */ "parser(" + std::to_string(this->_client->id) + ")",
+            /* step */ [this]() -> bool { return this->__daemon_step(); },
+            /* bind */ [this](bool is_first) -> pos_retval_t { return is_first ? this->daemon_init() : POS_SUCCESS; }
+        );
+        POS_CHECK_POINTER(this->_pool_task.get());
+    }
+
     return retval;
 }
 
 
 void POSParser::shutdown(){ 
     this->_stop_flag = true;
+    this->_client->parser_wait_event.notify();
+    if(this->_pool_task != nullptr){
+        this->_pool->remove(this->_pool_task);
+        this->_pool_task.reset();
+        this->_client->parser_wait_event.set_chained(nullptr);
+        POS_LOG_C("parser removed from daemon pool");
+    }
     if(this->_daemon_thread != nullptr){
         if(this->_daemon_thread->joinable()){
             this->_daemon_thread->join();
@@ -82,120 +127,170 @@ void POSParser::shutdown(){
 
 
 void POSParser::__daemon(){
-    uint64_t i, api_id;
-    pos_retval_t parser_retval, cmd_retval;
-    POSAPIMeta_t api_meta;
-    uint64_t last_ckpt_tick = 0, current_tick;
-    POSAPIContext_QE* apicxt_wqe;
-    std::vector<POSAPIContext_QE*> apicxt_wqes;
-    POSCommand_QE_t *cmd_wqe;
-    std::vector<POSCommand_QE_t*> cmd_wqes;
+    uint32_t wait_seq;
+    POSPlacementScope placement_scope(
+        /* placement */ &this->_ws->placement,
+        /* role */ kPOS_PlacementRole_Parser,
+        /* name */ "parser(" + std::to_string(this->_client->id) + ")"
+    );
 
     if(unlikely(POS_SUCCESS != this->daemon_init())){
-        POS_WARN_C("failed to init daemon, worker daemon exit");
+        POS_WARN_C("failed to init daemon, parser daemon exit");
         goto exit;
     }
 
     while(!this->_stop_flag){
-        // if the client isn't ready, the queue might not exist, we can't do any queue operation
-        if(this->_client->status != kPOS_ClientStatus_Active){ continue; }
-
-        // step 1: digest cmd from oob work queue
-        cmd_wqes.clear();
-        this->_client->poll_q<kPOS_QueueDirection_Oob2Parser, kPOS_QueueType_Cmd_WQ>(&cmd_wqes);
-        for(i=0; i<cmd_wqes.size(); i++){
-            POS_CHECK_POINTER(cmd_wqe = cmd_wqes[i]);
-            this->__process_cmd(cmd_wqe);
-        }
+        // obtain the wait sequence before polling, so that no push after polling would be missed
+        wait_seq = this->_client->parser_wait_event.prepare();
 
-        // step 2: digest cmd from worker completion queue
-        cmd_wqes.clear();
-        this->_client->poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_CQ>(&cmd_wqes);
-        for(i=0; i<cmd_wqes.size(); i++){
-            POS_CHECK_POINTER(cmd_wqe = cmd_wqes[i]);
-            this->__process_cmd(cmd_wqe);
+        // nothing to digest, wait until any producer pushes
+        if(this->__daemon_step() == false){
+            this->_client->parser_wait_event.wait(wait_seq);
         }
+    }
 
-        // step 3: digest apicxt from rpc work queue
-        apicxt_wqes.clear();
-        this->_client->poll_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_WQ>(&apicxt_wqes);
+exit:
+    return;
+}
 
-        for(i=0; i<apicxt_wqes.size(); i++){
-            POS_CHECK_POINTER(apicxt_wqe = apicxt_wqes[i]);
 
-            api_id = apicxt_wqe->api_cxt->api_id;
-            api_meta = _ws->api_mgnr->api_metas[api_id];
+bool POSParser::__daemon_step(){
+    uint64_t i, api_id;
+    pos_retval_t parser_retval, cmd_retval;
+    const POSAPIMeta_t *api_meta;
+    uint64_t nb_apicxt_wqes, nb_worker_wqes, nb_cmd_wqes;
+    POSAPIContext_QE* apicxt_wqe;
+    POSCommand_QE_t *cmd_wqe;
+    POSHandle *handle;
+    bool has_work;
+
+    // if the client isn't ready, the queue might not exist, we can't do any queue operation
+    if(this->_client->status != kPOS_ClientStatus_Active){ return false; }
+
+    // step 1: digest cmd from oob work queue
+    this->_client->poll_q<kPOS_QueueDirection_Oob2Parser, kPOS_QueueType_Cmd_WQ>(
+        /* qes */ this->_cmd_wqes.data(), /* max_nb_qes */ this->_batch_size, /* nb_qes */ nb_cmd_wqes
+    );
+    has_work = nb_cmd_wqes > 0;
+    for(i=0; i<nb_cmd_wqes; i++){
+        POS_CHECK_POINTER(cmd_wqe = this->_cmd_wqes[i]);
+        this->__process_cmd(cmd_wqe);
+    }
 
-        #if POS_CONF_RUNTIME_EnableDebugCheck
-            if(unlikely(_parser_functions.count(api_id) == 0)){
-                POS_ERROR_C_DETAIL(
-                    "runtime has no parser function for api %lu, need to implement", api_id
-                );
-            }
-        #endif
+    // step 2: digest cmd from worker completion queue
+    this->_client->poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_CQ>(
+        /* qes */ this->_cmd_wqes.data(), /* max_nb_qes */ this->_batch_size, /* nb_qes */ nb_cmd_wqes
+    );
+    has_work |= nb_cmd_wqes > 0;
+    for(i=0; i<nb_cmd_wqes; i++){
+        POS_CHECK_POINTER(cmd_wqe = this->_cmd_wqes[i]);
+        this->__process_cmd(cmd_wqe);
+    }
 
-            apicxt_wqe->parser_s_tick = POSUtilTscTimer::get_tsc();
-            parser_retval = (*(this->_parser_functions[api_id]))(this->_ws, this, apicxt_wqe);
-            apicxt_wqe->parser_e_tick = POSUtilTscTimer::get_tsc();
+    // step 3: digest apicxt from rpc work queue
+    this->_client->poll_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_WQ>(
+        /* qes */ this->_apicxt_wqes.data(), /* max_nb_qes */ this->_batch_size, /* nb_qes */ nb_apicxt_wqes
+    );
+    has_work |= nb_apicxt_wqes > 0;
 
-            // set the return code
-            apicxt_wqe->api_cxt->return_code = this->_ws->api_mgnr->cast_pos_retval(
-                /* pos_retval */ parser_retval, 
-                /* library_id */ api_meta.library_id
+    nb_worker_wqes = 0;
+    for(i=0; i<nb_apicxt_wqes; i++){
+        POS_CHECK_POINTER(apicxt_wqe = this->_apicxt_wqes[i]);
+
+        api_id = apicxt_wqe->api_cxt->api_id;
+        api_meta = &(this->_ws->api_mgnr->get_api_meta(api_id));
+
+    #if POS_CONF_RUNTIME_EnableDebugCheck
+        if(unlikely(!this->_parser_functions.contains(api_id))){
+            POS_ERROR_C_DETAIL(
+                "runtime has no parser function for api %lu, need to implement", api_id
             );
+        }
+    #endif
 
-            if(unlikely(POS_SUCCESS != parser_retval)){
-                // note:    some trash programs (e.g., inside torch) can cause parser failed (on purpose)
-                //          so we ignore parser failed warning
-                // POS_WARN_C(
-                //     "failed to execute parser function: client_id(%lu), api_id(%lu)",
-                //     apicxt_wqe->client_id, api_id
-                // );
-                apicxt_wqe->status = kPOS_API_Execute_Status_Parser_Failed;
-                apicxt_wqe->return_tick = POSUtilTscTimer::get_tsc();
-                this->_client->template push_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_CQ>(apicxt_wqe);
-                continue;
-            }
+        apicxt_wqe->parser_s_tick = POSUtilTscTimer::get_tsc();
+        parser_retval = (*(this->_parser_functions[api_id]))(this->_ws, this, apicxt_wqe);
+        apicxt_wqe->parser_e_tick = POSUtilTscTimer::get_tsc();
 
-            /*!
-             *  \note       for api in type of Delete_Resource, one can directly send
-             *              response to the client right after operating on mocked resources
-             *  \warning    we can't apply this rule for all Create_Resource, consider the memory
-             *              situation, which is passthrough addressed
-             *  TODO: delete this block, should be implement in autogen system
-             */
-            if(unlikely(api_meta.api_type == kPOS_API_Type_Delete_Resource)){
-                POS_DEBUG_C("api(%lu) is type of Delete_Resource, set as \"Return_After_Parse\"", api_id);
-                apicxt_wqe->status = kPOS_API_Execute_Status_Return_After_Parse;
-            }
+        // set the return code
+        apicxt_wqe->api_cxt->return_code = this->_ws->api_mgnr->cast_pos_retval(
+            /* pos_retval */ parser_retval, 
+            /* library_id */ api_meta->library_id
+        );
 
-            /*!
-             *  \note       for sync api that mark as kPOS_API_Execute_Status_Return_After_Parse,
-             *              we directly return the result back to the frontend side
-             */
-            if(     apicxt_wqe->status == kPOS_API_Execute_Status_Return_After_Parse 
-                ||  apicxt_wqe->status == kPOS_API_Execute_Status_Return_Without_Worker
-            ){
-                apicxt_wqe->return_tick = POSUtilTscTimer::get_tsc();
-                this->_client->template push_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_CQ>(apicxt_wqe);
-                apicxt_wqe->has_return = true;
-            }
+        if(unlikely(POS_SUCCESS != parser_retval)){
+            // note:    some trash programs (e.g., inside torch) can cause parser failed (on purpose)
+            //          so we ignore parser failed warning
+            // POS_WARN_C(
+            //     "failed to execute parser function: client_id(%lu), api_id(%lu)",
+            //     apicxt_wqe->client_id, api_id
+            // );
+            apicxt_wqe->status = kPOS_API_Execute_Status_Parser_Failed;
+            apicxt_wqe->has_return = true;
+            this->_client->complete_wqe(apicxt_wqe);
+            apicxt_wqe->release();
+            continue;
+        }
 
-            // launch the wqe to parser trace queue, if in resource trace mode
-            if(this->_client->_cxt.trace_resource == true){
-                this->_client->template push_q<kPOS_QueueDirection_ParserLocal, kPOS_QueueType_ApiCxt_Trace_WQ>(apicxt_wqe);
-            }
+        /*!
+         *  \note       for api in type of Delete_Resource, one can directly send
+         *              response to the client right after operating on mocked resources
+         *  \warning    we can't apply this rule for all Create_Resource, consider the memory
+         *              situation, which is passthrough addressed
+         *  TODO: delete this block, should be implement in autogen system
+         */
+        if(unlikely(api_meta->api_type == kPOS_API_Type_Delete_Resource)){
+            POS_DEBUG_C("api(%lu) is type of Delete_Resource, set as \"Return_After_Parse\"", api_id);
+            apicxt_wqe->status = kPOS_API_Execute_Status_Return_After_Parse;
+        }
+
+        /*!
+         *  \note       for sync api that mark as kPOS_API_Execute_Status_Return_After_Parse,
+         *              we directly return the result back to the frontend side
+         */
+        if(     apicxt_wqe->status == kPOS_API_Execute_Status_Return_After_Parse 
+            ||  apicxt_wqe->status == kPOS_API_Execute_Status_Return_Without_Worker
+        ){
+            apicxt_wqe->has_return = true;
+            this->_client->complete_wqe(apicxt_wqe);
+        }
+
+        // record the wqe to the trace ring, if in resource trace mode
+        if(this->_client->_api_trace_ring != nullptr){
+            this->__trace_api(apicxt_wqe);
+        }
 
-            // skip those APIs that doesn't need worker support
-            if(apicxt_wqe->status == kPOS_API_Execute_Status_Return_Without_Worker){ continue; }
+        // skip those APIs that doesn't need worker support
+        if(apicxt_wqe->status == kPOS_API_Execute_Status_Return_Without_Worker){
+            apicxt_wqe->release();
+            continue;
+        }
 
-            // insert apicxt_wqe to worker queue
-            this->_client->template push_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(apicxt_wqe);
+    #if POS_CONF_EVAL_CkptOptLevel == 2
+        /*!
+         *  \note  record the pending writes of each modified handle, so that the checkpoint
+         *         thread could commit the handles to be written sooner first
+         */
+        for(auto &inout_handle_view : apicxt_wqe->inout_handle_views){
+            POS_CHECK_POINTER(handle = inout_handle_view.handle);
+            handle->add_pending_write(apicxt_wqe->id);
+        }
+        for(auto &out_handle_view : apicxt_wqe->output_handle_views){
+            POS_CHECK_POINTER(handle = out_handle_view.handle);
+            handle->add_pending_write(apicxt_wqe->id);
         }
+    #endif
+
+        // insert apicxt_wqe to worker queue, published together with the rest of the batch
+        this->_worker_wqes[nb_worker_wqes] = apicxt_wqe;
+        nb_worker_wqes += 1;
     }
 
-exit:
-    return;
+    this->_client->template push_q_bulk<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(
+        /* qes */ this->_worker_wqes.data(), /* nb_qes */ nb_worker_wqes
+    );
+
+    return has_work;
 }
 
 
@@ -262,3 +357,59 @@ pos_retval_t POSParser::__process_cmd(POSCommand_QE_t *cmd){
 exit:
     return retval;
 }
+
+
+void POSParser::__trace_api(POSAPIContext_QE *wqe){
+    POSApiTraceRing *ring;
+    pos_api_trace_record_t *record;
+    pos_api_trace_handle_t *trace_handle;
+    uint64_t nb_handles;
+
+    POS_CHECK_POINTER(wqe);
+    POS_CHECK_POINTER(ring = this->_client->_api_trace_ring);
+
+    const std::pair<const std::vector<POSHandleView_t>*, pos_edge_direction_t> views[] = {
+        { &wqe->input_handle_views,     kPOS_Edge_Direction_In      },
+        { &wqe->output_handle_views,    kPOS_Edge_Direction_Out     },
+        { &wqe->inout_handle_views,     kPOS_Edge_Direction_InOut   },
+        { &wqe->create_handle_views,    kPOS_Edge_Direction_Create  },
+        { &wqe->delete_handle_views,    kPOS_Edge_Direction_Delete  },
+    };
+
+    nb_handles = 0;
+    for(auto &view : views){ nb_handles += view.first->size(); }
+    nb_handles = std::min<uint64_t>(nb_handles, UINT16_MAX);
+
+    // the ring is full, the record is counted as dropped
+    if(unlikely(nullptr == (record = ring->reserve(nb_handles)))){ goto exit; }
+
+    record->api_id = wqe->api_cxt->api_id;
+    record->apicxt_id = wqe->id;
+    record->create_tick = wqe->create_tick;
+    record->parser_s_tick = wqe->parser_s_tick;
+    record->parser_e_tick = wqe->parser_e_tick;
+    record->is_sync = wqe->is_sync;
+    record->status = wqe->status;
+    record->reserved = 0;
+
+    trace_handle = POSApiTraceRing::handles_of(record);
+    for(auto &view : views){
+        for(const POSHandleView_t &handle_view : *(view.first)){
+            if(unlikely(nb_handles == 0)){ break; }
+            POS_CHECK_POINTER(handle_view.handle);
+            trace_handle->direction = view.second;
+            trace_handle->reserved = 0;
+            trace_handle->param_index = handle_view.param_index;
+            trace_handle->resource_type_id = handle_view.handle->resource_type_id;
+            trace_handle->handle_id = handle_view.handle->id;
+            trace_handle->offset = handle_view.offset;
+            trace_handle++;
+            nb_handles--;
+        }
+    }
+
+    ring->commit();
+
+exit:
+    ;
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <string>
+#include <mutex>
+#include <algorithm>
+#include <stdint.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "pos/include/common.h"
+#include "pos/include/log.h"
+#include "pos/include/placement.h"
+
+
+// placement that placed the calling thread
+static thread_local POSPlacement *__current_placement = nullptr;
+
+
+POSPlacement::POSPlacement()
+    :   _policy(kPOS_PlacementPolicy_None), _numa_node(kAutoNumaNode), _device_numa_node(-1),
+        _nb_critical_cores(0), _used_numa_node(-1), _max_thread_id(0)
+{
+    cpu_set_t cpuset;
+    int32_t i;
+
+    CPU_ZERO(&cpuset);
+    if(likely(sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0)){
+        for(i=0; i<CPU_SETSIZE; i++){
+            if(CPU_ISSET(i, &cpuset)){ this->_allowed_cpus.push_back(i); }
+        }
+    } else {
+        POS_WARN_C("failed to obtain the affinity of the process, placement won't take effect");
+    }
+}
+
+
+void POSPlacement::configure(pos_placement_policy_t policy, int32_t numa_node, uint32_t nb_critical_cores){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    this->_policy = policy;
+    this->_numa_node = numa_node;
+    this->_nb_critical_cores = nb_critical_cores;
+    this->__compute();
+
+    for(auto &iter : this->_threads){ this->__apply(iter.second, /* restore */ true); }
+}
+
+
+void POSPlacement::set_device_numa_node(int32_t numa_node){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+
+    this->_device_numa_node = numa_node;
+    POS_DEBUG_C("recorded the NUMA node of the device: numa_node(%d)", numa_node);
+
+    if(this->_policy == kPOS_PlacementPolicy_Numa && this->_numa_node == kAutoNumaNode){
+        this->__compute();
+        for(auto &iter : this->_threads){ this->__apply(iter.second, /* restore */ false); }
+    }
+}
+
+
+uint64_t POSPlacement::enter(pos_placement_role_t role, std::string name){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    pos_placement_thread_t *thread;
+    uint64_t id;
+
+    POS_ASSERT(role < kPOS_PlacementRole_Unknown);
+
+    id = this->_max_thread_id++;
+    thread = &this->_threads[id];
+    thread->role = role;
+    thread->name = name;
+    thread->handle = pthread_self();
+    thread->cpu = -1;
+    this->__apply(*thread, /* restore */ false);
+
+    __current_placement = this;
+
+    return id;
+}
+
+
+void POSPlacement::leave(uint64_t id){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    typename std::map<uint64_t, pos_placement_thread_t>::iterator iter;
+
+    iter = this->_threads.find(id);
+    if(likely(iter != this->_threads.end())){
+        if(iter->second.cpu >= 0 && this->_critical_loads[iter->second.cpu] > 0){
+            this->_critical_loads[iter->second.cpu] -= 1;
+        }
+        this->_threads.erase(iter);
+    }
+
+    __current_placement = nullptr;
+}
+
+
+POSPlacement* POSPlacement::current(){ return __current_placement; }
+
+
+std::string POSPlacement::str(){
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    std::map<pos_placement_role_t, std::vector<int32_t>> role_cpus;
+    std::map<pos_placement_role_t, uint32_t> role_nb_threads;
+    std::vector<int32_t> *cpus;
+    std::string retval;
+    cpu_set_t cpuset;
+    uint8_t role;
+    int32_t i;
+
+    // read back the affinity actually taking effect
+    for(auto &iter : this->_threads){
+        role_nb_threads[iter.second.role] += 1;
+        CPU_ZERO(&cpuset);
+        if(unlikely(pthread_getaffinity_np(iter.second.handle, sizeof(cpuset), &cpuset) != 0)){ continue; }
+        cpus = &role_cpus[iter.second.role];
+        for(i=0; i<CPU_SETSIZE; i++){
+            if(CPU_ISSET(i, &cpuset)){ cpus->push_back(i); }
+        }
+    }
+
+    retval = std::string(POSPlacement::policy_str(this->_policy))
+            + " node(" + std::to_string(this->_used_numa_node) + ")";
+    for(role=0; role<kPOS_PlacementRole_Unknown; role++){
+        cpus = &role_cpus[(pos_placement_role_t)(role)];
+        std::sort(cpus->begin(), cpus->end());
+        cpus->erase(std::unique(cpus->begin(), cpus->end()), cpus->end());
+        retval += std::string(" ") + POSPlacement::role_str((pos_placement_role_t)(role))
+                + "(" + std::to_string(role_nb_threads[(pos_placement_role_t)(role)]) + ")"
+                + "[" + POSPlacement::__format_cpu_list(*cpus) + "]";
+    }
+
+    return retval;
+}
+
+
+int32_t POSPlacement::get_pci_numa_node(std::string pci_bus_id){
+    int32_t numa_node = -1;
+    std::ifstream file;
+
+    // sysfs names the devices in lower case
+    std::transform(pci_bus_id.begin(), pci_bus_id.end(), pci_bus_id.begin(), ::tolower);
+
+    file.open(std::string("/sys/bus/pci/devices/") + pci_bus_id + std::string("/numa_node"));
+    if(unlikely(!file.is_open())){
+        POS_WARN("failed to obtain the NUMA node of the device: pci_bus_id(%s)", pci_bus_id.c_str());
+        goto exit;
+    }
+    if(unlikely(!(file >> numa_node))){ numa_node = -1; }
+
+exit:
+    if(file.is_open()){ file.close(); }
+    return numa_node;
+}
+
+
+const char* POSPlacement::policy_str(pos_placement_policy_t policy){
+    switch (policy)
+    {
+    case kPOS_PlacementPolicy_None:
+        return "none";
+    case kPOS_PlacementPolicy_Numa:
+        return "numa";
+    default:
+        return "unknown";
+    }
+}
+
+
+pos_placement_policy_t POSPlacement::policy_from_str(const std::string& str){
+    if(str == "none"){
+        return kPOS_PlacementPolicy_None;
+    } else if(str == "numa"){
+        return kPOS_PlacementPolicy_Numa;
+    } else {
+        return kPOS_PlacementPolicy_Unknown;
+    }
+}
+
+
+const char* POSPlacement::role_str(pos_placement_role_t role){
+    switch (role)
+    {
+    case kPOS_PlacementRole_Parser:
+        return "parser";
+    case kPOS_PlacementRole_Worker:
+        return "worker";
+    case kPOS_PlacementRole_Checkpoint:
+        return "ckpt";
+    case kPOS_PlacementRole_Persist:
+        return "persist";
+    case kPOS_PlacementRole_CommitLane:
+        return "commit";
+    case kPOS_PlacementRole_Oob:
+        return "oob";
+    case kPOS_PlacementRole_Loader:
+        return "loader";
+    default:
+        return "unknown";
+    }
+}
+
+
+void POSPlacement::__compute(){
+    std::vector<int32_t> node_cpus;
+    std::ifstream file;
+    std::string cpu_list;
+    uint32_t nb_critical_cores;
+    int32_t numa_node;
+
+    this->_critical_cpus.clear();
+    this->_background_cpus.clear();
+    this->_critical_loads.clear();
+    this->_used_numa_node = -1;
+
+    if(this->_policy != kPOS_PlacementPolicy_Numa || this->_allowed_cpus.size() == 0){ return; }
+
+    // cores of the NUMA node that the process is allowed to run on
+    numa_node = this->_numa_node == kAutoNumaNode ? this->_device_numa_node : this->_numa_node;
+    if(numa_node >= 0){
+        file.open(std::string("/sys/devices/system/node/node") + std::to_string(numa_node) + std::string("/cpulist"));
+        if(likely(file.is_open() && std::getline(file, cpu_list))){
+            for(int32_t &cpu : POSPlacement::__parse_cpu_list(cpu_list)){
+                if(std::binary_search(this->_allowed_cpus.begin(), this->_allowed_cpus.end(), cpu)){
+                    node_cpus.push_back(cpu);
+                }
+            }
+        }
+        if(file.is_open()){ file.close(); }
+    }
+    if(node_cpus.size() > 0){
+        this->_used_numa_node = numa_node;
+    } else {
+        POS_WARN_C(
+            "no allowed core found on NUMA node, fallback to all allowed cores: numa_node(%d)", numa_node
+        );
+        node_cpus = this->_allowed_cpus;
+    }
+
+    // keep at least one core for the background roles, unless there's only one core
+    nb_critical_cores = this->_nb_critical_cores > 0 ? this->_nb_critical_cores : node_cpus.size() / 2;
+    nb_critical_cores = std::max<uint32_t>(nb_critical_cores, 1);
+    if(node_cpus.size() > 1){
+        nb_critical_cores = std::min<uint32_t>(nb_critical_cores, node_cpus.size() - 1);
+    } else {
+        nb_critical_cores = 1;
+    }
+
+    this->_critical_cpus.assign(node_cpus.begin(), node_cpus.begin() + nb_critical_cores);
+    this->_background_cpus.assign(node_cpus.begin() + nb_critical_cores, node_cpus.end());
+    if(this->_background_cpus.size() == 0){ this->_background_cpus = node_cpus; }
+    for(int32_t &cpu : this->_critical_cpus){ this->_critical_loads[cpu] = 0; }
+
+    POS_LOG_C(
+        "computed thread placement: numa_node(%d), critical_cores(%s), background_cores(%s)",
+        this->_used_numa_node,
+        POSPlacement::__format_cpu_list(this->_critical_cpus).c_str(),
+        POSPlacement::__format_cpu_list(this->_background_cpus).c_str()
+    );
+}
+
+
+void POSPlacement::__apply(pos_placement_thread_t& thread, bool restore){
+    const std::vector<int32_t> *cpus;
+    cpu_set_t cpuset;
+    int32_t cpu;
+    int retval;
+
+    thread.cpu = -1;
+
+    if(this->_policy != kPOS_PlacementPolicy_Numa || this->_critical_cpus.size() == 0){
+        // leave the inherited affinity untouched, unless the placement was changed
+        if(!restore || this->_allowed_cpus.size() == 0){ return; }
+        cpus = &this->_allowed_cpus;
+    } else if(thread.role == kPOS_PlacementRole_Parser || thread.role == kPOS_PlacementRole_Worker){
+        cpu = this->_critical_cpus[0];
+        for(int32_t &c : this->_critical_cpus){
+            if(this->_critical_loads[c] < this->_critical_loads[cpu]){ cpu = c; }
+        }
+        this->_critical_loads[cpu] += 1;
+        thread.cpu = cpu;
+        cpus = nullptr;
+    } else {
+        cpus = &this->_background_cpus;
+    }
+
+    CPU_ZERO(&cpuset);
+    if(cpus == nullptr){
+        CPU_SET(thread.cpu, &cpuset);
+    } else {
+        for(const int32_t &c : *cpus){ CPU_SET(c, &cpuset); }
+    }
+
+    if(unlikely(0 != (retval = pthread_setaffinity_np(thread.handle, sizeof(cpuset), &cpuset)))){
+        POS_WARN_C(
+            "failed to place thread: name(%s), role(%s), retval(%d)",
+            thread.name.c_str(), POSPlacement::role_str(thread.role), retval
+        );
+    } else {
+        POS_DEBUG_C(
+            "placed thread: name(%s), role(%s), cores(%s)",
+            thread.name.c_str(), POSPlacement::role_str(thread.role),
+            cpus == nullptr ? std::to_string(thread.cpu).c_str() : POSPlacement::__format_cpu_list(*cpus).c_str()
+        );
+    }
+}
+
+
+std::vector<int32_t> POSPlacement::__parse_cpu_list(const std::string& str){
+    std::vector<int32_t> cpus;
+    std::stringstream ss(str);
+    std::string range;
+    std::size_t pos;
+    int32_t i, s_cpu, e_cpu;
+
+    // format: 0-3,8,10-11
+    while(std::getline(ss, range, ',')){
+        try {
+            pos = range.find('-');
+            if(pos == std::string::npos){
+                s_cpu = e_cpu = std::stoi(range);
+            } else {
+                s_cpu = std::stoi(range.substr(0, pos));
+                e_cpu = std::stoi(range.substr(pos + 1));
+            }
+        } catch (const std::exception& e) {
+            continue;
+        }
+        for(i=s_cpu; i<=e_cpu && i<CPU_SETSIZE; i++){ cpus.push_back(i); }
+    }
+
+    return cpus;
+}
+
+
+std::string POSPlacement::__format_cpu_list(const std::vector<int32_t>& cpus){
+    std::string retval;
+    uint64_t i, j;
+
+    if(cpus.size() == 0){ return "-"; }
+
+    for(i=0; i<cpus.size(); i=j){
+        for(j=i+1; j<cpus.size() && cpus[j] == cpus[j-1] + 1; j++);
+        if(retval.size() > 0){ retval += ","; }
+        retval += std::to_string(cpus[i]);
+        if(j - i > 1){ retval += "-" + std::to_string(cpus[j-1]); }
+    }
+
+    return retval;
+}
@@ -37,23 +37,32 @@
 POSWorker::POSWorker(POSWorkspace* ws, POSClient* client) 
     : _max_wqe_id(0)
 {
+    std::string conf_val;
+
     POS_CHECK_POINTER(this->_ws = ws);
     POS_CHECK_POINTER(this->_client = client);
     this->_stop_flag = false;
+    this->_daemon_thread = nullptr;
 
-    // start daemon thread
-    this->_daemon_thread = new std::thread(&POSWorker::__daemon, this);
-    POS_CHECK_POINTER(this->_daemon_thread);
+    // preallocate the batch buffers, so that polling never reallocates on the critical path
+    this->_batch_size = POS_LOCKLESS_QUEUE_DEFAULT_BATCH_SIZE;
+    if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeDaemonBatchSize, conf_val))){
+        this->_batch_size = std::stoul(conf_val);
+    }
+    this->_wqes.resize(this->_batch_size);
+    this->_cmd_wqes.resize(this->_batch_size);
+
+    // start daemon thread, unless the daemon is served by the worker pool of the workspace
+    this->_pool = this->_ws->get_worker_pool();
+    if(this->_pool == nullptr){
+        this->_daemon_thread = new std::thread(&POSWorker::__daemon, this);
+        POS_CHECK_POINTER(this->_daemon_thread);
+    }
     
     #if POS_CONF_EVAL_CkptOptLevel == 2
-        this->_ckpt_stream_id = 0;
         this->_cow_stream_id = 0;
     #endif
 
-    #if POS_CONF_EVAL_CkptOptLevel == 2 && POS_CONF_EVAL_CkptEnablePipeline == 1
-        this->_ckpt_commit_stream_id = 0;
-    #endif
-
     #if POS_CONF_EVAL_MigrOptLevel > 0
         this->_migration_precopy_stream_id = 0;
     #endif
@@ -74,17 +83,54 @@ POSWorker::~POSWorker(){
 
 pos_retval_t POSWorker::init(){
     pos_retval_t retval;
+    uint64_t i;
+    std::vector<uint64_t> api_ids;
+
     if(unlikely(POS_SUCCESS != (
         retval = this->init_wk_functions()
     ))){
         POS_ERROR_C_DETAIL("failed to insert functions: retval(%u)", retval);
     }
+
+    // the daemon looks up the metadata of each launched API without checking,
+    // so every API with a worker function must have its metadata registered
+    api_ids = this->_launch_functions.get_api_ids();
+    for(i=0; i<api_ids.size(); i++){
+        if(unlikely(!this->_ws->api_mgnr->api_metas.contains(api_ids[i]))){
+            POS_ERROR_C_DETAIL("no metadata registered for api with worker function: api_id(%lu)", api_ids[i]);
+        }
+    }
+
+    /*!
+     *  \note  the pool runs the daemon right after adding, so it's added after the functions are inserted;
+     *         the daemon is initialized by the first pool thread running it, and the pool threads it
+     *         migrates to later only need to be bound to the device context
+     */
+    if(this->_pool != nullptr){
+        this->_client->worker_wait_event.set_chained(this->_pool->get_wait_event());
+        this->_pool_task = this->_pool->add(
+            /* name */ "worker(" + std::to_string(this->_client->id) + ")",
+            /* step */ [this]() -> bool { return this->__daemon_step(); },
+            /* bind */ [this](bool is_first) -> pos_retval_t {
+                return is_first ? this->daemon_init() : this->bind_thread_context();
+            }
+        );
+        POS_CHECK_POINTER(this->_pool_task.get());
+    }
+
     return retval;
 }
 
 
 void POSWorker::shutdown(){ 
     this->_stop_flag = true;
+    this->_client->worker_wait_event.notify();
+    if(this->_pool_task != nullptr){
+        this->_pool->remove(this->_pool_task);
+        this->_pool_task.reset();
+        this->_client->worker_wait_event.set_chained(nullptr);
+        POS_LOG_C("worker removed from daemon pool");
+    }
     if(this->_daemon_thread != nullptr){
         if(this->_daemon_thread->joinable()){
             this->_daemon_thread->join();
@@ -93,6 +139,32 @@ void POSWorker::shutdown(){
         this->_daemon_thread = nullptr;
         POS_LOG_C("worker daemon thread shutdown");
     }
+
+    #if POS_CONF_EVAL_CkptOptLevel == 2
+        if(this->async_ckpt_cxt.thread != nullptr){
+            if(this->async_ckpt_cxt.thread->joinable()){
+                this->async_ckpt_cxt.thread->join();
+            }
+            delete this->async_ckpt_cxt.thread;
+            this->async_ckpt_cxt.thread = nullptr;
+        }
+        if(this->async_ckpt_cxt.commit_engine != nullptr){
+            delete this->async_ckpt_cxt.commit_engine;
+            this->async_ckpt_cxt.commit_engine = nullptr;
+        }
+        if(this->async_ckpt_cxt.commit_backend != nullptr){
+            delete this->async_ckpt_cxt.commit_backend;
+            this->async_ckpt_cxt.commit_backend = nullptr;
+        }
+
+        // dump all decisions made by the cost model, along with their inputs, for offline tuning
+        if(this->async_ckpt_cxt.cost_model_dump_dir.size() > 0 && this->async_ckpt_cxt.cost_model.records.size() > 0){
+            this->async_ckpt_cxt.cost_model.dump(
+                this->async_ckpt_cxt.cost_model_dump_dir + std::string("/ckpt_cost_model.csv")
+            );
+            this->async_ckpt_cxt.cost_model.reset_records();
+        }
+    #endif
 }
 
 
@@ -126,111 +198,134 @@ void POSWorker::__done(POSWorkspace* ws, POSAPIContext_QE* wqe){
 
 
 void POSWorker::__daemon(){
+    uint32_t wait_seq;
+    POSPlacementScope placement_scope(
+        /* placement */ &this->_ws->placement,
+        /* role */ kPOS_PlacementRole_Worker,
+        /* name */ "worker(" + std::to_string(this->_client->id) + ")"
+    );
+
     if(unlikely(POS_SUCCESS != this->daemon_init())){
         POS_WARN_C("failed to init daemon, worker daemon exit");
         goto exit;
     }
 
+    while(!this->_stop_flag){
+        // obtain the wait sequence before polling, so that no push after polling would be missed
+        wait_seq = this->_client->worker_wait_event.prepare();
+
+        // nothing to digest, wait until the parser pushes
+        if(this->__daemon_step() == false){
+            this->_client->worker_wait_event.wait(wait_seq);
+        }
+    }
+
+exit:
+    return;
+}
+
+
+bool POSWorker::__daemon_step(){
     #if POS_CONF_EVAL_MigrOptLevel == 0
         // case: continuous checkpoint
         #if POS_CONF_EVAL_CkptOptLevel <= 1
-            this->__daemon_ckpt_sync();
+            return this->__daemon_step_ckpt_sync();
         #elif POS_CONF_EVAL_CkptOptLevel == 2
-            this->__daemon_ckpt_async();
+            return this->__daemon_step_ckpt_async();
         #endif
     #else
-        this->__daemon_migration_opt();
+        return this->__daemon_step_migration_opt();
     #endif
-
-exit:
-    return;
 }
 
 
 #if POS_CONF_EVAL_CkptOptLevel == 0 || POS_CONF_EVAL_CkptOptLevel == 1
 
 
-void POSWorker::__daemon_ckpt_sync(){
+bool POSWorker::__daemon_step_ckpt_sync(){
     uint64_t i, api_id;
     pos_retval_t launch_retval, tmp_retval;
-    POSAPIMeta_t api_meta;
+    const POSAPIMeta_t *api_meta;
+    uint64_t nb_wqes, nb_cmd_wqes;
     POSAPIContext_QE *wqe;
-    std::vector<POSAPIContext_QE*> wqes;
     POSCommand_QE_t *cmd_wqe;
-    std::vector<POSCommand_QE_t*> cmd_wqes;
 
-    while(!this->_stop_flag){
-        // if the client isn't ready, the queue might not exist, we can't do any queue operation
-        if(this->_client->status != kPOS_ClientStatus_Active){ continue; }
-
-        // step 1: digest cmd from parser work queue
-        cmd_wqes.clear();
-        this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_WQ>(&cmd_wqes);
-        for(i=0; i<cmd_wqes.size(); i++){
-            POS_CHECK_POINTER(cmd_wqe = cmd_wqes[i]);
-            this->__process_cmd(cmd_wqe);
-        }
-
-        // step 2: check whether we need to run the bottom half of sync checkpoint
-        if(unlikely(this->sync_ckpt_cxt.ckpt_active == true) && this->_client->is_under_sync_call == false){
-            POS_CHECK_POINTER(this->sync_ckpt_cxt.cmd);
-            this->__process_cmd(this->sync_ckpt_cxt.cmd);
-            continue;
-        }
+    // if the client isn't ready, the queue might not exist, we can't do any queue operation
+    if(this->_client->status != kPOS_ClientStatus_Active){ return false; }
 
-        // step 3: digest apicxt from parser work queue
-        wqes.clear();
-        this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(&wqes);
+    // step 1: digest cmd from parser work queue
+    this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_WQ>(
+        /* qes */ this->_cmd_wqes.data(), /* max_nb_qes */ this->_batch_size, /* nb_qes */ nb_cmd_wqes
+    );
+    for(i=0; i<nb_cmd_wqes; i++){
+        POS_CHECK_POINTER(cmd_wqe = this->_cmd_wqes[i]);
+        this->__process_cmd(cmd_wqe);
+    }
 
-        for(i=0; i<wqes.size(); i++){
-            POS_CHECK_POINTER(wqe = wqes[i]);
-            POS_CHECK_POINTER(wqe->api_cxt);
-            
-            wqe->worker_s_tick = POSUtilTscTimer::get_tsc();
-            
-            api_id = wqe->api_cxt->api_id;
-            api_meta = this->_ws->api_mgnr->api_metas[api_id];
+    // step 2: check whether we need to run the bottom half of sync checkpoint
+    if(unlikely(this->sync_ckpt_cxt.ckpt_active == true) && this->_client->is_under_sync_call == false){
+        POS_CHECK_POINTER(this->sync_ckpt_cxt.cmd);
+        this->__process_cmd(this->sync_ckpt_cxt.cmd);
+        return true;
+    }
 
-            // check and restore broken handles
-            if(unlikely(POS_SUCCESS != __restore_broken_handles(wqe, &api_meta))){
-                POS_WARN_C("failed to check / restore broken handles: api_id(%lu)", api_id);
-                continue;
-            }
+    // step 3: digest apicxt from parser work queue
+    this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(
+        /* qes */ this->_wqes.data(), /* max_nb_qes */ this->_batch_size, /* nb_qes */ nb_wqes
+    );
 
-        #if POS_CONF_RUNTIME_EnableDebugCheck
-            if(unlikely(this->_launch_functions.count(api_id) == 0)){
-                POS_ERROR_C_DETAIL(
-                    "runtime has no worker launch function for api %lu, need to implement", api_id
-                );
-            }
-        #endif
+    for(i=0; i<nb_wqes; i++){
+        POS_CHECK_POINTER(wqe = this->_wqes[i]);
+        POS_CHECK_POINTER(wqe->api_cxt);
+        
+        wqe->worker_s_tick = POSUtilTscTimer::get_tsc();
+        
+        api_id = wqe->api_cxt->api_id;
+        api_meta = &(this->_ws->api_mgnr->get_api_meta(api_id));
 
-            launch_retval = (*(this->_launch_functions[api_id]))(this->_ws, wqe);
-            wqe->worker_e_tick = POSUtilTscTimer::get_tsc();
+        // check and restore broken handles
+        if(unlikely(POS_SUCCESS != __restore_broken_handles(wqe, api_meta))){
+            POS_WARN_C("failed to check / restore broken handles: api_id(%lu)", api_id);
+            continue;
+        }
 
-            // cast return code
-            wqe->api_cxt->return_code = _ws->api_mgnr->cast_pos_retval(
-                /* pos_retval */ launch_retval, 
-                /* library_id */ api_meta.library_id
+    #if POS_CONF_RUNTIME_EnableDebugCheck
+        if(unlikely(!this->_launch_functions.contains(api_id))){
+            POS_ERROR_C_DETAIL(
+                "runtime has no worker launch function for api %lu, need to implement", api_id
             );
+        }
+    #endif
 
-            // check whether the execution is success
-            if(unlikely(launch_retval != POS_SUCCESS)){
-                wqe->status = kPOS_API_Execute_Status_Worker_Failed;
-            }
+        launch_retval = (*(this->_launch_functions[api_id]))(this->_ws, wqe);
+        wqe->worker_e_tick = POSUtilTscTimer::get_tsc();
 
-            // check whether we need to return to frontend
-            if(wqe->has_return == false){
-                // we only return the QE back to frontend when it hasn't been returned before
-                wqe->return_tick = POSUtilTscTimer::get_tsc();
-                this->_client->template push_q<kPOS_QueueDirection_Rpc2Worker, kPOS_QueueType_ApiCxt_CQ>(wqe);
-                wqe->has_return = true;
-            }
+        // cast return code
+        wqe->api_cxt->return_code = _ws->api_mgnr->cast_pos_retval(
+            /* pos_retval */ launch_retval, 
+            /* library_id */ api_meta->library_id
+        );
 
-            POS_ASSERT(wqe->id >= this->_max_wqe_id);
-            this->_max_wqe_id = wqe->id;
+        // check whether the execution is success
+        if(unlikely(launch_retval != POS_SUCCESS)){
+            wqe->status = kPOS_API_Execute_Status_Worker_Failed;
         }
+
+        // check whether we need to return to frontend
+        if(wqe->has_return == false){
+            // we only return the QE back to frontend when it hasn't been returned before
+            wqe->has_return = true;
+            this->_client->complete_wqe(wqe);
+        }
+
+        POS_ASSERT(wqe->id >= this->_max_wqe_id);
+        this->_max_wqe_id = wqe->id;
     }
+
+    // the worker is done with all polled wqes
+    for(i=0; i<nb_wqes; i++){ this->_wqes[i]->release(); }
+
+    return nb_cmd_wqes > 0 || nb_wqes > 0;
 }
 
 
@@ -456,290 +551,513 @@ exit:
 #elif POS_CONF_EVAL_CkptOptLevel == 2
 
 
-void POSWorker::__daemon_ckpt_async(){
+bool POSWorker::__daemon_step_ckpt_async(){
     uint64_t i, api_id, gpu_ticker;
     pos_retval_t launch_retval, tmp_retval;
-    POSAPIMeta_t api_meta;
+    const POSAPIMeta_t *api_meta;
+    uint64_t nb_wqes, nb_cmd_wqes;
     POSAPIContext_QE *wqe;
-    std::vector<POSAPIContext_QE*> wqes;
     POSCommand_QE_t *cmd_wqe;
-    std::vector<POSCommand_QE_t*> cmd_wqes;
     POSHandle *handle;
+    uint64_t cow_s_tick, launch_s_tick;
+    bool is_recorded;
 
     #if POS_CONF_RUNTIME_EnableTrace
         uint64_t nb_cow_handle = 0, nb_cow_stateful_handle = 0, cow_size = 0;
     #endif
 
-    while(!this->_stop_flag){
-        // if the client isn't ready, the queue might not exist, we can't do any queue operation
-        if(this->_client->status != kPOS_ClientStatus_Active){ continue; }
-
-        // step 1: digest cmd from parser work queue
-        cmd_wqes.clear();
-        this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_WQ>(&cmd_wqes);
-        for(i=0; i<cmd_wqes.size(); i++){
-            POS_CHECK_POINTER(cmd_wqe = cmd_wqes[i]);
-            this->__process_cmd(cmd_wqe);
-        }
+    // if the client isn't ready, the queue might not exist, we can't do any queue operation
+    if(this->_client->status != kPOS_ClientStatus_Active){ return false; }
 
-        // step 2: check whether we need to run the bottom half of concurrent checkpoint
-        if(unlikely(this->async_ckpt_cxt.BH_active == true) && this->_client->is_under_sync_call == false){
-            tmp_retval = this->__checkpoint_BH_sync();
-            continue;
-        }
+    // step 1: digest cmd from parser work queue
+    this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_WQ>(
+        /* qes */ this->_cmd_wqes.data(), /* max_nb_qes */ this->_batch_size, /* nb_qes */ nb_cmd_wqes
+    );
+    for(i=0; i<nb_cmd_wqes; i++){
+        POS_CHECK_POINTER(cmd_wqe = this->_cmd_wqes[i]);
+        this->__process_cmd(cmd_wqe);
+    }
 
-        // step 3: digest apicxt from parser work queue
-        wqes.clear();
-        this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(&wqes);
+    // step 2: check whether we need to run the bottom half of concurrent checkpoint
+    if(unlikely(this->async_ckpt_cxt.BH_active == true) && this->_client->is_under_sync_call == false){
+        tmp_retval = this->__checkpoint_BH_sync();
+        return true;
+    }
 
-        for(i=0; i<wqes.size(); i++){
-            POS_CHECK_POINTER(wqe = wqes[i]);
+    // step 3: digest apicxt from parser work queue
+    this->_client->template poll_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_ApiCxt_WQ>(
+        /* qes */ this->_wqes.data(), /* max_nb_qes */ this->_batch_size, /* nb_qes */ nb_wqes
+    );
 
-            #if POS_CONF_RUNTIME_EnableTrace
-                if(unlikely(this->_restoring_phrase < kPOS_WorkRestorePhrase_Normal)){
+    for(i=0; i<nb_wqes; i++){
+        POS_CHECK_POINTER(wqe = this->_wqes[i]);
 
-                    if(wqe->type == ApiCxt_TypeId_Recomputation){
+        #if POS_CONF_RUNTIME_EnableTrace
+            if(unlikely(this->_restoring_phrase < kPOS_WorkRestorePhrase_Normal)){
 
-                        if(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation_Init){
-                            // case 1: first recomputation API
-                            tmp_retval = this->start_gpu_ticker(/* stream_id */ 0);
-                            if(unlikely(tmp_retval != POS_SUCCESS)){
-                                POS_WARN("failed to start gpu ticker, restore measurement abandoned");
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                            } else {
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Recomputation;
-                            }
+                if(wqe->type == ApiCxt_TypeId_Recomputation){
+
+                    if(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation_Init){
+                        // case 1: first recomputation API
+                        tmp_retval = this->start_gpu_ticker(/* stream_id */ 0);
+                        if(unlikely(tmp_retval != POS_SUCCESS)){
+                            POS_WARN("failed to start gpu ticker, restore measurement abandoned");
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
                         } else {
-                            // case 2: subsequent recomputation API
-                            POS_ASSERT(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation);
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Recomputation;
                         }
+                    } else {
+                        // case 2: subsequent recomputation API
+                        POS_ASSERT(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation);
+                    }
 
-                    } else if (wqe->type == ApiCxt_TypeId_Unexecuted){
+                } else if (wqe->type == ApiCxt_TypeId_Unexecuted){
 
-                        if(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation_Init){
-                            // case 3: no recomputation API, first unexecution API
+                    if(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation_Init){
+                        // case 3: no recomputation API, first unexecution API
+                        tmp_retval = this->start_gpu_ticker(/* stream_id */ 0);
+                        if(unlikely(tmp_retval != POS_SUCCESS)){
+                            POS_WARN("failed to start gpu ticker, restore measurement abandoned");
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
+                        } else {
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Unexecution;
+                        }
+                    } else if (this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation){
+                        // case 4: first unexecution API after recomputation API
+                        tmp_retval = this->stop_gpu_ticker(gpu_ticker, /* stream_id */ 0);
+                        if(unlikely(tmp_retval != POS_SUCCESS)){
+                            POS_WARN("failed to stop gpu ticker, restore measurement abandoned");
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
+                        } else {
+                            this->_metric_tickers.add(RESTORE_recomputation_ticks, gpu_ticker);
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Unexecution;
                             tmp_retval = this->start_gpu_ticker(/* stream_id */ 0);
                             if(unlikely(tmp_retval != POS_SUCCESS)){
                                 POS_WARN("failed to start gpu ticker, restore measurement abandoned");
                                 this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                            } else {
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Unexecution;
-                            }
-                        } else if (this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation){
-                            // case 4: first unexecution API after recomputation API
-                            tmp_retval = this->stop_gpu_ticker(gpu_ticker, /* stream_id */ 0);
-                            if(unlikely(tmp_retval != POS_SUCCESS)){
-                                POS_WARN("failed to stop gpu ticker, restore measurement abandoned");
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                            } else {
-                                this->_metric_tickers.add(RESTORE_recomputation_ticks, gpu_ticker);
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Unexecution;
-                                tmp_retval = this->start_gpu_ticker(/* stream_id */ 0);
-                                if(unlikely(tmp_retval != POS_SUCCESS)){
-                                    POS_WARN("failed to start gpu ticker, restore measurement abandoned");
-                                    this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                                }
                             }
-                        } else {
-                            // case 5: subsequent unexecution API
-                            POS_ASSERT(this->_restoring_phrase == kPOS_WorkRestorePhrase_Unexecution);
                         }
-
                     } else {
-                        POS_ASSERT(wqe->type == ApiCxt_TypeId_Normal);
+                        // case 5: subsequent unexecution API
+                        POS_ASSERT(this->_restoring_phrase == kPOS_WorkRestorePhrase_Unexecution);
+                    }
 
-                        if(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation_Init){
-                            // case 6: no recomputation API, no unexecution API
+                } else {
+                    POS_ASSERT(wqe->type == ApiCxt_TypeId_Normal);
+
+                    if(this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation_Init){
+                        // case 6: no recomputation API, no unexecution API
+                        this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
+                    } else if (this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation){
+                        // case 7: first normal API after recomputation API, no unexecution API
+                        tmp_retval = this->stop_gpu_ticker(gpu_ticker, /* stream_id */ 0);
+                        if(unlikely(tmp_retval != POS_SUCCESS)){
+                            POS_WARN("failed to stop gpu ticker, restore measurement abandoned");
                             this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                        } else if (this->_restoring_phrase == kPOS_WorkRestorePhrase_Recomputation){
-                            // case 7: first normal API after recomputation API, no unexecution API
-                            tmp_retval = this->stop_gpu_ticker(gpu_ticker, /* stream_id */ 0);
-                            if(unlikely(tmp_retval != POS_SUCCESS)){
-                                POS_WARN("failed to stop gpu ticker, restore measurement abandoned");
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                            } else {
-                                this->_metric_tickers.add(RESTORE_recomputation_ticks, gpu_ticker);
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                            }
-                        } else if (this->_restoring_phrase == kPOS_WorkRestorePhrase_Unexecution){
-                            // case 8: first normal API after unexecution API
-                            tmp_retval = this->stop_gpu_ticker(gpu_ticker, /* stream_id */ 0);
-                            if(unlikely(tmp_retval != POS_SUCCESS)){
-                                POS_WARN("failed to stop gpu ticker, restore measurement abandoned");
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                            } else {
-                                this->_metric_tickers.add(RESTORE_unexecution_ticks, gpu_ticker);
-                                this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
-                                this->__print_metrics();
-                            }
                         } else {
-                            POS_ERROR_C_DETAIL("shouldn't be here, this is a bug");
+                            this->_metric_tickers.add(RESTORE_recomputation_ticks, gpu_ticker);
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
                         }
-
+                    } else if (this->_restoring_phrase == kPOS_WorkRestorePhrase_Unexecution){
+                        // case 8: first normal API after unexecution API
+                        tmp_retval = this->stop_gpu_ticker(gpu_ticker, /* stream_id */ 0);
+                        if(unlikely(tmp_retval != POS_SUCCESS)){
+                            POS_WARN("failed to stop gpu ticker, restore measurement abandoned");
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
+                        } else {
+                            this->_metric_tickers.add(RESTORE_unexecution_ticks, gpu_ticker);
+                            this->_restoring_phrase = kPOS_WorkRestorePhrase_Normal;
+                            this->__print_metrics();
+                        }
+                    } else {
+                        POS_ERROR_C_DETAIL("shouldn't be here, this is a bug");
                     }
+
                 }
-            #endif
+            }
+        #endif
 
-            wqe->worker_s_tick = POSUtilTscTimer::get_tsc();
+        wqe->worker_s_tick = POSUtilTscTimer::get_tsc();
 
-            /*!
-             *  \brief  if the async ckpt thread is active, we cache this wqe for potential recomputation while restoring
-             */
-            if(unlikely(this->async_ckpt_cxt.TH_actve == true && this->async_ckpt_cxt.cmd->do_cow)){
-                this->_client->template push_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>(wqe);
-            }
+        /*!
+         *  \brief  if the async ckpt thread is active, we cache this wqe for potential recomputation while restoring
+         */
+        is_recorded = false;
+        if(unlikely(this->async_ckpt_cxt.TH_actve == true && this->async_ckpt_cxt.cmd->do_cow)){
+            wqe->retain();
+            this->_client->template push_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>(wqe);
+            is_recorded = true;
+        }
 
-            POS_CHECK_POINTER(wqe->api_cxt);
-            api_id = wqe->api_cxt->api_id;
-            api_meta = this->_ws->api_mgnr->api_metas[api_id];
+        POS_CHECK_POINTER(wqe->api_cxt);
+        api_id = wqe->api_cxt->api_id;
+        api_meta = &(this->_ws->api_mgnr->get_api_meta(api_id));
 
-            // check and restore broken handles
-            if(unlikely(POS_SUCCESS != __restore_broken_handles(wqe, &api_meta))){
-                POS_WARN_C("failed to check / restore broken handles: api_id(%lu)", api_id);
-                continue;
+        // check and restore broken handles
+        if(unlikely(POS_SUCCESS != __restore_broken_handles(wqe, api_meta))){
+            POS_WARN_C("failed to check / restore broken handles: api_id(%lu)", api_id);
+            this->__remove_pending_writes(wqe);
+            continue;
+        }
+
+        #if POS_CONF_RUNTIME_EnableDebugCheck
+            if(unlikely(!this->_launch_functions.contains(api_id))){
+                POS_ERROR_C_DETAIL(
+                    "runtime has no worker launch function for api %lu, need to implement", api_id
+                );
             }
+        #endif
 
-            #if POS_CONF_RUNTIME_EnableDebugCheck
-                if(unlikely(_launch_functions.count(api_id) == 0)){
-                    POS_ERROR_C_DETAIL(
-                        "runtime has no worker launch function for api %lu, need to implement", api_id
-                    );
-                }
+        if(unlikely(this->async_ckpt_cxt.TH_actve == true)){
+            #if POS_CONF_RUNTIME_EnableTrace
+                nb_cow_handle = 0; nb_cow_stateful_handle = 0; cow_size = 0;
             #endif
 
-            if(unlikely(this->async_ckpt_cxt.TH_actve == true)){
-                #if POS_CONF_RUNTIME_EnableTrace
-                    nb_cow_handle = 0; nb_cow_stateful_handle = 0; cow_size = 0;
-                #endif
-
-                /*!
-                 *  \brief  before launching the API, we need to preserve the state of all stateful resources for checkpointing
-                 *  \note   there're serval cases handle in checkpoint_add:
-                 *          [1] the state hasn't been checkpoint yet, then it conducts CoW on the state
-                 *          [2] the state is under checkpointing, then it blocks until the checkpoint finished
-                 *          [3] the state is already checkpointed, then it directly returns
-                 */
-                for(auto &inout_handle_view : wqe->inout_handle_views){
-                    POS_CHECK_POINTER(handle = inout_handle_view.handle);
-                    if(unlikely(   handle->status == kPOS_HandleStatus_Deleted 
-                                || handle->status == kPOS_HandleStatus_Create_Pending
-                                || handle->status == kPOS_HandleStatus_Broken
-                    )){
-                        continue;
-                    }
-                    if( this->async_ckpt_cxt.cmd->do_cow 
-                        && this->async_ckpt_cxt.checkpoint_version_map.count(handle) > 0
-                        && this->async_ckpt_cxt.dirty_handles.count(handle) == 0
-                    ){
-                        #if POS_CONF_RUNTIME_EnableTrace
-                            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
-                            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
-                        #endif
-                        tmp_retval = handle->checkpoint_add(
-                            /* version_id */ this->async_ckpt_cxt.checkpoint_version_map[handle],
-                            /* stream_id */ this->_cow_stream_id
+            /*!
+             *  \brief  before launching the API, we need to preserve the state of all stateful resources for checkpointing
+             *  \note   there're serval cases handle in checkpoint_add:
+             *          [1] the state hasn't been checkpoint yet, then it conducts CoW on the state
+             *          [2] the state is under checkpointing, then it blocks until the checkpoint finished
+             *          [3] the state is already checkpointed, then it directly returns
+             */
+            for(auto &inout_handle_view : wqe->inout_handle_views){
+                POS_CHECK_POINTER(handle = inout_handle_view.handle);
+                if(unlikely(   handle->status == kPOS_HandleStatus_Deleted 
+                            || handle->status == kPOS_HandleStatus_Create_Pending
+                            || handle->status == kPOS_HandleStatus_Broken
+                )){
+                    continue;
+                }
+                if( handle->ckpt_epoch == this->async_ckpt_cxt.epoch
+                    && handle->dirty_epoch != this->async_ckpt_cxt.epoch
+                    && handle->ckpt_decision == kPOS_CkptDecision_CoW
+                ){
+                    #if POS_CONF_RUNTIME_EnableTrace
+                        this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
+                        this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
+                    #endif
+                    cow_s_tick = POSUtilTscTimer::get_tsc();
+                    tmp_retval = handle->checkpoint_add(
+                        /* version_id */ handle->ckpt_version,
+                        /* stream_id */ this->_cow_stream_id
+                    );
+                    POS_ASSERT(tmp_retval == POS_SUCCESS || tmp_retval == POS_WARN_ABANDONED || tmp_retval == POS_FAILED_ALREADY_EXIST);
+                    if(tmp_retval == POS_SUCCESS){
+                        this->async_ckpt_cxt.cost_model.observe_cow(
+                            /* bytes */ handle->state_size,
+                            /* ticks */ POSUtilTscTimer::get_tsc() - cow_s_tick
                         );
-                        POS_ASSERT(tmp_retval == POS_SUCCESS || tmp_retval == POS_WARN_ABANDONED || tmp_retval == POS_FAILED_ALREADY_EXIST);
-                        #if POS_CONF_RUNTIME_EnableTrace
-                            if(tmp_retval == POS_SUCCESS){
-                                this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
-                                this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_done_times_by_worker_thread);
-                                this->async_ckpt_cxt.metric_reducers.reduce(
-                                    /* index */ checkpoint_async_cxt_t::CKPT_cow_bytes_by_worker_thread,
-                                    /* value */ handle->state_size
-                                );
-                                if(handle->state_size > 0){ cow_size += handle->state_size; }
-                            } else if(tmp_retval == POS_WARN_ABANDONED){
-                                this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
-                                this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_block_times_by_worker_thread);
-                            }
-                        #endif
                     }
+                    #if POS_CONF_RUNTIME_EnableTrace
+                        if(tmp_retval == POS_SUCCESS){
+                            this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
+                            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_done_times_by_worker_thread);
+                            this->async_ckpt_cxt.metric_reducers.reduce(
+                                /* index */ checkpoint_async_cxt_t::CKPT_cow_bytes_by_worker_thread,
+                                /* value */ handle->state_size
+                            );
+                            if(handle->state_size > 0){ cow_size += handle->state_size; }
+                        } else if(tmp_retval == POS_WARN_ABANDONED){
+                            this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
+                            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_block_times_by_worker_thread);
+                        } else {
+                            // the state has been preserved by the checkpoint thread before this write
+                            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_avoided_times_by_worker_thread);
+                        }
+                    #endif
+                }
 
-                    // note: we also include those stateless handles here
-                    if(this->async_ckpt_cxt.dirty_handles.count(handle) == 0){
-                        this->async_ckpt_cxt.dirty_handles.insert(handle);
-                        this->async_ckpt_cxt.dirty_handle_state_size += handle->state_size;
-                    }
+                // note: we also include those stateless handles here
+                if(handle->ckpt_epoch == this->async_ckpt_cxt.epoch){
+                    handle->nb_ckpt_writes += 1;
                 }
-                for(auto &out_handle_view : wqe->output_handle_views){
-                    POS_CHECK_POINTER(handle = out_handle_view.handle);
-                    if(unlikely(   handle->status == kPOS_HandleStatus_Deleted 
-                                || handle->status == kPOS_HandleStatus_Create_Pending
-                                || handle->status == kPOS_HandleStatus_Broken
-                    )){
-                        continue;
-                    }
-                    if( this->async_ckpt_cxt.cmd->do_cow 
-                        && this->async_ckpt_cxt.checkpoint_version_map.count(handle) > 0
-                        && this->async_ckpt_cxt.dirty_handles.count(handle) == 0
+                if(handle->dirty_epoch != this->async_ckpt_cxt.epoch){
+                    handle->dirty_epoch = this->async_ckpt_cxt.epoch;
+                    handle->dirty_next = this->async_ckpt_cxt.dirty_handles;
+                    this->async_ckpt_cxt.dirty_handles = handle;
+                    this->async_ckpt_cxt.nb_dirty_handles += 1;
+                    this->async_ckpt_cxt.dirty_handle_state_size += handle->state_size;
+                    if( handle->ckpt_epoch == this->async_ckpt_cxt.epoch
+                        && handle->ckpt_decision != kPOS_CkptDecision_CoW
                     ){
-                        #if POS_CONF_RUNTIME_EnableTrace
-                            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
-                            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
-                        #endif
-                        tmp_retval = handle->checkpoint_add(
-                            /* version_id */ this->async_ckpt_cxt.checkpoint_version_map[handle],
-                            /* stream_id */ this->_cow_stream_id
+                        this->async_ckpt_cxt.nb_unpreserved_dirty_handles += 1;
+                    }
+                }
+            }
+            for(auto &out_handle_view : wqe->output_handle_views){
+                POS_CHECK_POINTER(handle = out_handle_view.handle);
+                if(unlikely(   handle->status == kPOS_HandleStatus_Deleted 
+                            || handle->status == kPOS_HandleStatus_Create_Pending
+                            || handle->status == kPOS_HandleStatus_Broken
+                )){
+                    continue;
+                }
+                if( handle->ckpt_epoch == this->async_ckpt_cxt.epoch
+                    && handle->dirty_epoch != this->async_ckpt_cxt.epoch
+                    && handle->ckpt_decision == kPOS_CkptDecision_CoW
+                ){
+                    #if POS_CONF_RUNTIME_EnableTrace
+                        this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
+                        this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
+                    #endif
+                    cow_s_tick = POSUtilTscTimer::get_tsc();
+                    tmp_retval = handle->checkpoint_add(
+                        /* version_id */ handle->ckpt_version,
+                        /* stream_id */ this->_cow_stream_id
+                    );
+                    POS_ASSERT(tmp_retval == POS_SUCCESS || tmp_retval == POS_WARN_ABANDONED || tmp_retval == POS_FAILED_ALREADY_EXIST);
+                    if(tmp_retval == POS_SUCCESS){
+                        this->async_ckpt_cxt.cost_model.observe_cow(
+                            /* bytes */ handle->state_size,
+                            /* ticks */ POSUtilTscTimer::get_tsc() - cow_s_tick
                         );
-                        POS_ASSERT(tmp_retval == POS_SUCCESS || tmp_retval == POS_WARN_ABANDONED || tmp_retval == POS_FAILED_ALREADY_EXIST);
-                        #if POS_CONF_RUNTIME_EnableTrace
-                            if(tmp_retval == POS_SUCCESS){
-                                this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
-                                this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_done_times_by_worker_thread);
-                                this->async_ckpt_cxt.metric_reducers.reduce(
-                                    /* index */ checkpoint_async_cxt_t::CKPT_cow_bytes_by_worker_thread,
-                                    /* value */ handle->state_size
-                                );
-                                if(handle->state_size > 0){ cow_size += handle->state_size; }
-                            } else if(tmp_retval == POS_WARN_ABANDONED){
-                                this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
-                                this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_block_times_by_worker_thread);
-                            }
-                        #endif
                     }
+                    #if POS_CONF_RUNTIME_EnableTrace
+                        if(tmp_retval == POS_SUCCESS){
+                            this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_worker_thread);
+                            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_done_times_by_worker_thread);
+                            this->async_ckpt_cxt.metric_reducers.reduce(
+                                /* index */ checkpoint_async_cxt_t::CKPT_cow_bytes_by_worker_thread,
+                                /* value */ handle->state_size
+                            );
+                            if(handle->state_size > 0){ cow_size += handle->state_size; }
+                        } else if(tmp_retval == POS_WARN_ABANDONED){
+                            this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_worker_thread);
+                            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_block_times_by_worker_thread);
+                        } else {
+                            // the state has been preserved by the checkpoint thread before this write
+                            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_avoided_times_by_worker_thread);
+                        }
+                    #endif
+                }
 
-                    // note: we might also include those stateless handles here
-                    if(this->async_ckpt_cxt.dirty_handles.count(handle) == 0){
-                        this->async_ckpt_cxt.dirty_handles.insert(handle);
-                        this->async_ckpt_cxt.dirty_handle_state_size += handle->state_size;
+                // note: we might also include those stateless handles here
+                if(handle->ckpt_epoch == this->async_ckpt_cxt.epoch){
+                    handle->nb_ckpt_writes += 1;
+                }
+                if(handle->dirty_epoch != this->async_ckpt_cxt.epoch){
+                    handle->dirty_epoch = this->async_ckpt_cxt.epoch;
+                    handle->dirty_next = this->async_ckpt_cxt.dirty_handles;
+                    this->async_ckpt_cxt.dirty_handles = handle;
+                    this->async_ckpt_cxt.nb_dirty_handles += 1;
+                    this->async_ckpt_cxt.dirty_handle_state_size += handle->state_size;
+                    if( handle->ckpt_epoch == this->async_ckpt_cxt.epoch
+                        && handle->ckpt_decision != kPOS_CkptDecision_CoW
+                    ){
+                        this->async_ckpt_cxt.nb_unpreserved_dirty_handles += 1;
                     }
                 }
+            }
 
-                #if POS_CONF_RUNTIME_EnableTrace
-                    #if POS_CONF_RUNTIME_EnableMemoryTrace
-                        if(cow_size > 0)
-                            this->_metric_sequences.add_spot(CKPT_cow_size, cow_size);
-                    #endif
+            #if POS_CONF_RUNTIME_EnableTrace
+                #if POS_CONF_RUNTIME_EnableMemoryTrace
+                    if(cow_size > 0)
+                        this->_metric_sequences.add_spot(CKPT_cow_size, cow_size);
                 #endif
-            } // this->async_ckpt_cxt.TH_actve == true
+            #endif
+        } // this->async_ckpt_cxt.TH_actve == true
 
-            launch_retval = (*(_launch_functions[api_id]))(_ws, wqe);
-            wqe->worker_e_tick = POSUtilTscTimer::get_tsc();
+        launch_s_tick = POSUtilTscTimer::get_tsc();
+        launch_retval = (*(this->_launch_functions[api_id]))(this->_ws, wqe);
+        wqe->worker_e_tick = POSUtilTscTimer::get_tsc();
+        this->__remove_pending_writes(wqe);
 
-            // cast return code
-            wqe->api_cxt->return_code = _ws->api_mgnr->cast_pos_retval(
-                /* pos_retval */ launch_retval, 
-                /* library_id */ api_meta.library_id
-            );
+        // accumulate the recomputation cost of the recorded API for the checkpoint cost model
+        if(unlikely(is_recorded)){
+            this->async_ckpt_cxt.nb_recompute_apis += 1;
+            this->async_ckpt_cxt.recompute_ticks += wqe->worker_e_tick - launch_s_tick;
+        }
 
-            // check whether the execution is success
-            if(unlikely(launch_retval != POS_SUCCESS)){
-                wqe->status = kPOS_API_Execute_Status_Worker_Failed;
-            }
+        // cast return code
+        wqe->api_cxt->return_code = _ws->api_mgnr->cast_pos_retval(
+            /* pos_retval */ launch_retval, 
+            /* library_id */ api_meta->library_id
+        );
 
-            // check whether we need to return to frontend
-            if(wqe->has_return == false){
-                // we only return the QE back to frontend when it hasn't been returned before
-                wqe->return_tick = POSUtilTscTimer::get_tsc();
-                this->_client->template push_q<kPOS_QueueDirection_Rpc2Worker, kPOS_QueueType_ApiCxt_CQ>(wqe);
-                wqe->has_return = true;
-            }
+        // check whether the execution is success
+        if(unlikely(launch_retval != POS_SUCCESS)){
+            wqe->status = kPOS_API_Execute_Status_Worker_Failed;
+        }
 
-            POS_ASSERT(wqe->id >= this->_max_wqe_id);
-            this->_max_wqe_id = wqe->id;
+        // check whether we need to return to frontend
+        if(wqe->has_return == false){
+            // we only return the QE back to frontend when it hasn't been returned before
+            wqe->has_return = true;
+            this->_client->complete_wqe(wqe);
         }
+
+        POS_ASSERT(wqe->id >= this->_max_wqe_id);
+        this->_max_wqe_id = wqe->id;
     }
+
+    // the worker is done with all polled wqes
+    for(i=0; i<nb_wqes; i++){ this->_wqes[i]->release(); }
+
+    return nb_cmd_wqes > 0 || nb_wqes > 0;
+}
+
+
+void POSWorker::__remove_pending_writes(POSAPIContext_QE* wqe){
+    POSHandle *handle;
+
+    POS_CHECK_POINTER(wqe);
+
+    for(auto &inout_handle_view : wqe->inout_handle_views){
+        POS_CHECK_POINTER(handle = inout_handle_view.handle);
+        handle->remove_pending_write(wqe->id);
+    }
+    for(auto &out_handle_view : wqe->output_handle_views){
+        POS_CHECK_POINTER(handle = out_handle_view.handle);
+        handle->remove_pending_write(wqe->id);
+    }
+}
+
+
+POSCheckpointCommitBackend_Worker::POSCheckpointCommitBackend_Worker(POSWorker *worker){
+    POS_CHECK_POINTER(this->_worker = worker);
+    this->reset_stats();
+    #if POS_CONF_EVAL_CkptEnablePipeline == 1
+        memset(this->_add_stream_ids, 0, sizeof(this->_add_stream_ids));
+    #endif
+}
+
+
+pos_retval_t POSCheckpointCommitBackend_Worker::init_lane(pos_ckpt_commit_lane_t& lane){
+    pos_retval_t retval = POS_SUCCESS;
+
+    POS_ASSERT(lane.id < POSCheckpointCommitEngine::kMaxNbLanes);
+
+    if(unlikely(POS_SUCCESS != (retval = this->_worker->create_stream(lane.stream_id)))){
+        POS_WARN_C("failed to create commit stream of lane: lane_id(%u), retval(%u)", lane.id, retval);
+        goto exit;
+    }
+
+    #if POS_CONF_EVAL_CkptEnablePipeline == 1
+        if(unlikely(POS_SUCCESS != (retval = this->_worker->create_stream(this->_add_stream_ids[lane.id])))){
+            POS_WARN_C("failed to create add stream of lane: lane_id(%u), retval(%u)", lane.id, retval);
+            this->_worker->destory_stream(lane.stream_id);
+            lane.stream_id = 0;
+            goto exit;
+        }
+    #endif
+
+exit:
+    return retval;
+}
+
+
+pos_retval_t POSCheckpointCommitBackend_Worker::deinit_lane(pos_ckpt_commit_lane_t& lane){
+    pos_retval_t retval = POS_SUCCESS, tmp_retval;
+
+    if(unlikely(POS_SUCCESS != (tmp_retval = this->_worker->destory_stream(lane.stream_id)))){
+        POS_WARN_C("failed to destory commit stream of lane: lane_id(%u), retval(%u)", lane.id, tmp_retval);
+        retval = tmp_retval;
+    }
+    lane.stream_id = 0;
+
+    #if POS_CONF_EVAL_CkptEnablePipeline == 1
+        if(unlikely(POS_SUCCESS != (tmp_retval = this->_worker->destory_stream(this->_add_stream_ids[lane.id])))){
+            POS_WARN_C("failed to destory add stream of lane: lane_id(%u), retval(%u)", lane.id, tmp_retval);
+            retval = tmp_retval;
+        }
+        this->_add_stream_ids[lane.id] = 0;
+    #endif
+
+    return retval;
+}
+
+
+pos_retval_t POSCheckpointCommitBackend_Worker::init_lane_thread(pos_ckpt_commit_lane_t& lane){
+    return this->_worker->bind_thread_context();
+}
+
+
+pos_retval_t POSCheckpointCommitBackend_Worker::commit(pos_ckpt_commit_lane_t& lane, pos_ckpt_commit_job_t& job){
+    pos_retval_t retval = POS_SUCCESS;
+    POSHandle *handle;
+    uint64_t throttled_ticks = 0;
+
+    POS_CHECK_POINTER(handle = (POSHandle*)(job.cxt));
+
+    // bound the bandwidth of checkpoint traffic, shared by all lanes
+    retval = this->_worker->async_ckpt_cxt.commit_throttle.acquire(
+        /* bytes */ job.size,
+        /* throttled_ticks */ throttled_ticks,
+        /* cancel_flag */ &this->_worker->_stop_flag
+    );
+    this->lane_throttled_ticks[lane.id] += throttled_ticks;
+    if(unlikely(retval != POS_SUCCESS)){
+        return retval;
+    }
+
+#if POS_CONF_EVAL_CkptEnablePipeline == 1
+    uint64_t s_tick, e_tick;
+    lane_add_stat_t &add_stat = this->lane_add_stats[lane.id];
+
+    /*!
+     *  \brief  [phrase 1]  add the state of this handle from its origin buffer
+     *  \note   the adding process is sync as it might disturbed by CoW
+     */
+    s_tick = POSUtilTscTimer::get_tsc();
+    retval = handle->checkpoint_add(
+        /* version_id */    job.version_id,
+        /* stream_id */     this->_add_stream_ids[lane.id]
+    );
+    e_tick = POSUtilTscTimer::get_tsc();
+    POS_ASSERT(retval == POS_SUCCESS || retval == POS_WARN_ABANDONED || retval == POS_FAILED_ALREADY_EXIST);
+    if(retval == POS_SUCCESS){
+        add_stat.nb_done += 1;
+        add_stat.done_bytes += job.size;
+        add_stat.done_ticks += e_tick - s_tick;
+    } else if(retval == POS_WARN_ABANDONED){
+        add_stat.nb_blocked += 1;
+        add_stat.blocked_ticks += e_tick - s_tick;
+    }
+
+    /*!
+     *  \brief  [phrase 2]  commit the resource state from cache
+     */
+    retval = handle->checkpoint_commit_async(
+        /* version_id */    job.version_id,
+        /* stream_id */     lane.stream_id
+    );
+#else
+    /*!
+     *  \brief  [phrase 1]  commit the resource state from origin buffer or CoW cache
+     *  \note   if the CoW is ongoing or finished, it commit from cache; otherwise it commit from origin buffer
+     */
+    retval = handle->checkpoint_commit_async(
+        /* version_id */    job.version_id,
+        /* stream_id */     lane.stream_id
+    );
+    if(retval == POS_WARN_ABANDONED){ retval = POS_SUCCESS; }
+#endif
+
+    return retval;
+}
+
+
+pos_retval_t POSCheckpointCommitBackend_Worker::sync_lane(pos_ckpt_commit_lane_t& lane){
+    return this->_worker->sync(lane.stream_id);
+}
+
+
+bool POSCheckpointCommitBackend_Worker::is_bus_contended(){
+    if constexpr (TMP_enable_mem_lock == false){ return false; }
+
+    //  this flag is raised by memcpy API worker functions, we stop all lanes to
+    //  avoid slowing down the application
+    return this->_worker->async_ckpt_cxt.membus_lock;
+}
+
+
+POSUtilWaitEvent* POSCheckpointCommitBackend_Worker::get_bus_event(){
+    return &this->_worker->async_ckpt_cxt.membus_event;
+}
+
+
+bool POSCheckpointCommitBackend_Worker::is_cancelled(){
+    return this->_worker->_stop_flag;
 }
 
 
@@ -749,178 +1067,137 @@ void POSWorker::__checkpoint_TH_async_thread() {
     pos_retval_t retval = POS_SUCCESS, dirty_retval = POS_SUCCESS;
     POSCommand_QE_t *cmd;
     POSHandle *handle;
-    uint64_t s_tick = 0, e_tick = 0;
-    uint64_t commit_stream_id;
+    uint64_t s_tick = 0, e_tick = 0, throttled_ticks = 0;
+    uint64_t commit_size = 0;
+    POSCheckpointCommitEngine *commit_engine;
+    POSCheckpointCommitBackend_Worker *commit_backend;
+    std::vector<pos_ckpt_commit_job_t> commit_jobs;
     
     std::set<POSHandle*> async_commited_handles;
     typename std::set<POSHandle*>::iterator set_iter;
-
-    // todo: we need an interface to know how many D2H engine we have,
-    //      to decide whether we need this lock
-    static constexpr bool TMP_enable_mem_lock = false;
+    std::vector<POSHandle*> ordered_handles;
+    POSPlacementScope placement_scope(
+        /* placement */ &this->_ws->placement,
+        /* role */ kPOS_PlacementRole_Checkpoint,
+        /* name */ "ckpt(" + std::to_string(this->_client->id) + ")"
+    );
 
     POS_CHECK_POINTER(cmd = this->async_ckpt_cxt.cmd);
-    POS_ASSERT(this->_ckpt_stream_id != 0);
+    POS_CHECK_POINTER(commit_engine = this->async_ckpt_cxt.commit_engine);
+    POS_CHECK_POINTER(commit_backend = this->async_ckpt_cxt.commit_backend);
 
-    #if POS_CONF_EVAL_CkptEnablePipeline == 1
-        POS_ASSERT(this->_ckpt_commit_stream_id != 0);
-    #endif
+    // order the commits, e.g., commit those handles to be written sooner first to avoid CoW on them
+    this->async_ckpt_cxt.scheduler.schedule(
+        /* handles */ cmd->stateful_handles,
+        /* current_wqe_id */ this->_max_wqe_id,
+        /* ordered_handles */ ordered_handles
+    );
 
-    for(set_iter=cmd->stateful_handles.begin(); set_iter!=cmd->stateful_handles.end(); set_iter++){
-        POSHandle *handle = *set_iter;
-        POS_CHECK_POINTER(handle);
+    // collect commit jobs in the scheduled order
+    commit_jobs.reserve(ordered_handles.size());
+    for(i=0; i<ordered_handles.size(); i++){
+        POS_CHECK_POINTER(handle = ordered_handles[i]);
 
         if(unlikely(   handle->status == kPOS_HandleStatus_Deleted 
                     || handle->status == kPOS_HandleStatus_Create_Pending
                     || handle->status == kPOS_HandleStatus_Broken
         )){
-            goto membus_lock_check;
+            continue;
         }
 
-        if(unlikely(this->async_ckpt_cxt.checkpoint_version_map.count(handle) == 0)){
+        if(unlikely(handle->ckpt_epoch != this->async_ckpt_cxt.epoch)){
             POS_WARN_C("failed to checkpoint handle, no checkpoint version provided: client_addr(%p)", handle->client_addr);
-            goto membus_lock_check;
+            continue;
         }
 
-        checkpoint_version = this->async_ckpt_cxt.checkpoint_version_map[handle];
-
-        // step 1: add & commit of all stateful handles
-    #if POS_CONF_EVAL_CkptEnablePipeline == 1
-        /*!
-         *  \brief  [phrase 1]  add the state of this handle from its origin buffer
-         *  \note   the adding process is sync as it might disturbed by CoW
-         */
-        #if POS_CONF_RUNTIME_EnableTrace
-            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_ckpt_thread);
-            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_ckpt_thread);
-        #endif
-        retval = handle->checkpoint_add(
-            /* version_id */    checkpoint_version,
-            /* stream_id */     this->_ckpt_stream_id
-        );
-        POS_ASSERT(retval == POS_SUCCESS || retval == POS_WARN_ABANDONED || retval == POS_FAILED_ALREADY_EXIST);
-        #if POS_CONF_RUNTIME_EnableTrace
-            if(retval == POS_SUCCESS){
-                this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_ckpt_thread);
-                this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_done_times_by_ckpt_thread);
-                this->async_ckpt_cxt.metric_reducers.reduce(
-                    /* index */ checkpoint_async_cxt_t::CKPT_cow_bytes_by_ckpt_thread,
-                    /* value */ handle->state_size
-                );
-            } else if(retval == POS_WARN_ABANDONED){
-                this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_ckpt_thread);
-                this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_cow_block_times_by_ckpt_thread);
-            }
-        #endif
-
-        /*!
-         *  \brief  [phrase 2]  commit the resource state from cache
-         */
-        #if POS_CONF_RUNTIME_EnableTrace
-            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
-        #endif
+        commit_jobs.emplace_back();
+        commit_jobs.back().cxt = handle;
+        commit_jobs.back().version_id = handle->ckpt_version;
+        commit_jobs.back().size = handle->state_size;
+    }
 
-        retval = handle->checkpoint_commit_async(
-            /* version_id */    checkpoint_version,
-            /* stream_id */     this->_ckpt_commit_stream_id
-        );
-        if(unlikely(retval != POS_SUCCESS)){
-            POS_WARN("failed to async commit the handle within ckpt thread: server_addr(%p), version_id(%lu)", handle->server_addr, checkpoint_version);
-            dirty_retval = retval;
-            goto membus_lock_check;
-        }
-        commit_stream_id = this->_ckpt_commit_stream_id;
+    // step 1: add & commit of all stateful handles, balanced across lanes of the commit engine
+    commit_backend->reset_stats();
+    #if POS_CONF_RUNTIME_EnableTrace
+        this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
+    #endif
+    s_tick = POSUtilTscTimer::get_tsc();
+    commit_engine->run(commit_jobs);
+    e_tick = POSUtilTscTimer::get_tsc();
+    #if POS_CONF_RUNTIME_EnableTrace
+        this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
+    #endif
 
-        if constexpr (TMP_enable_mem_lock == true){
-            /*!
-             *  \note   originally the commit process is async as it would never be disturbed by CoW, but we also need to prevent
-             *          ckpt memcpy conflict with normal memcpy, so we sync the execution here to check the memcpy flag
-             *  \todo   how many D2H engine do we have?
-             */
-            retval = this->sync(this->_ckpt_commit_stream_id);
-            if(unlikely(retval != POS_SUCCESS)){
-                POS_WARN("failed to sync the commit within ckpt thread: server_addr(%p), version_id(%lu)", handle->server_addr, checkpoint_version);
-                dirty_retval = retval;
-            }
-        } else {
-            async_commited_handles.insert(handle);
+    for(i=0; i<commit_jobs.size(); i++){
+        POS_CHECK_POINTER(handle = (POSHandle*)(commit_jobs[i].cxt));
+        if(unlikely(commit_jobs[i].retval != POS_SUCCESS)){
+            POS_WARN(
+                "failed to async commit the handle within ckpt thread: server_addr(%p), version_id(%lu), lane_id(%u)",
+                handle->server_addr, commit_jobs[i].version_id, commit_jobs[i].lane_id
+            );
+            dirty_retval = commit_jobs[i].retval;
+            continue;
         }
+        async_commited_handles.insert(handle);
+        commit_size += commit_jobs[i].size;
 
         #if POS_CONF_RUNTIME_EnableTrace
             this->async_ckpt_cxt.metric_reducers.reduce(
                 /* index */ checkpoint_async_cxt_t::CKPT_commit_bytes_by_ckpt_thread,
-                /* value */ handle->state_size
+                /* value */ commit_jobs[i].size
             );
             this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_commit_times_by_ckpt_thread);
-            this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
         #endif
-    #else
-        /*!
-         *  \brief  [phrase 1]  commit the resource state from origin buffer or CoW cache
-         *  \note   if the CoW is ongoing or finished, it commit from cache; otherwise it commit from origin buffer
-         */
-        #if POS_CONF_RUNTIME_EnableTrace
-            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
-        #endif
-    
-        retval = handle->checkpoint_commit_async(
-            /* version_id */    checkpoint_version,
-            /* stream_id */     this->_ckpt_stream_id
-        );
-        if(unlikely(retval != POS_SUCCESS && retval != POS_WARN_ABANDONED)){
-            POS_WARN("failed to async commit the handle within ckpt thread: server_addr(%p), version_id(%lu)", handle->server_addr, checkpoint_version);
-            dirty_retval = retval;
-            goto membus_lock_check;
-        }
-        commit_stream_id = this->_ckpt_stream_id;
-
-        if constexpr (TMP_enable_mem_lock == true){
-            // the sync would be done by persist below, we omit here
-            retval = this->sync(this->_ckpt_stream_id);
-            if(unlikely(retval != POS_SUCCESS)){
-                POS_WARN("failed to sync the commit within ckpt thread: server_addr(%p), version_id(%lu)", handle->server_addr, checkpoint_version);
-                dirty_retval = retval;
-            }
-        } else {
-            async_commited_handles.insert(handle);
-        }
+    }
 
-        #if POS_CONF_RUNTIME_EnableTrace
+    // fold the statistics of all lanes, as the metrics aren't thread-safe
+    #if POS_CONF_RUNTIME_EnableTrace
+        for(i=0; i<commit_engine->lanes.size(); i++){
+            pos_ckpt_commit_lane_t &lane = commit_engine->lanes[i];
             this->async_ckpt_cxt.metric_reducers.reduce(
-                /* index */ checkpoint_async_cxt_t::CKPT_commit_bytes_by_ckpt_thread,
-                /* value */ handle->state_size
+                /* index */ checkpoint_async_cxt_t::CKPT_commit_lane_bytes,
+                /* value */ lane.committed_bytes
             );
-            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_commit_times_by_ckpt_thread);
-            this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
-        #endif
-    #endif
-
-    membus_lock_check:
-        if constexpr (TMP_enable_mem_lock == true){
-            /*!
-            *  \note   we need to avoid conflict between ckpt memcpy and normal memcpy, and we will stop once it occurs
-            *  \todo   we only need to enable this once we only have one DMA engine on-device,
-            *          we need an interface to get such information
-            */
-            while(this->async_ckpt_cxt.membus_lock == true && !this->_stop_flag){ /* block */ }
-        }
-    }
+            if(lane.nb_stops > 0){
+                this->async_ckpt_cxt.metric_counters.add_counter(
+                    /* index */ checkpoint_async_cxt_t::CKPT_commit_lane_stops,
+                    /* value */ lane.nb_stops
+                );
+                this->async_ckpt_cxt.metric_tickers.add(checkpoint_async_cxt_t::CKPT_commit_lane_stall_ticks, lane.stall_ticks);
+            }
+            if(commit_backend->lane_throttled_ticks[i] > 0){
+                this->async_ckpt_cxt.metric_tickers.add(
+                    /* index */ checkpoint_async_cxt_t::CKPT_commit_throttle_ticks,
+                    /* value */ commit_backend->lane_throttled_ticks[i]
+                );
+            }
 
-    if constexpr (TMP_enable_mem_lock == false){
-        #if POS_CONF_RUNTIME_EnableTrace
-            this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
-        #endif
-    
         #if POS_CONF_EVAL_CkptEnablePipeline == 1
-            this->sync(this->_ckpt_commit_stream_id);
-        #else
-            this->sync(this->_ckpt_stream_id);
+            POSCheckpointCommitBackend_Worker::lane_add_stat_t &add_stat = commit_backend->lane_add_stats[i];
+            if(add_stat.nb_done > 0){
+                this->async_ckpt_cxt.metric_counters.add_counter(
+                    /* index */ checkpoint_async_cxt_t::CKPT_cow_done_times_by_ckpt_thread,
+                    /* value */ add_stat.nb_done
+                );
+                this->async_ckpt_cxt.metric_reducers.reduce(
+                    /* index */ checkpoint_async_cxt_t::CKPT_cow_bytes_by_ckpt_thread,
+                    /* value */ add_stat.done_bytes
+                );
+                this->async_ckpt_cxt.metric_tickers.add(checkpoint_async_cxt_t::CKPT_cow_done_ticks_by_ckpt_thread, add_stat.done_ticks);
+            }
+            if(add_stat.nb_blocked > 0){
+                this->async_ckpt_cxt.metric_counters.add_counter(
+                    /* index */ checkpoint_async_cxt_t::CKPT_cow_block_times_by_ckpt_thread,
+                    /* value */ add_stat.nb_blocked
+                );
+                this->async_ckpt_cxt.metric_tickers.add(checkpoint_async_cxt_t::CKPT_cow_block_ticks_by_ckpt_thread, add_stat.blocked_ticks);
+            }
         #endif
+        }
+    #endif
 
-        #if POS_CONF_RUNTIME_EnableTrace
-            this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_commit_ticks_by_ckpt_thread);
-        #endif
-    }
+    // feed the cost model with the effective commit bandwidth of this round
+    this->async_ckpt_cxt.cost_model.observe_commit(/* bytes */ commit_size, /* ticks */ e_tick - s_tick);
 
     // step 2: asynchronously persist all stateful handles
     #if POS_CONF_RUNTIME_EnableTrace
@@ -930,7 +1207,23 @@ void POSWorker::__checkpoint_TH_async_thread() {
         POSHandle *handle = *set_iter;
         POS_CHECK_POINTER(handle);
         
-        checkpoint_version = this->async_ckpt_cxt.checkpoint_version_map[handle];
+        checkpoint_version = handle->ckpt_version;
+
+        // bound the bandwidth of persist traffic
+        retval = this->async_ckpt_cxt.persist_throttle.acquire(
+            /* bytes */ handle->state_size,
+            /* throttled_ticks */ throttled_ticks,
+            /* cancel_flag */ &this->_stop_flag
+        );
+        if(unlikely(retval != POS_SUCCESS)){
+            dirty_retval = retval;
+            break;
+        }
+        #if POS_CONF_RUNTIME_EnableTrace
+            if(throttled_ticks > 0){
+                this->async_ckpt_cxt.metric_tickers.add(checkpoint_async_cxt_t::PERSIST_throttle_ticks, throttled_ticks);
+            }
+        #endif
 
         retval = handle->checkpoint_persist_async(
             /* ckpt_dir */ cmd->ckpt_dir,
@@ -994,6 +1287,7 @@ void POSWorker::__checkpoint_TH_async_thread() {
 
     // raise bottom-half of dumping (e.g., dirty-copy/recomputation, dump API contexts, etc.)
     this->async_ckpt_cxt.BH_active = true;
+    this->_client->worker_wait_event.notify();
 
  exit:
     ;
@@ -1093,30 +1387,35 @@ pos_retval_t POSWorker::__checkpoint_BH_sync() {
     POS_LOG("#stateless handles(%lu)", nb_ckpt_handles);
 
     // step 3: decide either dump recomputation APIs (only if CoW is enabled) or do dirty copy
+    this->async_ckpt_cxt.cost_model.observe_recompute(
+        /* nb_apis */ this->async_ckpt_cxt.nb_recompute_apis,
+        /* ticks */ this->async_ckpt_cxt.recompute_ticks
+    );
     if(cmd->do_cow == true){
-        if((this->async_ckpt_cxt.dirty_handle_state_size) >= GB(2)){
-            // case: too many dirty copies, we dump recomputation APIs
+        if(cmd->force_recompute == true){
+            // case: force-recompute is enabled, all modified handles are CoW-ed
+            POS_ASSERT(this->async_ckpt_cxt.nb_unpreserved_dirty_handles == 0);
             do_dirty_copy = false;
             POS_LOG(
-                "[Dirty Behaviour] potential dirty copies too large, do reompute: dirty-copies(%s)",
+                "[Dirty Behaviour] force-recompute is enabled, do reompute: dirty-copies(%s)",
                 POSUtilSystem::format_byte_number(this->async_ckpt_cxt.dirty_handle_state_size).c_str()
             );
         } else {
-            if(cmd->force_recompute == true){
-                // case: not too many dirty copies, bot force-recompute is enabled
-                do_dirty_copy = false;
-                POS_LOG(
-                    "[Dirty Behaviour] potential dirty copies is acceptable, but force-recompute is enabled, do reompute: dirty-copies(%s)",
-                    POSUtilSystem::format_byte_number(this->async_ckpt_cxt.dirty_handle_state_size).c_str()
-                );
-            } else {
-                // case: not too many dirty copies, conduct dirty copy
-                do_dirty_copy = true;
-                POS_LOG(
-                    "[Dirty Behaviour] potential dirty copies is acceptable, do dirty copy: dirty-copies(%s)",
-                    POSUtilSystem::format_byte_number(this->async_ckpt_cxt.dirty_handle_state_size).c_str()
-                );
-            }
+            // case: let the cost model decides
+            do_dirty_copy = kPOS_CkptDecision_Recompute != this->async_ckpt_cxt.cost_model.decide_round(
+                /* epoch */ this->async_ckpt_cxt.epoch,
+                /* dirty_state_size */ this->async_ckpt_cxt.dirty_handle_state_size,
+                /* nb_recompute_apis */ this->async_ckpt_cxt.nb_recompute_apis,
+                /* nb_unpreserved_handles */ this->async_ckpt_cxt.nb_unpreserved_dirty_handles
+            );
+            POS_LOG(
+                "[Dirty Behaviour] cost model decides to %s: dirty-copies(%s), #recompute-apis(%lu), #unpreserved-handles(%lu), %s",
+                do_dirty_copy ? "do dirty copy" : "do recompute",
+                POSUtilSystem::format_byte_number(this->async_ckpt_cxt.dirty_handle_state_size).c_str(),
+                this->async_ckpt_cxt.nb_recompute_apis,
+                this->async_ckpt_cxt.nb_unpreserved_dirty_handles,
+                this->async_ckpt_cxt.cost_model.str().c_str()
+            );
         }
     } else {
         do_dirty_copy = true;
@@ -1125,11 +1424,15 @@ pos_retval_t POSWorker::__checkpoint_BH_sync() {
             POSUtilSystem::format_byte_number(this->async_ckpt_cxt.dirty_handle_state_size).c_str()
         );
     }
+    #if POS_CONF_RUNTIME_EnableTrace
+        if(do_dirty_copy == false){
+            this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_recompute_decisions);
+        }
+    #endif
 
     if(do_dirty_copy){ // do dirty copy
-        for(set_iter=this->async_ckpt_cxt.dirty_handles.begin(); set_iter!=this->async_ckpt_cxt.dirty_handles.end(); set_iter++){
-            handle = *set_iter;
-            POS_CHECK_POINTER(handle);
+        for(handle=this->async_ckpt_cxt.dirty_handles; handle!=nullptr; handle=handle->dirty_next){
+            POS_ASSERT(handle->dirty_epoch == this->async_ckpt_cxt.epoch);
 
             if(unlikely(   handle->status == kPOS_HandleStatus_Deleted 
                         || handle->status == kPOS_HandleStatus_Create_Pending
@@ -1142,6 +1445,7 @@ pos_retval_t POSWorker::__checkpoint_BH_sync() {
             #if POS_CONF_RUNTIME_EnableTrace
                 this->async_ckpt_cxt.metric_tickers.start(checkpoint_async_cxt_t::CKPT_dirty_commit_ticks);
             #endif
+            s_tick = POSUtilTscTimer::get_tsc();
             retval = handle->checkpoint_commit_sync(
                 /* version_id */ handle->latest_version,
                 /* stream_id */ 0
@@ -1151,6 +1455,8 @@ pos_retval_t POSWorker::__checkpoint_BH_sync() {
                 retval = POS_FAILED;
                 goto sync_persist;
             }
+            e_tick = POSUtilTscTimer::get_tsc();
+            this->async_ckpt_cxt.cost_model.observe_commit(/* bytes */ handle->state_size, /* ticks */ e_tick - s_tick);
             #if POS_CONF_RUNTIME_EnableTrace
                 this->async_ckpt_cxt.metric_tickers.end(checkpoint_async_cxt_t::CKPT_dirty_commit_ticks);
                 this->async_ckpt_cxt.metric_counters.add_counter(checkpoint_async_cxt_t::CKPT_dirty_commit_times);
@@ -1285,6 +1591,10 @@ pos_retval_t POSWorker::__process_cmd(POSCommand_QE_t *cmd){
     POSHandle *handle;
     uint64_t i;
     typename std::set<POSHandle*>::iterator handle_set_iter;
+    std::vector<POSAPIContext_QE*> wqes;
+    std::string sched_policy, commit_lanes, conf_val;
+    uint64_t commit_bw = 0, commit_burst = 0, persist_bw = 0, persist_burst = 0, max_slowdown_pct = 0;
+    uint32_t nb_commit_lanes = POSCheckpointCommitEngine::kDefaultNbLanes;
 
     POS_CHECK_POINTER(cmd);
 
@@ -1307,9 +1617,26 @@ pos_retval_t POSWorker::__process_cmd(POSCommand_QE_t *cmd){
             goto exit;
         }
 
+        /*!
+         *  \note  start a new checkpoint round by bumping the epoch, all handles stamped
+         *         with previous epochs are no longer checkpoint members / dirty
+         */
         this->async_ckpt_cxt.cmd = cmd;
-        this->async_ckpt_cxt.dirty_handles.clear();
+        this->async_ckpt_cxt.epoch += 1;
+        this->async_ckpt_cxt.dirty_handles = nullptr;
+        this->async_ckpt_cxt.nb_dirty_handles = 0;
         this->async_ckpt_cxt.dirty_handle_state_size = 0;
+        this->async_ckpt_cxt.nb_unpreserved_dirty_handles = 0;
+        this->async_ckpt_cxt.nb_recompute_apis = 0;
+        this->async_ckpt_cxt.recompute_ticks = 0;
+
+        // decisions of all rounds are dumped to the directory of the latest checkpoint once the worker exits
+        this->async_ckpt_cxt.cost_model_dump_dir = cmd->ckpt_dir;
+
+        // update the scheduling policy of commits within the checkpoint thread
+        if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kEvalCkptSchedPolicy, sched_policy))){
+            POSCheckpointScheduler::parse_policy(sched_policy, this->async_ckpt_cxt.scheduler.policy);
+        }
         this->async_ckpt_cxt.persist_handles.clear();
 
         #if POS_CONF_RUNTIME_EnableTrace
@@ -1323,21 +1650,105 @@ pos_retval_t POSWorker::__process_cmd(POSCommand_QE_t *cmd){
             if(this->async_ckpt_cxt.thread->joinable())
                 this->async_ckpt_cxt.thread->join();
             delete this->async_ckpt_cxt.thread;
+            this->async_ckpt_cxt.thread = nullptr;
         }
 
-        // clear the ckpt dag queue
-        this->_client->clear_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>();
+        // clear the ckpt dag queue, wqes recorded in previous round are no longer needed for recomputation
+        wqes.clear();
+        this->_client->template poll_q<kPOS_QueueDirection_WorkerLocal, kPOS_QueueType_ApiCxt_CkptDag_WQ>(&wqes);
+        for(i=0; i<wqes.size(); i++){ wqes[i]->release(); }
 
-        // reset checkpoint version map
-        this->async_ckpt_cxt.checkpoint_version_map.clear();
+        /*!
+         *  \brief stamp checkpoint membership and version of all handles to be checkpointed, and
+         *         decide how to preserve their states once they're modified in this round
+         *  \note  without CoW, all handles wait for the bottom-half to commit; with force-recompute,
+         *         all handles are CoW-ed; otherwise the cost model decides per handle
+         */
         for(handle_set_iter = cmd->stateful_handles.begin(); 
             handle_set_iter != cmd->stateful_handles.end(); 
             handle_set_iter++)
         {
             POS_CHECK_POINTER(handle = *handle_set_iter);
             handle->reset_preserve_counter();
-            this->async_ckpt_cxt.checkpoint_version_map[handle] = handle->latest_version;
+            handle->ckpt_epoch = this->async_ckpt_cxt.epoch;
+            handle->ckpt_version = handle->latest_version;
+
+            handle->ckpt_write_freq = this->async_ckpt_cxt.cost_model.update_write_freq(
+                /* write_freq */ handle->ckpt_write_freq,
+                /* nb_writes */ handle->nb_ckpt_writes
+            );
+            handle->nb_ckpt_writes = 0;
+
+            if(cmd->do_cow == false){
+                handle->ckpt_decision = kPOS_CkptDecision_WaitCommit;
+            } else if(cmd->force_recompute == true){
+                handle->ckpt_decision = kPOS_CkptDecision_CoW;
+            } else {
+                handle->ckpt_decision = this->async_ckpt_cxt.cost_model.decide_handle(
+                    /* epoch */ this->async_ckpt_cxt.epoch,
+                    /* handle_id */ handle->id,
+                    /* resource_type_id */ handle->resource_type_id,
+                    /* state_size */ handle->state_size,
+                    /* write_freq */ handle->ckpt_write_freq
+                );
+            }
+
+            #if POS_CONF_RUNTIME_EnableTrace
+                this->async_ckpt_cxt.metric_counters.add_counter(
+                    handle->ckpt_decision == kPOS_CkptDecision_CoW
+                    ? checkpoint_async_cxt_t::CKPT_cow_decisions
+                    : checkpoint_async_cxt_t::CKPT_wait_commit_decisions
+                );
+            #endif
+        }
+
+        // (re-)create the commit engine of the checkpoint thread, once the number of lanes is changed
+        if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kEvalCkptCommitLanes, commit_lanes))){
+            nb_commit_lanes = std::stoul(commit_lanes);
         }
+        if(unlikely(   this->async_ckpt_cxt.commit_engine == nullptr
+                    || this->async_ckpt_cxt.commit_engine->get_nb_lanes() != nb_commit_lanes
+        )){
+            if(this->async_ckpt_cxt.commit_engine != nullptr){
+                delete this->async_ckpt_cxt.commit_engine;
+                this->async_ckpt_cxt.commit_engine = nullptr;
+            }
+            if(this->async_ckpt_cxt.commit_backend == nullptr){
+                this->async_ckpt_cxt.commit_backend = new POSCheckpointCommitBackend_Worker(this);
+                POS_CHECK_POINTER(this->async_ckpt_cxt.commit_backend);
+            }
+            this->async_ckpt_cxt.commit_engine = new POSCheckpointCommitEngine(
+                /* backend */ this->async_ckpt_cxt.commit_backend,
+                /* nb_lanes */ nb_commit_lanes,
+                /* staging_size */ 0
+            );
+            POS_CHECK_POINTER(this->async_ckpt_cxt.commit_engine);
+            if(unlikely(POS_SUCCESS != (retval = this->async_ckpt_cxt.commit_engine->init()))){
+                POS_WARN_C("failed to init checkpoint commit engine: nb_lanes(%u), retval(%u)", nb_commit_lanes, retval);
+                delete this->async_ckpt_cxt.commit_engine;
+                this->async_ckpt_cxt.commit_engine = nullptr;
+                cmd->retval = retval;
+                retval = this->_client->template push_q<kPOS_QueueDirection_Parser2Worker, kPOS_QueueType_Cmd_CQ>(cmd);
+                if(unlikely(retval != POS_SUCCESS)){
+                    POS_WARN_C("failed to reply ckpt cmd cq to parser: retval(%u)", retval);
+                }
+                goto exit;
+            }
+        }
+
+        // update the rate limiters of checkpoint traffic
+        if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kEvalCkptCommitBandwidth, conf_val)))
+            commit_bw = std::stoull(conf_val);
+        if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kEvalCkptCommitBurst, conf_val)))
+            commit_burst = std::stoull(conf_val);
+        if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kEvalCkptPersistBandwidth, conf_val)))
+            persist_bw = std::stoull(conf_val);
+        if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kEvalCkptPersistBurst, conf_val)))
+            persist_burst = std::stoull(conf_val);
+        if(likely(POS_SUCCESS == this->_ws->ws_conf.get(POSWorkspaceConf::ConfigType::kEvalCkptMaxSlowdownPct, conf_val)))
+            max_slowdown_pct = std::stoull(conf_val);
+        this->async_ckpt_cxt.commit_throttle.configure(commit_bw, commit_burst, max_slowdown_pct);
+        this->async_ckpt_cxt.persist_throttle.configure(persist_bw, persist_burst);
 
         // drain the device
         #if POS_CONF_RUNTIME_EnableTrace
@@ -1370,7 +1781,7 @@ exit:
 #endif // POS_CONF_EVAL_CkptOptLevel
 
 
-pos_retval_t POSWorker::__restore_broken_handles(POSAPIContext_QE* wqe, POSAPIMeta_t* api_meta){
+pos_retval_t POSWorker::__restore_broken_handles(POSAPIContext_QE* wqe, const POSAPIMeta_t* api_meta){
     pos_retval_t retval = POS_SUCCESS;
 
     #if POS_CONF_RUNTIME_EnableTrace
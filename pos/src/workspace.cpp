@@ -16,6 +16,7 @@
 
 #include <iostream>
 #include <string>
+#include <thread>
 #include <atomic>
 #include <filesystem>
 #include "pos/include/common.h"
@@ -33,11 +34,69 @@ POSWorkspaceConf::POSWorkspaceConf(POSWorkspace *root_ws){
     this->_runtime_daemon_log_path = POS_CONF_RUNTIME_DefaultDaemonLogPath;
     this->_runtime_trace_resource = false;
     this->_runtime_trace_performance = false;
+    this->_runtime_kernel_meta_cache_dir = std::string(POS_CONF_RUNTIME_DefaultDaemonLogPath) + std::string("/kernel_meta_cache");
+    this->_runtime_lazy_kernel_meta = false;
+    this->_runtime_fatbin_text_spill = false;
+    this->_runtime_daemon_batch_size = POS_LOCKLESS_QUEUE_DEFAULT_BATCH_SIZE;
+    this->_runtime_wait_spin_us = POSUtilWaitEvent::kDefaultSpinUs;
+    this->_runtime_wait_yield_us = POSUtilWaitEvent::kDefaultYieldUs;
+    this->_runtime_wait_park_timeout_us = POSUtilWaitEvent::kDefaultParkTimeoutUs;
+    this->_runtime_daemon_pool_threads = 0;
+    this->_runtime_placement_policy = kPOS_PlacementPolicy_None;
+    this->_runtime_placement_numa_node = POSPlacement::kAutoNumaNode;
+    this->_runtime_placement_critical_cores = 0;
 
     // evaluation configurations
     this->_eval_ckpt_interval_tick = this->_root_ws->tsc_timer.ms_to_tick(
         POS_CONF_EVAL_CkptDefaultIntervalMs
     );
+    this->_eval_ckpt_sched_policy = kPOS_CkptSchedPolicy_PredictedWrite;
+    this->_eval_ckpt_commit_lanes = POSCheckpointCommitEngine::kDefaultNbLanes;
+    this->_eval_ckpt_commit_bw = 0;
+    this->_eval_ckpt_commit_burst = 0;
+    this->_eval_ckpt_persist_bw = 0;
+    this->_eval_ckpt_persist_burst = 0;
+    this->_eval_ckpt_max_slowdown_pct = 0;
+}
+
+
+pos_retval_t POSWorkspaceConf::get_config_type_by_name(const std::string& name, ConfigType& conf_type){
+    pos_retval_t retval = POS_SUCCESS;
+    static const std::map<std::string, ConfigType> config_names = {
+        { "daemon_log_path",        kRuntimeDaemonLogPath },
+        { "trace_resource",         kRuntimeTraceResourceEnabled },
+        { "trace_performance",      kRuntimeTracePerformanceEnabled },
+        { "trace_dir",              kRuntimeTraceDir },
+        { "kernel_meta_cache_dir",  kRuntimeKernelMetaCacheDir },
+        { "lazy_kernel_meta",       kRuntimeLazyKernelMeta },
+        { "fatbin_text_spill",      kRuntimeFatbinTextSpill },
+        { "daemon_batch_size",      kRuntimeDaemonBatchSize },
+        { "wait_spin_us",           kRuntimeWaitSpinUs },
+        { "wait_yield_us",          kRuntimeWaitYieldUs },
+        { "wait_park_timeout_us",   kRuntimeWaitParkTimeoutUs },
+        { "daemon_pool_threads",    kRuntimeDaemonPoolThreads },
+        { "placement_policy",       kRuntimePlacementPolicy },
+        { "placement_numa_node",    kRuntimePlacementNumaNode },
+        { "placement_critical_cores", kRuntimePlacementCriticalCores },
+        { "placement",              kRuntimePlacement },
+        { "ckpt_interval_ms",       kEvalCkptIntervfalMs },
+        { "ckpt_sched_policy",      kEvalCkptSchedPolicy },
+        { "ckpt_commit_lanes",      kEvalCkptCommitLanes },
+        { "ckpt_commit_bw",         kEvalCkptCommitBandwidth },
+        { "ckpt_commit_burst",      kEvalCkptCommitBurst },
+        { "ckpt_persist_bw",        kEvalCkptPersistBandwidth },
+        { "ckpt_persist_burst",     kEvalCkptPersistBurst },
+        { "ckpt_max_slowdown_pct",  kEvalCkptMaxSlowdownPct },
+    };
+
+    auto it = config_names.find(name);
+    if(unlikely(it == config_names.end())){
+        retval = POS_FAILED_NOT_EXIST;
+    } else {
+        conf_type = it->second;
+    }
+
+    return retval;
 }
 
 
@@ -45,6 +104,7 @@ pos_retval_t POSWorkspaceConf::set(ConfigType conf_type, std::string val){
     pos_retval_t retval = POS_SUCCESS;
     std::lock_guard<std::mutex> lock(this->_mutex);
     uint64_t _tmp;
+    pos_placement_policy_t _policy;
 
     POS_ASSERT(conf_type < ConfigType::kUnknown);
 
@@ -78,6 +138,231 @@ pos_retval_t POSWorkspaceConf::set(ConfigType conf_type, std::string val){
         this->_runtime_trace_dir = val;
         break;
 
+    case kRuntimeKernelMetaCacheDir:
+        if(val == "none"){ val.clear(); }
+        this->_runtime_kernel_meta_cache_dir = val;
+        POS_LOG_C(
+            "set kernel meta cache directory as %s, applied to newly created clients",
+            val.size() > 0 ? val.c_str() : "none (disabled)"
+        );
+        break;
+
+    case kRuntimeLazyKernelMeta:
+        if(val == "true"){
+            this->_runtime_lazy_kernel_meta = true;
+            POS_LOG_C("set lazy kernel metadata as enabled, applied to newly created clients");
+        } else {
+            this->_runtime_lazy_kernel_meta = false;
+            POS_LOG_C("set lazy kernel metadata as disabled, applied to newly created clients");
+        }
+        break;
+
+    case kRuntimeFatbinTextSpill:
+        if(val == "true"){
+            this->_runtime_fatbin_text_spill = true;
+            POS_LOG_C("set spilling decompressed fatbin sections as enabled, applied to newly created clients");
+        } else {
+            this->_runtime_fatbin_text_spill = false;
+            POS_LOG_C("set spilling decompressed fatbin sections as disabled, applied to newly created clients");
+        }
+        break;
+
+    case kRuntimeDaemonBatchSize:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set daemon batch size: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set daemon batch size: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(unlikely(_tmp == 0 || _tmp > POS_LOCKLESS_QUEUE_MAX_BATCH_SIZE)){
+            POS_WARN_C(
+                "failed to set daemon batch size, should be within [1, %u]: %lu",
+                POS_LOCKLESS_QUEUE_MAX_BATCH_SIZE, _tmp
+            );
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_runtime_daemon_batch_size = static_cast<uint32_t>(_tmp);
+        POS_LOG_C("set daemon batch size as %u, applied to newly created clients", this->_runtime_daemon_batch_size);
+        break;
+
+    case kRuntimeWaitSpinUs:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set wait spin budget: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set wait spin budget: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(unlikely(_tmp > POSUtilWaitEvent::kMaxBudgetUs)){
+            POS_WARN_C(
+                "failed to set wait spin budget, should be within [0, %lu]: %lu",
+                POSUtilWaitEvent::kMaxBudgetUs, _tmp
+            );
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_runtime_wait_spin_us = _tmp;
+        POS_LOG_C("set wait spin budget as %lu us, applied to newly created clients", this->_runtime_wait_spin_us);
+        break;
+
+    case kRuntimeWaitYieldUs:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set wait yield budget: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set wait yield budget: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(unlikely(_tmp > POSUtilWaitEvent::kMaxBudgetUs)){
+            POS_WARN_C(
+                "failed to set wait yield budget, should be within [0, %lu]: %lu",
+                POSUtilWaitEvent::kMaxBudgetUs, _tmp
+            );
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_runtime_wait_yield_us = _tmp;
+        POS_LOG_C("set wait yield budget as %lu us, applied to newly created clients", this->_runtime_wait_yield_us);
+        break;
+
+    case kRuntimeWaitParkTimeoutUs:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set wait park timeout: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set wait park timeout: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(unlikely(_tmp == 0 || _tmp > POSUtilWaitEvent::kMaxBudgetUs)){
+            POS_WARN_C(
+                "failed to set wait park timeout, should be within [1, %lu]: %lu",
+                POSUtilWaitEvent::kMaxBudgetUs, _tmp
+            );
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_runtime_wait_park_timeout_us = _tmp;
+        POS_LOG_C("set wait park timeout as %lu us, applied to newly created clients", this->_runtime_wait_park_timeout_us);
+        break;
+
+    case kRuntimeDaemonPoolThreads:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set daemon pool threads: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set daemon pool threads: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(unlikely(_tmp > POSDaemonPool::kMaxNbThreads)){
+            POS_WARN_C(
+                "failed to set daemon pool threads, should be within [0, %u]: %lu",
+                POSDaemonPool::kMaxNbThreads, _tmp
+            );
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_runtime_daemon_pool_threads = static_cast<uint32_t>(_tmp);
+        POS_LOG_C(
+            "set daemon pool threads as %u, applied to newly created clients (pools already created are kept)",
+            this->_runtime_daemon_pool_threads
+        );
+        break;
+
+    case kRuntimePlacementPolicy:
+        if(unlikely(kPOS_PlacementPolicy_Unknown == (_policy = POSPlacement::policy_from_str(val)))){
+            POS_WARN_C("failed to set placement policy, unknown policy: %s", val.c_str());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_runtime_placement_policy = _policy;
+        this->_root_ws->placement.configure(
+            this->_runtime_placement_policy, this->_runtime_placement_numa_node, this->_runtime_placement_critical_cores
+        );
+        POS_LOG_C("set placement policy as %s", val.c_str());
+        break;
+
+    case kRuntimePlacementNumaNode:
+        if(val == "auto"){
+            _tmp = POSPlacement::kAutoNumaNode;
+        } else {
+            try {
+                _tmp = std::stoull(val);
+            } catch (const std::invalid_argument& e) {
+                POS_WARN_C("failed to set placement NUMA node: %s", e.what());
+                retval = POS_FAILED_INVALID_INPUT;
+                goto exit;
+            } catch (const std::out_of_range& e) {
+                POS_WARN_C("failed to set placement NUMA node: %s", e.what());
+                retval = POS_FAILED_INVALID_INPUT;
+                goto exit;
+            }
+            if(unlikely(_tmp > POSPlacement::kMaxNumaNode)){
+                POS_WARN_C(
+                    "failed to set placement NUMA node, should be 'auto' or within [0, %d]: %lu",
+                    POSPlacement::kMaxNumaNode, _tmp
+                );
+                retval = POS_FAILED_INVALID_INPUT;
+                goto exit;
+            }
+        }
+        this->_runtime_placement_numa_node = static_cast<int32_t>(_tmp);
+        this->_root_ws->placement.configure(
+            this->_runtime_placement_policy, this->_runtime_placement_numa_node, this->_runtime_placement_critical_cores
+        );
+        POS_LOG_C("set placement NUMA node as %s", val.c_str());
+        break;
+
+    case kRuntimePlacementCriticalCores:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set placement critical cores: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set placement critical cores: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(unlikely(_tmp > CPU_SETSIZE)){
+            POS_WARN_C("failed to set placement critical cores, should be within [0, %d]: %lu", CPU_SETSIZE, _tmp);
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_runtime_placement_critical_cores = static_cast<uint32_t>(_tmp);
+        this->_root_ws->placement.configure(
+            this->_runtime_placement_policy, this->_runtime_placement_numa_node, this->_runtime_placement_critical_cores
+        );
+        POS_LOG_C("set placement critical cores as %u", this->_runtime_placement_critical_cores);
+        break;
+
+    case kRuntimePlacement:
+        POS_WARN_C("failed to set placement, it's read-only, set placement_* instead");
+        retval = POS_FAILED_INVALID_INPUT;
+        goto exit;
+
     case kEvalCkptIntervfalMs:
         try {
             _tmp = std::stoull(val);
@@ -96,6 +381,78 @@ pos_retval_t POSWorkspaceConf::set(ConfigType conf_type, std::string val){
         this->_eval_ckpt_interval_ms = _tmp;
         break;
 
+    case kEvalCkptSchedPolicy:
+        if(unlikely(POS_SUCCESS != POSCheckpointScheduler::parse_policy(val, this->_eval_ckpt_sched_policy))){
+            POS_WARN_C("failed to set ckpt scheduling policy, unknown policy: %s", val.c_str());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        POS_LOG_C("set ckpt scheduling policy as %s", val.c_str());
+        break;
+
+    case kEvalCkptCommitLanes:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set ckpt commit lanes: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set ckpt commit lanes: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(unlikely(_tmp == 0 || _tmp > POSCheckpointCommitEngine::kMaxNbLanes)){
+            POS_WARN_C(
+                "failed to set ckpt commit lanes, should be within [1, %u]: %lu",
+                POSCheckpointCommitEngine::kMaxNbLanes, _tmp
+            );
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        this->_eval_ckpt_commit_lanes = static_cast<uint32_t>(_tmp);
+        POS_LOG_C("set ckpt commit lanes as %u", this->_eval_ckpt_commit_lanes);
+        break;
+
+    case kEvalCkptCommitBandwidth:
+    case kEvalCkptCommitBurst:
+    case kEvalCkptPersistBandwidth:
+    case kEvalCkptPersistBurst:
+    case kEvalCkptMaxSlowdownPct:
+        try {
+            _tmp = std::stoull(val);
+        } catch (const std::invalid_argument& e) {
+            POS_WARN_C("failed to set ckpt throttling: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        } catch (const std::out_of_range& e) {
+            POS_WARN_C("failed to set ckpt throttling: %s", e.what());
+            retval = POS_FAILED_INVALID_INPUT;
+            goto exit;
+        }
+        if(conf_type == kEvalCkptCommitBandwidth){
+            this->_eval_ckpt_commit_bw = _tmp;
+            POS_LOG_C("set ckpt commit bandwidth as %lu bytes/s", _tmp);
+        } else if(conf_type == kEvalCkptCommitBurst){
+            this->_eval_ckpt_commit_burst = _tmp;
+            POS_LOG_C("set ckpt commit burst as %lu bytes", _tmp);
+        } else if(conf_type == kEvalCkptPersistBandwidth){
+            this->_eval_ckpt_persist_bw = _tmp;
+            POS_LOG_C("set ckpt persist bandwidth as %lu bytes/s", _tmp);
+        } else if(conf_type == kEvalCkptPersistBurst){
+            this->_eval_ckpt_persist_burst = _tmp;
+            POS_LOG_C("set ckpt persist burst as %lu bytes", _tmp);
+        } else {
+            if(unlikely(_tmp > 100)){
+                POS_WARN_C("failed to set ckpt max slowdown, should be within [0, 100]: %lu", _tmp);
+                retval = POS_FAILED_INVALID_INPUT;
+                goto exit;
+            }
+            this->_eval_ckpt_max_slowdown_pct = static_cast<uint32_t>(_tmp);
+            POS_LOG_C("set ckpt max slowdown as %u%%", this->_eval_ckpt_max_slowdown_pct);
+        }
+        break;
+
     default:
         POS_ERROR_C_DETAIL("unknown config type %u, this is a bug", conf_type);
         break;
@@ -129,10 +486,90 @@ pos_retval_t POSWorkspaceConf::get(ConfigType conf_type, std::string& val){
         val = this->_runtime_trace_dir;
         break;
 
+    case kRuntimeKernelMetaCacheDir:
+        val = this->_runtime_kernel_meta_cache_dir.size() > 0 ? this->_runtime_kernel_meta_cache_dir : std::string("none");
+        break;
+
+    case kRuntimeLazyKernelMeta:
+        val = std::to_string(this->_runtime_lazy_kernel_meta);
+        break;
+
+    case kRuntimeFatbinTextSpill:
+        val = std::to_string(this->_runtime_fatbin_text_spill);
+        break;
+
+    case kRuntimeDaemonBatchSize:
+        val = std::to_string(this->_runtime_daemon_batch_size);
+        break;
+
+    case kRuntimeWaitSpinUs:
+        val = std::to_string(this->_runtime_wait_spin_us);
+        break;
+
+    case kRuntimeWaitYieldUs:
+        val = std::to_string(this->_runtime_wait_yield_us);
+        break;
+
+    case kRuntimeWaitParkTimeoutUs:
+        val = std::to_string(this->_runtime_wait_park_timeout_us);
+        break;
+
+    case kRuntimeDaemonPoolThreads:
+        val = std::to_string(this->_runtime_daemon_pool_threads);
+        break;
+
+    case kRuntimePlacementPolicy:
+        val = POSPlacement::policy_str(this->_runtime_placement_policy);
+        break;
+
+    case kRuntimePlacementNumaNode:
+        if(this->_runtime_placement_numa_node == POSPlacement::kAutoNumaNode){
+            val = "auto";
+        } else {
+            val = std::to_string(this->_runtime_placement_numa_node);
+        }
+        break;
+
+    case kRuntimePlacementCriticalCores:
+        val = std::to_string(this->_runtime_placement_critical_cores);
+        break;
+
+    case kRuntimePlacement:
+        val = this->_root_ws->placement.str();
+        break;
+
     case kEvalCkptIntervfalMs:
         val = std::to_string(this->_eval_ckpt_interval_ms);
         break;
 
+    case kEvalCkptSchedPolicy:
+        val = POSCheckpointScheduler::policy_str(this->_eval_ckpt_sched_policy);
+        break;
+
+    case kEvalCkptCommitLanes:
+        val = std::to_string(this->_eval_ckpt_commit_lanes);
+        break;
+
+    case kEvalCkptCommitBandwidth:
+        val = std::to_string(this->_eval_ckpt_commit_bw);
+        break;
+
+    case kEvalCkptCommitBurst:
+        val = std::to_string(this->_eval_ckpt_commit_burst);
+        break;
+
+    case kEvalCkptPersistBandwidth:
+        val = std::to_string(this->_eval_ckpt_persist_bw);
+        break;
+
+    case kEvalCkptPersistBurst:
+        val = std::to_string(this->_eval_ckpt_persist_burst);
+        break;
+
+    case kEvalCkptMaxSlowdownPct:
+        val = std::to_string(this->_eval_ckpt_max_slowdown_pct);
+        break;
+
     default:
         POS_ERROR_C_DETAIL("unknown config type %u, this is a bug", conf_type);
         break;
@@ -144,7 +581,10 @@ exit:
 
 
 POSWorkspace::POSWorkspace() :
-    _current_max_uuid(0),
+    _parser_pool(nullptr),
+    _worker_pool(nullptr),
+    _api_trace_writer(nullptr),
+    _nb_api_trace_rings(0),
     ws_conf(this)
 {
     // create out-of-band server
@@ -157,9 +597,11 @@ POSWorkspace::POSWorkspace() :
             {   kPOS_OOB_Msg_CLI_Ckpt_Dump,             oob_functions::cli_ckpt_dump::sv            },
             {   kPOS_OOB_Msg_CLI_Restore,               oob_functions::cli_restore::sv              },
             {   kPOS_OOB_Msg_CLI_Trace_Resource,        oob_functions::cli_trace_resource::sv       },
+            {   kPOS_OOB_Msg_CLI_Config,                oob_functions::cli_config::sv               },
         },
         /* ip_str */ POS_OOB_SERVER_DEFAULT_IP,
-        /* port */ POS_OOB_SERVER_DEFAULT_PORT
+        /* port */ POS_OOB_SERVER_DEFAULT_PORT,
+        /* placement */ &this->placement
     );
     POS_CHECK_POINTER(_oob_server);
 
@@ -213,8 +655,8 @@ pos_retval_t POSWorkspace::deinit(){
 
     POS_DEBUG_C("cleaning all clients...");
     nb_clean_client = 0;
-    for(i=0; i<this->_client_list.size(); i++){
-        if(this->_client_list[i] != nullptr){
+    for(i=0; i<this->_client_registry.get_max_uuid(); i++){
+        if(this->get_client_by_uuid(i) != nullptr){
             this->remove_client(i);
             nb_clean_client += 1;
         }
@@ -222,6 +664,22 @@ pos_retval_t POSWorkspace::deinit(){
     POS_BACK_LINE;
     POS_DEBUG_C("cleaned clients: #clients(%lu)", nb_clean_client);
 
+    // stop daemon pools after all clients are removed from them
+    if(this->_parser_pool != nullptr){
+        delete this->_parser_pool;
+        this->_parser_pool = nullptr;
+    }
+    if(this->_worker_pool != nullptr){
+        delete this->_worker_pool;
+        this->_worker_pool = nullptr;
+    }
+
+    // close the API trace file after all client rings are drained
+    if(this->_api_trace_writer != nullptr){
+        delete this->_api_trace_writer;
+        this->_api_trace_writer = nullptr;
+    }
+
     POS_DEBUG_C("deinit platform-specific context...");
     retval = this->__deinit();
     if(likely(retval == POS_SUCCESS)){
@@ -237,8 +695,7 @@ pos_retval_t POSWorkspace::create_client(pos_create_client_param_t& param, POSCl
     pos_retval_t retval = POS_SUCCESS;
     uuid_t uuid;
 
-    param.id = this->_current_max_uuid;
-    this->_current_max_uuid += 1;
+    param.id = this->_client_registry.alloc_uuid();
     param.is_restoring = false;
 
     // create client
@@ -248,10 +705,12 @@ pos_retval_t POSWorkspace::create_client(pos_create_client_param_t& param, POSCl
         goto exit;
     }
 
-    this->_client_list.resize(this->_current_max_uuid);
-    this->_client_list[(*clnt)->id] = (*clnt);
-
-    this->_pid_client_map[param.pid] = (*clnt);
+    if(unlikely(POS_SUCCESS != (retval = this->_client_registry.insert((*clnt)->id, param.pid, *clnt)))){
+        POS_WARN_C("failed to register client: uuid(%lu), pid(%d)", (*clnt)->id, param.pid);
+        this->__destory_client(*clnt);
+        *clnt = nullptr;
+        goto exit;
+    }
     POS_DEBUG_C("create client: addr(%p), uuid(%lu), pid(%d)", (*clnt), (*clnt)->id, param.pid);
 
 exit:
@@ -262,28 +721,19 @@ exit:
 pos_retval_t POSWorkspace::remove_client(pos_client_uuid_t uuid){
     pos_retval_t retval = POS_SUCCESS;
     POSClient *clnt;
-    typename std::map<__pid_t, POSClient*>::iterator pid_client_map_iter;
 
-    clnt = this->get_client_by_uuid(uuid);
+    // unregister, and wait until no RPC thread is accessing the client within a read section
+    clnt = this->_client_registry.erase(uuid);
     if(unlikely(clnt == nullptr)){
         POS_WARN_C("try to remove an non-exist client: uuid(%lu)", uuid);
         retval = POS_FAILED_NOT_EXIST;
         goto exit;
     }
 
-    // delete from pid map
-    for(pid_client_map_iter = this->_pid_client_map.begin();
-        pid_client_map_iter != this->_pid_client_map.end();
-        pid_client_map_iter ++
-    ){
-        if(pid_client_map_iter->second == clnt){
-            this->_pid_client_map.erase(pid_client_map_iter);
-            break;
-        }
-    }
-
-    // erase from global map
-    this->_client_list[uuid] = nullptr;
+    // no more RPC thread could hold the client, wake those waiting for it to be ready and wait them to leave
+    clnt->is_removed.store(true, std::memory_order_seq_cst);
+    clnt->rpc_wait_event.notify();
+    while(clnt->nb_rpc_refs.load(std::memory_order_acquire) > 0){ std::this_thread::yield(); }
 
     // delete client
     retval = this->__destory_client(clnt);
@@ -335,7 +785,7 @@ pos_retval_t POSWorkspace::restore_client(std::string& ckpt_file, POSClient** cl
         retval = POS_FAILED;
         goto exit;
     }
-    if(unlikely(this->_pid_client_map.count(create_param.pid) > 0)){
+    if(unlikely(this->get_client_by_pid(create_param.pid) != nullptr)){
         POS_WARN_C("confliction of client pid, %s", POS_BUG_REPORT);
         retval = POS_FAILED;
         goto exit;
@@ -350,11 +800,12 @@ pos_retval_t POSWorkspace::restore_client(std::string& ckpt_file, POSClient** cl
     POS_CHECK_POINTER(clnt);
     (*clnt)->_api_inst_pc = client_binary.api_inst_pc();
 
-    if(unlikely(this->_client_list.size() < (*clnt)->id))
-        this->_client_list.resize((*clnt)->id);
-    this->_client_list[(*clnt)->id] = (*clnt);
-
-    this->_pid_client_map[(*clnt)->pid] = (*clnt);
+    if(unlikely(POS_SUCCESS != (retval = this->_client_registry.insert((*clnt)->id, (*clnt)->pid, *clnt)))){
+        POS_WARN_C("failed to register restored client: uuid(%lu), pid(%d)", (*clnt)->id, (*clnt)->pid);
+        this->__destory_client(*clnt);
+        *clnt = nullptr;
+        goto exit;
+    }
     POS_DEBUG_C("restore client: addr(%p), uuid(%lu), pid(%d)", (*clnt), (*clnt)->id, (*clnt)->pid);
 
 exit:
@@ -363,55 +814,164 @@ exit:
 }
 
 
-POSClient* POSWorkspace::get_client_by_pid(__pid_t pid){
-    POSClient *retval = nullptr;
+pos_retval_t POSWorkspace::add_api_trace_ring(POSApiTraceRing *ring){
+    pos_retval_t retval = POS_SUCCESS;
+    std::lock_guard<std::mutex> lock(this->_api_trace_writer_mutex);
+    std::string trace_dir, file_path;
+
+    POS_CHECK_POINTER(ring);
+
+    // the writer is stopped once the last ring is detached, so a new one picks up the current trace directory
+    if(this->_api_trace_writer != nullptr){ goto attach; }
+    POS_ASSERT(this->_nb_api_trace_rings == 0);
 
-    if(unlikely(this->_pid_client_map.count(pid) > 0)){
-        retval = this->_pid_client_map[pid];
+    if(unlikely(POS_SUCCESS != (retval = this->ws_conf.get(POSWorkspaceConf::kRuntimeTraceDir, trace_dir)))){
+        POS_WARN_C("failed to obtain directory to store API trace");
+        goto exit;
+    }
+    try {
+        std::filesystem::create_directories(trace_dir);
+    } catch (const std::filesystem::filesystem_error& e) {
+        POS_WARN_C("failed to create directory to store API trace: dir(%s)", trace_dir.c_str());
+        retval = POS_FAILED;
+        goto exit;
     }
+    file_path = trace_dir
+                + std::string("/api_trace-")
+                + std::to_string(this->tsc_timer.get_tsc())
+                + std::string(".bin");
+
+    POS_CHECK_POINTER(this->_api_trace_writer = new POSApiTraceWriter(&this->placement));
+    if(unlikely(POS_SUCCESS != (retval = this->_api_trace_writer->init(file_path, this->tsc_timer.get_tsc_freq())))){
+        POS_WARN_C("failed to start API trace writer: path(%s)", file_path.c_str());
+        delete this->_api_trace_writer;
+        this->_api_trace_writer = nullptr;
+        goto exit;
+    }
+
+attach:
+    this->_api_trace_writer->add(ring);
+    this->_nb_api_trace_rings += 1;
 
+exit:
     return retval;
 }
 
 
+void POSWorkspace::remove_api_trace_ring(POSApiTraceRing *ring){
+    std::lock_guard<std::mutex> lock(this->_api_trace_writer_mutex);
+
+    POS_CHECK_POINTER(ring);
+    POS_CHECK_POINTER(this->_api_trace_writer);
+    POS_ASSERT(this->_nb_api_trace_rings > 0);
+
+    this->_api_trace_writer->remove(ring);
+    this->_nb_api_trace_rings -= 1;
+
+    // stop the writer once no client is traced, so that the trace file is closed
+    if(this->_nb_api_trace_rings == 0){
+        delete this->_api_trace_writer;
+        this->_api_trace_writer = nullptr;
+    }
+}
+
+
+POSDaemonPool* POSWorkspace::__get_daemon_pool(POSDaemonPool*& pool, const char *name, pos_placement_role_t role){
+    std::lock_guard<std::mutex> lock(this->_daemon_pool_mutex);
+    std::string conf_val;
+    uint64_t nb_threads = 0, spin_us, yield_us, park_timeout_us;
+
+    if(pool != nullptr){ goto exit; }
+
+    if(likely(POS_SUCCESS == this->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeDaemonPoolThreads, conf_val))){
+        nb_threads = std::stoull(conf_val);
+    }
+    if(nb_threads == 0){ goto exit; }
+
+    POS_CHECK_POINTER(pool = new POSDaemonPool(name, nb_threads, &this->tsc_timer, &this->placement, role));
+
+    // pool threads wait as the dedicated daemon threads do
+    spin_us = POSUtilWaitEvent::kDefaultSpinUs;
+    yield_us = POSUtilWaitEvent::kDefaultYieldUs;
+    park_timeout_us = POSUtilWaitEvent::kDefaultParkTimeoutUs;
+    if(likely(POS_SUCCESS == this->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeWaitSpinUs, conf_val))){
+        spin_us = std::stoull(conf_val);
+    }
+    if(likely(POS_SUCCESS == this->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeWaitYieldUs, conf_val))){
+        yield_us = std::stoull(conf_val);
+    }
+    if(likely(POS_SUCCESS == this->ws_conf.get(POSWorkspaceConf::ConfigType::kRuntimeWaitParkTimeoutUs, conf_val))){
+        park_timeout_us = std::stoull(conf_val);
+    }
+    pool->set_wait_budget(
+        /* spin_ticks */ this->tsc_timer.us_to_tick(spin_us),
+        /* yield_ticks */ this->tsc_timer.us_to_tick(yield_us),
+        /* park_timeout_us */ park_timeout_us
+    );
+
+    if(unlikely(POS_SUCCESS != pool->init())){
+        POS_WARN_C("failed to start daemon pool, fallback to dedicated daemon threads: name(%s)", name);
+        delete pool;
+        pool = nullptr;
+    }
+
+exit:
+    return pool;
+}
+
+
 int POSWorkspace::pos_process(
     uint64_t api_id, pos_client_uuid_t uuid, std::vector<POSAPIParamDesp_t> param_desps, void* ret_data, uint64_t ret_data_len
 ){
-    uint64_t i;
     int retval, prev_error_code = 0;
     POSClient *client = nullptr;
-    POSAPIMeta_t api_meta;
-    bool has_prev_error = false;
+    const POSAPIMeta_t *api_meta;
     POSAPIContext_QE* wqe;
-    std::vector<POSAPIContext_QE*> cqes;
-    POSAPIContext_QE* cqe;
+    uint32_t wait_seq;
 
-    // TODO: comment out this once we enable piggyback support of uuid
-    //      in remoting framework
-    uuid = 0;
-    
-    // wait until client is ready
-    while(client == nullptr){
-        client = this->get_client_by_uuid(uuid);
+    /*!
+     *  \note  the client is referenced within the read section, so that it won't be destoried by
+     *          remove_client until this call returns; the read section is left before blocking,
+     *          otherwise registering / removing clients would stall behind the waits below
+     */
+    POSClientRegistry::read_lock();
+
+    // wait until client is registered, the uuid is piggybacked by the remoting framework
+    while(unlikely(nullptr == (client = this->get_client_by_uuid(uuid)))){
+        // don't block the removal of other clients while waiting
+        POSClientRegistry::read_unlock();
+        std::this_thread::yield();
+        POSClientRegistry::read_lock();
+    }
+    client->nb_rpc_refs.fetch_add(1, std::memory_order_seq_cst);
+    POSClientRegistry::read_unlock();
+
+    // wait until client is ready, or give up once it's removed
+    while(true){
+        wait_seq = client->rpc_wait_event.prepare();
+        if(client->status == kPOS_ClientStatus_Active){ break; }
+        if(unlikely(client->is_removed.load(std::memory_order_seq_cst))){
+            retval = POS_FAILED_NOT_EXIST;
+            goto exit;
+        }
+        client->rpc_wait_event.wait(wait_seq);
     }
-
-    // wait until client is ready
-    while(client->status != kPOS_ClientStatus_Active){}
 
     // check whether the metadata of the API was recorded
     #if POS_CONF_RUNTIME_EnableDebugCheck
-        if(unlikely(this->api_mgnr->api_metas.count(api_id) == 0)){
+        if(unlikely(!this->api_mgnr->api_metas.contains(api_id))){
             POS_WARN_C_DETAIL(
                 "no api metadata was recorded in the api manager: api_id(%lu)", api_id
             );
-            return POS_FAILED_NOT_EXIST;
+            retval = POS_FAILED_NOT_EXIST;
+            goto exit;
         }
     #endif // POS_CONF_RUNTIME_EnableDebugCheck
 
-    api_meta = api_mgnr->api_metas[api_id];
+    api_meta = &(this->api_mgnr->get_api_meta(api_id));
 
-    // generate new work queue element
-    wqe = new POSAPIContext_QE(
+    // generate new work queue element, held by this thread until it's pushed (or completed for sync call)
+    wqe = client->_apicxt_pool->acquire(
         /* api_id*/ api_id,
         /* uuid */ uuid,
         /* param_desps */ param_desps,
@@ -421,75 +981,46 @@ int POSWorkspace::pos_process(
         /* pos_client */ client
     );
     POS_CHECK_POINTER(wqe);
+    wqe->is_sync = api_meta->is_sync;
 
     /*!
-     *  \brief  push to the work queue
+     *  \brief  push to the work queue, the wqe is also held by the parser / worker until it's executed
      */
+    wqe->retain();
     client->push_q<kPOS_QueueDirection_Rpc2Parser, kPOS_QueueType_ApiCxt_WQ>(wqe);
 
     /*!
-     *  \note   if this is a sync call, we need to block until cqe is obtained
+     *  \note   if this is a sync call, we need to block until the wqe is completed
      */
-    if(unlikely(api_meta.is_sync)){
+    if(unlikely(api_meta->is_sync)){
         // mark the client is under sync call, so that the worker thread will make sure it will return back results
         // event though it's under dumping
         client->is_under_sync_call = true;
 
-        while(1){
-            #if POS_CONF_RUNTIME_EnableDebugCheck
-                if(unlikely(this->get_client_by_uuid(uuid) == nullptr)){
-                    POS_ERROR_DETAIL("client disappear during waiting of sync call, this is a bug: uuid(%lu)", uuid);
-                }
-            #endif
-
-            if(unlikely(
-                POS_SUCCESS != (client->template poll_q<kPOS_QueueDirection_Rpc2Parser,kPOS_QueueType_ApiCxt_CQ>(&cqes))
-            )){
-                POS_ERROR_C_DETAIL("failed to poll runtime cq");
-            }
-
-            if(unlikely(
-                POS_SUCCESS != (client->template poll_q<kPOS_QueueDirection_Rpc2Worker,kPOS_QueueType_ApiCxt_CQ>(&cqes))
-            )){
-                POS_ERROR_C_DETAIL("failed to poll worker cq");
-            }
-
-        #if POS_CONF_RUNTIME_EnableDebugCheck
-            if(cqes.size() > 0){
-                POS_DEBUG_C("polling completion queue, obtain %lu elements: uuid(%lu)", cqes.size(), uuid);
-            }
-        #endif
-
-            for(i=0; i<cqes.size(); i++){
-                POS_CHECK_POINTER(cqe = cqes[i]);
-
-                // found the called sync api
-                if(cqe->id == wqe->id){
-                    // setup return code
-                    retval = has_prev_error ? prev_error_code : cqe->api_cxt->return_code;
+        // wait for exactly this wqe, the parser / worker signals its completion word once it returns
+        client->sync_completion.wait(wqe->completion);
+        client->sync_completion.record_latency(POSUtilTscTimer::get_tsc() - wqe->create_tick);
 
-                    client->is_under_sync_call = false;
-
-                    goto exit;
-                }
+        // setup return code, the error of previous async call takes precedence
+        if(likely(client->consume_async_error(prev_error_code) == false)){
+            retval = wqe->api_cxt->return_code;
+        } else {
+            retval = prev_error_code;
+        }
 
-                // record previous async error
-                if(unlikely(
-                    cqe->status == kPOS_API_Execute_Status_Parser_Failed
-                    || cqe->status == kPOS_API_Execute_Status_Worker_Failed
-                )){
-                    has_prev_error = true;
-                    prev_error_code = cqe->api_cxt->return_code;
-                }
-            }
+        client->is_under_sync_call = false;
 
-            cqes.clear();
-        }
+        // the worker might hold the bottom half of checkpoint until the sync call is finished
+        client->worker_wait_event.notify();
     } else {
         // if this is a async call, we directly return success
-        retval = api_mgnr->cast_pos_retval(POS_SUCCESS, api_meta.library_id);
+        retval = api_mgnr->cast_pos_retval(POS_SUCCESS, api_meta->library_id);
     }
 
+    // the wqe is still held by the parser / worker if it's not finished yet
+    wqe->release();
+
 exit:
+    client->nb_rpc_refs.fetch_sub(1, std::memory_order_release);
     return retval;
 }
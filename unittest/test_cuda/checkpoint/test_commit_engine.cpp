@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 The PhoenixOS Authors. All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+
+#include "pos/include/common.h"
+#include "pos/include/checkpoint_commit_engine.h"
+
+
+TEST(PhOSCheckpointCommitEngine, BalanceAndStopOnContention) {
+    uint64_t i, j, max_assigned = 0, min_assigned = UINT64_MAX, max_job_size = 0;
+    POSCheckpointCommitBackend_HostMemcpy backend;
+    POSCheckpointCommitEngine engine(/* backend */ &backend, /* nb_lanes */ 4, /* staging_size */ KB(4));
+    std::vector<std::vector<uint8_t>> srcs(64), dsts(64);
+    std::vector<pos_ckpt_commit_job_t> jobs(64);
+
+    ASSERT_EQ(POS_SUCCESS, engine.init());
+
+    for(i=0; i<jobs.size(); i++){
+        srcs[i].resize(KB(1) * ((i * 7) % 13 + 1) + i);
+        dsts[i].resize(srcs[i].size(), 0);
+        for(j=0; j<srcs[i].size(); j++){ srcs[i][j] = (uint8_t)(rand()); }
+        jobs[i].src = srcs[i].data();
+        jobs[i].dst = dsts[i].data();
+        jobs[i].size = srcs[i].size();
+        max_job_size = std::max(max_job_size, jobs[i].size);
+    }
+
+    // all lanes should stop until the memory bus is released
+    backend.bus_lock = true;
+    std::thread releaser([&](){
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        backend.release_bus();
+    });
+    EXPECT_EQ(POS_SUCCESS, engine.run(jobs));
+    releaser.join();
+
+    for(i=0; i<jobs.size(); i++){
+        EXPECT_EQ(POS_SUCCESS, jobs[i].retval);
+        EXPECT_EQ(srcs[i], dsts[i]);
+    }
+    for(auto &lane : engine.lanes){
+        EXPECT_EQ(lane.assigned_bytes, lane.committed_bytes);
+        EXPECT_GT(lane.nb_stops, 0);
+        max_assigned = std::max(max_assigned, lane.assigned_bytes);
+        min_assigned = std::min(min_assigned, lane.assigned_bytes);
+    }
+    // greedy dispatching bounds the imbalance by the largest job
+    EXPECT_LE(max_assigned - min_assigned, max_job_size);
+}
+
+
+TEST(PhOSCheckpointCommitEngine, CancelWhileContended) {
+    POSCheckpointCommitBackend_HostMemcpy backend;
+    POSCheckpointCommitEngine engine(/* backend */ &backend, /* nb_lanes */ 2, /* staging_size */ KB(4));
+    std::vector<uint8_t> src(KB(16), 1), dst(KB(16), 0);
+    std::vector<pos_ckpt_commit_job_t> jobs(8);
+
+    ASSERT_EQ(POS_SUCCESS, engine.init());
+    for(auto &job : jobs){
+        job.src = src.data();
+        job.dst = dst.data();
+        job.size = src.size();
+    }
+
+    backend.bus_lock = true;
+    backend.cancel_flag = true;
+    EXPECT_EQ(POS_FAILED_DRAIN, engine.run(jobs));
+    for(auto &job : jobs){
+        EXPECT_EQ(POS_FAILED_DRAIN, job.retval);
+    }
+    for(auto &lane : engine.lanes){
+        EXPECT_EQ(0, lane.committed_bytes);
+    }
+}
+
+
+TEST(PhOSCheckpointCommitEngine, MultipleRounds) {
+    uint64_t round, i;
+    POSCheckpointCommitBackend_HostMemcpy backend;
+    POSCheckpointCommitEngine engine(/* backend */ &backend, /* nb_lanes */ 4, /* staging_size */ KB(4));
+    std::vector<uint8_t> src(KB(8));
+    std::vector<std::vector<uint8_t>> dsts;
+    std::vector<pos_ckpt_commit_job_t> jobs;
+
+    ASSERT_EQ(POS_SUCCESS, engine.init());
+
+    // lane threads are reused across rounds, including rounds that leave some lanes idle
+    for(round=0; round<64; round++){
+        jobs.resize(round % 8);
+        dsts.assign(jobs.size(), std::vector<uint8_t>(src.size(), 0));
+        for(i=0; i<src.size(); i++){ src[i] = (uint8_t)(round + i); }
+        for(i=0; i<jobs.size(); i++){
+            jobs[i].src = src.data();
+            jobs[i].dst = dsts[i].data();
+            jobs[i].size = src.size();
+        }
+        EXPECT_EQ(POS_SUCCESS, engine.run(jobs));
+        for(i=0; i<jobs.size(); i++){
+            EXPECT_EQ(POS_SUCCESS, jobs[i].retval);
+            EXPECT_EQ(src, dsts[i]);
+        }
+    }
+
+    engine.deinit();
+}